@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+
+# A synthetic camera for the External poll type (CamImpl_Pipe). Writes raw
+# frames to stdout at a set frame rate, with no headers - the same way
+# raspiyuv or ffmpeg would be set up to.
+#
+# e.g., for a feed with the pipe_cmd option:
+#	"pipe_cmd" : "python3 pipe_testgen.py --width 640 --height 480 --chans 3 --fps 30"
+#
+# Also used by the app's --benchmark-pipe option.
+
+import argparse
+import struct
+import sys
+import time
+
+def make_base_frame(width, height, chans):
+	# A horizontal gradient, so flips and misaligned frames are visible.
+	row = bytearray()
+	for x in range(width):
+		v = (x * 255) // max(1, width - 1)
+		row += bytes([v]) * chans
+	return bytearray(row) * height
+
+def main():
+	parser = argparse.ArgumentParser(description="Write synthetic raw frames to stdout.")
+	parser.add_argument("--width", type=int, default=640)
+	parser.add_argument("--height", type=int, default=480)
+	parser.add_argument("--chans", type=int, default=3, help="Bytes per pixel.")
+	parser.add_argument("--fps", type=float, default=30.0)
+	parser.add_argument(
+		"--stamp",
+		action="store_true",
+		help="Write the monotonic clock, in nanoseconds, into the first 8 bytes of each frame, to measure latency.")
+	parser.add_argument(
+		"--exit-after",
+		type=int,
+		default=0,
+		help="Write a partial frame and exit after this many frames, to test restarting.")
+	args = parser.parse_args()
+
+	rowBytes = args.width * args.chans
+	base = make_base_frame(args.width, args.height, args.chans)
+	barRows = max(1, args.height // 16)
+	bar = bytes([255]) * (rowBytes * barRows)
+
+	out = sys.stdout.buffer
+	start = time.monotonic()
+	frame = 0
+
+	try:
+		while args.exit_after <= 0 or frame < args.exit_after:
+			# A bar moving down the frame.
+			buf = bytearray(base)
+			barStart = ((frame * 4) % (args.height - barRows + 1)) * rowBytes
+			buf[barStart : barStart + len(bar)] = bar
+
+			# Sleep until the frame is due. Falling behind doesn't try to
+			# catch up with a burst of frames.
+			due = start + frame / args.fps
+			now = time.monotonic()
+			if due > now:
+				time.sleep(due - now)
+			else:
+				start += now - due
+
+			if args.stamp:
+				buf[0:8] = struct.pack("<Q", time.monotonic_ns())
+
+			out.write(buf)
+			out.flush()
+			frame += 1
+
+		out.write(base[0 : len(base) // 2])
+		out.flush()
+	except (BrokenPipeError, KeyboardInterrupt):
+		pass
+
+if __name__ == "__main__":
+	main()
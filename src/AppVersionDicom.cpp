@@ -1,8 +1,8 @@
 #include "AppVersionDicom.h"
 #include <dcmtk/dcmdata/dcdeftag.h>
-void AppVersionDicom::InjectIntoDicom(DcmDataset* dicomData)
+void AppVersionDicom::InjectStaticIntoDicom(DcmDataset* dicomData)
 {
-	// For a given build of an application, the stuff InjectIntoDicom
+	// For a given build of an application, the stuff InjectStaticIntoDicom
 	// manages in here should never change.
 
 	// https://dicom.innolitics.com/ciods/cr-image/general-series/00080060
@@ -8,7 +8,7 @@
 class AppVersionDicom : public DicomInjector
 {
 public:
-	void InjectIntoDicom(DcmDataset* dicomData) override;
+	void InjectStaticIntoDicom(DcmDataset* dicomData) override;
 
 	static AppVersionDicom& GetInstance();
 };
\ No newline at end of file
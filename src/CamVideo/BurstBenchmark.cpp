@@ -0,0 +1,153 @@
+#include "BurstBenchmark.h"
+#include "BurstRequest.h"
+#include "../Utils/multiplatform.h"
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+
+namespace
+{
+	typedef std::chrono::steady_clock BenchClock;
+
+	const int frameWidth		= 1920;
+	const int frameHeight		= 1080;
+	const int frameChans		= 3;
+	const int framesPerBurst	= 30;
+
+	/// <summary>
+	/// A simulated sensor. Like the camera implementations, only the newest
+	/// frame is kept, and a frame that's replaced before it's polled is 
+	/// skipped.
+	/// </summary>
+	struct SimSensor
+	{
+		std::mutex frameMutex;
+		cv::Ptr<cv::Mat> newestFrame;
+		BenchClock::time_point newestTime;
+		long long skippedCt = 0;
+		std::atomic_bool running = true;
+	};
+
+	double Average(const std::vector<double>& values)
+	{
+		if(values.empty())
+			return 0.0;
+
+		double total = 0.0;
+		for(double v : values)
+			total += v;
+
+		return total / (double)values.size();
+	}
+}
+
+bool BurstBenchmark::Run(std::ostream& os, int burstCt, double fps)
+{
+	os << "Benchmarking bursts of " << framesPerBurst << " frames at " << 
+		frameWidth << "x" << frameHeight << "x" << frameChans << 
+		", " << fps << " FPS, " << burstCt << " bursts." << std::endl;
+
+	cv::Mat pattern(frameHeight, frameWidth, CV_8UC(frameChans));
+	cv::randu(pattern, cv::Scalar::all(0), cv::Scalar::all(255));
+
+	SimSensor sensor;
+	std::thread sensorThread(
+		[&sensor, &pattern, fps]
+		{
+			std::chrono::microseconds period((long long)(1000000.0 / fps));
+			BenchClock::time_point next = BenchClock::now();
+			while(sensor.running)
+			{
+				// Every frame is delivered in a new buffer, as a driver would.
+				cv::Ptr<cv::Mat> frame = cv::makePtr<cv::Mat>(pattern.clone());
+				{
+					std::lock_guard<std::mutex> guard(sensor.frameMutex);
+					if(sensor.newestFrame != nullptr)
+						++sensor.skippedCt;
+
+					sensor.newestFrame	= frame;
+					sensor.newestTime	= BenchClock::now();
+				}
+				next += period;
+				std::this_thread::sleep_until(next);
+			}
+		});
+
+	std::vector<double> copyUS;
+	std::vector<double> captureFPS;
+	std::vector<double> averageMS;
+	long long missedCt = 0;
+
+	for(int b = 0; b < burstCt; ++b)
+	{
+		BurstRequest::SPtr burst = 
+			BurstRequest::MakeRequest("benchmark", framesPerBurst, SnapRequest::ProcessType::Cannot, true);
+		burst->Preallocate(pattern.size(), pattern.type());
+
+		// Polled the same way as ManagedCam's polling loop while a burst is
+		// capturing.
+		long long skippedAtStart = -1;
+		bool complete = false;
+		while(!complete)
+		{
+			cv::Ptr<cv::Mat> frame;
+			BenchClock::time_point captureTime;
+			{
+				std::lock_guard<std::mutex> guard(sensor.frameMutex);
+				std::swap(frame, sensor.newestFrame);
+				captureTime = sensor.newestTime;
+				if(frame != nullptr && skippedAtStart < 0)
+					skippedAtStart = sensor.skippedCt;
+			}
+
+			if(frame == nullptr)
+			{
+				MSSleep(1);
+				continue;
+			}
+
+			BenchClock::time_point copyStart = BenchClock::now();
+			BurstRequest::FrameMeta meta;
+			meta.captureTime = captureTime;
+			complete = burst->_AddFrame(*frame, meta);
+			copyUS.push_back(std::chrono::duration<double, std::micro>(BenchClock::now() - copyStart).count());
+
+			frame = nullptr;
+			if(!complete)
+				MSSleep(2);
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(sensor.frameMutex);
+			missedCt += sensor.skippedCt - skippedAtStart;
+		}
+		captureFPS.push_back(burst->CaptureFPS());
+
+		BenchClock::time_point averageStart = BenchClock::now();
+		cv::Mat averaged = BurstRequest::AverageFrames(burst->Frames());
+		averageMS.push_back(std::chrono::duration<double, std::milli>(BenchClock::now() - averageStart).count());
+	}
+
+	sensor.running = false;
+	sensorThread.join();
+
+	os << std::fixed << std::setprecision(2);
+	os << "\tCapture - Avg FPS: " << Average(captureFPS) << 
+		" - Min FPS: " << *std::min_element(captureFPS.begin(), captureFPS.end()) << 
+		" - Missed frames: " << missedCt << std::endl;
+
+	os << "\tCopy - Avg US: " << Average(copyUS) << 
+		" - Max US: " << *std::max_element(copyUS.begin(), copyUS.end()) << 
+		" - Frame interval US: " << 1000000.0 / fps << std::endl;
+
+	os << "\tAverage - Avg MS: " << Average(averageMS) << 
+		" - Max MS: " << *std::max_element(averageMS.begin(), averageMS.end()) << std::endl;
+
+	bool fullRate = (missedCt == 0);
+	os << (fullRate ? "\tEvery frame was captured at the full rate." : "\tFrames were missed, bursts can't keep up with this rate.") << std::endl;
+	return fullRate;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <ostream>
+
+/// <summary>
+/// A benchmark of burst capturing (see BurstRequest), to check bursts can
+/// be captured at the full sensor rate without missing frames.
+///
+/// A simulated sensor thread delivers 1920x1080 BGR frames at the frame
+/// rate, replacing the last frame if it wasn't polled in time, the same way
+/// the camera implementations do. The frames are polled the way a camera
+/// thread does while bursting, and copied into the burst's preallocated
+/// buffers. The capture rate, frames missed, copy times and the time to
+/// average each burst are reported.
+///
+/// Run with the --benchmark-burst command line option, and optionally
+/// --benchmark-fps to test a higher frame rate.
+/// </summary>
+class BurstBenchmark
+{
+public:
+	/// <summary>
+	/// Run the benchmark and print the results.
+	/// </summary>
+	/// <param name="os">The stream to print the results to.</param>
+	/// <param name="burstCt">The number of bursts to capture.</param>
+	/// <param name="fps">The frame rate of the simulated sensor.</param>
+	/// <returns>True if every burst was captured without missing frames.</returns>
+	static bool Run(std::ostream& os, int burstCt, double fps = 30.0);
+};
@@ -0,0 +1,127 @@
+#include "BurstRequest.h"
+#include <algorithm>
+
+BurstRequest::BurstRequest()
+{}
+
+void BurstRequest::Preallocate(cv::Size size, int type)
+{
+	if(size.width <= 0 || size.height <= 0 || type < 0)
+		return;
+
+	for(cv::Mat& frame : this->frames)
+	{
+		frame.create(size, type);
+
+		// Touch the memory now, so its pages aren't faulted in while
+		// capturing.
+		frame.setTo(cv::Scalar::all(0));
+	}
+}
+
+bool BurstRequest::_AddFrame(const cv::Mat& frame, const FrameMeta& meta)
+{
+	if(this->capturedCt >= this->frames.size())
+		return true;
+
+	// Only reallocates if the frame doesn't match the preallocated buffer.
+	frame.copyTo(this->frames[this->capturedCt]);
+	this->frameMetas[this->capturedCt] = meta;
+	++this->capturedCt;
+
+	if(this->capturedCt < this->frames.size())
+		return false;
+
+	double spanSec =
+		std::chrono::duration<double>(this->frameMetas.back().captureTime - this->frameMetas.front().captureTime).count();
+
+	if(this->frames.size() > 1 && spanSec > 0.0)
+		this->captureFPS = (double)(this->frames.size() - 1) / spanSec;
+
+	return true;
+}
+
+void BurstRequest::_FinishSave(bool saved, const std::string& path)
+{
+	if(!saved)
+	{
+		std::lock_guard<std::mutex> guard(this->failedAccess);
+		if(!this->saveFailed)
+			this->failedFile = path;
+
+		this->saveFailed = true;
+	}
+
+	if(--this->pendingSaves > 0)
+		return;
+
+	if(this->saveFailed)
+	{
+		std::lock_guard<std::mutex> guard(this->failedAccess);
+		this->err = "Error attempting to save burst files, starting with " + this->failedFile + ".";
+		this->status = Status::Error;
+	}
+	else
+		this->status = Status::Filled;
+}
+
+bool BurstRequest::Cancel()
+{
+	if(this->status != Status::Requested)
+		return false;
+
+	this->status = Status::Error;
+	this->err = "There was a request to cancel.";
+	return true;
+}
+
+cv::Mat BurstRequest::AverageFrames(const std::vector<cv::Mat>& frames)
+{
+	if(frames.empty() || frames.size() > maxFrames || frames[0].depth() != CV_8U)
+		return cv::Mat();
+
+	const cv::Mat& first = frames[0];
+	cv::Mat accumulator(first.size(), CV_16UC(first.channels()), cv::Scalar::all(0));
+	for(const cv::Mat& frame : frames)
+	{
+		if(frame.size() != first.size() || frame.type() != first.type())
+			return cv::Mat();
+
+		cv::add(accumulator, frame, accumulator, cv::noArray(), accumulator.type());
+	}
+
+	cv::Mat averaged;
+	accumulator.convertTo(averaged, first.type(), 1.0 / (double)frames.size());
+	return averaged;
+}
+
+BurstRequest::SPtr BurstRequest::MakeRequest(
+	const std::string& filename,
+	int frameCt,
+	SnapRequest::ProcessType pt,
+	bool average,
+	bool multiFrame)
+{
+	frameCt = std::min(std::max(frameCt, 1), (int)maxFrames);
+
+	BurstRequest* newReq = new BurstRequest();
+	newReq->filename	= filename;
+	newReq->processType	= pt;
+	newReq->average		= average;
+	newReq->multiFrame	= multiFrame;
+	newReq->status		= Status::Unknown;
+	newReq->frames.resize(frameCt);
+	newReq->frameMetas.resize(frameCt);
+
+	return BurstRequest::SPtr(newReq);
+}
+
+BurstRequest::SPtr BurstRequest::MakeError(const std::string& err, const std::string& filename)
+{
+	BurstRequest* newReq = new BurstRequest();
+	newReq->filename	= filename;
+	newReq->status		= Status::Error;
+	newReq->err			= err;
+
+	return BurstRequest::SPtr(newReq);
+}
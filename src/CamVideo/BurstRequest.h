@@ -0,0 +1,258 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include "SnapRequest.h"
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+
+/// <summary>
+/// The representation of a burst snapshot request for CamStreamMgr. A burst
+/// captures several consecutive frames of a stream, for picking a frame
+/// afterwards or averaging them to reduce noise.
+///
+/// The frames are copied into buffers allocated when the request is made,
+/// so capturing them on the stream's thread is only a copy. Once every frame
+/// is captured, they're saved on the task pool, either as one multi-frame
+/// DICOM file with the request's filename, or as a DICOM file per frame,
+/// each named the request's filename with "_" and the frame's index. An
+/// averaged frame can also be saved, named with "_avg".
+/// </summary>
+class BurstRequest
+{
+	friend class IManagedCam;
+	friend class BurstBenchmark;
+
+public:
+	/// <summary>
+	/// The status of the request.
+	/// </summary>
+	enum class Status
+	{
+		Unknown,
+
+		/// <summary>
+		/// The frames are being captured.
+		/// </summary>
+		Requested,
+
+		/// <summary>
+		/// Every frame was captured, and the burst's files are being encoded
+		/// and written. Files saved one per frame, and the averaged frame, are
+		/// written behind the request (see CaptureStorage), and the request
+		/// stays Saving until they're all on disk.
+		/// </summary>
+		Saving,
+
+		/// <summary>
+		/// Every one of the burst's files was written and synced. If any 
+		/// couldn't be encoded or written, the status becomes Error instead.
+		/// </summary>
+		Filled,
+
+		/// <summary>
+		/// The request has resulted in an error. See err for more
+		/// information.
+		/// </summary>
+		Error
+	};
+
+	/// <summary>
+	/// The most frames in a burst. The average is accumulated in 16 bits,
+	/// which can sum up to 257 8-bit frames.
+	/// </summary>
+	static const int maxFrames = 256;
+
+	/// <summary>
+	/// What was recorded with each captured frame.
+	/// </summary>
+	struct FrameMeta
+	{
+		std::chrono::steady_clock::time_point captureTime;
+
+		/// <summary>
+		/// The CamSyncGroup acquisition epoch, or -1.
+		/// </summary>
+		long long epoch = -1;
+
+		/// <summary>
+		/// The camera's exposure time, in microseconds. 0 if automatic.
+		/// </summary>
+		int exposureUS = 0;
+
+		/// <summary>
+		/// The NIR and white light intensities, from 0.0 (off) to 1.0.
+		/// </summary>
+		float laserNIR = 0.0f;
+		float laserWhite = 0.0f;
+	};
+
+private:
+	BurstRequest();
+
+private:
+	/// <summary>
+	/// The base filename to save the frames as, without an extension.
+	/// </summary>
+	std::string filename;
+
+	SnapRequest::ProcessType processType = SnapRequest::ProcessType::Indifferent;
+
+	/// <summary>
+	/// If true, an averaged frame of the burst is also saved.
+	/// </summary>
+	bool average = false;
+
+	/// <summary>
+	/// If true, the frames are saved into one multi-frame DICOM file (see
+	/// MultiFrameDicomWriter), instead of a file per frame.
+	/// </summary>
+	bool multiFrame = true;
+
+	Status status = Status::Unknown;
+
+	/// <summary>
+	/// The frame buffers, one per frame of the burst.
+	/// </summary>
+	std::vector<cv::Mat> frames;
+
+	/// <summary>
+	/// The capture time, epoch, exposure and lights of each frame.
+	/// </summary>
+	std::vector<FrameMeta> frameMetas;
+
+	/// <summary>
+	/// The number of frames captured so far. Only modified by the stream's
+	/// thread.
+	/// </summary>
+	int capturedCt = 0;
+
+	/// <summary>
+	/// The stream's skipped frame count when the first frame was captured.
+	/// </summary>
+	long long skippedAtStart = 0;
+
+	/// <summary>
+	/// The frames the camera received during the burst, but replaced with
+	/// a newer frame before they were polled. If 0, the burst is every frame
+	/// the camera delivered.
+	/// </summary>
+	long long droppedCt = 0;
+
+	/// <summary>
+	/// The frame rate the burst was captured at.
+	/// </summary>
+	double captureFPS = 0.0;
+
+	/// <summary>
+	/// The number of files that haven't been written, or failed, yet.
+	/// </summary>
+	std::atomic_int pendingSaves = 0;
+
+	std::atomic_bool saveFailed = false;
+
+	/// <summary>
+	/// Guards failedFile, as the files finish on different threads.
+	/// </summary>
+	std::mutex failedAccess;
+
+	/// <summary>
+	/// The first file that couldn't be saved, for the error.
+	/// </summary>
+	std::string failedFile;
+
+	/// <summary>
+	/// Copy a frame into the next buffer.
+	/// </summary>
+	/// <returns>True if this was the last frame of the burst.</returns>
+	bool _AddFrame(const cv::Mat& frame, const FrameMeta& meta);
+
+	/// <summary>
+	/// Record that one of the burst's files was written, or failed, and set
+	/// the status when they all are.
+	/// </summary>
+	/// <param name="saved">If the file made it to disk.</param>
+	/// <param name="path">The file, named in the error if it failed.</param>
+	void _FinishSave(bool saved, const std::string& path);
+
+public:
+	/// <summary>
+	/// The error. Only set if the status is Status::Error.
+	/// </summary>
+	std::string err;
+
+	typedef std::shared_ptr<BurstRequest> SPtr;
+
+public:
+	inline Status GetStatus() const
+	{ return this->status; }
+
+	inline std::string Filename() const
+	{ return this->filename; }
+
+	inline int FrameCt() const
+	{ return (int)this->frames.size(); }
+
+	inline long long DroppedFrames() const
+	{ return this->droppedCt; }
+
+	inline double CaptureFPS() const
+	{ return this->captureFPS; }
+
+	inline bool IsMultiFrame() const
+	{ return this->multiFrame; }
+
+	/// <summary>
+	/// The captured frames. Only safe to access once the status is Saving
+	/// or Filled. They stay in memory as long as the request is referenced.
+	/// </summary>
+	inline const std::vector<cv::Mat>& Frames() const
+	{ return this->frames; }
+
+	/// <summary>
+	/// Allocate the frame buffers ahead of the burst, so capturing doesn't
+	/// allocate. Frames of another size or type are still captured, with a
+	/// new buffer.
+	/// </summary>
+	void Preallocate(cv::Size size, int type);
+
+	bool Cancel();
+
+	/// <summary>
+	/// Average frames to reduce noise. The frames are summed with a 16 bit
+	/// accumulator, using OpenCV's vectorized arithmetic.
+	/// </summary>
+	/// <param name="frames">
+	/// The 8-bit frames to average, all of the same size and type. At most
+	/// maxFrames.
+	/// </param>
+	/// <returns>The averaged frame, or an empty Mat if the frames don't match.</returns>
+	static cv::Mat AverageFrames(const std::vector<cv::Mat>& frames);
+
+	/// <summary>
+	/// Create a burst request.
+	/// </summary>
+	/// <param name="filename">The base filename to save the frames as.</param>
+	/// <param name="frameCt">The number of frames, clamped to [1, maxFrames].</param>
+	/// <param name="pt">The requirement for what stage of processing to record.</param>
+	/// <param name="average">If true, an averaged frame is also saved.</param>
+	/// <param name="multiFrame">
+	/// If true, the frames are saved into one multi-frame DICOM file, else a
+	/// file per frame.
+	/// </param>
+	static SPtr MakeRequest(
+		const std::string& filename,
+		int frameCt,
+		SnapRequest::ProcessType pt,
+		bool average,
+		bool multiFrame = true);
+
+	/// <summary>
+	/// Generate a BurstRequest containing an error state.
+	/// </summary>
+	static SPtr MakeError(const std::string& err, const std::string& filename);
+};
@@ -0,0 +1,212 @@
+#include "CamImpl_FaultInject.h"
+#include "../../Utils/cvgAssert.h"
+#include <iostream>
+
+CamImpl_FaultInject::CamImpl_FaultInject(ICamImpl* inner, const CamFaultProfile& profile)
+{
+	cvgAssert(inner != nullptr, "Fault injection wrapping a null implementation");
+
+	this->inner = inner;
+	this->profile = profile;
+	this->SeedRNG();
+}
+
+CamImpl_FaultInject::~CamImpl_FaultInject()
+{
+	// Shutdown here instead of leaving it to ~ICamImpl(), while
+	// ShutdownImpl() can still reach the inner implementation.
+	this->Shutdown();
+
+	delete this->inner;
+	this->inner = nullptr;
+}
+
+void CamImpl_FaultInject::SeedRNG()
+{
+	if(this->profile.seed != 0)
+		this->rng.seed(this->profile.seed);
+	else
+		this->rng.seed(std::random_device()());
+}
+
+bool CamImpl_FaultInject::Roll(float chance)
+{
+	if(chance <= 0.0f)
+		return false;
+
+	std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+	return dist(this->rng) < chance;
+}
+
+bool CamImpl_FaultInject::InitializeImpl()
+{
+	return this->inner->Initialize();
+}
+
+bool CamImpl_FaultInject::ShutdownImpl()
+{
+	std::cout << "Fault injection totals - Drops: " << this->dropCt <<
+		" - Stalls: " << this->stallCt <<
+		" - Disconnects: " << this->disconnectCt <<
+		" - Failed activations: " << this->activateFailCt << std::endl;
+
+	return this->inner->Shutdown();
+}
+
+bool CamImpl_FaultInject::ActivateImpl()
+{
+	if(this->disconnected)
+	{
+		if(this->swFault.Milliseconds(false) < this->profile.disconnectMS)
+		{
+			++this->activateFailCt;
+			return false;
+		}
+		this->disconnected = false;
+	}
+
+	if(this->Roll(this->profile.activateFailChance))
+	{
+		std::cout << "Fault injection: failing activation." << std::endl;
+		++this->activateFailCt;
+		return false;
+	}
+
+	this->stalled = false;
+	return this->inner->Activate();
+}
+
+bool CamImpl_FaultInject::DeactivateImpl()
+{
+	return this->inner->Deactivate();
+}
+
+bool CamImpl_FaultInject::InjectFrameFault()
+{
+	if(this->disconnected)
+		return true;
+
+	if(this->stalled)
+	{
+		if(this->swFault.Milliseconds(false) < this->profile.stallMS)
+			return true;
+
+		this->stalled = false;
+	}
+
+	if(this->Roll(this->profile.disconnectChance))
+	{
+		std::cout << "Fault injection: disconnecting for " << this->profile.disconnectMS << "ms." << std::endl;
+		++this->disconnectCt;
+		this->disconnected = true;
+		this->swFault.Restart();
+		return true;
+	}
+
+	if(this->Roll(this->profile.stallChance))
+	{
+		std::cout << "Fault injection: stalling for " << this->profile.stallMS << "ms." << std::endl;
+		++this->stallCt;
+		this->stalled = true;
+		this->swFault.Restart();
+		return true;
+	}
+	return false;
+}
+
+cv::Ptr<cv::Mat> CamImpl_FaultInject::InjectDrop(cv::Ptr<cv::Mat> frame)
+{
+	if(frame != nullptr && this->Roll(this->profile.dropChance))
+	{
+		++this->dropCt;
+		return cv::Ptr<cv::Mat>();
+	}
+	return frame;
+}
+
+cv::Ptr<cv::Mat> CamImpl_FaultInject::PollFrameImpl()
+{
+	if(this->InjectFrameFault())
+		return cv::Ptr<cv::Mat>();
+
+	// Still poll the inner implementation for dropped frames, so the
+	// device's frame is actually lost.
+	return this->InjectDrop(this->inner->PollFrame());
+}
+
+VideoPollType CamImpl_FaultInject::PollType()
+{
+	// Masquerade as the inner implementation, so the ManagedCam
+	// doesn't think the polling type has changed.
+	return this->inner->PollType();
+}
+
+bool CamImpl_FaultInject::IsValid()
+{
+	return
+		!this->disconnected &&
+		this->inner->IsValid();
+}
+
+bool CamImpl_FaultInject::PullOptions(const cvgCamFeedLocs& opts)
+{
+	this->ICamImpl::PullOptions(opts);
+
+	if(opts.faultInjection.has_value())
+		this->profile = opts.faultInjection.value();
+
+	return this->inner->PullOptions(opts);
+}
+
+bool CamImpl_FaultInject::SetParam(StreamParams paramid, double value)
+{
+	return this->inner->SetParam(paramid, value);
+}
+
+void CamImpl_FaultInject::DelegatedInjectIntoDicom(DcmDataset* dicomData)
+{
+	this->inner->DelegatedInjectIntoDicom(dicomData);
+}
+
+double CamImpl_FaultInject::GetLastFrameAgeMS()
+{
+	return this->inner->GetLastFrameAgeMS();
+}
+
+long long CamImpl_FaultInject::GetSkippedFrameCt()
+{
+	return this->inner->GetSkippedFrameCt();
+}
+
+bool CamImpl_FaultInject::IsSelfPaced()
+{
+	return this->inner->IsSelfPaced();
+}
+
+bool CamImpl_FaultInject::SupportsSplitGrab()
+{
+	return this->inner->SupportsSplitGrab();
+}
+
+bool CamImpl_FaultInject::GrabFrame()
+{
+	// A disconnected device has nothing to grab. Stalls and drops still
+	// grab, so the device's frame is actually lost.
+	if(this->disconnected)
+		return false;
+
+	return this->inner->GrabFrame();
+}
+
+double CamImpl_FaultInject::GetLastGrabTimeMS()
+{
+	return this->inner->GetLastGrabTimeMS();
+}
+
+cv::Ptr<cv::Mat> CamImpl_FaultInject::RetrieveFrame()
+{
+	if(this->InjectFrameFault())
+		return cv::Ptr<cv::Mat>();
+
+	return this->InjectDrop(this->inner->RetrieveFrame());
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "ICamImpl.h"
+#include "../../Utils/CamFaultProfile.h"
+#include "../../Utils/cvgStopwatch.h"
+#include <random>
+
+/// <summary>
+/// A ICamImpl that wraps another implementation and randomly injects
+/// faults into it - dropped frames, stalls where the camera stays valid
+/// but stops delivering frames, and disconnects where the camera becomes
+/// invalid and fails to reactivate for a while.
+///
+/// This is for development, to exercise ManagedCam's reconnect logic
+/// on demand. It's enabled per camera with the "fault_inject" camera
+/// option (see cvgCamFeedLocs::faultInjection).
+///
+/// Note that a simulated disconnect belongs to the wrapper instance, so if
+/// the ManagedCam gives up on reactivating and rebuilds the implementation,
+/// the disconnect ends early.
+/// </summary>
+class CamImpl_FaultInject : public ICamImpl
+{
+private:
+	/// <summary>
+	/// The real implementation. This is owned by the CamImpl_FaultInject.
+	/// </summary>
+	ICamImpl* inner;
+
+	CamFaultProfile profile;
+
+	std::mt19937 rng;
+
+	/// <summary>
+	/// If true, we're simulating a disconnect.
+	/// </summary>
+	bool disconnected = false;
+
+	/// <summary>
+	/// If true, we're simulating a stall.
+	/// </summary>
+	bool stalled = false;
+
+	/// <summary>
+	/// Measures how long the current stall or disconnect has lasted.
+	/// </summary>
+	cvgStopwatch swFault;
+
+	// Counts of injected faults, for logging.
+	int dropCt = 0;
+	int stallCt = 0;
+	int disconnectCt = 0;
+	int activateFailCt = 0;
+
+private:
+	/// <summary>
+	/// Roll the dice.
+	/// </summary>
+	/// <param name="chance">The chance of success, from [0.0, 1.0].</param>
+	/// <returns>True at a rate of chance.</returns>
+	bool Roll(float chance);
+
+	void SeedRNG();
+
+	/// <summary>
+	/// Continue or start a stall or disconnect, before a frame is taken
+	/// from the inner implementation.
+	/// </summary>
+	/// <returns>True if there's no frame because of a fault.</returns>
+	bool InjectFrameFault();
+
+	/// <summary>
+	/// Roll for dropping a frame taken from the inner implementation.
+	/// </summary>
+	/// <returns>The frame, or nullptr if it was dropped.</returns>
+	cv::Ptr<cv::Mat> InjectDrop(cv::Ptr<cv::Mat> frame);
+
+protected:
+	bool InitializeImpl() override;
+	bool ShutdownImpl() override;
+	bool ActivateImpl() override;
+	bool DeactivateImpl() override;
+	cv::Ptr<cv::Mat> PollFrameImpl() override;
+
+public:
+	/// <summary>
+	/// Constructor.
+	/// </summary>
+	/// <param name="inner">
+	/// The implementation to wrap. Ownership is transfered to the
+	/// CamImpl_FaultInject.
+	/// </param>
+	/// <param name="profile">The faults to inject.</param>
+	CamImpl_FaultInject(ICamImpl* inner, const CamFaultProfile& profile);
+	~CamImpl_FaultInject();
+
+	VideoPollType PollType() override;
+	bool IsValid() override;
+
+	bool PullOptions(const cvgCamFeedLocs& opts) override;
+	bool SetParam(StreamParams paramid, double value) override;
+	void DelegatedInjectIntoDicom(DcmDataset* dicomData) override;
+	double GetLastFrameAgeMS() override;
+	long long GetSkippedFrameCt() override;
+	bool IsSelfPaced() override;
+
+	// Split grabs are forwarded, so a wrapped camera stays in the 
+	// CamSyncGroup. Faults are applied when retrieving.
+	bool SupportsSplitGrab() override;
+	bool GrabFrame() override;
+	double GetLastGrabTimeMS() override;
+	cv::Ptr<cv::Mat> RetrieveFrame() override;
+};
@@ -13,6 +13,8 @@
 #include <sys/ioctl.h>
 #include <linux/videodev2.h>
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 #include "../IManagedCam.h"
 
 
@@ -715,6 +717,11 @@ static MMAL_STATUS_T create_camera_component(RPiYUVState* state, int videoExposu
 {
 	std::cout << "Creating camera component" << std::endl;
 	std::cout << "\t" << "Target exposure microseconds: " << videoExposureTime << std::endl;
+	std::cout << "\t" << "Target frame rate: " << state->framerate << std::endl;
+
+	// The longest exposure that fits in a frame at the target frame rate. The
+	// 2% of slack keeps 30FPS at its original 34000us limit.
+	const int maxFrameExposure = 1020000 / state->framerate;
 
 	// Create the component
 	MMAL_COMPONENT_T* camera = nullptr;
@@ -820,9 +827,9 @@ static MMAL_STATUS_T create_camera_component(RPiYUVState* state, int videoExposu
 	//
 	// When setting the video port, in order for this to be handled correctly,
 	// the preview port ALSO needs to honor videoExposureTime.
-	if(videoExposureTime <= 34000)
+	if(videoExposureTime <= maxFrameExposure)
 	{
-		format->es->video.frame_rate.num 	= VIDEO_FRAME_RATE_NUM;
+		format->es->video.frame_rate.num 	= state->framerate;
 		format->es->video.frame_rate.den 	= VIDEO_FRAME_RATE_DEN;
 	}
 	else
@@ -858,11 +865,11 @@ static MMAL_STATUS_T create_camera_component(RPiYUVState* state, int videoExposu
 	format->es->video.crop.width 		= state->width;
 	format->es->video.crop.height 		= state->height;	
 
-	// If the exposure time is greater than ~1/30th of a second, we need to lower
-	// the refresh rate to allow additional photons to collect.
-	if(videoExposureTime <= 34000)
+	// If the exposure time is greater than ~1 frame, we need to lower the
+	// refresh rate to allow additional photons to collect.
+	if(videoExposureTime <= maxFrameExposure)
 	{
-		format->es->video.frame_rate.num 	= VIDEO_FRAME_RATE_NUM;
+		format->es->video.frame_rate.num 	= state->framerate;
 		format->es->video.frame_rate.den 	= VIDEO_FRAME_RATE_DEN;
 	}
 	else
@@ -1046,6 +1053,9 @@ bool CamImpl_MMAL::ActivateImpl()
 	if(this->prefHeight != 0)
 		this->state->height = this->prefHeight;
 
+	if(this->prefFPS > 0.0)
+		this->state->framerate = std::max(1, (int)std::round(this->prefFPS));
+
 	// Setup for sensor specific parameters, only set W/H settings if zero on entry
 
 	std::cout << "Getting sensor defaults" << std::endl;
@@ -1293,6 +1303,66 @@ bool CamImpl_MMAL::SetParam(StreamParams paramid, double value)
 	case StreamParams::ExposureMicroseconds:
 		SetExposureMicroseconds((long)value);
 		return true;
+
+	// Flips are done by the camera component instead of in software.
+	case StreamParams::FlipHorizontal:
+	case StreamParams::FlipVertical:
+		if(paramid == StreamParams::FlipHorizontal)
+			this->flipHoriz = (value != 0.0);
+		else
+			this->flipVert = (value != 0.0);
+
+		if(this->IsValid())
+		{
+			raspicamcontrol_set_flips(
+				this->state->camera_component, 
+				this->flipHoriz ? 1 : 0, 
+				this->flipVert ? 1 : 0);
+		}
+		return true;
+
+	// For gains, a value of 0 or less switches the pair back to automatic.
+	// If only one of a pair has been set explicitly, the other defaults to
+	// unity gain.
+	case StreamParams::AnalogGain:
+	case StreamParams::DigitalGain:
+		if(value <= 0.0)
+			this->cameraGain.reset();
+		else
+		{
+			CameraGain cg = this->cameraGain.value_or(CameraGain{1.0f, 1.0f});
+			if(paramid == StreamParams::AnalogGain)
+				cg.analogGain = (float)value;
+			else
+				cg.digitalGain = (float)value;
+
+			this->cameraGain = cg;
+		}
+
+		if(this->IsValid())
+			this->EnforceGainSettings();
+
+		return true;
+
+	case StreamParams::WhiteBalanceRed:
+	case StreamParams::WhiteBalanceBlue:
+		if(value <= 0.0)
+			this->whitebalanceGain.reset();
+		else
+		{
+			WhiteBalanceGain wb = this->whitebalanceGain.value_or(WhiteBalanceGain{1.0f, 1.0f});
+			if(paramid == StreamParams::WhiteBalanceRed)
+				wb.redGain = (float)value;
+			else
+				wb.blueGain = (float)value;
+
+			this->whitebalanceGain = wb;
+		}
+
+		if(this->IsValid())
+			this->EnforceGainSettings();
+
+		return true;
 	}
 	return this->ICamImpl::SetParam(paramid, value);
 }
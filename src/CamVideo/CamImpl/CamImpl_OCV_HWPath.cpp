@@ -3,6 +3,8 @@
 #include <mutex>
 #include <thread>
 
+std::atomic_bool CamImpl_OCV_HWPath::serializeOpens(true);
+
 VideoPollType CamImpl_OCV_HWPath::PollType()
 {
 	return VideoPollType::OpenCVUSB_Named;
@@ -13,15 +15,32 @@ cv::VideoCapture * CamImpl_OCV_HWPath::CreateVideoCapture()
 	///It turns out that cv::VideoCapture may not be thread-safe for V4L2 
 	/// which is what the pi uses which lead to intermittent segfaults
 	/// so we are going to make mutex guards if we are not in windows.
+	///
+	/// This can be turned off with SetSerializeOpens() for platforms where
+	/// it's known to be safe, so multiple cameras can open in parallel.
 #if !_WIN32
 	static std::mutex mutexReturn;
-	std::lock_guard<std::mutex> guard(mutexReturn);
+	std::unique_lock<std::mutex> guard(mutexReturn, std::defer_lock);
+	if(serializeOpens)
+		guard.lock();
 #endif
 
 	this->AssertStreamNull();
 	return new cv::VideoCapture(this->path);
 }
 
+bool CamImpl_OCV_HWPath::IsCaptureDevice() const
+{
+	// The path could also be to a file, such as a recording standing in
+	// for a camera, which doesn't have modes to choose from.
+	return this->path.rfind("/dev/", 0) == 0;
+}
+
+std::string CamImpl_OCV_HWPath::GetDeviceNode() const
+{
+	return this->path;
+}
+
 CamImpl_OCV_HWPath::CamImpl_OCV_HWPath(const std::string& path)
 {
 	this->path = path;
@@ -43,7 +62,7 @@ bool CamImpl_OCV_HWPath::ChangeDeviceID(
 
 bool CamImpl_OCV_HWPath::PullOptions(const cvgCamFeedLocs& opts)
 {
-	this->ICamImpl::PullOptions(opts);
+	this->CamImpl_OpenCVBase::PullOptions(opts);
 
 	this->path = opts.devicePath;
 	return true;
@@ -2,6 +2,7 @@
 
 #include "ICamImpl.h"
 #include "CamImpl_OpenCVBase.h"
+#include <atomic>
 
 // This CamImpl_OpenCVBase subclass will no doubt resemble the Web subclass.
 //
@@ -22,9 +23,16 @@ private:
 	/// </summary>
 	std::string path;
 
+	/// <summary>
+	/// If true, device opens across all instances are serialized.
+	/// </summary>
+	static std::atomic_bool serializeOpens;
+
 protected:
 	cv::VideoCapture * CreateVideoCapture() override;
 	bool PullOptions(const cvgCamFeedLocs& opts) override;
+	bool IsCaptureDevice() const override;
+	std::string GetDeviceNode() const override;
 
 public:
 	CamImpl_OCV_HWPath(const std::string& path);
@@ -42,4 +50,13 @@ public:
 	/// </param>
 	/// <returns>True, if the value was successfully changed.</returns>
 	bool ChangeDeviceID(const std::string& newPath, bool cannotBeRunning = true);
+
+	/// <summary>
+	/// Set if opening devices should be serialized between all cameras.
+	/// This is on by default, because V4L2 opens haven't been thread-safe
+	/// on the Pi. Does nothing on Windows, where opens are never serialized.
+	/// </summary>
+	/// <param name="serialize">If true, only one device is opened at a time.</param>
+	static void SetSerializeOpens(bool serialize)
+	{ serializeOpens = serialize; }
 };
\ No newline at end of file
@@ -12,6 +12,21 @@ cv::VideoCapture* CamImpl_OCV_USB::CreateVideoCapture()
 	return new cv::VideoCapture(this->deviceID);
 }
 
+bool CamImpl_OCV_USB::IsCaptureDevice() const
+{
+	return true;
+}
+
+std::string CamImpl_OCV_USB::GetDeviceNode() const
+{
+#if __linux__
+	// OpenCV's V4L2 backend opens device indices as their video node.
+	return "/dev/video" + std::to_string(this->deviceID);
+#else
+	return "";
+#endif
+}
+
 CamImpl_OCV_USB::CamImpl_OCV_USB(int deviceID)
 {
 	this->deviceID = deviceID;
@@ -33,7 +48,7 @@ bool CamImpl_OCV_USB::ChangeDeviceID(
 
 bool CamImpl_OCV_USB::PullOptions(const cvgCamFeedLocs& opts)
 {
-	this->ICamImpl::PullOptions(opts);
+	this->CamImpl_OpenCVBase::PullOptions(opts);
 
 	this->deviceID = opts.camIndex;
 	return true;
@@ -19,6 +19,8 @@ private:
 
 protected:
 	cv::VideoCapture * CreateVideoCapture() override;
+	bool IsCaptureDevice() const override;
+	std::string GetDeviceNode() const override;
 
 public:
 	CamImpl_OCV_USB(int deviceID);
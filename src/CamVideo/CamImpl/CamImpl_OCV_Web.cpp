@@ -1,4 +1,11 @@
 #include "CamImpl_OCV_Web.h"
+#include <vector>
+
+// How long opening the stream, and each grab, may block on a stalled 
+// stream before FFmpeg gives up, instead of its own timeouts of around 30
+// seconds. This bounds how long stopping the grabber thread can take.
+const int msStreamOpenTimeout = 5000;
+const int msStreamReadTimeout = 2000;
 
 VideoPollType CamImpl_OCV_Web::PollType()
 {
@@ -8,7 +15,13 @@ VideoPollType CamImpl_OCV_Web::PollType()
 cv::VideoCapture * CamImpl_OCV_Web::CreateVideoCapture()
 {
 	this->AssertStreamNull();
-	return new cv::VideoCapture(this->url);
+
+	std::vector<int> params =
+	{
+		cv::CAP_PROP_OPEN_TIMEOUT_MSEC, msStreamOpenTimeout,
+		cv::CAP_PROP_READ_TIMEOUT_MSEC, msStreamReadTimeout
+	};
+	return new cv::VideoCapture(this->url, cv::CAP_ANY, params);
 }
 
 CamImpl_OCV_Web::CamImpl_OCV_Web(const std::string& path)
@@ -32,7 +45,7 @@ bool CamImpl_OCV_Web::ChangeDeviceID(
 
 bool CamImpl_OCV_Web::PullOptions(const cvgCamFeedLocs& opts)
 {
-	this->ICamImpl::PullOptions(opts);
+	this->CamImpl_OpenCVBase::PullOptions(opts);
 
 	this->url = opts.uriSource;
 	return true;
@@ -1,4 +1,18 @@
 #include "CamImpl_OpenCVBase.h"
+#include "../IManagedCam.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <iostream>
+#include <algorithm>
+
+// How long polling waits for a compressed frame to be decoded.
+const int msDecodeTimeout = 250;
+
+// How long polling waits for the grabber thread to grab a new frame.
+const int msGrabTimeout = 250;
+
+// How long the grabber thread waits after a failed grab before trying again.
+const int msGrabRetry = 10;
 
 bool CamImpl_OpenCVBase::InitializeImpl()
 { 
@@ -21,11 +35,19 @@ bool CamImpl_OpenCVBase::ActivateImpl()
 
 	this->InitCapture();
 
+	this->lastFrameAgeMS = -1.0;
+	this->prevPosMS = -1.0;
+	if(this->grabberMode)
+		this->_StartGrabber();
+
 	return true;
 }
 
 bool CamImpl_OpenCVBase::DeactivateImpl()
 {
+	this->_StopGrabber();
+	this->decodeWorker.Stop();
+
 	if(this->ocvStream == nullptr)
 		return true;
 
@@ -41,14 +63,327 @@ cv::Ptr<cv::Mat> CamImpl_OpenCVBase::PollFrameImpl()
 {
 	cvgAssert(this->ocvStream != nullptr, "polling with nullstream");
 
+	cv::Mat raw;
+	if(this->grabberMode)
+	{
+		if(!this->_RetrieveNewest(raw))
+			return nullptr;
+	}
+	else
+	{
+		*this->ocvStream >> raw;
+		if(!raw.empty())
+		{
+			this->_UpdateFrameAge(
+				this->ocvStream->get(cv::CAP_PROP_POS_MSEC), 
+				std::chrono::steady_clock::now());
+		}
+	}
+
+	return this->_FinishFrame(raw, true);
+}
+
+cv::Ptr<cv::Mat> CamImpl_OpenCVBase::_FinishFrame(const cv::Mat& raw, bool pipelined)
+{
 	cv::Ptr<cv::Mat> ret = new cv::Mat();
-	*this->ocvStream >> *ret;
+	if(!this->_ConvertFrame(raw, *ret, pipelined))
+		return nullptr;
 
 	this->UtilToFlipMatInOpenCV(*ret);
 
 	return ret;
 }
 
+bool CamImpl_OpenCVBase::SupportsSplitGrab()
+{
+	return !this->grabberMode && this->ocvStream != nullptr;
+}
+
+bool CamImpl_OpenCVBase::GrabFrame()
+{
+	cvgAssert(this->ocvStream != nullptr, "grabbing with nullstream");
+
+	if(!this->ocvStream->grab())
+		return false;
+
+	this->grabTime	= std::chrono::steady_clock::now();
+	this->grabPosMS	= this->ocvStream->get(cv::CAP_PROP_POS_MSEC);
+	return true;
+}
+
+double CamImpl_OpenCVBase::GetLastGrabTimeMS()
+{
+	typedef std::chrono::duration<double, std::milli> MSDuration;
+
+	// The device's timestamp is when the frame was actually captured. 
+	// Relative timestamps can't be compared between cameras, so for those
+	// the best we have is when the grab returned.
+	if(this->monotonicTimestamps && this->grabPosMS > 0.0)
+		return this->grabPosMS;
+
+	return MSDuration(this->grabTime.time_since_epoch()).count();
+}
+
+cv::Ptr<cv::Mat> CamImpl_OpenCVBase::RetrieveFrame()
+{
+	cvgAssert(this->ocvStream != nullptr, "retrieving with nullstream");
+
+	cv::Mat raw;
+	if(!this->ocvStream->retrieve(raw) || raw.empty())
+		return nullptr;
+
+	this->_UpdateFrameAge(this->grabPosMS, this->grabTime);
+
+	// Not pipelined, the returned frame needs to be the one that was 
+	// grabbed, to match the other cameras grabbed at the same time.
+	return this->_FinishFrame(raw, false);
+}
+
+void CamImpl_OpenCVBase::_StartGrabber()
+{
+	std::lock_guard<std::mutex> guard(this->grabMutex);
+	if(this->grabRunning)
+		return;
+
+	this->grabSeq		= 0;
+	this->retrievedSeq	= 0;
+	this->skippedCt		= 0;
+	this->grabInProgress	= false;
+	this->grabRunning	= true;
+	this->grabThread = std::thread(&CamImpl_OpenCVBase::_GrabThreadFn, this);
+}
+
+void CamImpl_OpenCVBase::_StopGrabber()
+{
+	{
+		std::lock_guard<std::mutex> guard(this->grabMutex);
+		if(!this->grabRunning)
+			return;
+
+		this->grabRunning = false;
+	}
+	this->grabCond.notify_all();
+
+	// If the grabber is blocked on a grab, this waits for it to finish.
+	// Network streams are opened with a read timeout to bound that.
+	if(this->grabThread.joinable())
+		this->grabThread.join();
+
+	// The stream is about to be released, and the preferences they applied
+	// are set again by InitCapture() when it's reopened.
+	std::lock_guard<std::mutex> guard(this->grabMutex);
+	this->pendingStreamOps.clear();
+}
+
+void CamImpl_OpenCVBase::_GrabThreadFn()
+{
+	std::unique_lock<std::mutex> lock(this->grabMutex);
+	while(this->grabRunning)
+	{
+		// If polling is waiting on the frame we already have, let it take
+		// it before grabbing over it.
+		this->grabCond.wait(
+			lock, 
+			[this]
+			{ 
+				return 
+					!this->grabRunning || 
+					!this->retrieveWaiting || 
+					this->grabSeq == this->retrievedSeq; 
+			});
+
+		if(!this->grabRunning)
+			break;
+
+		for(std::function<void()>& op : this->pendingStreamOps)
+			op();
+
+		this->pendingStreamOps.clear();
+
+		// Grab without the lock, so a grab blocked on a stalled stream 
+		// doesn't hold up setting properties, polling, or stopping.
+		this->grabInProgress = true;
+		lock.unlock();
+
+		bool grabbed = this->ocvStream->grab();
+		std::chrono::steady_clock::time_point grabbedTime = std::chrono::steady_clock::now();
+		double posMS = grabbed ? this->ocvStream->get(cv::CAP_PROP_POS_MSEC) : 0.0;
+
+		lock.lock();
+		this->grabInProgress = false;
+		if(grabbed)
+		{
+			if(this->grabSeq > this->retrievedSeq)
+				++this->skippedCt;
+
+			++this->grabSeq;
+			this->grabTime	= grabbedTime;
+			this->grabPosMS	= posMS;
+		}
+
+		lock.unlock();
+		this->grabCond.notify_all();
+
+		// Stream errors are left for the owner to detect from polling
+		// timing out.
+		if(!grabbed)
+			std::this_thread::sleep_for(std::chrono::milliseconds(msGrabRetry));
+
+		lock.lock();
+	}
+}
+
+bool CamImpl_OpenCVBase::_RetrieveNewest(cv::Mat& raw)
+{
+	this->retrieveWaiting = true;
+
+	std::unique_lock<std::mutex> lock(this->grabMutex);
+	bool ready = this->grabCond.wait_for(
+		lock, 
+		std::chrono::milliseconds(msGrabTimeout),
+		[this]
+		{ 
+			return 
+				!this->grabRunning || 
+				(this->grabSeq > this->retrievedSeq && !this->grabInProgress); 
+		});
+
+	bool retrieved = false;
+	if(ready && this->grabRunning)
+	{
+		retrieved = this->ocvStream->retrieve(raw);
+		this->retrievedSeq = this->grabSeq;
+
+		if(retrieved)
+			this->_UpdateFrameAge(this->grabPosMS, this->grabTime);
+	}
+
+	this->retrieveWaiting = false;
+	lock.unlock();
+	this->grabCond.notify_all();
+
+	return retrieved;
+}
+
+bool CamImpl_OpenCVBase::_UseStreamBetweenGrabs(const std::function<bool()>& op)
+{
+	std::unique_lock<std::mutex> lock(this->grabMutex);
+	if(!this->grabRunning)
+		return op();
+
+	bool idle = this->grabCond.wait_for(
+		lock, 
+		std::chrono::milliseconds(msGrabTimeout),
+		[this]{ return !this->grabRunning || !this->grabInProgress; });
+
+	if(idle)
+		return op();
+
+	this->pendingStreamOps.push_back([op]{ op(); });
+	return true;
+}
+
+void CamImpl_OpenCVBase::_UpdateFrameAge(double posMS, std::chrono::steady_clock::time_point received)
+{
+	typedef std::chrono::duration<double, std::milli> MSDuration;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	// Without a timestamp, the most we know is how long the frame waited
+	// since it was received.
+	double heldMS = MSDuration(now - received).count();
+	if(posMS <= 0.0)
+	{
+		this->lastFrameAgeMS = heldMS;
+		return;
+	}
+
+	if(this->monotonicTimestamps)
+	{
+		// steady_clock is also the monotonic clock.
+		this->lastFrameAgeMS = std::max(0.0, MSDuration(now.time_since_epoch()).count() - posMS);
+		return;
+	}
+
+	double offsetMS = MSDuration(received.time_since_epoch()).count() - posMS;
+	if(this->prevPosMS < 0.0 || posMS < this->prevPosMS || offsetMS < this->minTimestampOffsetMS)
+		this->minTimestampOffsetMS = offsetMS;
+
+	this->prevPosMS = posMS;
+	this->lastFrameAgeMS = (offsetMS - this->minTimestampOffsetMS) + heldMS;
+}
+
+bool CamImpl_OpenCVBase::_ConvertFrame(const cv::Mat& raw, cv::Mat& out, bool pipelined)
+{
+	if(raw.empty())
+		return false;
+
+	// Compressed frames come through as a single row of bytes. If they
+	// don't, the backend decoded them for us anyways.
+	if(this->decodeWorker.IsRunning() && raw.rows == 1 && raw.type() == CV_8UC1)
+	{
+		if(!pipelined)
+		{
+			out = cv::imdecode(
+				raw, 
+				this->captureFormat != CaptureFormat::BGR ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR);
+
+			return !out.empty();
+		}
+
+		this->decodeWorker.Submit(raw);
+		return this->decodeWorker.GetDecoded(out, msDecodeTimeout);
+	}
+
+	if(this->captureFormat == CaptureFormat::BGR)
+		out = raw;
+	else
+		this->_ExtractLuma(raw, out);
+
+	return !out.empty();
+}
+
+void CamImpl_OpenCVBase::_ExtractLuma(const cv::Mat& raw, cv::Mat& luma)
+{
+	if(raw.empty())
+		return;
+
+	switch(raw.channels())
+	{
+	case 1:
+		if(this->captureFormat == CaptureFormat::YUYV && raw.rows == 1)
+		{
+			// Some backends hand back the unconverted buffer as a single
+			// row of bytes instead of a 2 channel image.
+			int width	= (int)this->ocvStream->get(cv::CAP_PROP_FRAME_WIDTH);
+			int height	= (int)this->ocvStream->get(cv::CAP_PROP_FRAME_HEIGHT);
+			if(width > 0 && height > 0 && raw.total() == (size_t)width * height * 2)
+			{
+				cv::extractChannel(raw.reshape(2, height), luma, 0);
+				return;
+			}
+		}
+		// GREY frames are already what we want.
+		luma = raw;
+		return;
+
+	case 2:
+		// YUYV interleaves as (Y0 U) (Y1 V), so the first channel of
+		// every pixel is its luma.
+		cv::extractChannel(raw, luma, 0);
+		return;
+
+	default:
+		// The backend ignored the request and converted the frame anyways.
+		if(!this->reportedFormatFallback)
+		{
+			std::cout << "Camera did not provide the " << to_string(this->captureFormat) << " capture format, converting " << raw.channels() << " channel frames to greyscale instead." << std::endl;
+			this->reportedFormatFallback = true;
+		}
+		cv::cvtColor(raw, luma, (raw.channels() == 4) ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+	}
+}
+
 bool CamImpl_OpenCVBase::InitCapture(cv::VideoCapture* capture)
 {
 	// Keep the buffer as small as possible so while the video
@@ -56,15 +391,113 @@ bool CamImpl_OpenCVBase::InitCapture(cv::VideoCapture* capture)
 	// will be as low as possible.
 	capture->set(cv::CAP_PROP_BUFFERSIZE, 1);
 
-	// Standardize the FPS rate.
-	capture->set(cv::CAP_PROP_FPS, 30);
+	if(!this->negotiateMode || !this->IsCaptureDevice() || !this->_NegotiateMode(capture))
+	{
+		// Standardize the FPS rate.
+		capture->set(cv::CAP_PROP_FPS, this->prefFPS);
+
+		// The pixel format is set before the dimensions, as some backends
+		// renegotiate the format when the dimensions change.
+		switch(this->captureFormat)
+		{
+		case CaptureFormat::BGR:
+			break;
+
+		case CaptureFormat::YUYV:
+			capture->set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('Y', 'U', 'Y', 'V'));
+			// Keep the raw frames, instead of having the backend convert them
+			// to BGR for us to convert back to a single channel.
+			capture->set(cv::CAP_PROP_CONVERT_RGB, 0);
+			break;
+
+		case CaptureFormat::Grey:
+			capture->set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('G', 'R', 'E', 'Y'));
+			capture->set(cv::CAP_PROP_CONVERT_RGB, 0);
+			break;
+		}
+
+		if(this->prefWidth != 0)
+			capture->set(cv::CAP_PROP_FRAME_WIDTH, this->prefWidth);
+
+		if(this->prefHeight != 0)
+			capture->set(cv::CAP_PROP_FRAME_HEIGHT, this->prefHeight);
+	}
 
-	if(this->prefWidth != 0)
-		capture->set(cv::CAP_PROP_FRAME_WIDTH, this->prefWidth);
+	// Record what the backend actually went with, which isn't necessarily
+	// what was asked for.
+	this->monotonicTimestamps = capture->isOpened() && capture->getBackendName() == "V4L2";
 
-	if(this->prefHeight != 0)
-		capture->set(cv::CAP_PROP_FRAME_HEIGHT, this->prefHeight);
+	CaptureMode opened;
+	opened.fourcc	= (int)capture->get(cv::CAP_PROP_FOURCC);
+	opened.width	= (int)capture->get(cv::CAP_PROP_FRAME_WIDTH);
+	opened.height	= (int)capture->get(cv::CAP_PROP_FRAME_HEIGHT);
+	opened.fps		= capture->get(cv::CAP_PROP_FPS);
+	{
+		std::lock_guard<std::mutex> guard(this->activeModeMutex);
+		this->activeMode = opened;
+	}
+	std::cout << "Opened capture in mode " << opened.ToString() << std::endl;
+
+	if(opened.IsCompressed())
+	{
+		// Have the compressed frames handed to us as-is, so they can be 
+		// decoded off of the polling thread. This also lets a recorded MJPEG 
+		// file stand in for a camera, through FFmpeg's raw packet mode.
+		capture->set(cv::CAP_PROP_CONVERT_RGB, 0);
+		if(capture->isOpened() && capture->getBackendName() == "FFMPEG")
+			capture->set(cv::CAP_PROP_FORMAT, -1);
+
+		this->decodeWorker.Start(this->captureFormat != CaptureFormat::BGR);
+	}
+
+	this->ApplyExposure(capture);
+	return true;
+}
+
+bool CamImpl_OpenCVBase::_NegotiateMode(cv::VideoCapture* capture)
+{
+	std::vector<int> fourccs = CaptureModeNegotiator::CandidateFourCCs(this->captureFormat);
 
+	std::vector<CaptureMode> modes = CaptureModeNegotiator::EnumerateV4L2(this->GetDeviceNode());
+	if(modes.empty())
+	{
+		modes = CaptureModeNegotiator::Probe(
+			capture, 
+			fourccs, 
+			this->prefWidth, 
+			this->prefHeight, 
+			this->prefFPS);
+	}
+
+	CaptureMode chosen;
+	if(!CaptureModeNegotiator::Choose(modes, fourccs, this->prefWidth, this->prefHeight, this->prefFPS, chosen))
+	{
+		std::cout << "Could not negotiate a capture mode from " << modes.size() << " modes, using the requested settings as-is." << std::endl;
+		return false;
+	}
+
+	if(this->prefWidth != 0 && this->prefHeight != 0 && (chosen.width != this->prefWidth || chosen.height != this->prefHeight))
+		std::cout << "Capture device does not support " << this->prefWidth << "x" << this->prefHeight << ", using the closest mode." << std::endl;
+
+	// The pixel format is set before the dimensions, as some backends
+	// renegotiate the format when the dimensions change.
+	capture->set(cv::CAP_PROP_FOURCC, chosen.fourcc);
+	capture->set(cv::CAP_PROP_FRAME_WIDTH, chosen.width);
+	capture->set(cv::CAP_PROP_FRAME_HEIGHT, chosen.height);
+	capture->set(cv::CAP_PROP_FPS, std::min(this->prefFPS, chosen.fps));
+
+	// Keep uncompressed frames raw for single channel capture formats, 
+	// instead of having the backend convert them to BGR for us to convert
+	// back to a single channel.
+	if(!chosen.IsCompressed() && this->captureFormat != CaptureFormat::BGR)
+		capture->set(cv::CAP_PROP_CONVERT_RGB, 0);
+
+	std::cout << "Negotiated capture mode " << chosen.ToString() << " from " << modes.size() << " modes." << std::endl;
+	return true;
+}
+
+void CamImpl_OpenCVBase::ApplyExposure(cv::VideoCapture* capture)
+{
 	// Note that setting the exposure time may not guarantee it's
 	// used as requested. It's up to OpenCV and the implementation
 	// to (be able to) honor this value.
@@ -95,7 +528,6 @@ bool CamImpl_OpenCVBase::InitCapture(cv::VideoCapture* capture)
 		// to specific subclasses, mainly ther OCV_USB and OCV_HWPath.
 		capture->set(cv::CAP_PROP_AUTO_EXPOSURE, 1);
 	}
-	return true;
 }
 
 void CamImpl_OpenCVBase::InitCapture()
@@ -115,11 +547,116 @@ void CamImpl_OpenCVBase::DelegatedInjectIntoDicom(DcmDataset* dicomData)
 {
 	// TODO: Placeholder, this should be more specific.
 	dicomData->putAndInsertString(DCM_SensorName, "OpenCV Stream");
+
+	CaptureMode mode = this->GetActiveMode();
+	if(mode.width != 0)
+		InsertAcquisitionContextInfo(dicomData, "capture_mode", mode.ToString());
+}
+
+CaptureMode CamImpl_OpenCVBase::GetActiveMode()
+{
+	std::lock_guard<std::mutex> guard(this->activeModeMutex);
+	return this->activeMode;
+}
+
+double CamImpl_OpenCVBase::GetLastFrameAgeMS()
+{
+	return this->lastFrameAgeMS;
+}
+
+long long CamImpl_OpenCVBase::GetSkippedFrameCt()
+{
+	return this->skippedCt;
+}
+
+bool CamImpl_OpenCVBase::SetParam(StreamParams paramid, double value)
+{
+	switch(paramid)
+	{
+	case StreamParams::ExposureMicroseconds:
+		this->exposureTime = (int)value;
+		if(this->IsStreamAllocated())
+		{
+			this->_UseStreamBetweenGrabs(
+				[this]
+				{
+					this->ApplyExposure(this->ocvStream);
+					return true;
+				});
+		}
+		return true;
+
+	case StreamParams::StreamFPS:
+		{
+			this->prefFPS = value;
+			if(!this->IsStreamAllocated())
+				return true;
+
+			// The mode was negotiated for the old frame rate.
+			if(this->negotiateMode && this->IsCaptureDevice())
+				return false;
+
+			// Files and network streams deliver at their own rate, so this 
+			// is only a request.
+			double fps = this->prefFPS;
+			this->_UseStreamBetweenGrabs(
+				[this, fps]
+				{
+					this->ocvStream->set(cv::CAP_PROP_FPS, fps);
+					return true;
+				});
+			return true;
+		}
+
+	case StreamParams::StreamWidth:
+	case StreamParams::StreamHeight:
+		{
+			int& prefDim = 
+				(paramid == StreamParams::StreamWidth) ? 
+					this->prefWidth : 
+					this->prefHeight;
+
+			prefDim = (int)value;
+			if(!this->IsStreamAllocated() || prefDim == 0)
+				return true;
+
+			// The mode was negotiated for the old resolution, it needs to
+			// reconnect to negotiate a new one.
+			if(this->negotiateMode && this->IsCaptureDevice())
+				return false;
+
+			// Not all backends can resize a stream that's already open. 
+			// Check that the change actually stuck, and if not, let the
+			// owner know it'll need to reconnect to apply it.
+			cv::VideoCaptureProperties prop = 
+				(paramid == StreamParams::StreamWidth) ? 
+					cv::CAP_PROP_FRAME_WIDTH : 
+					cv::CAP_PROP_FRAME_HEIGHT;
+
+			int dim = prefDim;
+			return this->_UseStreamBetweenGrabs(
+				[this, prop, dim]
+				{
+					if(!this->ocvStream->set(prop, dim))
+						return false;
+
+					return (int)this->ocvStream->get(prop) == dim;
+				});
+		}
+
+	default:
+		break;
+	}
+	return this->ICamImpl::SetParam(paramid, value);
 }
 
 bool CamImpl_OpenCVBase::PullOptions(const cvgCamFeedLocs& opts)
 {
 	this->exposureTime = opts.videoExposureTime;
+	this->captureFormat = opts.captureFormat;
+	this->negotiateMode = opts.negotiateCaptureMode;
+	this->grabberMode = opts.lowLatencyGrab;
+	this->reportedFormatFallback = false;
 
 	return this->ICamImpl::PullOptions(opts);
 }
\ No newline at end of file
@@ -3,6 +3,16 @@
 #include "ICamImpl.h"
 #include <opencv2/videoio.hpp>
 #include "../../Utils/cvgAssert.h"
+#include "../../Utils/CaptureFormat.h"
+#include "CaptureMode.h"
+#include "MJPEGDecodeWorker.h"
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <vector>
 
 /// <summary>
 /// A base class for all ICamImpl implementations that will
@@ -25,6 +35,202 @@ private:
 	/// </summary>
 	int exposureTime = 0;
 
+	/// <summary>
+	/// The pixel format to request from the device.
+	/// </summary>
+	CaptureFormat captureFormat = CaptureFormat::BGR;
+
+	/// <summary>
+	/// If true, the device didn't deliver the requested single channel format
+	/// and the frames are being converted, which has already been reported.
+	/// </summary>
+	bool reportedFormatFallback = false;
+
+	/// <summary>
+	/// If true, capture devices are opened with the best supported mode
+	/// for the requested resolution and frame rate.
+	/// </summary>
+	bool negotiateMode = true;
+
+	/// <summary>
+	/// Guards activeMode.
+	/// </summary>
+	std::mutex activeModeMutex;
+
+	/// <summary>
+	/// The mode the stream was opened with, as reported by the backend.
+	/// </summary>
+	CaptureMode activeMode;
+
+	/// <summary>
+	/// Decodes frames when the stream is opened in a compressed mode.
+	/// </summary>
+	MJPEGDecodeWorker decodeWorker;
+
+	/// <summary>
+	/// If true, a grabber thread continuously grabs frames, and polling
+	/// retrieves the newest one. This keeps backends that buffer frames
+	/// internally (such as FFmpeg for network streams) from handing out 
+	/// old frames.
+	/// </summary>
+	bool grabberMode = false;
+
+	std::thread grabThread;
+
+	/// <summary>
+	/// While the grabber thread is running, guards ocvStream (except while
+	/// grabInProgress is set), and everything below.
+	/// </summary>
+	std::mutex grabMutex;
+
+	/// <summary>
+	/// Notified when a frame is grabbed or retrieved, or the grabber 
+	/// is stopped.
+	/// </summary>
+	std::condition_variable grabCond;
+
+	bool grabRunning = false;
+
+	/// <summary>
+	/// Set while the grabber thread is in a grab, which it does without 
+	/// grabMutex locked, so a grab blocked on a stalled stream doesn't hold
+	/// up everything else. ocvStream can't be used by other threads while
+	/// it's set.
+	/// </summary>
+	bool grabInProgress = false;
+
+	/// <summary>
+	/// Stream property changes that couldn't wait for a grab to finish,
+	/// for the grabber thread to apply before its next grab.
+	/// </summary>
+	std::vector<std::function<void()>> pendingStreamOps;
+
+	/// <summary>
+	/// Set while polling is waiting to retrieve a frame, so the grabber 
+	/// thread steps aside instead of starting a new grab when there's 
+	/// already a new frame.
+	/// </summary>
+	std::atomic_bool retrieveWaiting = false;
+
+	/// <summary>
+	/// The number of frames grabbed, and the grab count when a frame was
+	/// last retrieved.
+	/// </summary>
+	long long grabSeq = 0;
+	long long retrievedSeq = 0;
+
+	/// <summary>
+	/// The number of grabbed frames that were grabbed over before being
+	/// retrieved.
+	/// </summary>
+	std::atomic<long long> skippedCt = 0;
+
+	/// <summary>
+	/// When the newest frame was grabbed, and the backend's timestamp
+	/// for it (CAP_PROP_POS_MSEC).
+	/// </summary>
+	std::chrono::steady_clock::time_point grabTime;
+	double grabPosMS = 0.0;
+
+	/// <summary>
+	/// If true, the backend timestamps frames with the monotonic clock
+	/// (V4L2). Else, timestamps are relative to the start of the stream.
+	/// </summary>
+	bool monotonicTimestamps = false;
+
+	/// <summary>
+	/// For relative timestamps, the smallest difference seen between when
+	/// a frame was received and its timestamp, i.e., the frame that arrived
+	/// the least late. Frame ages are measured against this.
+	/// </summary>
+	double minTimestampOffsetMS = 0.0;
+
+	/// <summary>
+	/// For relative timestamps, the timestamp of the previous frame. If a
+	/// timestamp goes backwards, the stream restarted and minTimestampOffsetMS
+	/// is reset.
+	/// </summary>
+	double prevPosMS = -1.0;
+
+	/// <summary>
+	/// The age of the last polled frame, or negative if unknown.
+	/// </summary>
+	std::atomic<double> lastFrameAgeMS = -1.0;
+
+	/// <summary>
+	/// Get the luma of a frame captured with a single channel capture format, 
+	/// as a single channel image.
+	/// </summary>
+	/// <param name="raw">The frame as received from the VideoCapture.</param>
+	/// <param name="luma">The output single channel image.</param>
+	void _ExtractLuma(const cv::Mat& raw, cv::Mat& luma);
+
+	/// <summary>
+	/// Choose and set the capture mode for the requested resolution, frame
+	/// rate, and capture format.
+	/// </summary>
+	/// <param name="capture">The VideoCapture to set the mode on.</param>
+	/// <returns>False if no mode could be chosen, and nothing was set.</returns>
+	bool _NegotiateMode(cv::VideoCapture* capture);
+
+	/// <summary>
+	/// Convert a frame, as received from the VideoCapture, into what's 
+	/// returned from polling.
+	/// </summary>
+	/// <param name="raw">The frame as received from the VideoCapture.</param>
+	/// <param name="out">The output frame.</param>
+	/// <param name="pipelined">
+	/// If true, compressed frames are decoded pipelined on the decode worker,
+	/// and the frame returned is the one received before raw. Else they're
+	/// decoded immediately, so the frame returned is always raw's.
+	/// </param>
+	/// <returns>False if there's no frame to return.</returns>
+	bool _ConvertFrame(const cv::Mat& raw, cv::Mat& out, bool pipelined);
+
+	/// <summary>
+	/// Convert and flip a frame, as received from the VideoCapture, into
+	/// a new frame to return from polling.
+	/// </summary>
+	/// <returns>The new frame, or nullptr if there's no frame to return.</returns>
+	cv::Ptr<cv::Mat> _FinishFrame(const cv::Mat& raw, bool pipelined);
+
+	void _StartGrabber();
+	void _StopGrabber();
+	void _GrabThreadFn();
+
+	/// <summary>
+	/// Wait for the grabber thread to grab a frame that hasn't been 
+	/// retrieved yet, and retrieve it.
+	/// </summary>
+	/// <param name="raw">The frame as received from the VideoCapture.</param>
+	/// <returns>False if no new frame was grabbed in time.</returns>
+	bool _RetrieveNewest(cv::Mat& raw);
+
+	/// <summary>
+	/// Use ocvStream between the grabber thread's grabs, for setting stream
+	/// properties. If the grabber isn't running, op is run immediately.
+	/// 
+	/// If a grab doesn't finish in time (a stalled network stream can block
+	/// for the backend's read timeout), op is left for the grabber thread
+	/// to run before its next grab, and its result isn't known.
+	/// </summary>
+	/// <param name="op">Uses ocvStream, and returns if it succeeded.</param>
+	/// <returns>The result of op, or true if it was left for the grabber thread.</returns>
+	bool _UseStreamBetweenGrabs(const std::function<bool()>& op);
+
+	/// <summary>
+	/// Update lastFrameAgeMS for a frame that was just received.
+	/// 
+	/// If the backend timestamps frames with the monotonic clock (V4L2), the
+	/// age is absolute. Otherwise the timestamps are relative to the start of
+	/// the stream, and the age is how much later the frame arrived than the
+	/// least late frame of the stream. That doesn't include any delay every
+	/// frame has, but it does catch frames piling up in backend buffers.
+	/// </summary>
+	/// <param name="posMS">The backend's timestamp for the frame.</param>
+	/// <param name="received">When the frame was received from the backend.</param>
+	void _UpdateFrameAge(double posMS, std::chrono::steady_clock::time_point received);
+
 protected:
 	bool InitializeImpl() override;
 	bool ShutdownImpl() override;
@@ -59,13 +265,34 @@ protected:
 	/// </summary>
 	void InitCapture();
 
+	/// <summary>
+	/// Apply this->exposureTime to a VideoCapture. This is part of 
+	/// InitCapture(), but can also be called on a running capture.
+	/// </summary>
+	/// <param name="capture">The VideoCapture to set the exposure on.</param>
+	void ApplyExposure(cv::VideoCapture* capture);
+
 	inline bool IsStreamAllocated()
 	{ return this->ocvStream != nullptr; }
 
 	inline void AssertStreamNull()
 	{ cvgAssert(!this->IsStreamAllocated(),"AssertStreamNull failed"); }
 
-	bool PullOptions(const cvgCamFeedLocs& opts);
+	bool PullOptions(const cvgCamFeedLocs& opts) override;
+
+	/// <summary>
+	/// Query if the VideoCapture is a local capture device that supports
+	/// choosing its mode, as opposed to a file or network stream.
+	/// </summary>
+	virtual bool IsCaptureDevice() const
+	{ return false; }
+
+	/// <summary>
+	/// The V4L2 device node, if known, to list the device's supported 
+	/// modes from. If empty, the modes are probed instead.
+	/// </summary>
+	virtual std::string GetDeviceNode() const
+	{ return ""; }
 
 public:
 	// No poll type here, that's the responsibility for 
@@ -75,4 +302,23 @@ public:
 	bool IsValid() override;
 
 	void DelegatedInjectIntoDicom(DcmDataset* dicomData) override;
+
+	/// <summary>
+	/// Get the mode the stream was opened with.
+	/// </summary>
+	CaptureMode GetActiveMode();
+
+	double GetLastFrameAgeMS() override;
+	long long GetSkippedFrameCt() override;
+
+	/// <summary>
+	/// Splitting the grab is only supported without the grabber thread, 
+	/// which does its own grabbing.
+	/// </summary>
+	bool SupportsSplitGrab() override;
+	bool GrabFrame() override;
+	double GetLastGrabTimeMS() override;
+	cv::Ptr<cv::Mat> RetrieveFrame() override;
+
+	bool SetParam(StreamParams paramid, double value) override;
 };
\ No newline at end of file
@@ -0,0 +1,541 @@
+#include "CamImpl_Pipe.h"
+#include "../IManagedCam.h"
+#include <iostream>
+#include <algorithm>
+
+#if _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <unistd.h>
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <signal.h>
+	#include <sys/types.h>
+	#include <sys/wait.h>
+	#include <cerrno>
+#endif
+
+// How long polling waits for the reader thread to read a new frame.
+const int msFrameTimeout = 250;
+
+// How long the reader waits between checks for data or being stopped.
+const int msReadWait = 50;
+
+// If the program stops writing in the middle of a frame for this long,
+// the rest of the frame is given up on.
+const int msMidFrameStall = 1000;
+
+// How long to wait before restarting the program after it exits.
+const int msRestartBackoff = 500;
+
+// How long the program has to exit after being asked to, before it's killed.
+const int msStopGrace = 500;
+
+// The most frame buffers to keep pooled.
+const size_t maxPooledBuffers = 6;
+
+// The pipe buffer size to request, so a reasonable frame size can be
+// written without the program having to wait on us between reads.
+const int pipeBufferBytes = 1 << 20;
+
+typedef std::chrono::duration<double, std::milli> MSDuration;
+
+CamImpl_Pipe::CamImpl_Pipe(const std::string& cmd)
+{
+	this->cmd = cmd;
+}
+
+CamImpl_Pipe::~CamImpl_Pipe()
+{
+	// Shutdown here instead of leaving it to ~ICamImpl(), while
+	// ShutdownImpl() can still stop the reader thread.
+	this->Shutdown();
+}
+
+bool CamImpl_Pipe::InitializeImpl()
+{
+	return true;
+}
+
+bool CamImpl_Pipe::ShutdownImpl()
+{
+	this->DeactivateImpl();
+	return true;
+}
+
+bool CamImpl_Pipe::ActivateImpl()
+{
+	if(this->readRunning)
+		return true;
+
+	if(this->cmd.empty())
+	{
+		std::cout << "No external pipe command to stream from." << std::endl;
+		return false;
+	}
+
+	if(this->width <= 0 || this->height <= 0 || this->channels < 1 || this->channels > 4)
+	{
+		std::cout << "Invalid external pipe frame layout " <<
+			this->width << "x" << this->height << "x" << this->channels << std::endl;
+		return false;
+	}
+
+	if(!this->_SpawnChild())
+		return false;
+
+	{
+		std::lock_guard<std::mutex> guard(this->frameMutex);
+		this->newestFrame = nullptr;
+		this->stats = PipeStats();
+	}
+	this->lastFrameAgeMS = -1.0;
+
+	this->readRunning = true;
+	this->readThread = std::thread(&CamImpl_Pipe::_ReadThreadFn, this);
+	return true;
+}
+
+bool CamImpl_Pipe::DeactivateImpl()
+{
+	this->readRunning = false;
+	this->frameCond.notify_all();
+
+	// The reader checks if it's been stopped at least every msReadWait.
+	if(this->readThread.joinable())
+		this->readThread.join();
+
+	this->_StopChild();
+	this->bufferPool.clear();
+
+	std::lock_guard<std::mutex> guard(this->frameMutex);
+	this->newestFrame = nullptr;
+	return true;
+}
+
+cv::Ptr<cv::Mat> CamImpl_Pipe::PollFrameImpl()
+{
+	std::unique_lock<std::mutex> lock(this->frameMutex);
+	this->frameCond.wait_for(
+		lock,
+		std::chrono::milliseconds(msFrameTimeout),
+		[this]{ return !this->readRunning || this->newestFrame != nullptr; });
+
+	if(this->newestFrame == nullptr)
+		return nullptr;
+
+	cv::Ptr<cv::Mat> ret = this->newestFrame;
+	this->newestFrame = nullptr;
+	this->lastFrameAgeMS = MSDuration(std::chrono::steady_clock::now() - this->newestTime).count();
+	return ret;
+}
+
+void CamImpl_Pipe::_ReadThreadFn()
+{
+	const size_t frameBytes = this->FrameBytes();
+
+	while(this->readRunning)
+	{
+		if(!this->_HasChild())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(msRestartBackoff));
+			if(!this->readRunning)
+				break;
+
+			if(!this->_SpawnChild())
+				continue;
+
+			std::lock_guard<std::mutex> guard(this->frameMutex);
+			++this->stats.restartCt;
+		}
+
+		cv::Ptr<cv::Mat> buffer = this->_AcquireBuffer();
+
+		std::chrono::steady_clock::time_point firstByteTime;
+		size_t read = this->_ReadFull(buffer->data, frameBytes, firstByteTime);
+
+		if(!this->readRunning)
+			break;
+
+		if(read == frameBytes)
+		{
+			this->UtilToFlipMatInOpenCV(*buffer);
+			{
+				std::lock_guard<std::mutex> guard(this->frameMutex);
+				if(this->newestFrame != nullptr)
+					++this->stats.skippedCt;
+
+				this->newestFrame = buffer;
+				this->newestTime = firstByteTime;
+				++this->stats.frameCt;
+				this->stats.bytesRead += read;
+			}
+			this->frameCond.notify_all();
+			continue;
+		}
+
+		// The program exited, or stalled in the middle of a frame. There's
+		// nothing in a raw stream to find where the next frame starts, so
+		// the only way to get back in sync is to start from the beginning
+		// of a new stream.
+		{
+			std::lock_guard<std::mutex> guard(this->frameMutex);
+			this->stats.bytesRead += read;
+			if(read > 0)
+				++this->stats.partialCt;
+		}
+
+		if(read > 0)
+			std::cout << "External pipe stream short by " << (frameBytes - read) << " bytes, restarting " << this->cmd << std::endl;
+		else
+			std::cout << "External pipe stream ended, restarting " << this->cmd << std::endl;
+
+		this->_StopChild();
+	}
+}
+
+cv::Ptr<cv::Mat> CamImpl_Pipe::_AcquireBuffer()
+{
+	const int type = CV_8UC(this->channels);
+
+	for(cv::Ptr<cv::Mat>& pooled : this->bufferPool)
+	{
+		// Anything else holding the frame (or its pixels) means it's still
+		// in use downstream.
+		if(pooled.use_count() != 1)
+			continue;
+
+		if(pooled->u != nullptr && pooled->u->refcount != 1)
+			continue;
+
+		// If someone replaced the pixels, this reallocates them.
+		pooled->create(this->height, this->width, type);
+		return pooled;
+	}
+
+	cv::Ptr<cv::Mat> ret = new cv::Mat(this->height, this->width, type);
+	if(this->bufferPool.size() < maxPooledBuffers)
+		this->bufferPool.push_back(ret);
+	else
+	{
+		std::lock_guard<std::mutex> guard(this->frameMutex);
+		++this->stats.unpooledCt;
+	}
+
+	return ret;
+}
+
+#if _WIN32
+
+bool CamImpl_Pipe::_SpawnChild()
+{
+	SECURITY_ATTRIBUTES sa;
+	sa.nLength				= sizeof(SECURITY_ATTRIBUTES);
+	sa.bInheritHandle		= TRUE;
+	sa.lpSecurityDescriptor	= NULL;
+
+	HANDLE readEnd = NULL;
+	HANDLE writeEnd = NULL;
+	if(!CreatePipe(&readEnd, &writeEnd, &sa, pipeBufferBytes))
+	{
+		std::cout << "Failed to create pipe for " << this->cmd << std::endl;
+		return false;
+	}
+	// Only the program's end should be inherited.
+	SetHandleInformation(readEnd, HANDLE_FLAG_INHERIT, 0);
+
+	STARTUPINFOA si;
+	ZeroMemory(&si, sizeof(si));
+	si.cb			= sizeof(si);
+	si.dwFlags		= STARTF_USESTDHANDLES;
+	si.hStdInput	= GetStdHandle(STD_INPUT_HANDLE);
+	si.hStdOutput	= writeEnd;
+	si.hStdError	= GetStdHandle(STD_ERROR_HANDLE);
+
+	PROCESS_INFORMATION pi;
+	ZeroMemory(&pi, sizeof(pi));
+
+	// The program is run directly instead of through cmd.exe, so stopping
+	// the process stops the program itself.
+	std::vector<char> cmdLine(this->cmd.begin(), this->cmd.end());
+	cmdLine.push_back('\0');
+
+	BOOL created =
+		CreateProcessA(
+			NULL,
+			cmdLine.data(),
+			NULL,
+			NULL,
+			TRUE,
+			CREATE_NO_WINDOW,
+			NULL,
+			NULL,
+			&si,
+			&pi);
+
+	CloseHandle(writeEnd);
+	if(!created)
+	{
+		std::cout << "Failed to start " << this->cmd << std::endl;
+		CloseHandle(readEnd);
+		return false;
+	}
+
+	CloseHandle(pi.hThread);
+	this->childProcess	= pi.hProcess;
+	this->childStdout	= readEnd;
+	return true;
+}
+
+void CamImpl_Pipe::_StopChild()
+{
+	if(this->childProcess != nullptr)
+	{
+		if(WaitForSingleObject((HANDLE)this->childProcess, 0) == WAIT_TIMEOUT)
+		{
+			TerminateProcess((HANDLE)this->childProcess, 0);
+			WaitForSingleObject((HANDLE)this->childProcess, msStopGrace);
+		}
+		CloseHandle((HANDLE)this->childProcess);
+		this->childProcess = nullptr;
+	}
+
+	if(this->childStdout != nullptr)
+	{
+		CloseHandle((HANDLE)this->childStdout);
+		this->childStdout = nullptr;
+	}
+}
+
+bool CamImpl_Pipe::_HasChild() const
+{
+	return this->childStdout != nullptr;
+}
+
+size_t CamImpl_Pipe::_ReadFull(
+	unsigned char* dst,
+	size_t len,
+	std::chrono::steady_clock::time_point& firstByteTime)
+{
+	size_t read = 0;
+	std::chrono::steady_clock::time_point lastData;
+
+	while(read < len && this->readRunning)
+	{
+		// Anonymous pipes can't wait with a timeout, so check what's
+		// available before blocking on it.
+		DWORD avail = 0;
+		if(!PeekNamedPipe((HANDLE)this->childStdout, NULL, 0, NULL, &avail, NULL))
+			break;
+
+		if(avail == 0)
+		{
+			if(read > 0 && MSDuration(std::chrono::steady_clock::now() - lastData).count() >= msMidFrameStall)
+				break;
+
+			Sleep(1);
+			continue;
+		}
+
+		DWORD toRead = (DWORD)std::min<size_t>(len - read, avail);
+		DWORD got = 0;
+		if(!ReadFile((HANDLE)this->childStdout, dst + read, toRead, &got, NULL) || got == 0)
+			break;
+
+		lastData = std::chrono::steady_clock::now();
+		if(read == 0)
+			firstByteTime = lastData;
+
+		read += got;
+	}
+	return read;
+}
+
+#else
+
+bool CamImpl_Pipe::_SpawnChild()
+{
+	int fds[2];
+	if(pipe(fds) != 0)
+	{
+		std::cout << "Failed to create pipe for " << this->cmd << std::endl;
+		return false;
+	}
+
+	pid_t pid = fork();
+	if(pid < 0)
+	{
+		std::cout << "Failed to start " << this->cmd << std::endl;
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if(pid == 0)
+	{
+		// Give the program (and anything it spawns, if the command is a
+		// shell pipeline) its own process group, so they can be stopped
+		// together.
+		setpgid(0, 0);
+
+		dup2(fds[1], STDOUT_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+
+		execl("/bin/sh", "sh", "-c", this->cmd.c_str(), (char*)nullptr);
+		_exit(127);
+	}
+
+	close(fds[1]);
+	setpgid(pid, pid);
+
+#ifdef F_SETPIPE_SZ
+	// Linux pipes default to 64KB, which would take several round trips
+	// between the program and us per frame.
+	fcntl(fds[0], F_SETPIPE_SZ, pipeBufferBytes);
+#endif
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+
+	this->childPid		= pid;
+	this->childStdout	= fds[0];
+	return true;
+}
+
+void CamImpl_Pipe::_StopChild()
+{
+	if(this->childStdout != -1)
+	{
+		close(this->childStdout);
+		this->childStdout = -1;
+	}
+
+	if(this->childPid == -1)
+		return;
+
+	// Closing the pipe is usually enough for a program writing to it to
+	// exit, but ask (and then insist) in case it isn't.
+	kill(-this->childPid, SIGTERM);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	while(waitpid(this->childPid, nullptr, WNOHANG) == 0)
+	{
+		if(MSDuration(std::chrono::steady_clock::now() - start).count() >= msStopGrace)
+		{
+			kill(-this->childPid, SIGKILL);
+			waitpid(this->childPid, nullptr, 0);
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	this->childPid = -1;
+}
+
+bool CamImpl_Pipe::_HasChild() const
+{
+	return this->childStdout != -1;
+}
+
+size_t CamImpl_Pipe::_ReadFull(
+	unsigned char* dst,
+	size_t len,
+	std::chrono::steady_clock::time_point& firstByteTime)
+{
+	size_t read = 0;
+	std::chrono::steady_clock::time_point lastData;
+
+	while(read < len && this->readRunning)
+	{
+		pollfd pfd;
+		pfd.fd		= this->childStdout;
+		pfd.events	= POLLIN;
+		pfd.revents	= 0;
+
+		int ready = poll(&pfd, 1, msReadWait);
+		if(ready < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			break;
+		}
+
+		if(ready == 0)
+		{
+			if(read > 0 && MSDuration(std::chrono::steady_clock::now() - lastData).count() >= msMidFrameStall)
+				break;
+
+			continue;
+		}
+
+		// Read everything that's left of the frame at once, the pipe gives
+		// back as much of it as it has.
+		ssize_t got = ::read(this->childStdout, dst + read, len - read);
+		if(got < 0)
+		{
+			if(errno == EINTR || errno == EAGAIN)
+				continue;
+			break;
+		}
+
+		// End of stream, the program exited.
+		if(got == 0)
+			break;
+
+		lastData = std::chrono::steady_clock::now();
+		if(read == 0)
+			firstByteTime = lastData;
+
+		read += (size_t)got;
+	}
+	return read;
+}
+
+#endif
+
+VideoPollType CamImpl_Pipe::PollType()
+{
+	return VideoPollType::External;
+}
+
+bool CamImpl_Pipe::IsValid()
+{
+	// Program exits are handled by restarting it. If it stops producing
+	// frames altogether, the owner will see polling time out.
+	return this->readRunning;
+}
+
+bool CamImpl_Pipe::PullOptions(const cvgCamFeedLocs& opts)
+{
+	this->ICamImpl::PullOptions(opts);
+
+	this->cmd		= opts.externalPipeCmd;
+	this->width		= opts.pipeWidth;
+	this->height	= opts.pipeHeight;
+	this->channels	= opts.channelCtFromPipe;
+	return true;
+}
+
+void CamImpl_Pipe::DelegatedInjectIntoDicom(DcmDataset* dicomData)
+{
+	dicomData->putAndInsertString(DCM_SensorName, "External Pipe");
+	InsertAcquisitionContextInfo(dicomData, "pipe_cmd", this->cmd);
+}
+
+double CamImpl_Pipe::GetLastFrameAgeMS()
+{
+	return this->lastFrameAgeMS;
+}
+
+long long CamImpl_Pipe::GetSkippedFrameCt()
+{
+	std::lock_guard<std::mutex> guard(this->frameMutex);
+	return this->stats.skippedCt;
+}
+
+CamImpl_Pipe::PipeStats CamImpl_Pipe::GetStats()
+{
+	std::lock_guard<std::mutex> guard(this->frameMutex);
+	return this->stats;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "ICamImpl.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+/// <summary>
+/// A ICamImpl that spawns an external program (e.g., raspiyuv, ffmpeg,
+/// gst-launch, or a test generator) and reads raw frames from its stdout.
+///
+/// There's no handshaking with the program, so it's expected to write
+/// frames of exactly pipeWidth x pipeHeight x channelCtFromPipe bytes,
+/// with no headers or padding between them. 3 channel frames are expected
+/// to be in BGR order.
+///
+/// A reader thread reads each frame straight into a pooled frame buffer,
+/// and polling returns the newest frame. If the program exits, it's
+/// restarted.
+/// </summary>
+class CamImpl_Pipe : public ICamImpl
+{
+public:
+	/// <summary>
+	/// Counters of what's been read from the program, since activation.
+	/// </summary>
+	struct PipeStats
+	{
+		/// <summary>
+		/// The number of complete frames read.
+		/// </summary>
+		long long frameCt = 0;
+
+		/// <summary>
+		/// The number of bytes read, including discarded partial frames.
+		/// </summary>
+		long long bytesRead = 0;
+
+		/// <summary>
+		/// The number of frames that were read, but were replaced by a
+		/// newer frame before being polled.
+		/// </summary>
+		long long skippedCt = 0;
+
+		/// <summary>
+		/// The number of partial frames that were discarded, because the
+		/// program exited or stalled in the middle of a frame.
+		/// </summary>
+		long long partialCt = 0;
+
+		/// <summary>
+		/// The number of times the program was restarted.
+		/// </summary>
+		long long restartCt = 0;
+
+		/// <summary>
+		/// The number of frames that didn't have a free pooled buffer to
+		/// be read into, and needed a new allocation.
+		/// </summary>
+		long long unpooledCt = 0;
+	};
+
+private:
+	/// <summary>
+	/// The command line of the program to spawn.
+	/// </summary>
+	std::string cmd;
+
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+
+#if _WIN32
+	// The process and the read end of its stdout pipe, as Win32 HANDLEs.
+	void* childProcess = nullptr;
+	void* childStdout = nullptr;
+#else
+	// The process id of the program (which is also its process group),
+	// and the read end of its stdout pipe.
+	int childPid = -1;
+	int childStdout = -1;
+#endif
+
+	std::thread readThread;
+	std::atomic_bool readRunning = false;
+
+	/// <summary>
+	/// Frame buffers that are reused, once nothing else references them.
+	/// Only accessed by the reader thread.
+	/// </summary>
+	std::vector<cv::Ptr<cv::Mat>> bufferPool;
+
+	/// <summary>
+	/// Guards everything below.
+	/// </summary>
+	std::mutex frameMutex;
+
+	/// <summary>
+	/// Notified when a frame is read, or the reader thread is stopped.
+	/// </summary>
+	std::condition_variable frameCond;
+
+	/// <summary>
+	/// The newest frame that hasn't been polled yet, or nullptr.
+	/// </summary>
+	cv::Ptr<cv::Mat> newestFrame;
+
+	/// <summary>
+	/// When the first byte of newestFrame was read.
+	/// </summary>
+	std::chrono::steady_clock::time_point newestTime;
+
+	PipeStats stats;
+
+	/// <summary>
+	/// The age of the last polled frame, or negative if unknown.
+	/// </summary>
+	std::atomic<double> lastFrameAgeMS = -1.0;
+
+private:
+	inline size_t FrameBytes() const
+	{ return (size_t)this->width * this->height * this->channels; }
+
+	/// <summary>
+	/// Spawn the program, with its stdout redirected into a pipe for us.
+	/// </summary>
+	/// <returns>False if the program couldn't be spawned.</returns>
+	bool _SpawnChild();
+
+	/// <summary>
+	/// Stop the program if it's still running, and close the pipe.
+	/// </summary>
+	void _StopChild();
+
+	bool _HasChild() const;
+
+	/// <summary>
+	/// Read a full frame's worth of bytes from the program, in as few and
+	/// as large reads as the pipe allows.
+	/// </summary>
+	/// <param name="dst">Where to read the bytes to.</param>
+	/// <param name="len">The number of bytes to read.</param>
+	/// <param name="firstByteTime">
+	/// Output parameter. When the first byte was read.
+	/// </param>
+	/// <returns>
+	/// The number of bytes read. If less than len, the program exited,
+	/// stalled in the middle of the frame, or the reader was stopped.
+	/// </returns>
+	size_t _ReadFull(
+		unsigned char* dst,
+		size_t len,
+		std::chrono::steady_clock::time_point& firstByteTime);
+
+	/// <summary>
+	/// Get a frame buffer to read the next frame into. A pooled buffer is
+	/// reused if nothing else still references it.
+	/// </summary>
+	cv::Ptr<cv::Mat> _AcquireBuffer();
+
+	void _ReadThreadFn();
+
+protected:
+	bool InitializeImpl() override;
+	bool ShutdownImpl() override;
+	bool ActivateImpl() override;
+	bool DeactivateImpl() override;
+	cv::Ptr<cv::Mat> PollFrameImpl() override;
+
+public:
+	CamImpl_Pipe(const std::string& cmd);
+	~CamImpl_Pipe();
+
+	VideoPollType PollType() override;
+	bool IsValid() override;
+
+	bool PullOptions(const cvgCamFeedLocs& opts) override;
+	void DelegatedInjectIntoDicom(DcmDataset* dicomData) override;
+
+	double GetLastFrameAgeMS() override;
+	long long GetSkippedFrameCt() override;
+
+	PipeStats GetStats();
+};
@@ -0,0 +1,318 @@
+#include "CamImpl_Replay.h"
+#include "../IManagedCam.h"
+#include <boost/filesystem.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <boost/algorithm/string.hpp>
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+
+// The name of the timestamps file in a directory of images.
+static const char* szDirTimestampsFile	= "timestamps";
+
+// The extension added to a raw frame file for its timestamps file.
+static const char* szRawTimestampsExt	= ".timestamps";
+
+typedef std::chrono::duration<double, std::milli> MSDuration;
+
+CamImpl_Replay::CamImpl_Replay(const std::string& replayPath)
+{
+	this->replayPath = replayPath;
+}
+
+CamImpl_Replay::~CamImpl_Replay()
+{
+	// Shutdown here instead of leaving it to ~ICamImpl(), while
+	// ShutdownImpl() can still release the frames.
+	this->Shutdown();
+}
+
+bool CamImpl_Replay::InitializeImpl()
+{
+	return true;
+}
+
+bool CamImpl_Replay::ShutdownImpl()
+{
+	this->DeactivateImpl();
+	return true;
+}
+
+bool CamImpl_Replay::ActivateImpl()
+{
+	this->DeactivateImpl();
+
+	bool loaded = false;
+	if(boost::filesystem::is_directory(this->replayPath))
+		loaded = this->_LoadImageDirectory();
+	else if(boost::filesystem::is_regular_file(this->replayPath))
+		loaded = this->_LoadRawFile();
+	else
+		std::cout << "Replay path " << this->replayPath << " does not exist." << std::endl;
+
+	if(!loaded)
+	{
+		this->DeactivateImpl();
+		return false;
+	}
+
+	std::cout << "Replaying " << this->frames.size() << " frames from " << this->replayPath;
+	if(!this->frameTimesMS.empty())
+		std::cout << " with recorded timestamps." << std::endl;
+	else if(this->replayFPS > 0.0)
+		std::cout << " at " << this->replayFPS << " FPS." << std::endl;
+	else
+		std::cout << " as fast as possible." << std::endl;
+
+	this->nextFrame		= 0;
+	this->holdingLast	= false;
+	this->nextDue		= std::chrono::steady_clock::now();
+	this->lastFrameAgeMS = -1.0;
+	return true;
+}
+
+bool CamImpl_Replay::DeactivateImpl()
+{
+	this->frames.clear();
+	this->frameTimesMS.clear();
+	this->rawFile.Close();
+	return true;
+}
+
+bool CamImpl_Replay::_LoadRawFile()
+{
+	if(this->rawWidth <= 0 || this->rawHeight <= 0 || this->rawChannels < 1 || this->rawChannels > 4)
+	{
+		std::cout << "Invalid raw replay frame layout " <<
+			this->rawWidth << "x" << this->rawHeight << "x" << this->rawChannels << std::endl;
+		return false;
+	}
+
+	if(!this->rawFile.Open(this->replayPath))
+	{
+		std::cout << "Could not map raw replay file " << this->replayPath << std::endl;
+		return false;
+	}
+
+	size_t frameBytes = (size_t)this->rawWidth * this->rawHeight * this->rawChannels;
+	size_t frameCt = this->rawFile.Size() / frameBytes;
+	if(frameCt == 0)
+	{
+		std::cout << "Raw replay file " << this->replayPath << " is smaller than a frame." << std::endl;
+		return false;
+	}
+
+	if(this->rawFile.Size() % frameBytes != 0)
+		std::cout << "Raw replay file " << this->replayPath << " ends with a partial frame, which is ignored." << std::endl;
+
+	// The frames are only ever read, polling returns copies of them.
+	unsigned char* data = const_cast<unsigned char*>(this->rawFile.Data());
+	this->frames.reserve(frameCt);
+	for(size_t i = 0; i < frameCt; ++i)
+		this->frames.emplace_back(this->rawHeight, this->rawWidth, CV_8UC(this->rawChannels), data + i * frameBytes);
+
+	this->_PrefaultRawFile();
+
+	if(this->replayTimestamps)
+		this->_LoadTimestamps(this->replayPath + szRawTimestampsExt);
+
+	return true;
+}
+
+bool CamImpl_Replay::_LoadImageDirectory()
+{
+	std::vector<std::string> imagePaths;
+	for(const boost::filesystem::directory_entry& entry : boost::filesystem::directory_iterator(this->replayPath))
+	{
+		if(!boost::filesystem::is_regular_file(entry.path()))
+			continue;
+
+		std::string ext = boost::algorithm::to_lower_copy(entry.path().extension().string());
+		if(ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tif" || ext == ".tiff")
+			imagePaths.push_back(entry.path().string());
+	}
+	std::sort(imagePaths.begin(), imagePaths.end());
+
+	// Decoded once here, so replaying measures the pipeline instead of
+	// image decoding.
+	for(const std::string& imagePath : imagePaths)
+	{
+		cv::Mat img = cv::imread(imagePath, cv::IMREAD_ANYCOLOR);
+		if(img.empty())
+		{
+			std::cout << "Could not load replay image " << imagePath << ", skipping." << std::endl;
+			continue;
+		}
+
+		if(!this->frames.empty() && img.size() != this->frames[0].size())
+		{
+			std::cout << "Replay image " << imagePath << " is a different size than the first image, skipping." << std::endl;
+			continue;
+		}
+		this->frames.push_back(img);
+	}
+
+	if(this->frames.empty())
+	{
+		std::cout << "No images to replay in " << this->replayPath << std::endl;
+		return false;
+	}
+
+	if(this->replayTimestamps)
+	{
+		boost::filesystem::path timestampsPath = boost::filesystem::path(this->replayPath) / szDirTimestampsFile;
+		this->_LoadTimestamps(timestampsPath.string());
+	}
+
+	return true;
+}
+
+void CamImpl_Replay::_LoadTimestamps(const std::string& timestampsPath)
+{
+	std::ifstream timestampsFile(timestampsPath);
+	if(!timestampsFile.is_open())
+	{
+		std::cout << "No replay timestamps at " << timestampsPath << ", replaying at a fixed frame rate." << std::endl;
+		return;
+	}
+
+	std::vector<double> timesMS;
+	double ms = 0.0;
+	while(timesMS.size() < this->frames.size() && timestampsFile >> ms)
+		timesMS.push_back(ms);
+
+	if(timesMS.size() != this->frames.size())
+	{
+		std::cout << "Replay timestamps at " << timestampsPath << " only cover " << timesMS.size() <<
+			" of " << this->frames.size() << " frames, replaying at a fixed frame rate." << std::endl;
+		return;
+	}
+
+	for(size_t i = 1; i < timesMS.size(); ++i)
+	{
+		if(timesMS[i] < timesMS[i - 1])
+		{
+			std::cout << "Replay timestamps at " << timestampsPath << " go backwards, replaying at a fixed frame rate." << std::endl;
+			return;
+		}
+	}
+
+	this->frameTimesMS.resize(timesMS.size());
+	for(size_t i = 0; i < timesMS.size(); ++i)
+		this->frameTimesMS[i] = timesMS[i] - timesMS[0];
+}
+
+void CamImpl_Replay::_PrefaultRawFile()
+{
+	const size_t pageBytes = 4096;
+
+	const unsigned char* data = this->rawFile.Data();
+	size_t size = this->rawFile.Size();
+
+	volatile unsigned char sink = 0;
+	for(size_t i = 0; i < size; i += pageBytes)
+		sink ^= data[i];
+}
+
+double CamImpl_Replay::_IntervalAfterMS(size_t frameIdx) const
+{
+	if(!this->frameTimesMS.empty())
+	{
+		if(frameIdx + 1 < this->frameTimesMS.size())
+			return this->frameTimesMS[frameIdx + 1] - this->frameTimesMS[frameIdx];
+
+		// Looping back to the start uses the average interval.
+		if(this->frameTimesMS.size() > 1)
+			return this->frameTimesMS.back() / (double)(this->frameTimesMS.size() - 1);
+	}
+
+	if(this->replayFPS > 0.0)
+		return 1000.0 / this->replayFPS;
+
+	return 0.0;
+}
+
+cv::Ptr<cv::Mat> CamImpl_Replay::PollFrameImpl()
+{
+	if(this->frames.empty())
+		return nullptr;
+
+	size_t frameIdx = this->nextFrame;
+	if(this->holdingLast)
+		frameIdx = this->frames.size() - 1;
+
+	std::this_thread::sleep_until(this->nextDue);
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	this->lastFrameAgeMS = MSDuration(now - this->nextDue).count();
+
+	// The copy stands in for a camera handing over a new frame, and keeps
+	// the pipeline from modifying the replayed frames.
+	cv::Ptr<cv::Mat> ret = new cv::Mat();
+	this->frames[frameIdx].copyTo(*ret);
+	this->UtilToFlipMatInOpenCV(*ret);
+
+	// If the pipeline fell behind, the schedule restarts from now instead
+	// of returning a burst of frames to catch up.
+	this->nextDue += std::chrono::duration_cast<std::chrono::steady_clock::duration>(MSDuration(this->_IntervalAfterMS(frameIdx)));
+	if(this->nextDue < now)
+		this->nextDue = now;
+
+	if(!this->holdingLast)
+	{
+		++this->nextFrame;
+		if(this->nextFrame >= this->frames.size())
+		{
+			this->nextFrame = 0;
+			if(!this->replayLoop)
+			{
+				std::cout << "Replay of " << this->replayPath << " finished, holding the last frame." << std::endl;
+				this->holdingLast = true;
+			}
+		}
+	}
+
+	return ret;
+}
+
+VideoPollType CamImpl_Replay::PollType()
+{
+	return VideoPollType::Replay;
+}
+
+bool CamImpl_Replay::IsValid()
+{
+	return !this->frames.empty();
+}
+
+bool CamImpl_Replay::PullOptions(const cvgCamFeedLocs& opts)
+{
+	this->ICamImpl::PullOptions(opts);
+
+	this->replayPath		= opts.replayPath;
+	this->replayFPS			= opts.replayFPS;
+	this->replayLoop		= opts.replayLoop;
+	this->replayTimestamps	= opts.replayTimestamps;
+	this->rawWidth			= opts.pipeWidth;
+	this->rawHeight			= opts.pipeHeight;
+	this->rawChannels		= opts.channelCtFromPipe;
+	return true;
+}
+
+void CamImpl_Replay::DelegatedInjectIntoDicom(DcmDataset* dicomData)
+{
+	// Like StaticImg, this is for development and testing.
+	dicomData->putAndInsertString(DCM_SensorName, "Replay");
+	InsertAcquisitionContextInfo(dicomData, "replay_path", this->replayPath);
+}
+
+double CamImpl_Replay::GetLastFrameAgeMS()
+{
+	return this->lastFrameAgeMS;
+}
+
+bool CamImpl_Replay::IsSelfPaced()
+{
+	return true;
+}
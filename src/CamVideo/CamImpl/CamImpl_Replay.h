@@ -0,0 +1,116 @@
+#pragma once
+
+#include "ICamImpl.h"
+#include "../../Utils/cvgMappedFile.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+
+/// <summary>
+/// A ICamImpl that replays recorded frames, so the camera pipeline can be
+/// run reproducibly without a camera.
+///
+/// Frames come from either:
+/// - A raw frame file, with frames laid out the same as the External poll
+///   type's pipe (pipeWidth x pipeHeight x channelCtFromPipe bytes, with
+///   nothing between frames). The file is memory mapped.
+/// - A directory of images, replayed in filename order. The images are
+///   decoded once, when activated, and kept in memory.
+///
+/// Optionally, a timestamps file (replayPath + ".timestamps" for raw files,
+/// or "timestamps" in the image directory) with one millisecond timestamp
+/// per line can give frames their recorded timing.
+/// </summary>
+class CamImpl_Replay : public ICamImpl
+{
+private:
+	std::string replayPath;
+	double replayFPS = 30.0;
+	bool replayLoop = true;
+	bool replayTimestamps = false;
+
+	int rawWidth = 0;
+	int rawHeight = 0;
+	int rawChannels = 0;
+
+	/// <summary>
+	/// The mapping of a raw frame file.
+	/// </summary>
+	cvgMappedFile rawFile;
+
+	/// <summary>
+	/// The frames to replay. For raw frame files, these reference the
+	/// mapped file directly.
+	/// </summary>
+	std::vector<cv::Mat> frames;
+
+	/// <summary>
+	/// The recorded timestamp of each frame, relative to the first. Empty
+	/// if frames are replayed at replayFPS.
+	/// </summary>
+	std::vector<double> frameTimesMS;
+
+	/// <summary>
+	/// The index of the next frame to replay.
+	/// </summary>
+	size_t nextFrame = 0;
+
+	/// <summary>
+	/// When the next frame is due to be returned from polling.
+	/// </summary>
+	std::chrono::steady_clock::time_point nextDue;
+
+	/// <summary>
+	/// Set once the end of the frames was reached without looping.
+	/// </summary>
+	bool holdingLast = false;
+
+	/// <summary>
+	/// How late the last polled frame was returned, compared to when it
+	/// was due.
+	/// </summary>
+	std::atomic<double> lastFrameAgeMS = -1.0;
+
+private:
+	bool _LoadRawFile();
+	bool _LoadImageDirectory();
+
+	/// <summary>
+	/// Load the timestamps file into frameTimesMS, if there is one and
+	/// it has a timestamp for every frame.
+	/// </summary>
+	void _LoadTimestamps(const std::string& timestampsPath);
+
+	/// <summary>
+	/// Touch every page of the mapped file, so the first pass of a replay
+	/// isn't slowed down by reading from disk.
+	/// </summary>
+	void _PrefaultRawFile();
+
+	/// <summary>
+	/// Get the time between replaying a frame and the one after it.
+	/// </summary>
+	/// <returns>The interval in milliseconds. 0 if frames aren't paced.</returns>
+	double _IntervalAfterMS(size_t frameIdx) const;
+
+protected:
+	bool InitializeImpl() override;
+	bool ShutdownImpl() override;
+	bool ActivateImpl() override;
+	bool DeactivateImpl() override;
+	cv::Ptr<cv::Mat> PollFrameImpl() override;
+
+public:
+	CamImpl_Replay(const std::string& replayPath);
+	~CamImpl_Replay();
+
+	VideoPollType PollType() override;
+	bool IsValid() override;
+
+	bool PullOptions(const cvgCamFeedLocs& opts) override;
+	void DelegatedInjectIntoDicom(DcmDataset* dicomData) override;
+
+	double GetLastFrameAgeMS() override;
+	bool IsSelfPaced() override;
+};
@@ -0,0 +1,233 @@
+#include "CaptureMode.h"
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+
+#if __linux__
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/ioctl.h>
+	#include <linux/videodev2.h>
+#endif
+
+// Frame rates are often reported as slightly under their nominal rate,
+// e.g., 29.97 for 30, so they're allowed to be this far under.
+const double fpsTolerance = 0.95;
+
+bool CaptureMode::IsCompressed() const
+{
+	return this->fourcc == cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+}
+
+std::string CaptureMode::ToString() const
+{
+	std::stringstream sstrm;
+	sstrm << FourCCToString(this->fourcc) << " " << this->width << "x" << this->height << " @ " << this->fps << "fps";
+	return sstrm.str();
+}
+
+std::string CaptureMode::FourCCToString(int fourcc)
+{
+	std::string ret;
+	for(int i = 0; i < 4; ++i)
+	{
+		char c = (char)((fourcc >> (i * 8)) & 0xFF);
+		ret += (c >= 32 && c < 127) ? c : '?';
+	}
+	return ret;
+}
+
+std::vector<CaptureMode> CaptureModeNegotiator::EnumerateV4L2(const std::string& deviceNode)
+{
+	std::vector<CaptureMode> ret;
+
+#if __linux__
+	// Listing the modes doesn't interfere with the device being opened
+	// by a VideoCapture.
+	int fd = open(deviceNode.c_str(), O_RDWR | O_NONBLOCK);
+	if(fd < 0)
+		return ret;
+
+	v4l2_fmtdesc fmtDesc = {};
+	fmtDesc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	for(fmtDesc.index = 0; ioctl(fd, VIDIOC_ENUM_FMT, &fmtDesc) == 0; ++fmtDesc.index)
+	{
+		v4l2_frmsizeenum frmSize = {};
+		frmSize.pixel_format = fmtDesc.pixelformat;
+		for(frmSize.index = 0; ioctl(fd, VIDIOC_ENUM_FRAMESIZES, &frmSize) == 0; ++frmSize.index)
+		{
+			CaptureMode mode;
+			mode.fourcc = (int)fmtDesc.pixelformat;
+			if(frmSize.type == V4L2_FRMSIZE_TYPE_DISCRETE)
+			{
+				mode.width	= frmSize.discrete.width;
+				mode.height = frmSize.discrete.height;
+			}
+			else
+			{
+				// For continuous and stepwise sizes, only the largest
+				// size is considered.
+				mode.width	= frmSize.stepwise.max_width;
+				mode.height = frmSize.stepwise.max_height;
+			}
+
+			v4l2_frmivalenum frmIval = {};
+			frmIval.pixel_format	= fmtDesc.pixelformat;
+			frmIval.width			= mode.width;
+			frmIval.height			= mode.height;
+			for(frmIval.index = 0; ioctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &frmIval) == 0; ++frmIval.index)
+			{
+				// The frame interval is in seconds, as a fraction.
+				const v4l2_fract& interval =
+					(frmIval.type == V4L2_FRMIVAL_TYPE_DISCRETE) ?
+						frmIval.discrete :
+						frmIval.stepwise.min;
+
+				if(interval.numerator == 0)
+					continue;
+
+				mode.fps = std::max(mode.fps, (double)interval.denominator / interval.numerator);
+
+				if(frmIval.type != V4L2_FRMIVAL_TYPE_DISCRETE)
+					break;
+			}
+
+			if(mode.fps > 0.0)
+				ret.push_back(mode);
+
+			if(frmSize.type != V4L2_FRMSIZE_TYPE_DISCRETE)
+				break;
+		}
+	}
+	close(fd);
+#endif
+
+	return ret;
+}
+
+std::vector<CaptureMode> CaptureModeNegotiator::Probe(
+	cv::VideoCapture* capture,
+	const std::vector<int>& fourccs,
+	int width,
+	int height,
+	double fps)
+{
+	std::vector<CaptureMode> ret;
+	for(int fourcc : fourccs)
+	{
+		capture->set(cv::CAP_PROP_FOURCC, fourcc);
+		if(width != 0)
+			capture->set(cv::CAP_PROP_FRAME_WIDTH, width);
+		if(height != 0)
+			capture->set(cv::CAP_PROP_FRAME_HEIGHT, height);
+		capture->set(cv::CAP_PROP_FPS, fps);
+
+		// Backends will silently fall back to something else if they
+		// can't do what was requested.
+		CaptureMode probed;
+		probed.fourcc	= (int)capture->get(cv::CAP_PROP_FOURCC);
+		probed.width	= (int)capture->get(cv::CAP_PROP_FRAME_WIDTH);
+		probed.height	= (int)capture->get(cv::CAP_PROP_FRAME_HEIGHT);
+		probed.fps		= capture->get(cv::CAP_PROP_FPS);
+
+		if(probed.fourcc != fourcc || probed.width <= 0 || probed.height <= 0)
+			continue;
+
+		ret.push_back(probed);
+	}
+	return ret;
+}
+
+std::vector<int> CaptureModeNegotiator::CandidateFourCCs(CaptureFormat format)
+{
+	const int yuyv = cv::VideoWriter::fourcc('Y', 'U', 'Y', 'V');
+	const int grey = cv::VideoWriter::fourcc('G', 'R', 'E', 'Y');
+	const int mjpg = cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+
+	switch(format)
+	{
+	case CaptureFormat::YUYV:
+		return { yuyv, grey, mjpg };
+
+	case CaptureFormat::Grey:
+		return { grey, yuyv, mjpg };
+
+	case CaptureFormat::BGR:
+		break;
+	}
+	return { yuyv, mjpg };
+}
+
+bool CaptureModeNegotiator::Choose(
+	const std::vector<CaptureMode>& modes,
+	const std::vector<int>& fourccs,
+	int width,
+	int height,
+	double fps,
+	CaptureMode& chosen)
+{
+	const bool anyRes = (width <= 0 || height <= 0);
+	const long long reqArea = (long long)width * height;
+
+	// Returns true if mode a should be chosen over mode b.
+	auto fnBetter =
+		[&](const CaptureMode& a, int aFmtRank, const CaptureMode& b, int bFmtRank)
+		{
+			const long long aArea = (long long)a.width * a.height;
+			const long long bArea = (long long)b.width * b.height;
+			if(anyRes)
+			{
+				if(aArea != bArea)
+					return aArea > bArea;
+			}
+			else
+			{
+				bool aCovers = a.width >= width && a.height >= height;
+				bool bCovers = b.width >= width && b.height >= height;
+				if(aCovers != bCovers)
+					return aCovers;
+
+				long long aDiff = std::llabs(aArea - reqArea);
+				long long bDiff = std::llabs(bArea - reqArea);
+				if(aDiff != bDiff)
+					return aDiff < bDiff;
+			}
+
+			bool aMeets = a.fps >= fps * fpsTolerance;
+			bool bMeets = b.fps >= fps * fpsTolerance;
+			if(aMeets != bMeets)
+				return aMeets;
+
+			if(aMeets)
+			{
+				// Both are fast enough, so use the preferred format, at the
+				// rate closest to what was requested.
+				if(aFmtRank != bFmtRank)
+					return aFmtRank < bFmtRank;
+				return a.fps < b.fps;
+			}
+
+			// Neither is fast enough, get as close as possible.
+			if(a.fps != b.fps)
+				return a.fps > b.fps;
+			return aFmtRank < bFmtRank;
+		};
+
+	bool found = false;
+	int chosenFmtRank = 0;
+	for(const CaptureMode& mode : modes)
+	{
+		auto itFmt = std::find(fourccs.begin(), fourccs.end(), mode.fourcc);
+		if(itFmt == fourccs.end())
+			continue;
+
+		int fmtRank = (int)(itFmt - fourccs.begin());
+		if(!found || fnBetter(mode, fmtRank, chosen, chosenFmtRank))
+		{
+			chosen = mode;
+			chosenFmtRank = fmtRank;
+			found = true;
+		}
+	}
+	return found;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <opencv2/videoio.hpp>
+#include "../../Utils/CaptureFormat.h"
+
+/// <summary>
+/// A pixel format, resolution and frame rate combination that a capture
+/// device can stream.
+/// </summary>
+struct CaptureMode
+{
+	/// <summary>
+	/// The pixel format, as a FOURCC code in the same encoding as
+	/// cv::VideoWriter::fourcc() and V4L2.
+	/// </summary>
+	int fourcc = 0;
+
+	int width = 0;
+	int height = 0;
+
+	/// <summary>
+	/// The highest frame rate the mode supports.
+	/// </summary>
+	double fps = 0.0;
+
+	/// <summary>
+	/// Check if the mode streams compressed frames that need to be
+	/// decoded.
+	/// </summary>
+	bool IsCompressed() const;
+
+	/// <summary>
+	/// Get a readable description of the mode, e.g., "MJPG 1920x1080 @ 30fps".
+	/// </summary>
+	std::string ToString() const;
+
+	/// <summary>
+	/// Convert a FOURCC code to its four characters.
+	/// </summary>
+	static std::string FourCCToString(int fourcc);
+};
+
+/// <summary>
+/// Chooses the capture mode of a device that best matches the requested
+/// resolution and frame rate.
+///
+/// OpenCV doesn't expose what modes a device supports, so on Linux they're
+/// listed from V4L2 directly. On other platforms, or if the device can't be
+/// listed, the requested resolution is probed on the VideoCapture with each
+/// candidate pixel format.
+/// </summary>
+class CaptureModeNegotiator
+{
+public:
+	/// <summary>
+	/// List the modes of a V4L2 device.
+	/// </summary>
+	/// <param name="deviceNode">The device node, e.g., "/dev/video0".</param>
+	/// <returns>
+	/// The supported modes, or an empty vector if the device couldn't be
+	/// listed, or on non-Linux platforms.
+	/// </returns>
+	static std::vector<CaptureMode> EnumerateV4L2(const std::string& deviceNode);
+
+	/// <summary>
+	/// Find which of the candidate pixel formats an opened VideoCapture
+	/// can stream at a resolution, by setting them and reading back what
+	/// was actually applied.
+	///
+	/// This will change the mode of the VideoCapture.
+	/// </summary>
+	/// <param name="capture">The opened VideoCapture to probe.</param>
+	/// <param name="fourccs">The candidate pixel formats.</param>
+	/// <param name="width">The resolution width to probe.</param>
+	/// <param name="height">The resolution height to probe.</param>
+	/// <param name="fps">The frame rate to request.</param>
+	/// <returns>The modes the VideoCapture accepted.</returns>
+	static std::vector<CaptureMode> Probe(
+		cv::VideoCapture* capture,
+		const std::vector<int>& fourccs,
+		int width,
+		int height,
+		double fps);
+
+	/// <summary>
+	/// The pixel formats that can be used for a capture format, in order
+	/// of preference for when multiple formats can reach the requested
+	/// frame rate. Uncompressed formats are preferred since they don't need
+	/// to be decoded, but MJPEG is always a candidate since many USB cameras
+	/// can only reach their higher resolutions at full rate with it.
+	/// </summary>
+	static std::vector<int> CandidateFourCCs(CaptureFormat format);
+
+	/// <summary>
+	/// Choose the best mode for a requested resolution and frame rate.
+	///
+	/// The closest resolution is chosen first, preferring ones that cover the
+	/// requested resolution. Then, modes that can reach the frame rate are
+	/// preferred, using the order of the fourccs to break ties. If no mode
+	/// can reach the frame rate, the fastest one is chosen.
+	/// </summary>
+	/// <param name="modes">The modes to choose from.</param>
+	/// <param name="fourccs">
+	/// The pixel formats that can be chosen, in order of preference.
+	/// </param>
+	/// <param name="width">
+	/// The requested width. If 0, the largest resolution is preferred.
+	/// </param>
+	/// <param name="height">
+	/// The requested height. If 0, the largest resolution is preferred.
+	/// </param>
+	/// <param name="fps">The requested frame rate.</param>
+	/// <param name="chosen">Output parameter. The chosen mode.</param>
+	/// <returns>False if none of the modes can be used.</returns>
+	static bool Choose(
+		const std::vector<CaptureMode>& modes,
+		const std::vector<int>& fourccs,
+		int width,
+		int height,
+		double fps,
+		CaptureMode& chosen);
+};
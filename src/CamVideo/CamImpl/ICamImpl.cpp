@@ -44,6 +44,7 @@ bool ICamImpl::PullOptions(const cvgCamFeedLocs& opts)
 {
 	this->prefWidth		= opts.streamWidth;
 	this->prefHeight	= opts.streamHeight;
+	this->prefFPS		= opts.streamFPS;
 	this->flipHoriz		= opts.flipHorizontal;
 	this->flipVert		= opts.flipVertical;
 	return true;
@@ -54,6 +55,44 @@ void ICamImpl::DelegatedInjectIntoDicom(DcmDataset* dicomData)
 	// Does nothing, subclasses are expected to implement this.
 }
 
+double ICamImpl::GetLastFrameAgeMS()
+{
+	// Unknown by default.
+	return -1.0;
+}
+
+long long ICamImpl::GetSkippedFrameCt()
+{
+	return 0;
+}
+
+bool ICamImpl::SupportsSplitGrab()
+{
+	// Subclasses that can grab separately from retrieving will override 
+	// this, along with GrabFrame() and RetrieveFrame().
+	return false;
+}
+
+bool ICamImpl::GrabFrame()
+{
+	return false;
+}
+
+double ICamImpl::GetLastGrabTimeMS()
+{
+	return -1.0;
+}
+
+cv::Ptr<cv::Mat> ICamImpl::RetrieveFrame()
+{
+	return nullptr;
+}
+
+bool ICamImpl::IsSelfPaced()
+{
+	return false;
+}
+
 void ICamImpl::UtilToFlipMatInOpenCV(cv::Mat& mat)
 {
 	// https://docs.opencv.org/3.4/d2/de8/group__core__array.html#gaca7be533e3dac7feb70fc60635adf441
@@ -67,6 +106,23 @@ void ICamImpl::UtilToFlipMatInOpenCV(cv::Mat& mat)
 
 bool ICamImpl::SetParam(StreamParams paramid, double value)
 {
+	// Flipping is done in software by default (see UtilToFlipMatInOpenCV())
+	// so it can change at any time. Subclasses that flip at the hardware
+	// level should intercept these.
+	switch(paramid)
+	{
+	case StreamParams::FlipHorizontal:
+		this->flipHoriz = (value != 0.0);
+		return true;
+
+	case StreamParams::FlipVertical:
+		this->flipVert = (value != 0.0);
+		return true;
+
+	default:
+		break;
+	}
+
 	std::cout << "Unhandled parameter " << paramid << "In ICamImpl::SetParam()" << std::endl;
 	return false;
 }
\ No newline at end of file
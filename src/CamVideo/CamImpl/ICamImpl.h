@@ -36,6 +36,11 @@ protected:
 	/// </summary>
 	int prefHeight = 0;
 
+	/// <summary>
+	/// The preferred frame rate to stream in data.
+	/// </summary>
+	double prefFPS = 30.0;
+
 	bool flipHoriz = false;
 
 	bool flipVert = false;
@@ -171,7 +176,69 @@ public:
 	/// <param name="dicomData"></param>
 	virtual void DelegatedInjectIntoDicom(DcmDataset* dicomData);
 
+	/// <summary>
+	/// Change a parameter on the (possibly running) implementation.
+	/// 
+	/// This is used both for runtime UI tweaks, and for applying reloaded
+	/// AppOptions without reconnecting to the device.
+	/// </summary>
+	/// <returns>
+	/// True if the change was applied. False if the parameter is unknown, or
+	/// can't be changed live by the implementation - in which case the owner
+	/// may choose to reconnect to apply it instead.
+	/// </returns>
 	virtual bool SetParam(StreamParams paramid, double value);
 
+	/// <summary>
+	/// Get how old the last polled frame was when it was returned, measured
+	/// from the device's or stream's timestamp of the frame.
+	/// </summary>
+	/// <returns>The age in milliseconds, or a negative value if unknown.</returns>
+	virtual double GetLastFrameAgeMS();
+
+	/// <summary>
+	/// Get the number of frames that were received, but were replaced by a
+	/// newer frame before being polled.
+	/// </summary>
+	virtual long long GetSkippedFrameCt();
+
+	/// <summary>
+	/// Query if the implementation can grab a frame separately from
+	/// retrieving it, with GrabFrame() and RetrieveFrame(). This allows
+	/// multiple cameras to grab at the same time (see CamSyncGroup), and
+	/// then take their time retrieving and decoding.
+	/// </summary>
+	virtual bool SupportsSplitGrab();
+
+	/// <summary>
+	/// Grab the next frame from the device, without retrieving it.
+	/// Only valid if SupportsSplitGrab().
+	/// </summary>
+	/// <returns>True if a frame was grabbed.</returns>
+	virtual bool GrabFrame();
+
+	/// <summary>
+	/// Get when the frame last grabbed with GrabFrame() was captured.
+	/// </summary>
+	/// <returns>
+	/// The capture time in milliseconds of the steady (monotonic) clock, 
+	/// or a negative value if unknown.
+	/// </returns>
+	virtual double GetLastGrabTimeMS();
+
+	/// <summary>
+	/// Retrieve the frame last grabbed with GrabFrame(). This is what
+	/// PollFrame() returns, but split from the grab.
+	/// </summary>
+	/// <returns>The retrieved frame, or nullptr if there's none.</returns>
+	virtual cv::Ptr<cv::Mat> RetrieveFrame();
+
+	/// <summary>
+	/// Query if polling blocks until the next frame is due, so the owner 
+	/// shouldn't add its own frame rate pacing on top. This is for sources 
+	/// that are simulated instead of captured, which set their own rate.
+	/// </summary>
+	virtual bool IsSelfPaced();
+
 	virtual ~ICamImpl();
 };
\ No newline at end of file
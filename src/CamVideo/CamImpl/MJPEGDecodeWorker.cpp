@@ -0,0 +1,130 @@
+#include "MJPEGDecodeWorker.h"
+#include <opencv2/imgcodecs.hpp>
+#include <chrono>
+
+MJPEGDecodeWorker::~MJPEGDecodeWorker()
+{
+	this->Stop();
+}
+
+void MJPEGDecodeWorker::Start(bool greyscale)
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	if(this->running)
+		return;
+
+	this->decodeFlags	= greyscale ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+	this->pending		= cv::Mat();
+	this->pendingSeq	= -1;
+	this->decodingSeq	= -1;
+	this->decoded		= cv::Mat();
+	this->decodedSeq	= -1;
+	this->returnedSeq	= -1;
+	this->running		= true;
+
+	this->thread = std::thread(&MJPEGDecodeWorker::ThreadFn, this);
+}
+
+void MJPEGDecodeWorker::Stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(this->mutex);
+		if(!this->running)
+			return;
+
+		this->running = false;
+	}
+	this->condSubmitted.notify_all();
+	this->condDecoded.notify_all();
+
+	if(this->thread.joinable())
+		this->thread.join();
+
+	std::lock_guard<std::mutex> guard(this->mutex);
+	this->pending = cv::Mat();
+	this->decoded = cv::Mat();
+}
+
+bool MJPEGDecodeWorker::IsRunning()
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	return this->running;
+}
+
+void MJPEGDecodeWorker::ThreadFn()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while(this->running)
+	{
+		this->condSubmitted.wait(
+			lock,
+			[this]{ return !this->running || this->pendingSeq > this->decodingSeq; });
+
+		if(!this->running)
+			break;
+
+		cv::Mat compressed = this->pending;
+		this->pending = cv::Mat();
+		this->decodingSeq = this->pendingSeq;
+
+		lock.unlock();
+		// Decoded into a new Mat every time, since the previous one may
+		// still be in use by whoever it was returned to.
+		cv::Mat img = cv::imdecode(compressed, this->decodeFlags);
+		lock.lock();
+
+		if(img.empty())
+			++this->failedCt;
+
+		this->decoded		= img;
+		this->decodedSeq	= this->decodingSeq;
+		this->condDecoded.notify_all();
+	}
+}
+
+void MJPEGDecodeWorker::Submit(const cv::Mat& compressed)
+{
+	{
+		std::lock_guard<std::mutex> guard(this->mutex);
+		if(!this->running)
+			return;
+
+		if(this->pendingSeq > this->decodingSeq)
+			++this->droppedCt;
+
+		this->pending = compressed;
+		++this->pendingSeq;
+	}
+	this->condSubmitted.notify_one();
+}
+
+bool MJPEGDecodeWorker::GetDecoded(cv::Mat& out, int timeoutMS)
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	// Pipelined one deep, the frame before the last submitted one is
+	// what we need. For the very first frame, there's nothing to return
+	// yet.
+	long long waitSeq = this->pendingSeq - 1;
+	if(waitSeq < 0)
+		return false;
+
+	bool ready = this->condDecoded.wait_for(
+		lock,
+		std::chrono::milliseconds(timeoutMS),
+		[this, waitSeq]{ return !this->running || this->decodedSeq >= waitSeq; });
+
+	if(!ready || !this->running || this->decoded.empty() || this->decodedSeq <= this->returnedSeq)
+		return false;
+
+	out = this->decoded;
+	this->returnedSeq = this->decodedSeq;
+	return true;
+}
+
+void MJPEGDecodeWorker::GetCounts(long long& dropped, long long& failed)
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	dropped = this->droppedCt;
+	failed	= this->failedCt;
+}
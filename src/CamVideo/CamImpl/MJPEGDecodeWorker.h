@@ -0,0 +1,125 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/// <summary>
+/// Decodes compressed MJPEG frames on a dedicated thread, so a camera's
+/// capture of the next frame can overlap with the decode of the current one.
+///
+/// Frames are pipelined one deep: after a frame is submitted, GetDecoded()
+/// only waits for the frame submitted before it, which has usually finished
+/// decoding while the camera was waiting on the new frame.
+/// </summary>
+class MJPEGDecodeWorker
+{
+private:
+	std::thread thread;
+
+	/// <summary>
+	/// Guards everything below.
+	/// </summary>
+	std::mutex mutex;
+
+	/// <summary>
+	/// Notified when a frame is submitted, or the worker is stopped.
+	/// </summary>
+	std::condition_variable condSubmitted;
+
+	/// <summary>
+	/// Notified when a frame has been decoded.
+	/// </summary>
+	std::condition_variable condDecoded;
+
+	bool running = false;
+
+	/// <summary>
+	/// The cv::imdecode() flags.
+	/// </summary>
+	int decodeFlags = 0;
+
+	/// <summary>
+	/// The compressed frame waiting to be decoded, if pendingSeq is
+	/// newer than decodingSeq.
+	/// </summary>
+	cv::Mat pending;
+	long long pendingSeq = -1;
+
+	/// <summary>
+	/// The sequence number of the frame being decoded, or that was
+	/// last decoded.
+	/// </summary>
+	long long decodingSeq = -1;
+
+	/// <summary>
+	/// The newest decoded frame.
+	/// </summary>
+	cv::Mat decoded;
+	long long decodedSeq = -1;
+
+	/// <summary>
+	/// The sequence number of the last frame returned from GetDecoded().
+	/// </summary>
+	long long returnedSeq = -1;
+
+	/// <summary>
+	/// The number of submitted frames that were replaced before the
+	/// worker got to them.
+	/// </summary>
+	long long droppedCt = 0;
+
+	/// <summary>
+	/// The number of frames that failed to decode.
+	/// </summary>
+	long long failedCt = 0;
+
+private:
+	void ThreadFn();
+
+public:
+	~MJPEGDecodeWorker();
+
+	/// <summary>
+	/// Start the worker thread. Does nothing if it's already running.
+	/// </summary>
+	/// <param name="greyscale">
+	/// If true, frames are decoded to a single channel instead of BGR.
+	/// </param>
+	void Start(bool greyscale);
+
+	/// <summary>
+	/// Stop the worker thread and forget any frames.
+	/// </summary>
+	void Stop();
+
+	bool IsRunning();
+
+	/// <summary>
+	/// Queue a compressed frame to be decoded. If the worker hasn't
+	/// started on the previously submitted frame, it's replaced.
+	/// </summary>
+	/// <param name="compressed">The compressed JPEG bytes.</param>
+	void Submit(const cv::Mat& compressed);
+
+	/// <summary>
+	/// Get the newest decoded frame that hasn't been returned yet.
+	///
+	/// Waits until the frame submitted before the last Submit() has been
+	/// decoded. After the first Submit(), there's nothing to return yet.
+	/// </summary>
+	/// <param name="out">Output parameter. The decoded frame.</param>
+	/// <param name="timeoutMS">How long to wait for a decoded frame.</param>
+	/// <returns>
+	/// True if a frame was returned. Else, it timed out, or the only
+	/// frames left failed to decode.
+	/// </returns>
+	bool GetDecoded(cv::Mat& out, int timeoutMS);
+
+	/// <summary>
+	/// Get the number of frames that were replaced before being decoded,
+	/// and the number of frames that failed to decode.
+	/// </summary>
+	void GetCounts(long long& dropped, long long& failed);
+};
@@ -6,6 +6,8 @@
 #include "../Utils/multiplatform.h"
 #include <iostream>
 #include "../Utils/multiplatform.h"
+#include "../Utils/cvgQualityGovernor.h"
+#include <boost/filesystem.hpp>
 
 CamStreamMgr CamStreamMgr::_inst;
 
@@ -148,6 +150,7 @@ bool CamStreamMgr::BootConnectionToCamera(const std::vector<cvgCamFeedSource>& s
 		return false;
 
 	ValidateSourcePlatforms(sources);
+	_ApplyFrameRates(sources);
 
 	std::lock_guard<std::mutex> guard(this->camAccess);
 
@@ -179,6 +182,49 @@ bool CamStreamMgr::BootConnectionToCamera(const std::vector<cvgCamFeedSource>& s
 	return true;
 }
 
+bool CamStreamMgr::ReloadCameraOptions(const std::vector<cvgCamFeedSource>& sources)
+{
+	std::lock_guard<std::mutex> guard(this->camAccess);
+
+	if(this->cams.empty())
+		return false;
+
+	if(sources.size() != this->cams.size())
+	{
+		std::cerr << "Reloaded options have " << sources.size() << " video feeds, but " << 
+			this->cams.size() << " are running. Only matching feeds will be updated, restart to change the feed count." << std::endl;
+	}
+
+	int updateCt = (int)sources.size();
+	if(updateCt > this->cams.size())
+		updateCt = (int)this->cams.size();
+
+	for(int i = 0; i < updateCt; ++i)
+		this->cams[i]->QueueOptionsReload(sources[i]);
+
+	_ApplyFrameRates(sources);
+	return true;
+}
+
+void CamStreamMgr::_ApplyFrameRates(const std::vector<cvgCamFeedSource>& sources)
+{
+	double maxFPS = 0.0;
+	for(const cvgCamFeedSource& src : sources)
+	{
+		if(src.GetUsedPoll() != VideoPollType::Deactivated && src.streamFPS > maxFPS)
+			maxFPS = src.streamFPS;
+	}
+
+	if(maxFPS <= 0.0)
+		return;
+
+	ManagedComposite::SetTargetFPS(maxFPS);
+
+	// The governor has a single budget for every stage, so it's held to
+	// the fastest feed's frame time.
+	cvgQualityGovernor::GetInstance().SetBudgetMS(1000.0 / maxFPS);
+}
+
 cv::Ptr<cv::Mat> CamStreamMgr::GetCurrentFrame(int idx)
 {
 	std::lock_guard<std::mutex> guard(this->camAccess);
@@ -220,7 +266,9 @@ void CamStreamMgr::ClearAllSnapshotRequests()
 SnapRequest::SPtr CamStreamMgr::RequestSnapshot(
 	int idx, 
 	const std::string& filename, 
-	SnapRequest::ProcessType procType)
+	SnapRequest::ProcessType procType,
+	SnapRequest::FrameSelect select,
+	int lookbackMS)
 {
 	std::lock_guard<std::mutex> guard(this->camAccess);
 
@@ -228,7 +276,7 @@ SnapRequest::SPtr CamStreamMgr::RequestSnapshot(
 	if(imc == nullptr)
 		return SnapRequest::MakeError("Could not find requested camera stream", filename);
 
-	return imc->RequestSnapshot(filename, procType);
+	return imc->RequestSnapshot(filename, procType, select, lookbackMS);
 }
 
 std::vector<SnapRequest::SPtr> CamStreamMgr::RequestSnapshotAll(const std::string& filenameBase)
@@ -266,6 +314,54 @@ std::vector<SnapRequest::SPtr> CamStreamMgr::RequestSnapshotAll(const std::strin
 	return ret;
 }
 
+BurstRequest::SPtr CamStreamMgr::RequestBurst(
+	int idx,
+	const std::string& filename,
+	int frameCt,
+	SnapRequest::ProcessType procType,
+	bool average)
+{
+	std::lock_guard<std::mutex> guard(this->camAccess);
+
+	IManagedCam* imc = this->_GetIManaged(idx);
+	if(imc == nullptr)
+		return BurstRequest::MakeError("Could not find requested camera stream", filename);
+
+	return imc->RequestBurst(filename, frameCt, procType, average);
+}
+
+std::vector<BurstRequest::SPtr> CamStreamMgr::RequestBurstAll(
+	const std::string& filenameBase,
+	int frameCt,
+	bool average)
+{
+	std::lock_guard<std::mutex> guard(this->camAccess);
+
+	std::vector<BurstRequest::SPtr> ret;
+
+	std::vector<IManagedCam*> allCams;
+	for(int i = 0; i < this->cams.size(); ++i)
+		allCams.push_back(this->cams[i]);
+
+	if(this->composite != nullptr)
+		allCams.push_back(this->composite);
+
+	for(IManagedCam* mc : allCams)
+	{
+		std::string strIdx = mc->GetStreamName();
+		ret.push_back(
+			mc->RequestBurst(filenameBase + "_" + strIdx + "RAW", frameCt, SnapRequest::ProcessType::Cannot, average));
+
+		if(mc->UsesImageProcessingChain())
+		{
+			ret.push_back(
+				mc->RequestBurst(filenameBase + "_" + strIdx + "IMPROC", frameCt, SnapRequest::ProcessType::HasTo, average));
+		}
+	}
+
+	return ret;
+}
+
 void CamStreamMgr::ClearSnapshotRequests(int idx)
 {
 	std::lock_guard<std::mutex> guard(this->camAccess);
@@ -276,14 +372,24 @@ void CamStreamMgr::ClearSnapshotRequests(int idx)
 	imc->ClearSnapshotRequests();
 }
 
-VideoRequest::SPtr CamStreamMgr::RecordVideo(int idx, const std::string& filename)
+VideoRequest::SPtr CamStreamMgr::RecordVideo(
+	int idx, 
+	const std::string& filename, 
+	VideoRequest::Format format,
+	int preRollMS)
 {
 	std::lock_guard<std::mutex> guard(this->camAccess);
 	IManagedCam* imc = this->_GetIManaged(idx);
 	if(imc == nullptr)
 		return VideoRequest::MakeError("__invalidstate__");
 
-	return imc->OpenVideo(filename);
+	return imc->OpenVideo(
+		filename, 
+		format, 
+		VideoRequest::Source::Processed, 
+		nullptr, 
+		-1, 
+		preRollMS);
 }
 
 bool CamStreamMgr::StopRecording(int idx)
@@ -296,6 +402,108 @@ bool CamStreamMgr::StopRecording(int idx)
 	return imc->CloseVideo();
 }
 
+SessionRecording::SPtr CamStreamMgr::RecordSession(
+	const std::string& dirPath, 
+	const std::vector<SessionRecording::StreamReq>& streams)
+{
+	boost::system::error_code ec;
+	boost::filesystem::create_directories(dirPath, ec);
+	if(!boost::filesystem::is_directory(dirPath))
+	{
+		std::cout << "Could not create session directory " << dirPath << std::endl;
+		return nullptr;
+	}
+
+	SessionRecording::SPtr session = std::make_shared<SessionRecording>(dirPath);
+
+	// Videos the cameras are already recording are closed first, without
+	// camAccess. Closing drains the camera's queued video frames, which
+	// shouldn't block every other camera request, or be waited on while
+	// holding a lock. The cameras are only destroyed in Shutdown().
+	std::vector<IManagedCam*> recording;
+	{
+		std::lock_guard<std::mutex> guard(this->camAccess);
+		for(const SessionRecording::StreamReq& sr : streams)
+		{
+			IManagedCam* imc = this->_GetIManaged(sr.camId);
+			if(imc != nullptr && imc->IsRecordingVideo())
+				recording.push_back(imc);
+		}
+	}
+	for(IManagedCam* imc : recording)
+		imc->CloseVideo();
+
+	std::lock_guard<std::mutex> guard(this->camAccess);
+	for(const SessionRecording::StreamReq& sr : streams)
+	{
+		IManagedCam* imc = this->_GetIManaged(sr.camId);
+		if(imc == nullptr)
+		{
+			std::cout << "Session stream for unknown camera " << sr.camId << " was skipped." << std::endl;
+			continue;
+		}
+
+		bool alreadyRecorded = false;
+		for(const SessionRecording::Stream& s : session->streams)
+			alreadyRecorded = alreadyRecorded || (s.camId == sr.camId);
+
+		if(alreadyRecorded)
+		{
+			std::cout << "Camera " << sr.camId << " can only be recorded once in a session, the extra stream was skipped." << std::endl;
+			continue;
+		}
+
+		SessionRecording::Stream stream;
+		stream.camId	= sr.camId;
+		stream.source	= sr.source;
+		stream.name		= SessionRecording::StreamName(sr.camId, sr.source);
+
+		std::string filename = (boost::filesystem::path(dirPath) / (stream.name + ".mkv")).string();
+		int streamIdx = (int)session->streams.size();
+
+		// The log is added first, the camera may write its first frame as
+		// soon as the video is opened.
+		{
+			std::lock_guard<std::mutex> logGuard(session->logMutex);
+			session->frameLogs.emplace_back();
+		}
+		session->streams.push_back(stream);
+		session->streams.back().req = 
+			imc->OpenVideo(filename, VideoRequest::Format::Compressed, sr.source, session, streamIdx);
+	}
+
+	if(session->streams.empty())
+		return nullptr;
+
+	return session;
+}
+
+bool CamStreamMgr::StopSession(SessionRecording::SPtr session)
+{
+	if(session == nullptr)
+		return false;
+
+	// Closed without camAccess, see RecordSession().
+	std::vector<IManagedCam*> closing;
+	{
+		std::lock_guard<std::mutex> guard(this->camAccess);
+		for(const SessionRecording::Stream& s : session->streams)
+		{
+			VideoRequest::Status status = s.req->GetStatus();
+			if(status != VideoRequest::Status::Requested && status != VideoRequest::Status::StreamingOut)
+				continue;
+
+			IManagedCam* imc = this->_GetIManaged(s.camId);
+			if(imc != nullptr)
+				closing.push_back(imc);
+		}
+	}
+	for(IManagedCam* imc : closing)
+		imc->CloseVideo();
+
+	return session->WriteIndex();
+}
+
 bool CamStreamMgr::IsRecording(int idx)
 {
 	std::lock_guard<std::mutex> guard(this->camAccess);
@@ -346,6 +554,26 @@ int CamStreamMgr::GetStreamFrameCt(int idx)
 	return imc->streamFrameCt;
 }
 
+cvgJitterMeter::Stats CamStreamMgr::GetFrameJitter(int idx)
+{
+	std::lock_guard<std::mutex> guard(this->camAccess);
+	IManagedCam* imc = this->_GetIManaged(idx);
+	if(imc == nullptr)
+		return cvgJitterMeter::Stats();
+
+	return imc->frameJitter.GetStats();
+}
+
+FrameHistory::Stats CamStreamMgr::GetHistoryStats(int idx)
+{
+	std::lock_guard<std::mutex> guard(this->camAccess);
+	IManagedCam* imc = this->_GetIManaged(idx);
+	if(imc == nullptr)
+		return FrameHistory::Stats();
+
+	return imc->history.GetStats();
+}
+
 ProcessingType CamStreamMgr::GetProcessingType(int idx)
 {
 	std::lock_guard<std::mutex> guard(this->camAccess);
@@ -376,6 +604,36 @@ ManagedCam::State CamStreamMgr::GetState(int idx)
 	return imc->GetState();
 }
 
+bool CamStreamMgr::IsFrameStale(int idx)
+{
+	std::lock_guard<std::mutex> guard(this->camAccess);
+	ManagedCam* mc = this->_GetManaged(idx);
+	if(mc == nullptr)
+		return false;
+
+	return mc->IsFrameStale();
+}
+
+ManagedCam::ReconnectStats CamStreamMgr::GetReconnectStats(int idx)
+{
+	std::lock_guard<std::mutex> guard(this->camAccess);
+	ManagedCam* mc = this->_GetManaged(idx);
+	if(mc == nullptr)
+		return ManagedCam::ReconnectStats();
+
+	return mc->GetReconnectStats();
+}
+
+ManagedCam::FrameAgeStats CamStreamMgr::GetFrameAgeStats(int idx)
+{
+	std::lock_guard<std::mutex> guard(this->camAccess);
+	ManagedCam* mc = this->_GetManaged(idx);
+	if(mc == nullptr)
+		return ManagedCam::FrameAgeStats();
+
+	return mc->GetFrameAgeStats();
+}
+
 bool CamStreamMgr::Shutdown()
 {
 	std::lock_guard<std::mutex> guard(this->camAccess);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ManagedCam.h"
+#include "SessionRecording.h"
 #include "../Utils/VideoPollType.h"
 #include "../Utils/cvgCamFeedSource.h"
 
@@ -92,6 +93,17 @@ public:
 	/// <returns>True, if successful.</returns>
 	bool BootConnectionToCamera(const std::vector<cvgCamFeedSource>& sources);
 
+	/// <summary>
+	/// Apply reloaded camera options to the already booted cameras.
+	/// 
+	/// See ManagedCam::QueueOptionsReload() for what can be applied
+	/// without reconnecting. Adding or removing cameras is not supported,
+	/// and requires restarting the application.
+	/// </summary>
+	/// <param name="sources">The reloaded properties of the cameras.</param>
+	/// <returns>True if the cameras have been booted and the options were queued.</returns>
+	bool ReloadCameraOptions(const std::vector<cvgCamFeedSource>& sources);
+
 	/// <summary>
 	/// Get access to the shared pointer of the last polled image.
 	/// 
@@ -129,6 +141,37 @@ public:
 	/// <returns></returns>
 	ManagedCam::State GetState(int idx);
 
+	/// <summary>
+	/// Query if a camera's current frame is the last good frame from
+	/// before it lost its stream.
+	/// </summary>
+	/// <param name="idx">The camera index to query.</param>
+	/// <returns>
+	/// True if the camera is reconnecting. False if the camera is streaming,
+	/// or the index isn't a camera.
+	/// </returns>
+	bool IsFrameStale(int idx);
+
+	/// <summary>
+	/// Get a camera's reconnect counts and outage durations.
+	/// </summary>
+	/// <param name="idx">The camera index to query.</param>
+	/// <returns>
+	/// The camera's reconnect bookkeeping. If the index isn't a camera,
+	/// a default (zeroed) value is returned.
+	/// </returns>
+	ManagedCam::ReconnectStats GetReconnectStats(int idx);
+
+	/// <summary>
+	/// Get how old a camera's frames are when they're polled.
+	/// </summary>
+	/// <param name="idx">The camera index to query.</param>
+	/// <returns>
+	/// The camera's frame age statistics. If the index isn't a camera,
+	/// a default (unmeasured) value is returned.
+	/// </returns>
+	ManagedCam::FrameAgeStats GetFrameAgeStats(int idx);
+
 	/// <summary>
 	/// Specify how a camera should be polling for its image stream.
 	/// </summary>
@@ -156,11 +199,20 @@ public:
 	/// Do not include a file extension, (for now) it is assumed to be a Dicom file.
 	/// </param>
 	/// <param name="procType">The processing type to save.</param>
+	/// <param name="select">
+	/// Which frame to save. Frames from before the request are taken from
+	/// the stream's FrameHistory.
+	/// </param>
+	/// <param name="lookbackMS">
+	/// How far back to look for the frame, if select isn't FrameSelect::Next.
+	/// </param>
 	/// <returns>A handle to the generated snapshot request.</returns>
 	SnapRequest::SPtr RequestSnapshot(
 		int idx, 
 		const std::string& filename, 
-		SnapRequest::ProcessType procType);
+		SnapRequest::ProcessType procType,
+		SnapRequest::FrameSelect select = SnapRequest::FrameSelect::Next,
+		int lookbackMS = 0);
 
 	/// <summary>
 	/// Queue a snapshot request for all camera streams.
@@ -176,13 +228,55 @@ public:
 	/// </returns>
 	std::vector<SnapRequest::SPtr> RequestSnapshotAll(const std::string& filenameBase);
 
+	/// <summary>
+	/// Queue a burst request, to capture the next several consecutive frames 
+	/// of a stream. See BurstRequest for more information.
+	/// </summary>
+	/// <param name="idx">The video index to queue.</param>
+	/// <param name="filename">
+	/// The base filename to save the frames as. More will be added to the 
+	/// filename to identify the frame. Do not include a file extension.
+	/// </param>
+	/// <param name="frameCt">The number of frames to capture.</param>
+	/// <param name="procType">The processing type to save.</param>
+	/// <param name="average">If true, an averaged frame is also saved.</param>
+	/// <returns>A handle to the generated burst request.</returns>
+	BurstRequest::SPtr RequestBurst(
+		int idx,
+		const std::string& filename,
+		int frameCt,
+		SnapRequest::ProcessType procType,
+		bool average);
+
+	/// <summary>
+	/// Queue a burst request for all camera streams, named the same way as 
+	/// RequestSnapshotAll().
+	/// </summary>
+	/// <param name="filenameBase">The base filename to save the frames as.</param>
+	/// <param name="frameCt">The number of frames to capture per stream.</param>
+	/// <param name="average">If true, an averaged frame is also saved per stream.</param>
+	/// <returns>Handles to the generated burst requests.</returns>
+	std::vector<BurstRequest::SPtr> RequestBurstAll(
+		const std::string& filenameBase,
+		int frameCt,
+		bool average);
+
 	/// <summary>
 	/// Requests a video stream to be recorded to a video file.
 	/// </summary>
 	/// <param name="idx">The id of the video to request the recording for.</param>
 	/// <param name="filename">The video filename to record the video to.</param>
+	/// <param name="format">How the video is saved.</param>
+	/// <param name="preRollMS">
+	/// How far back before the request the video starts, using frames from
+	/// the stream's FrameHistory. Only used for compressed videos.
+	/// </param>
 	/// <returns> The VideoRequest object related to the request.</returns>
-	VideoRequest::SPtr RecordVideo(int idx, const std::string& filename);
+	VideoRequest::SPtr RecordVideo(
+		int idx, 
+		const std::string& filename, 
+		VideoRequest::Format format = VideoRequest::Format::Compressed,
+		int preRollMS = 0);
 
 	/// <summary>
 	/// Stop recording a video stream.
@@ -191,6 +285,36 @@ public:
 	/// <returns>True, if the request to stop the recording was successful.</returns>
 	bool StopRecording(int idx);
 
+	/// <summary>
+	/// Start recording several video streams at once, as a session. Any
+	/// recordings already running on the streams are stopped.
+	/// 
+	/// See SessionRecording for more information.
+	/// </summary>
+	/// <param name="dirPath">
+	/// The directory to record the session into. It's created if it doesn't
+	/// exist.
+	/// </param>
+	/// <param name="streams">
+	/// The streams to record. Each camera can only be recorded once, so
+	/// only the first stream of each camera is used.
+	/// </param>
+	/// <returns>
+	/// The session, or nullptr if none of the streams could be recorded.
+	/// Each stream's VideoRequest has its own status.
+	/// </returns>
+	SessionRecording::SPtr RecordSession(
+		const std::string& dirPath, 
+		const std::vector<SessionRecording::StreamReq>& streams);
+
+	/// <summary>
+	/// Stop recording a session, and write its frame pairing index. This 
+	/// waits for the streams' queued frames to be encoded.
+	/// </summary>
+	/// <param name="session">The session to stop.</param>
+	/// <returns>True if the session's index was written.</returns>
+	bool StopSession(SessionRecording::SPtr session);
+
 	/// <summary>
 	/// Query if a video stream is currenly saving to a file.
 	/// </summary>
@@ -232,6 +356,19 @@ public:
 	/// <param name="idx">The camera index to query.</param>
 	int GetStreamFrameCt(int idx);
 
+	/// <summary>
+	/// Query the statistics of the intervals between processed frames,
+	/// to measure how regularly the camera's thread is delivering them.
+	/// </summary>
+	/// <param name="idx">The camera index to query.</param>
+	cvgJitterMeter::Stats GetFrameJitter(int idx);
+
+	/// <summary>
+	/// Query the memory use of a stream's frame history.
+	/// </summary>
+	/// <param name="idx">The id of the video stream to query.</param>
+	FrameHistory::Stats GetHistoryStats(int idx);
+
 	/// <summary>
 	/// Query the processing type of a camera stream.
 	/// </summary>
@@ -271,6 +408,13 @@ private:
 	// Only the singleton systems should be in charge of its construction.
 	CamStreamMgr();
 
+	/// <summary>
+	/// Set the composite's frame rate, and the quality governor's budget,
+	/// from the fastest of the video feeds.
+	/// </summary>
+	/// <param name="sources">The properties of the cameras.</param>
+	static void _ApplyFrameRates(const std::vector<cvgCamFeedSource>& sources);
+
 public:
 	static void ValidateSourcePlatforms(const std::vector<cvgCamFeedSource>& sources);
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "CamSyncGroup.h"
+#include <algorithm>
+#include <chrono>
+
+// The weight of a new sample in the skew's moving average.
+const double skewAvgWeight = 0.1;
+
+// Epochs that are this far behind the current one are forgotten, even
+// if not every member reported a grab for them.
+const long long maxPendingEpochs = 8;
+
+CamSyncGroup CamSyncGroup::_inst;
+
+CamSyncGroup& CamSyncGroup::GetInstance()
+{
+	return _inst;
+}
+
+void CamSyncGroup::SetEnabled(bool enable)
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	if(this->enabled == enable)
+		return;
+
+	this->enabled = enable;
+	if(!enable)
+	{
+		this->_Release();
+		this->pendingGrabs.clear();
+	}
+}
+
+void CamSyncGroup::Join(int camId)
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	this->members.insert(camId);
+	this->stats.memberCt = (int)this->members.size();
+}
+
+void CamSyncGroup::Leave(int camId)
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	this->members.erase(camId);
+	this->arrived.erase(camId);
+	this->stats.memberCt = (int)this->members.size();
+
+	// Don't leave the rest waiting on someone who isn't coming.
+	if(!this->arrived.empty() && this->arrived.size() >= this->members.size())
+		this->_Release();
+}
+
+void CamSyncGroup::_Release()
+{
+	if(!this->arrived.empty())
+	{
+		EpochGrabs grabs;
+		grabs.expectedCt = this->arrived.size();
+		this->pendingGrabs[this->epoch] = grabs;
+
+		if(this->arrived.size() < this->members.size())
+			++this->stats.partialEpochCt;
+	}
+
+	this->arrived.clear();
+	++this->epoch;
+
+	while(!this->pendingGrabs.empty() && this->pendingGrabs.begin()->first < this->epoch - maxPendingEpochs)
+		this->pendingGrabs.erase(this->pendingGrabs.begin());
+
+	this->condRelease.notify_all();
+}
+
+long long CamSyncGroup::ArriveAndWait(int camId, int timeoutMS)
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	if(!this->enabled || this->members.count(camId) == 0)
+		return -1;
+
+	long long waitEpoch = this->epoch;
+	this->arrived.insert(camId);
+
+	if(this->arrived.size() >= this->members.size())
+	{
+		this->_Release();
+		return waitEpoch;
+	}
+
+	bool released = this->condRelease.wait_for(
+		lock,
+		std::chrono::milliseconds(timeoutMS),
+		[this, waitEpoch]{ return this->epoch != waitEpoch; });
+
+	// Whoever times out first releases everyone else that's waiting. The
+	// missing members will catch up in a later epoch.
+	if(!released)
+		this->_Release();
+
+	return waitEpoch;
+}
+
+void CamSyncGroup::ReportGrab(long long epoch, double captureMS)
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+
+	auto itFind = this->pendingGrabs.find(epoch);
+	if(itFind == this->pendingGrabs.end())
+		return;
+
+	EpochGrabs& grabs = itFind->second;
+	if(grabs.reportedCt == 0)
+	{
+		grabs.minMS = captureMS;
+		grabs.maxMS = captureMS;
+	}
+	else
+	{
+		grabs.minMS = std::min(grabs.minMS, captureMS);
+		grabs.maxMS = std::max(grabs.maxMS, captureMS);
+	}
+	++grabs.reportedCt;
+
+	if(grabs.reportedCt < grabs.expectedCt)
+		return;
+
+	// A single camera has nothing to be skewed against.
+	if(grabs.expectedCt > 1)
+	{
+		double skewMS = grabs.maxMS - grabs.minMS;
+		if(this->stats.epochCt == 0)
+			this->stats.avgSkewMS = skewMS;
+		else
+			this->stats.avgSkewMS += (skewMS - this->stats.avgSkewMS) * skewAvgWeight;
+
+		this->stats.lastSkewMS = skewMS;
+		this->stats.maxSkewMS = std::max(this->stats.maxSkewMS, skewMS);
+		++this->stats.epochCt;
+	}
+	this->pendingGrabs.erase(itFind);
+}
+
+CamSyncGroup::SkewStats CamSyncGroup::GetStats()
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	return this->stats;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <set>
+#include <map>
+
+/// <summary>
+/// Synchronizes when the cameras grab their frames, so frames that are
+/// blended together were taken as close together in time as possible.
+///
+/// Each camera thread polls independently, so on their own, two cameras can
+/// be up to a frame apart. In synchronized acquisition, every camera that
+/// supports grabbing separately from retrieving (see ICamImpl::GrabFrame())
+/// joins the group. Before each grab, a camera waits at a barrier for the
+/// rest of the group, and then they all grab at once. Each round through
+/// the barrier is an acquisition epoch, which the frames are tagged with so
+/// the composite and snapshots can pair frames from the same epoch.
+///
+/// The cameras report when their frames were captured, and the difference
+/// between the earliest and latest frame of an epoch is the skew.
+/// </summary>
+class CamSyncGroup
+{
+public:
+	struct SkewStats
+	{
+		/// <summary>
+		/// The number of cameras in the group.
+		/// </summary>
+		int memberCt = 0;
+
+		/// <summary>
+		/// The number of epochs that all members grabbed in.
+		/// </summary>
+		long long epochCt = 0;
+
+		/// <summary>
+		/// The number of epochs that were released early, because not every
+		/// member arrived in time.
+		/// </summary>
+		long long partialEpochCt = 0;
+
+		double lastSkewMS = 0.0;
+
+		/// <summary>
+		/// The moving average of the skew.
+		/// </summary>
+		double avgSkewMS = 0.0;
+
+		double maxSkewMS = 0.0;
+	};
+
+private:
+	static CamSyncGroup _inst;
+
+	std::atomic_bool enabled = false;
+
+	/// <summary>
+	/// Guards everything below.
+	/// </summary>
+	std::mutex mutex;
+
+	/// <summary>
+	/// Notified when an epoch is released.
+	/// </summary>
+	std::condition_variable condRelease;
+
+	/// <summary>
+	/// The camera ids in the group.
+	/// </summary>
+	std::set<int> members;
+
+	/// <summary>
+	/// The members waiting at the barrier for the current epoch.
+	/// </summary>
+	std::set<int> arrived;
+
+	/// <summary>
+	/// The current epoch, which members are waiting to be released into.
+	/// </summary>
+	long long epoch = 0;
+
+	/// <summary>
+	/// The capture times reported for a released epoch, until all the
+	/// members released into it have reported.
+	/// </summary>
+	struct EpochGrabs
+	{
+		size_t expectedCt = 0;
+		double minMS = 0.0;
+		double maxMS = 0.0;
+		size_t reportedCt = 0;
+	};
+	std::map<long long, EpochGrabs> pendingGrabs;
+
+	SkewStats stats;
+
+private:
+	/// <summary>
+	/// Release the members waiting at the barrier into the current epoch.
+	/// Expects the mutex to be locked.
+	/// </summary>
+	void _Release();
+
+public:
+	static CamSyncGroup& GetInstance();
+
+	/// <summary>
+	/// Enable or disable synchronized acquisition. When disabled, any
+	/// cameras waiting at the barrier are released, and cameras leave
+	/// the group on their next poll.
+	/// </summary>
+	void SetEnabled(bool enable);
+
+	inline bool IsEnabled() const
+	{ return this->enabled; }
+
+	/// <summary>
+	/// Add a camera to the group.
+	/// </summary>
+	void Join(int camId);
+
+	/// <summary>
+	/// Remove a camera from the group. If the rest of the group is waiting
+	/// on the camera, they're released.
+	/// </summary>
+	void Leave(int camId);
+
+	/// <summary>
+	/// Wait for the rest of the group to arrive, so every member grabs
+	/// at the same time.
+	/// </summary>
+	/// <param name="camId">The arriving camera.</param>
+	/// <param name="timeoutMS">
+	/// The longest to wait for the rest of the group. If it times out, the
+	/// members that did arrive are released without the rest.
+	/// </param>
+	/// <returns>
+	/// The epoch to tag the grabbed frame with, or -1 if the camera isn't
+	/// in the group.
+	/// </returns>
+	long long ArriveAndWait(int camId, int timeoutMS);
+
+	/// <summary>
+	/// Report when a member's frame for an epoch was captured.
+	/// </summary>
+	/// <param name="epoch">The epoch returned from ArriveAndWait().</param>
+	/// <param name="captureMS">
+	/// When the frame was captured, in milliseconds of the steady (monotonic)
+	/// clock.
+	/// </param>
+	void ReportGrab(long long epoch, double captureMS);
+
+	SkewStats GetStats();
+};
@@ -0,0 +1,715 @@
+#include "CaptureStorage.h"
+
+#include <boost/filesystem.hpp>
+#include <iostream>
+#include <cstdio>
+#include <cerrno>
+#include <set>
+#include <algorithm>
+
+#if _WIN32
+	#include <io.h>
+#else
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#if CVG_IO_URING
+	#include <liburing.h>
+#endif
+
+CaptureStorage CaptureStorage::_inst;
+
+namespace
+{
+	typedef std::chrono::steady_clock StorageClock;
+
+	/// <summary>
+	/// The most files written and synced in a batch, regardless of the
+	/// settings.
+	/// </summary>
+	const size_t maxBatchFiles = 32;
+
+#if !_WIN32
+	/// <summary>
+	/// Open a file to be written, creating its folder if it was removed.
+	/// </summary>
+	/// <returns>The file descriptor, or -1.</returns>
+	int OpenForWrite(const std::string& path)
+	{
+		int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if(fd == -1 && errno == ENOENT && CaptureStorage::EnsureParentFolder(path))
+			fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+		return fd;
+	}
+
+	/// <summary>
+	/// Reserve a file's space before it's written.
+	/// </summary>
+	/// <returns>False if the card is out of space.</returns>
+	bool Preallocate(int fd, size_t bytes)
+	{
+		if(bytes == 0)
+			return true;
+
+	#if __linux__
+		// Not posix_fallocate(), which falls back to writing the file out
+		// when the filesystem can't preallocate, as with some SD cards.
+		if(fallocate(fd, 0, 0, (off_t)bytes) == -1)
+			return errno != ENOSPC;
+	#endif
+		return true;
+	}
+
+	/// <summary>
+	/// Sync the folders of a batch of files, so the new files are found
+	/// after a power loss.
+	/// </summary>
+	void SyncFolders(const std::set<std::string>& folders)
+	{
+		for(const std::string& folder : folders)
+		{
+			int dirFd = open(folder.empty() ? "." : folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if(dirFd == -1)
+				continue;
+
+			fsync(dirFd);
+			close(dirFd);
+		}
+	}
+#endif
+}
+
+#if CVG_IO_URING
+struct CaptureStorage::Ring
+{
+	io_uring ring;
+	bool ready = false;
+
+	~Ring()
+	{
+		if(this->ready)
+			io_uring_queue_exit(&this->ring);
+	}
+};
+#else
+struct CaptureStorage::Ring
+{};
+#endif
+
+CaptureStorage::CaptureStorage()
+{}
+
+CaptureStorage::~CaptureStorage()
+{
+	this->Shutdown();
+}
+
+CaptureStorage& CaptureStorage::GetInstance()
+{
+	return _inst;
+}
+
+void CaptureStorage::SetSettings(const Settings& newSettings)
+{
+	std::lock_guard<std::mutex> guard(this->access);
+	this->settings = newSettings;
+	if(this->settings.syncBatch < 1)
+		this->settings.syncBatch = 1;
+}
+
+CaptureStorage::Settings CaptureStorage::GetSettings()
+{
+	std::lock_guard<std::mutex> guard(this->access);
+	return this->settings;
+}
+
+std::string CaptureStorage::EnsureSessionFolder(
+	const std::string& folder,
+	const std::function<void(const std::string&)>& onCreated)
+{
+	std::lock_guard<std::mutex> folderGuard(this->folderAccess);
+	if(this->folderReady && folder == this->sessionFolder)
+		return folder;
+
+	this->sessionFolder = folder;
+	this->folderReady = false;
+
+	boost::system::error_code ec;
+	if(!boost::filesystem::is_directory(folder, ec))
+	{
+		boost::filesystem::create_directories(folder, ec);
+		if(!boost::filesystem::is_directory(folder, ec))
+		{
+			std::cerr << "Could not create the captures folder " << folder << std::endl;
+			return "";
+		}
+
+		if(onCreated)
+			onCreated(folder);
+	}
+	this->folderReady = true;
+
+	{
+		std::lock_guard<std::mutex> guard(this->access);
+		this->spacePath = folder;
+		this->_EnsureThread();
+	}
+	this->_CheckFreeSpace(true);
+	return folder;
+}
+
+void CaptureStorage::_EnsureThread()
+{
+	if(this->shutDown || this->writeThread.joinable())
+		return;
+
+	this->stopping = false;
+	this->writeThread = std::thread([this]{ this->_WriteThreadFn(); });
+}
+
+bool CaptureStorage::EnsureParentFolder(const std::string& path)
+{
+	boost::filesystem::path parent = boost::filesystem::path(path).parent_path();
+	if(parent.empty())
+		return true;
+
+	boost::system::error_code ec;
+	boost::filesystem::create_directories(parent, ec);
+	return boost::filesystem::is_directory(parent, ec);
+}
+
+bool CaptureStorage::WriteFile(
+	const std::string& path, 
+	std::vector<unsigned char>&& bytes,
+	std::function<void(bool)> onWritten)
+{
+	if(!this->HasRoomFor(bytes.size()))
+	{
+		std::cerr << "Not enough free space to write " << path << std::endl;
+		{
+			std::lock_guard<std::mutex> guard(this->access);
+			++this->stats.errorCt;
+		}
+		if(onWritten)
+			onWritten(false);
+
+		return false;
+	}
+
+	std::vector<Job> batch(1);
+	batch[0].path = path;
+	batch[0].bytes = std::move(bytes);
+	batch[0].queuedTime = StorageClock::now();
+	batch[0].onWritten = std::move(onWritten);
+
+	{
+		std::lock_guard<std::mutex> guard(this->access);
+		this->_EnsureThread();
+
+		size_t jobBytes = batch[0].bytes.size();
+		if(this->writeThread.joinable() && this->queuedBytes + jobBytes <= this->settings.bufferBytes)
+		{
+			this->queuedBytes += jobBytes;
+			if(this->queuedBytes > this->stats.peakQueuedBytes)
+				this->stats.peakQueuedBytes = this->queuedBytes;
+
+			this->queue.push_back(std::move(batch[0]));
+			this->queueCond.notify_one();
+			return true;
+		}
+		++this->stats.writeThroughCt;
+	}
+
+	// Over the memory budget, so the caller waits on the card instead.
+	return this->_WriteBatch(batch, false) == 0;
+}
+
+void CaptureStorage::_WriteThreadFn()
+{
+	while(true)
+	{
+		std::vector<Job> batch;
+		size_t batchBytes = 0;
+		{
+			std::unique_lock<std::mutex> lock(this->access);
+			this->queueCond.wait_for(
+				lock,
+				std::chrono::milliseconds(spaceCheckMS),
+				[this]{ return !this->queue.empty() || this->stopping; });
+
+			if(this->queue.empty() && this->stopping)
+				break;
+
+			size_t maxBatch = (size_t)this->settings.syncBatch;
+			if(maxBatch > maxBatchFiles)
+				maxBatch = maxBatchFiles;
+
+			while(!this->queue.empty() && batch.size() < maxBatch)
+			{
+				batchBytes += this->queue.front().bytes.size();
+				batch.push_back(std::move(this->queue.front()));
+				this->queue.pop_front();
+			}
+			this->writingBatch = !batch.empty();
+		}
+
+		if(!batch.empty())
+			this->_WriteBatch(batch, true);
+
+		this->_CheckFreeSpace(false);
+
+		{
+			// The batch's memory was in use until now.
+			std::lock_guard<std::mutex> guard(this->access);
+			this->queuedBytes -= batchBytes;
+			this->writingBatch = false;
+		}
+		this->idleCond.notify_all();
+	}
+
+	std::lock_guard<std::mutex> guard(this->access);
+	this->ring.reset();
+}
+
+int CaptureStorage::_WriteBatch(std::vector<Job>& batch, bool allowRing)
+{
+	StorageClock::time_point start = StorageClock::now();
+	std::vector<bool> failed(batch.size(), false);
+
+	bool usedRing = false;
+#if CVG_IO_URING
+	if(allowRing)
+		usedRing = this->_WriteBatchRing(batch, failed);
+#endif
+	if(!usedRing)
+		this->_WriteBatchPosix(batch, failed);
+
+	StorageClock::time_point end = StorageClock::now();
+
+	int failCt = 0;
+	{
+		std::lock_guard<std::mutex> guard(this->access);
+		for(size_t i = 0; i < batch.size(); ++i)
+		{
+			if(failed[i])
+			{
+				std::cerr << "Could not write " << batch[i].path << std::endl;
+				++failCt;
+				continue;
+			}
+
+			double latencyMS = std::chrono::duration<double, std::milli>(end - batch[i].queuedTime).count();
+			++this->stats.fileCt;
+			this->stats.bytesWritten += (long long)batch[i].bytes.size();
+			this->stats.latencyTotalMS += latencyMS;
+			if(latencyMS > this->stats.latencyMaxMS)
+				this->stats.latencyMaxMS = latencyMS;
+		}
+		this->stats.errorCt += failCt;
+		this->stats.writeSeconds += std::chrono::duration<double>(end - start).count();
+		++this->stats.syncBatchCt;
+		if(allowRing)
+			this->stats.ioUring = usedRing;
+	}
+
+	// Outside the lock, the callbacks may ask the storage for something.
+	for(size_t i = 0; i < batch.size(); ++i)
+	{
+		if(batch[i].onWritten)
+			batch[i].onWritten(!failed[i]);
+	}
+
+	return failCt;
+}
+
+#if _WIN32
+
+void CaptureStorage::_WriteBatchPosix(std::vector<Job>& batch, std::vector<bool>& failed)
+{
+	std::vector<FILE*> files(batch.size(), nullptr);
+	for(size_t i = 0; i < batch.size(); ++i)
+	{
+		FILE* file = fopen(batch[i].path.c_str(), "wb");
+		if(file == nullptr && EnsureParentFolder(batch[i].path))
+			file = fopen(batch[i].path.c_str(), "wb");
+
+		if(file == nullptr)
+		{
+			failed[i] = true;
+			continue;
+		}
+
+		files[i] = file;
+		const std::vector<unsigned char>& bytes = batch[i].bytes;
+		if(!bytes.empty() && fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size())
+			failed[i] = true;
+	}
+
+	// Sync the batch together, after everything is written.
+	for(size_t i = 0; i < batch.size(); ++i)
+	{
+		if(files[i] == nullptr)
+			continue;
+
+		if(fflush(files[i]) != 0 || _commit(_fileno(files[i])) != 0)
+			failed[i] = true;
+		if(fclose(files[i]) != 0)
+			failed[i] = true;
+	}
+}
+
+#else
+
+void CaptureStorage::_WriteBatchPosix(std::vector<Job>& batch, std::vector<bool>& failed)
+{
+	bool preallocate = this->GetSettings().preallocate;
+
+	std::vector<int> fds(batch.size(), -1);
+	std::set<std::string> folders;
+	for(size_t i = 0; i < batch.size(); ++i)
+	{
+		int fd = OpenForWrite(batch[i].path);
+		if(fd == -1)
+		{
+			failed[i] = true;
+			continue;
+		}
+		fds[i] = fd;
+		folders.insert(boost::filesystem::path(batch[i].path).parent_path().string());
+
+		const std::vector<unsigned char>& bytes = batch[i].bytes;
+		if(preallocate && !Preallocate(fd, bytes.size()))
+		{
+			failed[i] = true;
+			continue;
+		}
+
+		size_t offset = 0;
+		while(offset < bytes.size())
+		{
+			ssize_t written = write(fd, bytes.data() + offset, bytes.size() - offset);
+			if(written == -1 && errno == EINTR)
+				continue;
+
+			if(written <= 0)
+			{
+				failed[i] = true;
+				break;
+			}
+			offset += (size_t)written;
+		}
+	}
+
+	// Sync the batch together, after everything is written.
+	for(size_t i = 0; i < batch.size(); ++i)
+	{
+		if(fds[i] == -1)
+			continue;
+
+		if(!failed[i] && fdatasync(fds[i]) == -1)
+			failed[i] = true;
+		close(fds[i]);
+	}
+	SyncFolders(folders);
+}
+
+#endif
+
+#if CVG_IO_URING
+
+bool CaptureStorage::_WriteBatchRing(std::vector<Job>& batch, std::vector<bool>& failed)
+{
+	Settings curSettings = this->GetSettings();
+	if(!curSettings.useIOUring || this->ringFailed)
+		return false;
+
+	if(this->ring == nullptr)
+	{
+		// Enough entries for the writes and syncs of the largest batch.
+		std::unique_ptr<Ring> newRing(new Ring());
+		int err = io_uring_queue_init((unsigned)(maxBatchFiles * 2), &newRing->ring, 0);
+		if(err < 0)
+		{
+			this->ringFailed = true;
+			std::cerr << "io_uring is not available (" << -err << "), writing captures with POSIX calls." << std::endl;
+			return false;
+		}
+		newRing->ready = true;
+		this->ring = std::move(newRing);
+	}
+	io_uring* uring = &this->ring->ring;
+
+	// The files are opened and preallocated the same as without io_uring,
+	// the writes and syncs are what's batched.
+	struct Pending
+	{
+		int fd = -1;
+		size_t offset = 0;
+		size_t index = 0;
+	};
+	std::vector<Pending> pending(batch.size());
+	std::set<std::string> folders;
+	for(size_t i = 0; i < batch.size(); ++i)
+	{
+		pending[i].index = i;
+		pending[i].fd = OpenForWrite(batch[i].path);
+		if(pending[i].fd == -1)
+		{
+			failed[i] = true;
+			continue;
+		}
+		folders.insert(boost::filesystem::path(batch[i].path).parent_path().string());
+
+		if(curSettings.preallocate && !Preallocate(pending[i].fd, batch[i].bytes.size()))
+			failed[i] = true;
+	}
+
+	// Get a submission entry, submitting what's queued to make room if
+	// the submission queue is full.
+	auto fnGetSqe = [&]() -> io_uring_sqe*
+	{
+		io_uring_sqe* sqe = io_uring_get_sqe(uring);
+		if(sqe == nullptr)
+		{
+			io_uring_submit(uring);
+			sqe = io_uring_get_sqe(uring);
+		}
+		return sqe;
+	};
+
+	auto fnQueueWrite = [&](Pending& p)
+	{
+		io_uring_sqe* sqe = fnGetSqe();
+		if(sqe == nullptr)
+			return false;
+
+		const std::vector<unsigned char>& bytes = batch[p.index].bytes;
+		io_uring_prep_write(sqe, p.fd, bytes.data() + p.offset, (unsigned)(bytes.size() - p.offset), (__u64)p.offset);
+		io_uring_sqe_set_data(sqe, &p);
+		return true;
+	};
+
+	auto fnWaitCqe = [&](io_uring_cqe*& cqe)
+	{
+		while(true)
+		{
+			int err = io_uring_wait_cqe(uring, &cqe);
+			if(err == -EINTR || err == -EAGAIN)
+				continue;
+
+			if(err < 0 || cqe == nullptr)
+			{
+				std::cerr << "Waiting on io_uring failed (" << -err << "), writing captures with POSIX calls." << std::endl;
+				return false;
+			}
+			return true;
+		}
+	};
+
+	// If a wait fails, what's still in flight can't be accounted for. Its
+	// completions would point at this call's pending entries after they're 
+	// gone, so they're never waited on again: the ring is torn down, and 
+	// the batch is written again without it.
+	bool ringBroken = false;
+
+	// WRITE EVERYTHING
+	int inFlight = 0;
+	for(Pending& p : pending)
+	{
+		if(p.fd == -1 || failed[p.index] || batch[p.index].bytes.empty())
+			continue;
+
+		if(!fnQueueWrite(p))
+		{
+			failed[p.index] = true;
+			continue;
+		}
+		++inFlight;
+	}
+	io_uring_submit(uring);
+
+	while(inFlight > 0)
+	{
+		io_uring_cqe* cqe = nullptr;
+		if(!fnWaitCqe(cqe))
+		{
+			ringBroken = true;
+			break;
+		}
+
+		Pending& p = *(Pending*)io_uring_cqe_get_data(cqe);
+		int res = cqe->res;
+		io_uring_cqe_seen(uring, cqe);
+		--inFlight;
+
+		if(res <= 0)
+		{
+			failed[p.index] = true;
+			continue;
+		}
+
+		// Short writes continue where they left off.
+		p.offset += (size_t)res;
+		if(p.offset < batch[p.index].bytes.size())
+		{
+			if(!fnQueueWrite(p))
+			{
+				failed[p.index] = true;
+				continue;
+			}
+			++inFlight;
+			io_uring_submit(uring);
+		}
+	}
+
+	// SYNC EVERYTHING TOGETHER
+	inFlight = 0;
+	for(size_t i = 0; !ringBroken && i < pending.size(); ++i)
+	{
+		Pending& p = pending[i];
+		if(p.fd == -1 || failed[p.index])
+			continue;
+
+		io_uring_sqe* sqe = fnGetSqe();
+		if(sqe == nullptr)
+		{
+			failed[p.index] = true;
+			continue;
+		}
+		io_uring_prep_fsync(sqe, p.fd, IORING_FSYNC_DATASYNC);
+		io_uring_sqe_set_data(sqe, &p);
+		++inFlight;
+	}
+	if(inFlight > 0)
+		io_uring_submit(uring);
+
+	while(inFlight > 0)
+	{
+		io_uring_cqe* cqe = nullptr;
+		if(!fnWaitCqe(cqe))
+		{
+			ringBroken = true;
+			break;
+		}
+
+		Pending& p = *(Pending*)io_uring_cqe_get_data(cqe);
+		if(cqe->res < 0)
+			failed[p.index] = true;
+		io_uring_cqe_seen(uring, cqe);
+		--inFlight;
+	}
+
+	if(ringBroken)
+	{
+		// Tearing down the ring cancels or finishes what's in flight, 
+		// before the files are closed.
+		this->ring.reset();
+		this->ringFailed = true;
+	}
+
+	for(Pending& p : pending)
+	{
+		if(p.fd != -1)
+			close(p.fd);
+	}
+
+	if(ringBroken)
+	{
+		std::fill(failed.begin(), failed.end(), false);
+		return false;
+	}
+
+	SyncFolders(folders);
+	return true;
+}
+
+#endif
+
+void CaptureStorage::_CheckFreeSpace(bool force)
+{
+	std::string path;
+	{
+		std::lock_guard<std::mutex> guard(this->access);
+		StorageClock::time_point now = StorageClock::now();
+		if(!force && now - this->lastSpaceCheck < std::chrono::milliseconds(spaceCheckMS))
+			return;
+
+		this->lastSpaceCheck = now;
+		path = this->spacePath;
+	}
+
+	boost::system::error_code ec;
+	boost::filesystem::space_info space = boost::filesystem::space(path, ec);
+	if(ec)
+		return;
+
+	std::lock_guard<std::mutex> guard(this->access);
+	this->stats.freeBytes = (uint64_t)space.available;
+	this->stats.capacityBytes = (uint64_t)space.capacity;
+
+	bool low = this->stats.freeBytes < this->settings.warnFreeBytes;
+	if(low && !this->warnedLowSpace)
+	{
+		std::cerr <<
+			"Storage is low: " << (this->stats.freeBytes / (1024 * 1024)) <<
+			" MB free in " << path << std::endl;
+	}
+	this->warnedLowSpace = low;
+}
+
+void CaptureStorage::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(this->access);
+	this->idleCond.wait(
+		lock,
+		[this]{ return (this->queue.empty() && !this->writingBatch) || !this->writeThread.joinable(); });
+}
+
+bool CaptureStorage::HasRoomFor(uint64_t bytes)
+{
+	this->_CheckFreeSpace(false);
+
+	std::lock_guard<std::mutex> guard(this->access);
+	if(this->stats.capacityBytes == 0)
+		return true;
+
+	// The queued files haven't taken their space yet.
+	uint64_t needed = bytes + (uint64_t)this->queuedBytes + reserveBytes;
+	return this->stats.freeBytes >= needed;
+}
+
+bool CaptureStorage::IsLowOnSpace()
+{
+	std::lock_guard<std::mutex> guard(this->access);
+	return this->stats.capacityBytes != 0 && this->stats.freeBytes < this->settings.warnFreeBytes;
+}
+
+CaptureStorage::Stats CaptureStorage::GetStats()
+{
+	std::lock_guard<std::mutex> guard(this->access);
+	Stats ret = this->stats;
+	ret.queuedCt = (int)this->queue.size();
+	ret.queuedBytes = this->queuedBytes;
+	return ret;
+}
+
+void CaptureStorage::Shutdown()
+{
+	std::thread toJoin;
+	{
+		std::lock_guard<std::mutex> guard(this->access);
+		this->shutDown = true;
+		this->stopping = true;
+		toJoin = std::move(this->writeThread);
+	}
+	this->queueCond.notify_all();
+
+	// The writer thread empties the queue before it stops.
+	if(toJoin.joinable())
+		toJoin.join();
+
+	this->idleCond.notify_all();
+}
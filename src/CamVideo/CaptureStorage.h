@@ -0,0 +1,339 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+/// <summary>
+/// The storage layer captures are written through. It owns the session's
+/// captures folder, and writes files behind the tasks that encode them, so
+/// a slow SD card doesn't back up into the capture path.
+///
+/// - Write-behind: WriteFile() queues a file's bytes for the writer thread,
+///   as long as everything queued fits in the memory budget. Past the budget,
+///   the caller writes the file itself, so a slow card slows down the encode
+///   tasks instead of using more memory.
+/// - Each file's space is preallocated with fallocate (on Linux) before it's
+///   written, so the filesystem can place it in one piece.
+/// - Files are synced in batches, along with their folder, instead of one
+///   at a time.
+/// - The free space of the card is checked periodically, see IsLowOnSpace().
+///   Files that would leave less than reserveBytes free aren't written.
+/// - On Linux, if built with CVG_IO_URING (make IOURING=1), the writer thread
+///   writes and syncs its batches through io_uring. Else, or if io_uring
+///   isn't available, it uses POSIX calls.
+///
+/// Compressed videos are written by OpenCV, and raw recordings by
+/// RawCaptureWriter's memory mapped chunks, so they don't go through the
+/// write queue. Raw recordings check HasRoomFor() before preallocating.
+/// </summary>
+class CaptureStorage
+{
+public:
+	struct Settings
+	{
+		/// <summary>
+		/// The most memory used by queued files. If 0, files are written
+		/// by the caller.
+		/// </summary>
+		size_t bufferBytes = 64 * 1024 * 1024;
+
+		/// <summary>
+		/// The most files written before they're synced together.
+		/// </summary>
+		int syncBatch = 16;
+
+		/// <summary>
+		/// When the free space falls below this, IsLowOnSpace() is true.
+		/// </summary>
+		uint64_t warnFreeBytes = 1024ull * 1024 * 1024;
+
+		/// <summary>
+		/// If true, files are preallocated before they're written.
+		/// </summary>
+		bool preallocate = true;
+
+		/// <summary>
+		/// If true, io_uring is used if the program was built with it.
+		/// </summary>
+		bool useIOUring = true;
+	};
+
+	struct Stats
+	{
+		/// <summary>
+		/// The number of files written and synced.
+		/// </summary>
+		long long fileCt = 0;
+		long long bytesWritten = 0;
+
+		/// <summary>
+		/// The time spent writing and syncing.
+		/// </summary>
+		double writeSeconds = 0.0;
+
+		/// <summary>
+		/// The number of files written by the caller, because the queue
+		/// was over the memory budget.
+		/// </summary>
+		long long writeThroughCt = 0;
+
+		/// <summary>
+		/// The number of files that couldn't be written.
+		/// </summary>
+		long long errorCt = 0;
+
+		long long syncBatchCt = 0;
+
+		int queuedCt = 0;
+		size_t queuedBytes = 0;
+		size_t peakQueuedBytes = 0;
+
+		/// <summary>
+		/// The times from WriteFile() being called to the file being synced.
+		/// </summary>
+		double latencyTotalMS = 0.0;
+		double latencyMaxMS = 0.0;
+
+		/// <summary>
+		/// The free space and size of the card. 0 if it hasn't been checked.
+		/// </summary>
+		uint64_t freeBytes = 0;
+		uint64_t capacityBytes = 0;
+
+		/// <summary>
+		/// If true, the writer thread is using io_uring.
+		/// </summary>
+		bool ioUring = false;
+
+		inline double MBPerSec() const
+		{ return (this->writeSeconds > 0.0) ? (double)this->bytesWritten / (1024.0 * 1024.0) / this->writeSeconds : 0.0; }
+
+		inline double AvgLatencyMS() const
+		{ return (this->fileCt > 0) ? this->latencyTotalMS / (double)this->fileCt : 0.0; }
+	};
+
+	/// <summary>
+	/// The space always left free on the card.
+	/// </summary>
+	static const uint64_t reserveBytes = 64ull * 1024 * 1024;
+
+	/// <summary>
+	/// How often the writer thread checks the free space.
+	/// </summary>
+	static const int spaceCheckMS = 2000;
+
+private:
+	/// <summary>
+	/// A file waiting to be written.
+	/// </summary>
+	struct Job
+	{
+		std::string path;
+		std::vector<unsigned char> bytes;
+		std::chrono::steady_clock::time_point queuedTime;
+
+		/// <summary>
+		/// If not empty, called once the file is synced, or failed.
+		/// </summary>
+		std::function<void(bool)> onWritten;
+	};
+
+	/// <summary>
+	/// The io_uring state of the writer thread, only defined when built
+	/// with CVG_IO_URING.
+	/// </summary>
+	struct Ring;
+
+	static CaptureStorage _inst;
+
+	/// <summary>
+	/// Guards the session folder. May be locked before access, but not
+	/// after.
+	/// </summary>
+	std::mutex folderAccess;
+	std::string sessionFolder;
+	bool folderReady = false;
+
+	/// <summary>
+	/// Guards everything below.
+	/// </summary>
+	std::mutex access;
+
+	/// <summary>
+	/// Notified when a file is queued, or the writer thread is stopped.
+	/// </summary>
+	std::condition_variable queueCond;
+
+	/// <summary>
+	/// Notified when the writer thread finishes a batch.
+	/// </summary>
+	std::condition_variable idleCond;
+
+	Settings settings;
+	std::deque<Job> queue;
+
+	/// <summary>
+	/// The bytes of the queued files, and the batch being written.
+	/// </summary>
+	size_t queuedBytes = 0;
+
+	/// <summary>
+	/// If true, the writer thread is writing a batch.
+	/// </summary>
+	bool writingBatch = false;
+
+	std::thread writeThread;
+	bool stopping = false;
+
+	/// <summary>
+	/// If true, Shutdown() was called, and the writer thread won't be
+	/// started again.
+	/// </summary>
+	bool shutDown = false;
+
+	/// <summary>
+	/// The folder whose filesystem's free space is checked.
+	/// </summary>
+	std::string spacePath = ".";
+	std::chrono::steady_clock::time_point lastSpaceCheck;
+	bool warnedLowSpace = false;
+
+	Stats stats;
+
+	/// <summary>
+	/// Only used by the writer thread.
+	/// </summary>
+	std::unique_ptr<Ring> ring;
+	bool ringFailed = false;
+
+private:
+	CaptureStorage();
+
+	/// <summary>
+	/// Start the writer thread, if it isn't running. Expects access to be
+	/// locked.
+	/// </summary>
+	void _EnsureThread();
+
+	void _WriteThreadFn();
+
+	/// <summary>
+	/// Write and sync a batch of files.
+	/// </summary>
+	/// <param name="batch">The files to write.</param>
+	/// <param name="allowRing">
+	/// If true, io_uring may be used. Only the writer thread uses it.
+	/// </param>
+	/// <returns>The number of files that couldn't be written.</returns>
+	int _WriteBatch(std::vector<Job>& batch, bool allowRing);
+
+	/// <summary>
+	/// Write and sync a batch with POSIX (or Win32 CRT) calls.
+	/// </summary>
+	/// <param name="failed">Set to true for each file that failed.</param>
+	void _WriteBatchPosix(std::vector<Job>& batch, std::vector<bool>& failed);
+
+#if CVG_IO_URING
+	/// <summary>
+	/// Write and sync a batch through io_uring.
+	/// </summary>
+	/// <returns>
+	/// False if io_uring couldn't be used, or failed part way and was torn
+	/// down. Either way, the batch still has to be written.
+	/// </returns>
+	bool _WriteBatchRing(std::vector<Job>& batch, std::vector<bool>& failed);
+#endif
+
+	/// <summary>
+	/// Check the free space, if it hasn't been checked recently.
+	/// </summary>
+	/// <param name="force">If true, check it regardless.</param>
+	void _CheckFreeSpace(bool force);
+
+public:
+	~CaptureStorage();
+
+	CaptureStorage(const CaptureStorage&) = delete;
+	CaptureStorage& operator=(const CaptureStorage&) = delete;
+
+	static CaptureStorage& GetInstance();
+
+	void SetSettings(const Settings& newSettings);
+	Settings GetSettings();
+
+	/// <summary>
+	/// Create the session's captures folder if it doesn't exist. After the
+	/// first call, the same folder is returned without checking the disk.
+	/// </summary>
+	/// <param name="folder">The session's captures folder.</param>
+	/// <param name="onCreated">
+	/// If not empty, called with the folder when it had to be created.
+	/// </param>
+	/// <returns>The folder, or an empty string if it couldn't be created.</returns>
+	std::string EnsureSessionFolder(
+		const std::string& folder,
+		const std::function<void(const std::string&)>& onCreated);
+
+	/// <summary>
+	/// Create a file's folder, if it doesn't exist. Files written through
+	/// WriteFile() have their folder recreated if it's removed during the
+	/// session. Files written another way, such as videos and multi-frame
+	/// DICOMs, call this before they're opened.
+	/// </summary>
+	/// <returns>False if the folder couldn't be created.</returns>
+	static bool EnsureParentFolder(const std::string& path);
+
+	/// <summary>
+	/// Write a file, replacing any existing file, behind the caller.
+	/// </summary>
+	/// <param name="path">The file to write.</param>
+	/// <param name="bytes">The file's contents, which are taken.</param>
+	/// <param name="onWritten">
+	/// If not empty, called once with true when the file is written and 
+	/// synced, or false if it couldn't be. It's usually called from the 
+	/// writer thread, but may be called before WriteFile() returns.
+	/// </param>
+	/// <returns>
+	/// False if the file couldn't be written by the caller, or there isn't
+	/// room for it on the card. True only means the file was queued; queued
+	/// files that fail later are reported to onWritten, and counted in
+	/// Stats::errorCt.
+	/// </returns>
+	bool WriteFile(
+		const std::string& path, 
+		std::vector<unsigned char>&& bytes,
+		std::function<void(bool)> onWritten = nullptr);
+
+	/// <summary>
+	/// Wait for every queued file to be written and synced.
+	/// </summary>
+	void WaitIdle();
+
+	/// <summary>
+	/// Check if a file can be written and still leave reserveBytes free.
+	/// If the free space is unknown, it's assumed there's room.
+	/// </summary>
+	/// <param name="bytes">The size of the file.</param>
+	bool HasRoomFor(uint64_t bytes);
+
+	/// <summary>
+	/// Check if the free space is below Settings::warnFreeBytes.
+	/// </summary>
+	bool IsLowOnSpace();
+
+	Stats GetStats();
+
+	/// <summary>
+	/// Write every queued file and stop the writer thread. Files written
+	/// afterwards are written by the caller.
+	/// </summary>
+	void Shutdown();
+};
@@ -0,0 +1,130 @@
+#include "CaptureWarmup.h"
+#include "IManagedCam.h"
+#include "CaptureStorage.h"
+#include "DicomCompress.h"
+#include "../DicomUtils/DicomInjectorSet.h"
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <dcmtk/dcmdata/dcdict.h>
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <iomanip>
+
+std::mutex CaptureWarmup::timingsAccess;
+CaptureWarmup::Timings CaptureWarmup::lastTimings;
+
+namespace
+{
+	typedef std::chrono::steady_clock WarmupClock;
+
+	double MSSince(WarmupClock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(WarmupClock::now() - start).count();
+	}
+}
+
+double CaptureWarmup::EnsureFolder(std::ostream& os, const std::function<std::string()>& ensureFolder)
+{
+	WarmupClock::time_point start = WarmupClock::now();
+	if(ensureFolder && ensureFolder().empty())
+		os << "Warm-up: could not create the session's captures folder." << std::endl;
+
+	return MSSince(start);
+}
+
+CaptureWarmup::Timings CaptureWarmup::Run(
+	std::ostream& os,
+	const std::vector<cv::Ptr<cv::Mat>>& sampleFrames,
+	double folderMS)
+{
+	Timings timings;
+	timings.folderMS = folderMS;
+
+	// LOAD THE DATA DICTIONARY
+	WarmupClock::time_point stepStart = WarmupClock::now();
+	if(!dcmDataDict.isDictionaryLoaded())
+		os << "Warm-up: no DICOM data dictionary loaded." << std::endl;
+	timings.dictionaryMS = MSSince(stepStart);
+
+	// BUILD THE HEADER TEMPLATE
+	stepStart = WarmupClock::now();
+	DicomInjectorSet::GetSingleton().PrepareTemplate();
+	timings.templateMS = MSSince(stepStart);
+
+	std::vector<cv::Mat> frames;
+	for(const cv::Ptr<cv::Mat>& sample : sampleFrames)
+	{
+		if(sample != nullptr && !sample->empty())
+			frames.push_back(sample->clone());
+	}
+	if(frames.empty())
+		frames.push_back(cv::Mat(480, 640, CV_8UC3, cv::Scalar::all(0)));
+
+	// The throwaway files don't go in the session folder.
+	boost::system::error_code ec;
+	boost::filesystem::path tempDir =
+		boost::filesystem::temp_directory_path(ec) / boost::filesystem::unique_path("hmdop_warmup_%%%%%%%%");
+	boost::filesystem::create_directories(tempDir, ec);
+
+	// ENCODE A SNAPSHOT OF EACH FRAME
+	stepStart = WarmupClock::now();
+	{
+		// The throwaway encodes aren't the session's, they're left out of
+		// the compression totals shown on the debug view.
+		DicomCompress::UncountedScope uncounted;
+		for(size_t i = 0; i < frames.size(); ++i)
+		{
+			std::string baseFilename = (tempDir / ("snap_" + std::to_string(i))).string();
+			if(!SaveMatAsDicomBmp(cv::makePtr<cv::Mat>(frames[i]), nullptr, baseFilename, std::string(), -1))
+				os << "Warm-up: the throwaway snapshot failed." << std::endl;
+		}
+	}
+	// Including the CaptureStorage writing them, before they're deleted.
+	CaptureStorage::GetInstance().WaitIdle();
+	timings.snapshotMS = MSSince(stepStart);
+
+	// OPEN THE VIDEO ENCODER FOR EACH FRAME, THE SAME WAY RECORDINGS DO
+	stepStart = WarmupClock::now();
+	for(size_t i = 0; i < frames.size(); ++i)
+	{
+		cv::Mat videoFrame = frames[i];
+		if(videoFrame.channels() == 4)
+			cv::cvtColor(videoFrame, videoFrame, cv::COLOR_BGRA2BGR);
+
+		std::string videoPath = (tempDir / ("video_" + std::to_string(i) + ".mp4")).string();
+		int mp4FourCC = cv::VideoWriter::fourcc('a', 'v', 'c', '1');
+		cv::VideoWriter writer;
+		writer.open(videoPath, mp4FourCC, 30.0, videoFrame.size(), videoFrame.channels() != 1);
+		if(!writer.isOpened())
+		{
+			os << "Warm-up: could not open the throwaway video." << std::endl;
+			continue;
+		}
+		writer.write(videoFrame);
+		writer.release();
+	}
+	timings.videoMS = MSSince(stepStart);
+
+	boost::filesystem::remove_all(tempDir, ec);
+
+	timings.done = true;
+	os << std::fixed << std::setprecision(2) <<
+		"Warm-up finished in " << timings.TotalMS() << " MS" <<
+		" - Dictionary: " << timings.dictionaryMS <<
+		" - Template: " << timings.templateMS <<
+		" - Folder: " << timings.folderMS <<
+		" - Snapshot: " << timings.snapshotMS <<
+		" - Video: " << timings.videoMS << std::endl;
+
+	std::lock_guard<std::mutex> guard(timingsAccess);
+	lastTimings = timings;
+	return timings;
+}
+
+CaptureWarmup::Timings CaptureWarmup::GetTimings()
+{
+	std::lock_guard<std::mutex> guard(timingsAccess);
+	return lastTimings;
+}
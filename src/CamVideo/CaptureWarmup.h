@@ -0,0 +1,93 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <ostream>
+
+/// <summary>
+/// Pays the one-time costs of saving snapshots and recording videos before
+/// the first snapshot of a session, so the first snapshot costs the same as
+/// the ones after it.
+///
+/// Without it, the first snapshot loads DCMTK's data dictionary, registers
+/// the compression codecs and builds the DicomInjectorSet's header template,
+/// the first capture creates the session's captures folder, and the first
+/// recording has OpenCV load its video encoder. The warm-up does all of that
+/// ahead of time, with throwaway encodes of sample frames written to the temp
+/// directory and deleted.
+///
+/// StateInitCameras creates the folder with EnsureFolder() on the UI thread,
+/// where capture requests create it, and runs the rest with Run() on the
+/// task pool once the cameras are ready. The throwaway encodes aren't counted
+/// in DicomCompress's totals.
+/// </summary>
+class CaptureWarmup
+{
+public:
+	/// <summary>
+	/// How long each step of a warm-up took.
+	/// </summary>
+	struct Timings
+	{
+		/// <summary>
+		/// If false, the warm-up hasn't finished.
+		/// </summary>
+		bool done = false;
+
+		double dictionaryMS = 0.0;
+		double templateMS = 0.0;
+		double folderMS = 0.0;
+		double snapshotMS = 0.0;
+		double videoMS = 0.0;
+
+		inline double TotalMS() const
+		{ return this->dictionaryMS + this->templateMS + this->folderMS + this->snapshotMS + this->videoMS; }
+	};
+
+private:
+	static std::mutex timingsAccess;
+
+	/// <summary>
+	/// The timings of the last warm-up to finish.
+	/// </summary>
+	static Timings lastTimings;
+
+public:
+	/// <summary>
+	/// Create the session's captures folder, on the thread capture requests
+	/// create it from.
+	/// </summary>
+	/// <param name="os">The stream to print problems to.</param>
+	/// <param name="ensureFolder">
+	/// Creates the session's captures folder if it doesn't exist, and returns
+	/// its path, or an empty string if it couldn't be created.
+	/// </param>
+	/// <returns>How long it took, to pass to Run().</returns>
+	static double EnsureFolder(std::ostream& os, const std::function<std::string()>& ensureFolder);
+
+	/// <summary>
+	/// Run the rest of the warm-up. Blocks until it's done.
+	/// </summary>
+	/// <param name="os">The stream to print the timings and problems to.</param>
+	/// <param name="sampleFrames">
+	/// Frames of the sizes and types the cameras are streaming, to encode.
+	/// Null and empty frames are skipped. If there are none, a 640x480 BGR
+	/// frame is used.
+	/// </param>
+	/// <param name="folderMS">How long EnsureFolder() took.</param>
+	/// <returns>How long each step took.</returns>
+	static Timings Run(
+		std::ostream& os,
+		const std::vector<cv::Ptr<cv::Mat>>& sampleFrames,
+		double folderMS);
+
+	/// <summary>
+	/// Get the timings of the last warm-up to finish. If none has finished,
+	/// Timings::done is false.
+	/// </summary>
+	static Timings GetTimings();
+};
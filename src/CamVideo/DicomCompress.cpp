@@ -0,0 +1,462 @@
+#include "DicomCompress.h"
+#include "../Utils/cvgTaskPool.h"
+
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcpixel.h>
+#include <dcmtk/dcmdata/dcpixseq.h>
+#include <dcmtk/dcmdata/dcpxitem.h>
+#include <dcmtk/dcmdata/dcrledrg.h>
+
+#if CVG_DICOM_JPEGLS
+	#include <dcmtk/dcmjpls/djencode.h>
+	#include <dcmtk/dcmjpls/djdecode.h>
+	#include <dcmtk/dcmjpls/djrparam.h>
+#endif
+
+#include <chrono>
+#include <iostream>
+#include <cstring>
+
+std::atomic<DicomCompress::Method> DicomCompress::method(DicomCompress::Method::None);
+std::mutex DicomCompress::totalsAccess;
+DicomCompress::Stats DicomCompress::totals;
+thread_local bool DicomCompress::uncounted = false;
+
+namespace
+{
+	/// <summary>
+	/// PackBits encode a row of one sample, as described in PS3.5 G.3.1.
+	/// </summary>
+	/// <param name="src">The first byte of the row's sample.</param>
+	/// <param name="n">The number of bytes in the row.</param>
+	/// <param name="stride">The distance between the row's bytes.</param>
+	/// <param name="out">The segment to append to.</param>
+	void PackBitsRow(const unsigned char* src, int n, int stride, std::vector<unsigned char>& out)
+	{
+		int i = 0;
+		while(i < n)
+		{
+			unsigned char value = src[i * stride];
+			int run = 1;
+			while(i + run < n && run < 128 && src[(i + run) * stride] == value)
+				++run;
+
+			// Replicate run: -(run - 1), then the byte.
+			if(run >= 2)
+			{
+				out.push_back((unsigned char)(257 - run));
+				out.push_back(value);
+				i += run;
+				continue;
+			}
+
+			// Literal run: (length - 1), then the bytes, up to the next
+			// repeated byte.
+			int start = i;
+			int len = 0;
+			while(i < n && len < 128)
+			{
+				if(i + 1 < n && src[i * stride] == src[(i + 1) * stride])
+					break;
+
+				++i;
+				++len;
+			}
+
+			out.push_back((unsigned char)(len - 1));
+			for(int k = start; k < start + len; ++k)
+				out.push_back(src[k * stride]);
+		}
+	}
+
+	void PutUint32LE(unsigned char* dst, uint32_t v)
+	{
+		dst[0] = (unsigned char)(v >> 0);
+		dst[1] = (unsigned char)(v >> 8);
+		dst[2] = (unsigned char)(v >> 16);
+		dst[3] = (unsigned char)(v >> 24);
+	}
+}
+
+void DicomCompress::_RegisterCodecs()
+{
+	static std::once_flag registered;
+	std::call_once(
+		registered,
+		[]
+		{
+			DcmRLEDecoderRegistration::registerCodecs();
+#if CVG_DICOM_JPEGLS
+			DJLSEncoderRegistration::registerCodecs();
+			DJLSDecoderRegistration::registerCodecs();
+#endif
+		});
+}
+
+bool DicomCompress::EncodeRLEFrame(
+	const unsigned char* pixels,
+	int rows,
+	int cols,
+	int samples,
+	bool planar,
+	std::vector<unsigned char>& out)
+{
+	// The RLE header has room for 15 segments, but we only handle 8-bit
+	// mono and RGB.
+	if(pixels == nullptr || rows <= 0 || cols <= 0 || (samples != 1 && samples != 3))
+		return false;
+
+	int stripeCt = rows / minRowsPerStripe;
+	int workerCt = cvgTaskPool::GetInstance().WorkerCount();
+	if(stripeCt > workerCt)
+		stripeCt = workerCt;
+	if(stripeCt < 1)
+		stripeCt = 1;
+
+	// Each stripe encodes its rows of every segment into its own buffers.
+	std::vector<std::vector<unsigned char>> parts(samples * stripeCt);
+	size_t planeBytes = (size_t)rows * cols;
+	auto encodeStripe =
+		[&](int stripe)
+		{
+			int rowBegin	= (int)((long long)rows * stripe / stripeCt);
+			int rowEnd		= (int)((long long)rows * (stripe + 1) / stripeCt);
+			for(int s = 0; s < samples; ++s)
+			{
+				std::vector<unsigned char>& part = parts[s * stripeCt + stripe];
+				part.reserve((size_t)(rowEnd - rowBegin) * cols / 2);
+				for(int y = rowBegin; y < rowEnd; ++y)
+				{
+					if(planar)
+						PackBitsRow(pixels + s * planeBytes + (size_t)y * cols, cols, 1, part);
+					else
+						PackBitsRow(pixels + ((size_t)y * cols * samples) + s, cols, samples, part);
+				}
+			}
+		};
+
+	if(stripeCt > 1)
+	{
+		cvgTaskPool::GetInstance().ParallelFor(
+			0,
+			stripeCt,
+			[&](int begin, int end)
+			{
+				for(int stripe = begin; stripe < end; ++stripe)
+					encodeStripe(stripe);
+			},
+			stripeCt);
+	}
+	else
+		encodeStripe(0);
+
+	// The header is the segment count, and the offset of each segment from
+	// the start of the frame. Segments are padded to an even length.
+	const size_t headerBytes = 64;
+	std::vector<size_t> segmentBytes(samples, 0);
+	size_t totalBytes = headerBytes;
+	for(int s = 0; s < samples; ++s)
+	{
+		for(int stripe = 0; stripe < stripeCt; ++stripe)
+			segmentBytes[s] += parts[s * stripeCt + stripe].size();
+
+		totalBytes += segmentBytes[s] + (segmentBytes[s] % 2);
+	}
+
+	if(totalBytes > 0xFFFFFFFE)
+		return false;
+
+	out.assign(totalBytes, 0);
+	PutUint32LE(&out[0], (uint32_t)samples);
+
+	size_t offset = headerBytes;
+	for(int s = 0; s < samples; ++s)
+	{
+		PutUint32LE(&out[4 + 4 * s], (uint32_t)offset);
+		for(int stripe = 0; stripe < stripeCt; ++stripe)
+		{
+			const std::vector<unsigned char>& part = parts[s * stripeCt + stripe];
+			if(!part.empty())
+				memcpy(&out[offset], part.data(), part.size());
+
+			offset += part.size();
+		}
+		offset += segmentBytes[s] % 2;
+	}
+	return true;
+}
+
+bool DicomCompress::CompressDataset(
+	DcmDataset* dset,
+	Method compression,
+	E_TransferSyntax& outXfer,
+	Stats* outStats)
+{
+	if(dset == nullptr || compression == Method::None)
+		return false;
+
+	_RegisterCodecs();
+
+	Uint16 rows			= 0;
+	Uint16 cols			= 0;
+	Uint16 samples		= 0;
+	Uint16 bitsAlloc	= 0;
+	Uint16 planarConfig	= 0;
+	dset->findAndGetUint16(DCM_Rows,				rows);
+	dset->findAndGetUint16(DCM_Columns,				cols);
+	dset->findAndGetUint16(DCM_SamplesPerPixel,		samples);
+	dset->findAndGetUint16(DCM_BitsAllocated,		bitsAlloc);
+	dset->findAndGetUint16(DCM_PlanarConfiguration,	planarConfig);
+
+	Sint32 frameCt = 1;
+	if(dset->findAndGetSint32(DCM_NumberOfFrames, frameCt).bad() || frameCt < 1)
+		frameCt = 1;
+
+	DcmElement* pixElem = nullptr;
+	if(bitsAlloc != 8 || dset->findAndGetElement(DCM_PixelData, pixElem).bad() || pixElem == nullptr)
+		return false;
+
+	DcmPixelData* pixData = OFstatic_cast(DcmPixelData*, pixElem);
+	size_t frameBytes = (size_t)rows * cols * samples;
+	size_t rawBytes = frameBytes * frameCt;
+
+	std::chrono::steady_clock::time_point encodeStart = std::chrono::steady_clock::now();
+
+	Stats stats;
+	stats.frameCt	= frameCt;
+	stats.rawBytes	= (long long)rawBytes;
+
+#if !CVG_DICOM_JPEGLS
+	if(compression == Method::JPEGLS)
+		compression = Method::RLE;
+#else
+	if(compression == Method::JPEGLS)
+	{
+		DJLSRepresentationParameter lsParam(0, OFTrue);
+		if(!dset->chooseRepresentation(EXS_JPEGLSLossless, &lsParam).good() || !dset->canWriteXfer(EXS_JPEGLSLossless))
+			return false;
+
+		DcmPixelSequence* lsSeq = nullptr;
+		if(pixData->getEncapsulatedRepresentation(EXS_JPEGLSLossless, &lsParam, lsSeq).bad() || lsSeq == nullptr)
+			return false;
+
+		// The basic offset table is the first item, the frames follow.
+		for(unsigned long i = 1; i < lsSeq->card(); ++i)
+		{
+			DcmPixelItem* fragment = nullptr;
+			if(lsSeq->getItem(fragment, i).good() && fragment != nullptr)
+				stats.encodedBytes += fragment->getLength();
+		}
+		outXfer = EXS_JPEGLSLossless;
+	}
+#endif
+
+	if(compression == Method::RLE)
+	{
+		Uint8* pixels = nullptr;
+		if(pixData->getUint8Array(pixels).bad() || pixels == nullptr || pixData->getLength() < rawBytes)
+			return false;
+
+		DcmPixelSequence* rleSeq = new DcmPixelSequence(DcmTag(DCM_PixelData, EVR_OB));
+
+		// An empty basic offset table.
+		rleSeq->insert(new DcmPixelItem(DcmTag(DCM_Item, EVR_OB)));
+
+		std::vector<unsigned char> encoded;
+		for(Sint32 i = 0; i < frameCt; ++i)
+		{
+			if(!EncodeRLEFrame(pixels + frameBytes * i, rows, cols, samples, planarConfig == 1, encoded))
+			{
+				delete rleSeq;
+				return false;
+			}
+
+			DcmPixelItem* fragment = new DcmPixelItem(DcmTag(DCM_Item, EVR_OB));
+			fragment->putUint8Array(encoded.data(), (unsigned long)encoded.size());
+			rleSeq->insert(fragment);
+			stats.encodedBytes += (long long)encoded.size();
+		}
+
+		// Noise can make RLE larger than the original.
+		if(stats.encodedBytes >= stats.rawBytes)
+		{
+			delete rleSeq;
+
+			Stats skipped;
+			skipped.skippedCt = 1;
+			AddToTotals(skipped);
+			return false;
+		}
+
+		pixData->putOriginalRepresentation(EXS_RLELossless, nullptr, rleSeq);
+		outXfer = EXS_RLELossless;
+	}
+
+	stats.encodeMS =
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - encodeStart).count();
+
+	if(outStats != nullptr)
+		*outStats = stats;
+
+	AddToTotals(stats);
+	return true;
+}
+
+bool DicomCompress::EncodeJPEGLSFrame(
+	const unsigned char* pixels,
+	int rows,
+	int cols,
+	int samples,
+	std::vector<unsigned char>& out)
+{
+#if !CVG_DICOM_JPEGLS
+	return false;
+#else
+	if(pixels == nullptr || rows <= 0 || cols <= 0 || rows > 0xFFFF || cols > 0xFFFF || (samples != 1 && samples != 3))
+		return false;
+
+	_RegisterCodecs();
+
+	// The codec only encodes datasets, so the frame is wrapped in one that
+	// describes its pixels.
+	DcmDataset frameSet;
+	frameSet.putAndInsertUint16(DCM_SamplesPerPixel,			(Uint16)samples);
+	frameSet.putAndInsertString(DCM_PhotometricInterpretation,	(samples == 1) ? "MONOCHROME2" : "RGB");
+	frameSet.putAndInsertUint16(DCM_Rows,						(Uint16)rows);
+	frameSet.putAndInsertUint16(DCM_Columns,					(Uint16)cols);
+	frameSet.putAndInsertUint16(DCM_BitsAllocated,				8);
+	frameSet.putAndInsertUint16(DCM_BitsStored,					8);
+	frameSet.putAndInsertUint16(DCM_HighBit,					7);
+	frameSet.putAndInsertUint16(DCM_PixelRepresentation,		0);
+	if(samples == 3)
+		frameSet.putAndInsertUint16(DCM_PlanarConfiguration,	0);
+	frameSet.putAndInsertUint8Array(DCM_PixelData, pixels, (unsigned long)rows * cols * samples);
+
+	DJLSRepresentationParameter lsParam(0, OFTrue);
+	if(!frameSet.chooseRepresentation(EXS_JPEGLSLossless, &lsParam).good() || !frameSet.canWriteXfer(EXS_JPEGLSLossless))
+		return false;
+
+	DcmElement* pixElem = nullptr;
+	if(frameSet.findAndGetElement(DCM_PixelData, pixElem).bad() || pixElem == nullptr)
+		return false;
+
+	DcmPixelSequence* lsSeq = nullptr;
+	if(OFstatic_cast(DcmPixelData*, pixElem)->getEncapsulatedRepresentation(EXS_JPEGLSLossless, &lsParam, lsSeq).bad() || lsSeq == nullptr)
+		return false;
+
+	// The basic offset table is the first item, the frame's fragments 
+	// follow, and are joined back into one.
+	out.clear();
+	for(unsigned long i = 1; i < lsSeq->card(); ++i)
+	{
+		DcmPixelItem* fragment = nullptr;
+		Uint8* data = nullptr;
+		if(lsSeq->getItem(fragment, i).bad() || fragment == nullptr || fragment->getUint8Array(data).bad() || data == nullptr)
+			return false;
+
+		out.insert(out.end(), data, data + fragment->getLength());
+	}
+
+	if(out.size() % 2 != 0)
+		out.push_back(0);
+
+	return !out.empty();
+#endif
+}
+
+bool DicomCompress::DecompressDataset(DcmDataset* dset)
+{
+	if(dset == nullptr)
+		return false;
+
+	_RegisterCodecs();
+
+	if(dset->chooseRepresentation(EXS_LittleEndianExplicit, nullptr).bad())
+		return false;
+
+	return dset->canWriteXfer(EXS_LittleEndianExplicit);
+}
+
+bool DicomCompress::IsSupported(Method compression)
+{
+#if !CVG_DICOM_JPEGLS
+	if(compression == Method::JPEGLS)
+		return false;
+#endif
+	return true;
+}
+
+void DicomCompress::SetMethod(Method compression)
+{
+	if(!IsSupported(compression))
+	{
+		std::cout << "DICOM compression " << to_string(compression) << " isn't available in this build, using RLE." << std::endl;
+		compression = Method::RLE;
+	}
+	method = compression;
+}
+
+DicomCompress::Method DicomCompress::GetMethod()
+{
+	return method;
+}
+
+DicomCompress::Stats DicomCompress::GetTotals()
+{
+	std::lock_guard<std::mutex> guard(totalsAccess);
+	return totals;
+}
+
+void DicomCompress::AddToTotals(const Stats& stats)
+{
+	if(uncounted)
+		return;
+
+	std::lock_guard<std::mutex> guard(totalsAccess);
+	totals.frameCt		+= stats.frameCt;
+	totals.rawBytes		+= stats.rawBytes;
+	totals.encodedBytes	+= stats.encodedBytes;
+	totals.encodeMS		+= stats.encodeMS;
+	totals.skippedCt	+= stats.skippedCt;
+}
+
+DicomCompress::UncountedScope::UncountedScope()
+{
+	this->prevUncounted = uncounted;
+	uncounted = true;
+}
+
+DicomCompress::UncountedScope::~UncountedScope()
+{
+	uncounted = this->prevUncounted;
+}
+
+std::string to_string(DicomCompress::Method compression)
+{
+	switch(compression)
+	{
+	case DicomCompress::Method::None:
+		return "none";
+
+	case DicomCompress::Method::RLE:
+		return "rle";
+
+	case DicomCompress::Method::JPEGLS:
+		return "jpegls";
+	}
+
+	return "none";
+}
+
+DicomCompress::Method StringToDicomCompression(const std::string& str)
+{
+	if(str == "rle")
+		return DicomCompress::Method::RLE;
+
+	if(str == "jpegls")
+		return DicomCompress::Method::JPEGLS;
+
+	//if(str == "none")
+	return DicomCompress::Method::None;
+}
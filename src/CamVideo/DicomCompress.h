@@ -0,0 +1,215 @@
+#pragma once
+
+#include <dcmtk/dcmdata/dcxfer.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+class DcmDataset;
+
+/// <summary>
+/// Lossless compression of DICOM pixel data, to save storage space and
+/// bandwidth on the SD card.
+///
+/// RLE Lossless is encoded by following the DICOM standard (PS3.5 Annex G)
+/// directly, instead of through DCMTK's RLE encoder, so large frames can be
+/// encoded in parallel: every row is encoded on its own, so frames are split
+/// into stripes of rows encoded on the task pool, and the stripes are joined
+/// into the same bytes a single pass would produce. DCMTK's RLE decoder reads
+/// the results.
+///
+/// JPEG-LS Lossless is encoded with DCMTK's dcmjpls codec, if the program is
+/// built with CVG_DICOM_JPEGLS. It isn't striped, as the codec encodes a frame
+/// at a time. Without it, JPEG-LS falls back to RLE.
+///
+/// The method is shared by everything saving DICOMs, see SetMethod().
+/// </summary>
+class DicomCompress
+{
+public:
+	enum class Method
+	{
+		/// <summary>
+		/// The pixel data is stored uncompressed.
+		/// </summary>
+		None,
+
+		RLE,
+
+		JPEGLS
+	};
+
+	/// <summary>
+	/// The sizes and time of compressing pixel data.
+	/// </summary>
+	struct Stats
+	{
+		long long frameCt = 0;
+		long long rawBytes = 0;
+		long long encodedBytes = 0;
+		double encodeMS = 0.0;
+
+		/// <summary>
+		/// The number of datasets left uncompressed, because compressing
+		/// would have made them larger.
+		/// </summary>
+		long long skippedCt = 0;
+
+		/// <summary>
+		/// The uncompressed size divided by the compressed size.
+		/// </summary>
+		inline double Ratio() const
+		{ return (this->encodedBytes > 0) ? (double)this->rawBytes / (double)this->encodedBytes : 0.0; }
+	};
+
+	/// <summary>
+	/// While one exists, what the thread that made it compresses isn't
+	/// added to the totals, for throwaway encodes such as CaptureWarmup's.
+	/// </summary>
+	class UncountedScope
+	{
+	private:
+		bool prevUncounted;
+
+	public:
+		UncountedScope();
+		~UncountedScope();
+
+		UncountedScope(const UncountedScope&) = delete;
+		UncountedScope& operator=(const UncountedScope&) = delete;
+	};
+
+	/// <summary>
+	/// The fewest rows given to a stripe, so small frames aren't split
+	/// into more tasks than they're worth.
+	/// </summary>
+	static const int minRowsPerStripe = 64;
+
+private:
+	static std::atomic<Method> method;
+
+	static std::mutex totalsAccess;
+
+	/// <summary>
+	/// If true, what the thread compresses isn't added to the totals, see
+	/// UncountedScope.
+	/// </summary>
+	static thread_local bool uncounted;
+
+	/// <summary>
+	/// The stats of everything compressed since the program started.
+	/// </summary>
+	static Stats totals;
+
+	/// <summary>
+	/// Register DCMTK's codecs, the first time it's called.
+	/// </summary>
+	static void _RegisterCodecs();
+
+public:
+	/// <summary>
+	/// Encode a frame of 8-bit pixels as a DICOM RLE frame: the RLE header,
+	/// followed by a segment per sample. The rows are split into stripes
+	/// that are encoded in parallel on the task pool.
+	/// </summary>
+	/// <param name="pixels">The frame's pixels, without row padding.</param>
+	/// <param name="rows">The number of rows.</param>
+	/// <param name="cols">The number of columns.</param>
+	/// <param name="samples">The samples per pixel, 1 or 3.</param>
+	/// <param name="planar">
+	/// If true, the samples are stored a plane at a time (planar configuration
+	/// 1), else interleaved per pixel.
+	/// </param>
+	/// <param name="out">Receives the encoded frame. Its length is always even.</param>
+	/// <returns>False if the frame can't be RLE encoded.</returns>
+	static bool EncodeRLEFrame(
+		const unsigned char* pixels,
+		int rows,
+		int cols,
+		int samples,
+		bool planar,
+		std::vector<unsigned char>& out);
+
+	/// <summary>
+	/// Encode a frame of 8-bit pixels as a JPEG-LS Lossless frame, with
+	/// DCMTK's dcmjpls codec.
+	/// </summary>
+	/// <param name="pixels">The frame's pixels, without row padding.</param>
+	/// <param name="rows">The number of rows.</param>
+	/// <param name="cols">The number of columns.</param>
+	/// <param name="samples">The samples per pixel, 1 or 3 (interleaved RGB).</param>
+	/// <param name="out">Receives the encoded frame. Its length is always even.</param>
+	/// <returns>
+	/// False if the frame can't be encoded, or the program wasn't built with
+	/// CVG_DICOM_JPEGLS.
+	/// </returns>
+	static bool EncodeJPEGLSFrame(
+		const unsigned char* pixels,
+		int rows,
+		int cols,
+		int samples,
+		std::vector<unsigned char>& out);
+
+	/// <summary>
+	/// Compress the uncompressed 8-bit pixel data of a dataset.
+	/// </summary>
+	/// <param name="dset">The dataset to compress.</param>
+	/// <param name="compression">The compression to use.</param>
+	/// <param name="outXfer">
+	/// Set to the transfer syntax to save the dataset with, if it was
+	/// compressed.
+	/// </param>
+	/// <param name="outStats">If not null, receives the dataset's stats.</param>
+	/// <returns>
+	/// True if the dataset was compressed. If false, it's left uncompressed.
+	/// </returns>
+	static bool CompressDataset(
+		DcmDataset* dset,
+		Method compression,
+		E_TransferSyntax& outXfer,
+		Stats* outStats = nullptr);
+
+	/// <summary>
+	/// Decompress a dataset's pixel data back to uncompressed little endian.
+	/// </summary>
+	/// <returns>True if the pixel data is uncompressed.</returns>
+	static bool DecompressDataset(DcmDataset* dset);
+
+	/// <summary>
+	/// Check if a method can be encoded by this build.
+	/// </summary>
+	static bool IsSupported(Method compression);
+
+	/// <summary>
+	/// Set the compression used for saved DICOMs.
+	/// </summary>
+	static void SetMethod(Method compression);
+
+	static Method GetMethod();
+
+	/// <summary>
+	/// Get the stats of everything compressed so far.
+	/// </summary>
+	static Stats GetTotals();
+
+	/// <summary>
+	/// Add the stats of pixel data compressed without CompressDataset()
+	/// to the totals, unless the thread is in an UncountedScope.
+	/// </summary>
+	static void AddToTotals(const Stats& stats);
+};
+
+/// <summary>
+/// Convert a DicomCompress::Method to a serialiable string value.
+///
+/// The name convention is made to match std::to_string() functions.
+/// </summary>
+std::string to_string(DicomCompress::Method compression);
+
+/// <summary>
+/// Convert a serialized string to a DicomCompress::Method. If the string
+/// is not recognized, it is defaulted to DicomCompress::Method::None.
+/// </summary>
+DicomCompress::Method StringToDicomCompression(const std::string& str);
@@ -53,6 +53,32 @@ OFCondition DicomImg_RawBmp::readPixelData (
 	Uint32 &length, 
 	E_TransferSyntax &ts)
 {
+	// Monochrome images are copied over as-is. There's no channel reordering,
+	// and the rows are already top-down without padding, so there's no need to
+	// round-trip through a BMP.
+	if(matImg->channels() == 1 && matImg->elemSize() == 1)
+	{
+		rows			= matImg->rows;
+		cols			= matImg->cols;
+		samplesPerPixel	= 1;
+		photoMetrInt	= "MONOCHROME2";
+		bitsAlloc		= 8;
+		bitsStored		= 8;
+		highBit			= 7;
+		planConf		= 0;
+		pixAspectH		= 1;
+		pixAspectV		= 1;
+		pixelRepr		= 0;
+		ts = EXS_LittleEndianExplicit;
+
+		length = (Uint32)rows * cols;
+		pixData = new char[length];
+		for(int y = 0; y < matImg->rows; ++y)
+			memcpy(&pixData[y * cols], matImg->ptr(y), cols);
+
+		return EC_Normal;
+	}
+
 	// We'll need a mono or 3 channel image to save to bitmap. Thenere's the question
 	// of what to do if it's an 3 channel with an alpha...
 	//
@@ -0,0 +1,370 @@
+#include "DicomWriteBenchmark.h"
+#include "MultiFrameDicomWriter.h"
+#include "DicomCompress.h"
+#include "CaptureStorage.h"
+#include "IManagedCam.h"
+#include "../DicomUtils/DicomInjectorSet.h"
+#include "../DicomUtils/DicomMiscUtils.h"
+#include "../AppVersionDicom.h"
+#include "../OpSession.h"
+#include <opencv2/imgproc.hpp>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcuid.h>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <iomanip>
+
+namespace
+{
+	typedef std::chrono::steady_clock BenchClock;
+
+	/// <summary>
+	/// A frame format to benchmark.
+	/// </summary>
+	struct BenchFormat
+	{
+		const char* name;
+		int width;
+		int height;
+		int channels;
+	};
+
+	const BenchFormat benchFormats[] =
+	{
+		{"1920x1080 BGR",	1920,	1080,	3},
+		{"640x480 mono",	640,	480,	1}
+	};
+
+	/// <summary>
+	/// The files written by a path, and their total size.
+	/// </summary>
+	void MeasureDir(const boost::filesystem::path& dir, int& fileCt, uintmax_t& bytes)
+	{
+		fileCt = 0;
+		bytes = 0;
+		for(boost::filesystem::directory_iterator it(dir); it != boost::filesystem::directory_iterator(); ++it)
+		{
+			if(!boost::filesystem::is_regular_file(it->path()))
+				continue;
+
+			++fileCt;
+			bytes += boost::filesystem::file_size(it->path());
+		}
+	}
+
+	void Report(
+		std::ostream& os,
+		const std::string& pathName,
+		double seconds,
+		int frameCt,
+		double pixelMB,
+		const boost::filesystem::path& dir)
+	{
+		int fileCt;
+		uintmax_t bytes;
+		MeasureDir(dir, fileCt, bytes);
+		double diskMB = (double)bytes / (1024.0 * 1024.0);
+
+		os << "\t\t" << std::left << std::setw(24) << pathName << std::right <<
+			" - MS: " << seconds * 1000.0 <<
+			" - FPS: " << (double)frameCt / seconds <<
+			" - MB/s: " << pixelMB / seconds <<
+			" - Files: " << fileCt <<
+			" - Disk MB: " << diskMB <<
+			" - Ratio: " << ((diskMB > 0.0) ? pixelMB / diskMB : 0.0) << std::endl;
+	}
+
+	/// <summary>
+	/// Make a frame that compresses like a processed frame: flat regions
+	/// with sharp edges, and some noise.
+	/// </summary>
+	cv::Mat MakeFrame(const BenchFormat& format)
+	{
+		cv::Mat blocks(format.height / 40, format.width / 40, CV_8UC(format.channels));
+		cv::randu(blocks, cv::Scalar::all(0), cv::Scalar::all(255));
+
+		cv::Mat frame;
+		cv::resize(blocks, frame, cv::Size(format.width, format.height), 0.0, 0.0, cv::INTER_NEAREST);
+
+		cv::Mat noise(frame.size(), frame.type(), cv::Scalar::all(0));
+		cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(4));
+		cv::Mat mask(frame.size(), CV_8U);
+		cv::randu(mask, cv::Scalar(0), cv::Scalar(16));
+		cv::add(frame, noise, frame, mask == 0);
+		return frame;
+	}
+
+	/// <summary>
+	/// Load a DICOM file, decompress it, and check its pixels are the
+	/// frames exactly, after the same BGR to RGB conversion as saving.
+	/// </summary>
+	bool VerifyFile(const std::string& filename, const std::vector<cv::Mat>& frames)
+	{
+		DcmFileFormat fileFormat;
+		if(fileFormat.loadFile(filename.c_str()).bad())
+			return false;
+
+		DcmDataset* dset = fileFormat.getDataset();
+		if(!DicomCompress::DecompressDataset(dset))
+			return false;
+
+		Uint16 planarConfig = 0;
+		dset->findAndGetUint16(DCM_PlanarConfiguration, planarConfig);
+
+		const Uint8* pixels = nullptr;
+		unsigned long pixelCt = 0;
+		if(dset->findAndGetUint8Array(DCM_PixelData, pixels, &pixelCt).bad() || pixels == nullptr)
+			return false;
+
+		size_t offset = 0;
+		for(const cv::Mat& frame : frames)
+		{
+			cv::Mat expected = frame;
+			if(expected.channels() == 3)
+				cv::cvtColor(frame, expected, cv::COLOR_BGR2RGB);
+
+			if(planarConfig == 1 && expected.channels() > 1)
+			{
+				std::vector<cv::Mat> planes;
+				cv::split(expected, planes);
+				cv::vconcat(planes, expected);
+			}
+
+			size_t bytes = expected.total() * expected.elemSize();
+			if(offset + bytes > pixelCt || memcmp(pixels + offset, expected.data, bytes) != 0)
+				return false;
+
+			offset += bytes;
+		}
+
+		// Allow for the pad byte of odd length pixel data.
+		return offset == pixelCt || offset + 1 == pixelCt;
+	}
+
+	/// <summary>
+	/// Check two headers have the same values, other than the ones made
+	/// new for every header.
+	/// </summary>
+	bool SameHeaders(DcmDataset& a, DcmDataset& b)
+	{
+		if(a.card() != b.card())
+			return false;
+
+		for(unsigned long i = 0; i < a.card(); ++i)
+		{
+			DcmElement* elemA = a.getElement(i);
+			DcmTagKey tag = elemA->getTag();
+			if(
+				tag == DCM_SOPInstanceUID || 
+				tag == DCM_StudyInstanceUID || 
+				tag == DCM_SeriesInstanceUID ||
+				tag == DCM_StudyDate ||
+				tag == DCM_StudyTime)
+			{
+				continue;
+			}
+
+			DcmElement* elemB = nullptr;
+			if(b.findAndGetElement(tag, elemB).bad() || elemB == nullptr)
+				return false;
+
+			OFString valA;
+			OFString valB;
+			elemA->getOFStringArray(valA);
+			elemB->getOFStringArray(valB);
+			if(valA != valB)
+				return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Time building snapshot headers with every injector asked for all of
+	/// its data, against cloning the header template and only asking for
+	/// the data that changes per snapshot.
+	/// </summary>
+	bool RunHeaderBuild(std::ostream& os, int iterations)
+	{
+		// A session like one loaded from a session TOML. The benchmark has
+		// its own injector set, so the app's isn't touched.
+		OpSession session;
+		session.patientid				= "BENCH00001";
+		session.studyID					= "BENCHSTUDY";
+		session.studyDescription		= "DICOM header benchmark";
+		session.surgeryDate				= "20220728";
+		session.surgeryStartTime		= "083000";
+		session.contrastAgent			= "ICG";
+		session.contrastMilliliters		= 2.5f;
+		session.contrastInjectionTime	= "084500";
+		session.patientComments			= "Benchmark session";
+
+		DicomInjectorSet injSet;
+		injSet.AddInjectorRef(&session);
+		injSet.AddInjectorRef(&AppVersionDicom::GetInstance());
+
+		auto buildHeader =
+			[&](DcmDataset* dicomData, bool useTemplate)
+			{
+				dicomData->putAndInsertString(DCM_StudyDate, DicomMiscUtils::GetCurrentDateString().c_str());
+				dicomData->putAndInsertString(DCM_StudyTime, DicomMiscUtils::GetCurrentTime().c_str());
+				injSet.InjectDataInto(dicomData, useTemplate);
+				DicomMiscUtils::InsertSecondaryCaptureHeader(dicomData, UID_SecondaryCaptureImageStorage);
+			};
+
+		auto timeHeaders =
+			[&](bool useTemplate)
+			{
+				BenchClock::time_point start = BenchClock::now();
+				for(int i = 0; i < iterations; ++i)
+				{
+					DcmFileFormat dcmff;
+					buildHeader(dcmff.getDataset(), useTemplate);
+				}
+				return std::chrono::duration<double, std::micro>(BenchClock::now() - start).count() / iterations;
+			};
+
+		// The template is built once per session, before the first snapshot.
+		BenchClock::time_point prepStart = BenchClock::now();
+		injSet.PrepareTemplate();
+		double prepUS = std::chrono::duration<double, std::micro>(BenchClock::now() - prepStart).count();
+
+		double rebuiltUS	= timeHeaders(false);
+		double templateUS	= timeHeaders(true);
+
+		DcmDataset rebuilt;
+		DcmDataset cloned;
+		buildHeader(&rebuilt, false);
+		buildHeader(&cloned, true);
+		bool same = SameHeaders(rebuilt, cloned);
+
+		os << "\tHeader build, " << iterations << " headers" << std::endl;
+		os << "\t\tTemplate prepare US: " << prepUS << std::endl;
+		os << "\t\tRebuilt per snapshot - US per header: " << rebuiltUS << std::endl;
+		os << "\t\tCloned from template - US per header: " << templateUS << std::endl;
+		if(templateUS > 0.0)
+			os << "\t\tTemplate speedup: " << rebuiltUS / templateUS << "x" << std::endl;
+		os << "\t\tHeaders: " << (same ? "identical" : "MISMATCH") << std::endl;
+
+		return same;
+	}
+
+	/// <summary>
+	/// Write the frames as a file per frame, then as one multi-frame file,
+	/// with a compression, and report the results of both.
+	/// </summary>
+	bool RunPaths(
+		std::ostream& os,
+		const std::vector<cv::Mat>& frames,
+		double pixelMB,
+		DicomCompress::Method compression,
+		const boost::filesystem::path& root)
+	{
+		boost::system::error_code ec;
+		boost::filesystem::path singleDir	= root / ("single_" + to_string(compression));
+		boost::filesystem::path multiDir	= root / ("multi_" + to_string(compression));
+		boost::filesystem::create_directories(singleDir, ec);
+		boost::filesystem::create_directories(multiDir, ec);
+
+		int frameCt = (int)frames.size();
+		DicomCompress::SetMethod(compression);
+
+		// A file per frame, the way snapshots are saved.
+		bool singleWritten = true;
+		BenchClock::time_point singleStart = BenchClock::now();
+		for(int i = 0; i < frameCt; ++i)
+		{
+			singleWritten &= SaveMatAsDicomBmp(
+				cv::makePtr<cv::Mat>(frames[i]),
+				nullptr,
+				(singleDir / ("frame_" + std::to_string(i))).string(),
+				std::string(),
+				-1);
+		}
+		// Snapshots are written behind the caller, they're timed until
+		// they're on the disk.
+		CaptureStorage::GetInstance().WaitIdle();
+		double singleSec = std::chrono::duration<double>(BenchClock::now() - singleStart).count();
+		// Labeled with what was actually used, in case of a fallback.
+		Report(os, "Single-frame " + to_string(DicomCompress::GetMethod()), singleSec, frameCt, pixelMB, singleDir);
+
+		// One multi-frame file.
+		BenchClock::time_point multiStart = BenchClock::now();
+		MultiFrameDicomWriter writer;
+		bool multiWritten = writer.Open(
+			(multiDir / "frames").string(),
+			nullptr,
+			frames[0].size(),
+			frames[0].type(),
+			std::string(),
+			{},
+			compression);
+
+		for(int i = 0; multiWritten && i < frameCt; ++i)
+		{
+			MultiFrameDicomWriter::FrameInfo info;
+			info.wallUS = MultiFrameDicomWriter::SteadyToWallUS(BenchClock::now());
+			multiWritten = writer.AddFrame(frames[i], info);
+		}
+		if(multiWritten)
+			multiWritten = writer.Close();
+
+		double multiSec = std::chrono::duration<double>(BenchClock::now() - multiStart).count();
+		Report(os, "Multi-frame " + to_string(writer.Compression()), multiSec, frameCt, pixelMB, multiDir);
+
+		if(!multiWritten)
+			os << "\t\tThe multi-frame file failed: " << writer.GetError() << std::endl;
+		else if(multiSec > 0.0)
+			os << "\t\tMulti-frame speedup: " << singleSec / multiSec << "x" << std::endl;
+
+		// Every file has to decode back to exactly what was saved.
+		bool roundTrip = multiWritten && VerifyFile((multiDir / "frames.dcm").string(), frames);
+		for(int i = 0; roundTrip && i < frameCt; ++i)
+			roundTrip = VerifyFile((singleDir / ("frame_" + std::to_string(i) + ".dcm")).string(), {frames[i]});
+
+		os << "\t\tRound trip: " << (roundTrip ? "bit-exact" : "MISMATCH") << std::endl;
+		return singleWritten && multiWritten && roundTrip;
+	}
+}
+
+bool DicomWriteBenchmark::Run(std::ostream& os, int frameCt)
+{
+	boost::system::error_code ec;
+	boost::filesystem::path root =
+		boost::filesystem::temp_directory_path(ec) / boost::filesystem::unique_path("hmdop_dicombench_%%%%%%%%");
+
+	os << "Benchmarking DICOM writes of " << frameCt << " frames, in " << root.string() << std::endl;
+	os << std::fixed << std::setprecision(2);
+
+	std::vector<DicomCompress::Method> compressions = {DicomCompress::Method::None, DicomCompress::Method::RLE};
+	if(DicomCompress::IsSupported(DicomCompress::Method::JPEGLS))
+		compressions.push_back(DicomCompress::Method::JPEGLS);
+
+	DicomCompress::Method prevCompression = DicomCompress::GetMethod();
+
+	bool allPassed = RunHeaderBuild(os, 1000);
+	for(const BenchFormat& format : benchFormats)
+	{
+		std::vector<cv::Mat> frames(frameCt);
+		for(cv::Mat& frame : frames)
+			frame = MakeFrame(format);
+
+		double pixelMB = (double)frameCt * format.width * format.height * format.channels / (1024.0 * 1024.0);
+
+		os << "\t" << format.name << std::endl;
+		for(DicomCompress::Method compression : compressions)
+			allPassed = RunPaths(os, frames, pixelMB, compression, root) && allPassed;
+
+		boost::filesystem::remove_all(root, ec);
+	}
+
+	DicomCompress::SetMethod(prevCompression);
+
+	DicomCompress::Stats totals = DicomCompress::GetTotals();
+	os << "\tCompressed " << totals.frameCt << " frames - Ratio: " << totals.Ratio() <<
+		" - Avg encode MS: " << ((totals.frameCt > 0) ? totals.encodeMS / (double)totals.frameCt : 0.0) << std::endl;
+
+	return allPassed;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ostream>
+
+/// <summary>
+/// A benchmark of writing frames to DICOM files, comparing saving each frame
+/// as its own single-frame DICOM (SaveMatAsDicomBmp(), how snapshots are
+/// saved) against streaming them into one multi-frame DICOM
+/// (MultiFrameDicomWriter), uncompressed and with each lossless compression
+/// (see DicomCompress).
+///
+/// Synthetic frames are written into a temporary directory, which is deleted
+/// afterwards. The time, frame rate, throughput, files written and
+/// compression ratio for each path are reported. Every file is read back
+/// and decompressed with DCMTK, and has to match the frames exactly.
+///
+/// Before that, the time to build a snapshot's header is measured, with
+/// every injector asked for all of its data against cloning the
+/// DicomInjectorSet's header template.
+///
+/// Run with the --benchmark-dicom command line option.
+/// </summary>
+class DicomWriteBenchmark
+{
+public:
+	/// <summary>
+	/// Run the benchmark and print the results.
+	/// </summary>
+	/// <param name="os">The stream to print the results to.</param>
+	/// <param name="frameCt">The number of frames to write with each path.</param>
+	/// <returns>
+	/// False if any path failed to write the frames, or a file didn't decode
+	/// back to the frames it was written from.
+	/// </returns>
+	static bool Run(std::ostream& os, int frameCt);
+};
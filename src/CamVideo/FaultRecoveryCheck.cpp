@@ -0,0 +1,146 @@
+#include "FaultRecoveryCheck.h"
+#include "ManagedCam.h"
+#include "../Utils/multiplatform.h"
+#include <opencv2/imgcodecs.hpp>
+#include <boost/filesystem.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	/// <summary>
+	/// The camera id used for the check, out of the way of real cameras.
+	/// </summary>
+	const int checkCamId = 100;
+
+	struct Scenario
+	{
+		std::string name;
+		CamFaultProfile profile;
+
+		/// <summary>
+		/// How long the camera streams with the faults.
+		/// </summary>
+		int runMS;
+
+		/// <summary>
+		/// If true, the faults should cause outages that are recovered
+		/// from. Else, there should be no outages.
+		/// </summary>
+		bool expectOutage;
+
+		/// <summary>
+		/// If true, at least one outage should be recovered from by 
+		/// reactivating the implementation instead of rebuilding it.
+		/// </summary>
+		bool expectWarmRestart;
+	};
+
+	std::vector<Scenario> MakeScenarios()
+	{
+		std::vector<Scenario> ret;
+
+		Scenario drops;
+		drops.name						= "Drops";
+		drops.profile.dropChance		= 0.3f;
+		drops.profile.seed				= 1;
+		drops.runMS						= 2000;
+		drops.expectOutage				= false;
+		drops.expectWarmRestart			= false;
+		ret.push_back(drops);
+
+		// Stalls outlast ManagedCam::stallTimeoutMS.
+		Scenario stalls;
+		stalls.name						= "Stalls";
+		stalls.profile.stallChance		= 0.05f;
+		stalls.profile.stallMS			= 1000;
+		stalls.profile.seed				= 2;
+		stalls.runMS					= 5000;
+		stalls.expectOutage				= true;
+		stalls.expectWarmRestart		= true;
+		ret.push_back(stalls);
+
+		Scenario disconnects;
+		disconnects.name				= "Disconnects";
+		disconnects.profile.disconnectChance	= 0.05f;
+		disconnects.profile.disconnectMS		= 400;
+		disconnects.profile.seed				= 3;
+		disconnects.runMS				= 5000;
+		disconnects.expectOutage		= true;
+		disconnects.expectWarmRestart	= false;
+		ret.push_back(disconnects);
+
+		return ret;
+	}
+
+	bool RunScenario(std::ostream& os, const Scenario& scenario, const std::string& imgPath)
+	{
+		cvgCamFeedSource opts;
+		opts.defPoll			= VideoPollType::Image;
+		opts.staticImagePath	= imgPath;
+		opts.faultInjection		= scenario.profile;
+
+		std::unique_ptr<ManagedCam> cam(new ManagedCam(VideoPollType::Image, checkCamId, opts));
+		cam->BootupPollingThread(checkCamId);
+		MSSleep(scenario.runMS);
+
+		// Frames were delivered at some point, and the last outage, if
+		// there is one, has time to end.
+		const int settleMS = 3000;
+		for(int waitedMS = 0; cam->IsFrameStale() && waitedMS < settleMS; waitedMS += 50)
+			MSSleep(50);
+
+		bool gotFrame = (cam->GetCurrentFrame() != nullptr);
+		ManagedCam::ReconnectStats stats = cam->GetReconnectStats();
+
+		// Shuts down and joins the camera thread.
+		cam.reset();
+
+		bool passed = gotFrame;
+		if(scenario.expectOutage)
+			passed = passed && stats.reconnectCt > 0;
+		else
+			passed = passed && stats.attemptCt == 0 && stats.reconnectCt == 0;
+
+		if(scenario.expectWarmRestart)
+			passed = passed && stats.warmRestartCt > 0;
+
+		os << "\t" << scenario.name << ": " << (passed ? "PASSED" : "FAILED") <<
+			" - Frames: " << (gotFrame ? "yes" : "no") <<
+			" - Reconnects: " << stats.reconnectCt <<
+			" - Attempts: " << stats.attemptCt <<
+			" - Warm restarts: " << stats.warmRestartCt <<
+			" - Longest outage MS: " << stats.longestOutageMS <<
+			" - In outage: " << (stats.inOutage ? "yes" : "no") << std::endl;
+
+		return passed;
+	}
+}
+
+bool FaultRecoveryCheck::Run(std::ostream& os)
+{
+	boost::system::error_code ec;
+	boost::filesystem::path root =
+		boost::filesystem::temp_directory_path(ec) / boost::filesystem::unique_path("hmdop_faultcheck_%%%%%%%%");
+	boost::filesystem::create_directories(root, ec);
+
+	std::string imgPath = (root / "frame.png").string();
+	cv::Mat img(240, 320, CV_8UC3, cv::Scalar(0, 128, 255));
+	if(!cv::imwrite(imgPath, img))
+	{
+		os << "Could not write the check's image to " << imgPath << std::endl;
+		return false;
+	}
+
+	os << "Fault recovery check:" << std::endl;
+
+	bool allPassed = true;
+	for(const Scenario& scenario : MakeScenarios())
+		allPassed &= RunScenario(os, scenario, imgPath);
+
+	boost::filesystem::remove_all(root, ec);
+
+	os << (allPassed ? "Every scenario recovered as expected." : "Some scenarios did not recover as expected.") << std::endl;
+	return allPassed;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <ostream>
+
+/// <summary>
+/// A scripted check of ManagedCam's recovery from camera faults, using
+/// CamImpl_FaultInject with fixed seeds.
+///
+/// A ManagedCam streams a generated static image through the fault 
+/// injection wrapper, once for each kind of fault:
+/// - Drops: frames keep being delivered, with no outage.
+/// - Stalls: the stall is detected, and the stream is recovered by 
+///   reactivating the implementation.
+/// - Disconnects: the outage is recovered from once the simulated 
+///   disconnect is over.
+///
+/// Run with the --check-fault-recovery command line option.
+/// </summary>
+class FaultRecoveryCheck
+{
+public:
+	/// <summary>
+	/// Run every scenario and print the results.
+	/// </summary>
+	/// <param name="os">The stream to print the results to.</param>
+	/// <returns>True if every scenario recovered the way it's expected to.</returns>
+	static bool Run(std::ostream& os);
+};
@@ -0,0 +1,220 @@
+#include "FrameHistory.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+
+std::mutex FrameHistory::settingsAccess;
+FrameHistory::Settings FrameHistory::settings;
+
+FrameHistory::~FrameHistory()
+{
+	this->storeStrand.Drain();
+}
+
+void FrameHistory::Push(
+	cv::Ptr<cv::Mat> frame,
+	std::chrono::steady_clock::time_point captureTime,
+	long long epoch,
+	bool processed)
+{
+	if(frame == nullptr || frame->empty())
+		return;
+
+	Settings curSettings = GetSettings();
+	if(curSettings.budgetBytes == 0)
+	{
+		// If the history was turned off, let go of its memory.
+		this->Clear();
+		return;
+	}
+
+	Entry entry;
+	entry.size			= frame->size();
+	entry.type			= frame->type();
+	entry.captureTime	= captureTime;
+	entry.epoch			= epoch;
+	entry.processed		= processed;
+
+	if(curSettings.storage == Storage::Full)
+	{
+		entry.stored	= *frame;
+		entry.bytes		= frame->total() * frame->elemSize();
+		this->_Insert(std::move(entry), curSettings);
+		return;
+	}
+
+	// The history is a convenience, it isn't worth holding up the pool for.
+	if(this->storeStrand.Pending() >= maxStoreBacklog)
+	{
+		std::lock_guard<std::mutex> guard(this->entriesAccess);
+		++this->droppedCt;
+		return;
+	}
+
+	cv::Mat src = *frame;
+	this->storeStrand.Post(
+		[this, src, entry, curSettings]() mutable
+		{
+			if(curSettings.storage == Storage::Downscaled)
+			{
+				int factor = std::max(1, curSettings.downscale);
+				cv::Size smallSize(std::max(1, src.cols / factor), std::max(1, src.rows / factor));
+				cv::resize(src, entry.stored, smallSize, 0.0, 0.0, cv::INTER_AREA);
+			}
+			else
+			{
+				std::vector<unsigned char> encoded;
+				std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, curSettings.jpegQuality};
+				if(!cv::imencode(".jpg", src, encoded, params))
+					return;
+
+				entry.stored		= cv::Mat(encoded, true);
+				entry.compressed	= true;
+			}
+			entry.bytes = entry.stored.total() * entry.stored.elemSize();
+			this->_Insert(std::move(entry), curSettings);
+		});
+}
+
+void FrameHistory::_Insert(Entry&& entry, const Settings& curSettings)
+{
+	std::lock_guard<std::mutex> guard(this->entriesAccess);
+	this->bytes += entry.bytes;
+	this->entries.push_back(std::move(entry));
+	this->_Evict_NoMutex(curSettings);
+}
+
+void FrameHistory::_Evict_NoMutex(const Settings& curSettings)
+{
+	std::chrono::milliseconds maxSpan(curSettings.maxMS);
+	while(!this->entries.empty())
+	{
+		const Entry& oldest = this->entries.front();
+		bool overBudget	= this->bytes > curSettings.budgetBytes;
+		bool tooOld		= this->entries.back().captureTime - oldest.captureTime > maxSpan;
+		if(!overBudget && !tooOld)
+			break;
+
+		this->bytes -= oldest.bytes;
+		this->entries.pop_front();
+	}
+}
+
+std::vector<FrameHistory::Entry> FrameHistory::GetSince(std::chrono::steady_clock::time_point since) const
+{
+	std::vector<Entry> ret;
+
+	std::lock_guard<std::mutex> guard(this->entriesAccess);
+	for(const Entry& e : this->entries)
+	{
+		if(e.captureTime >= since)
+			ret.push_back(e);
+	}
+	return ret;
+}
+
+void FrameHistory::Clear()
+{
+	std::lock_guard<std::mutex> guard(this->entriesAccess);
+	this->entries.clear();
+	this->bytes = 0;
+}
+
+void FrameHistory::Drain()
+{
+	this->storeStrand.Drain();
+}
+
+FrameHistory::Stats FrameHistory::GetStats() const
+{
+	Stats ret;
+	ret.budgetBytes = GetSettings().budgetBytes;
+
+	std::lock_guard<std::mutex> guard(this->entriesAccess);
+	ret.frameCt		= (int)this->entries.size();
+	ret.bytes		= this->bytes;
+	ret.droppedCt	= this->droppedCt;
+	if(!this->entries.empty())
+	{
+		ret.spanMS =
+			std::chrono::duration<double, std::milli>(
+				this->entries.back().captureTime - this->entries.front().captureTime).count();
+	}
+	return ret;
+}
+
+cv::Mat FrameHistory::Decode(const Entry& entry)
+{
+	cv::Mat img = entry.stored;
+	if(entry.compressed)
+		img = cv::imdecode(entry.stored, cv::IMREAD_UNCHANGED);
+
+	if(img.empty())
+		return img;
+
+	if(img.size() != entry.size)
+	{
+		cv::Mat fullSize;
+		cv::resize(img, fullSize, entry.size, 0.0, 0.0, cv::INTER_LINEAR);
+		img = fullSize;
+	}
+	return img;
+}
+
+double FrameHistory::Sharpness(const cv::Mat& frame)
+{
+	cv::Mat grey = frame;
+	if(frame.channels() == 3)
+		cv::cvtColor(frame, grey, cv::COLOR_BGR2GRAY);
+	else if(frame.channels() == 4)
+		cv::cvtColor(frame, grey, cv::COLOR_BGRA2GRAY);
+
+	cv::Mat laplacian;
+	cv::Laplacian(grey, laplacian, CV_16S);
+
+	cv::Scalar mean;
+	cv::Scalar stddev;
+	cv::meanStdDev(laplacian, mean, stddev);
+	return stddev[0] * stddev[0];
+}
+
+void FrameHistory::SetSettings(const Settings& newSettings)
+{
+	std::lock_guard<std::mutex> guard(settingsAccess);
+	settings = newSettings;
+}
+
+FrameHistory::Settings FrameHistory::GetSettings()
+{
+	std::lock_guard<std::mutex> guard(settingsAccess);
+	return settings;
+}
+
+std::string to_string(FrameHistory::Storage storage)
+{
+	switch(storage)
+	{
+	case FrameHistory::Storage::Full:
+		return "full";
+
+	case FrameHistory::Storage::Downscaled:
+		return "downscaled";
+
+	case FrameHistory::Storage::Compressed:
+		return "compressed";
+	}
+
+	return "full";
+}
+
+FrameHistory::Storage StringToFrameHistoryStorage(const std::string& str)
+{
+	if(str == "downscaled")
+		return FrameHistory::Storage::Downscaled;
+
+	if(str == "compressed")
+		return FrameHistory::Storage::Compressed;
+
+	//if(str == "full")
+	return FrameHistory::Storage::Full;
+}
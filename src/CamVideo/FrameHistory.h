@@ -0,0 +1,245 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include "../Utils/cvgTaskPool.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <chrono>
+
+/// <summary>
+/// An in-memory ring buffer of a stream's most recent frames, so snapshots
+/// and videos can include frames from before they were requested.
+///
+/// The history is bounded both by time and by a memory budget, whichever
+/// is reached first; the oldest frames are evicted to make room. Frames
+/// can be stored as they are (sharing the pixels with the rest of the
+/// pipeline), downscaled, or JPEG compressed. Downscaling and compressing
+/// are done on the task pool, not on the stream's thread.
+///
+/// The settings are shared by every stream, see SetSettings().
+/// </summary>
+class FrameHistory
+{
+public:
+	/// <summary>
+	/// How frames are stored in the history.
+	/// </summary>
+	enum class Storage
+	{
+		/// <summary>
+		/// The frame is kept as is. Costs no processing, but the most memory.
+		/// </summary>
+		Full,
+
+		/// <summary>
+		/// The frame is kept at a reduced resolution, and scaled back to its
+		/// original size when it's retrieved.
+		/// </summary>
+		Downscaled,
+
+		/// <summary>
+		/// The frame is kept JPEG compressed.
+		/// </summary>
+		Compressed
+	};
+
+	/// <summary>
+	/// The settings for all stream histories.
+	/// </summary>
+	struct Settings
+	{
+		/// <summary>
+		/// The most memory each stream's history can use. If 0, frames
+		/// aren't kept.
+		/// </summary>
+		size_t budgetBytes = 0;
+
+		/// <summary>
+		/// The longest span of time kept, in milliseconds.
+		/// </summary>
+		int maxMS = 5000;
+
+		Storage storage = Storage::Full;
+
+		/// <summary>
+		/// The factor the width and height are divided by, for Downscaled
+		/// storage.
+		/// </summary>
+		int downscale = 2;
+
+		/// <summary>
+		/// The JPEG quality, for Compressed storage.
+		/// </summary>
+		int jpegQuality = 90;
+	};
+
+	/// <summary>
+	/// A frame stored in the history. It's cheap to copy, as the stored
+	/// data is shared.
+	/// </summary>
+	struct Entry
+	{
+		/// <summary>
+		/// The pixels for Full storage, the smaller image for Downscaled
+		/// storage, or a row of the encoded bytes for Compressed storage.
+		/// </summary>
+		cv::Mat stored;
+
+		bool compressed = false;
+
+		/// <summary>
+		/// The size and type of the original frame.
+		/// </summary>
+		cv::Size size;
+		int type = 0;
+
+		std::chrono::steady_clock::time_point captureTime;
+
+		/// <summary>
+		/// The CamSyncGroup acquisition epoch, or -1.
+		/// </summary>
+		long long epoch = -1;
+
+		/// <summary>
+		/// If the frame went through the stream's image processing chain.
+		/// </summary>
+		bool processed = false;
+
+		/// <summary>
+		/// The memory used by the stored data.
+		/// </summary>
+		size_t bytes = 0;
+	};
+
+	/// <summary>
+	/// The memory use of a history, for diagnostics.
+	/// </summary>
+	struct Stats
+	{
+		int frameCt = 0;
+		size_t bytes = 0;
+		size_t budgetBytes = 0;
+
+		/// <summary>
+		/// The time between the oldest and newest frame.
+		/// </summary>
+		double spanMS = 0.0;
+
+		/// <summary>
+		/// Frames that weren't stored because the task pool was too far
+		/// behind on storing them.
+		/// </summary>
+		long long droppedCt = 0;
+	};
+
+private:
+	static std::mutex settingsAccess;
+	static Settings settings;
+
+	/// <summary>
+	/// The most frames that can be waiting on storeStrand to be downscaled
+	/// or compressed. Past this, frames are left out of the history.
+	/// </summary>
+	static const int maxStoreBacklog = 8;
+
+	/// <summary>
+	/// Guards entries, bytes and droppedCt.
+	/// </summary>
+	mutable std::mutex entriesAccess;
+
+	/// <summary>
+	/// The stored frames, oldest first.
+	/// </summary>
+	std::deque<Entry> entries;
+
+	size_t bytes = 0;
+
+	long long droppedCt = 0;
+
+	/// <summary>
+	/// Downscales or compresses frames on the task pool, in order, so they
+	/// stay in capture order.
+	/// </summary>
+	cvgTaskPool::Strand storeStrand;
+
+private:
+	/// <summary>
+	/// Add a stored frame, and evict the frames that no longer fit.
+	/// </summary>
+	void _Insert(Entry&& entry, const Settings& curSettings);
+
+	/// <summary>
+	/// Evict the oldest frames until the history is within its settings.
+	/// Assumes entriesAccess is locked.
+	/// </summary>
+	void _Evict_NoMutex(const Settings& curSettings);
+
+public:
+	~FrameHistory();
+
+	/// <summary>
+	/// Add a frame to the history. Called from the stream's thread, after
+	/// the frame has been handled.
+	/// </summary>
+	/// <param name="frame">
+	/// The frame to add. It's referenced by Full storage, so it must not
+	/// be modified afterwards.
+	/// </param>
+	/// <param name="captureTime">When the frame was captured.</param>
+	/// <param name="epoch">The acquisition epoch, or -1.</param>
+	/// <param name="processed">If the frame was image processed.</param>
+	void Push(
+		cv::Ptr<cv::Mat> frame,
+		std::chrono::steady_clock::time_point captureTime,
+		long long epoch,
+		bool processed);
+
+	/// <summary>
+	/// Get the frames captured at or after a time, oldest first.
+	/// </summary>
+	std::vector<Entry> GetSince(std::chrono::steady_clock::time_point since) const;
+
+	/// <summary>
+	/// Remove all the frames.
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Wait for the frames being stored on the task pool.
+	/// </summary>
+	void Drain();
+
+	Stats GetStats() const;
+
+	/// <summary>
+	/// Get a stored frame back at its original size and type.
+	/// </summary>
+	/// <returns>The frame, or an empty Mat if it couldn't be decoded.</returns>
+	static cv::Mat Decode(const Entry& entry);
+
+	/// <summary>
+	/// Measure the sharpness of a frame, as the variance of its Laplacian.
+	/// Only comparable between frames of the same stream.
+	/// </summary>
+	static double Sharpness(const cv::Mat& frame);
+
+	static void SetSettings(const Settings& newSettings);
+
+	static Settings GetSettings();
+};
+
+/// <summary>
+/// Convert a FrameHistory::Storage to a serialiable string value.
+///
+/// The name convention is made to match std::to_string() functions.
+/// </summary>
+std::string to_string(FrameHistory::Storage storage);
+
+/// <summary>
+/// Convert a serialized string to a FrameHistory::Storage. If the string
+/// is not recognized, it is defaulted to FrameHistory::Storage::Full.
+/// </summary>
+FrameHistory::Storage StringToFrameHistoryStorage(const std::string& str);
@@ -0,0 +1,209 @@
+#include "GrabberStallCheck.h"
+#include "CamImpl/CamImpl_OpenCVBase.h"
+#include "../Utils/multiplatform.h"
+#include <opencv2/videoio.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <string>
+
+namespace
+{
+	/// <summary>
+	/// How long a grab of the stand-in stream blocks while it's stalled,
+	/// like FFmpeg's read timeout.
+	/// </summary>
+	const int standInReadTimeoutMS = 1000;
+
+	/// <summary>
+	/// How long the stand-in stream takes to deliver a frame.
+	/// </summary>
+	const int standInFrameMS = 33;
+
+	/// <summary>
+	/// How much longer than expected a call may take, for scheduling.
+	/// </summary>
+	const int slackMS = 250;
+
+	/// <summary>
+	/// A VideoCapture that stands in for a network stream, without a
+	/// backend behind it.
+	/// </summary>
+	class StandInStream : public cv::VideoCapture
+	{
+	private:
+		std::mutex stallMutex;
+		std::chrono::steady_clock::time_point stallUntil;
+
+		std::atomic<double> fps = 0.0;
+
+	public:
+		/// <summary>
+		/// Stall the stream, starting now, for ms milliseconds.
+		/// </summary>
+		void Stall(int ms)
+		{
+			std::lock_guard<std::mutex> guard(this->stallMutex);
+			this->stallUntil = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+		}
+
+		/// <summary>
+		/// The last frame rate set on the stream.
+		/// </summary>
+		double GetSetFPS() const
+		{ return this->fps; }
+
+		bool grab() override
+		{
+			std::chrono::steady_clock::time_point until;
+			{
+				std::lock_guard<std::mutex> guard(this->stallMutex);
+				until = this->stallUntil;
+			}
+
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if(now < until)
+			{
+				std::this_thread::sleep_for(
+					std::min<std::chrono::steady_clock::duration>(
+						until - now,
+						std::chrono::milliseconds(standInReadTimeoutMS)));
+				return false;
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(standInFrameMS));
+			return true;
+		}
+
+		bool retrieve(cv::OutputArray image, int flag = 0) override
+		{
+			cv::Mat frame(240, 320, CV_8UC3, cv::Scalar(0, 128, 255));
+			frame.copyTo(image);
+			return true;
+		}
+
+		bool set(int propId, double value) override
+		{
+			if(propId == cv::CAP_PROP_FPS)
+				this->fps = value;
+
+			return true;
+		}
+
+		double get(int propId) const override
+		{
+			if(propId == cv::CAP_PROP_FPS)
+				return this->fps;
+
+			return 0.0;
+		}
+	};
+
+	class StandInCam : public CamImpl_OpenCVBase
+	{
+	public:
+		/// <summary>
+		/// The stream while the camera is active, owned by the camera.
+		/// </summary>
+		StandInStream* stream = nullptr;
+
+	protected:
+		cv::VideoCapture* CreateVideoCapture() override
+		{
+			this->stream = new StandInStream();
+			return this->stream;
+		}
+
+	public:
+		VideoPollType PollType() override
+		{ return VideoPollType::Web; }
+	};
+
+	/// <summary>
+	/// Time a call, in milliseconds.
+	/// </summary>
+	template<typename Fn>
+	long long TimeMS(Fn fn)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		fn();
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool Report(std::ostream& os, const std::string& name, bool passed, const std::string& detail)
+	{
+		os << "\t" << name << ": " << (passed ? "PASSED" : "FAILED") << " - " << detail << std::endl;
+		return passed;
+	}
+}
+
+bool GrabberStallCheck::Run(std::ostream& os)
+{
+	os << "Grabber stall check:" << std::endl;
+
+	StandInCam cam;
+	ICamImpl& impl = cam;
+
+	cvgCamFeedLocs opts;
+	opts.lowLatencyGrab = true;
+	impl.PullOptions(opts);
+
+	if(!impl.Initialize() || !impl.Activate())
+	{
+		os << "Could not activate the stand-in camera." << std::endl;
+		return false;
+	}
+
+	bool allPassed = true;
+
+	int frameCt = 0;
+	for(int i = 0; i < 10; ++i)
+	{
+		if(impl.PollFrame() != nullptr)
+			++frameCt;
+	}
+	allPassed &= Report(os, "Streaming", frameCt > 0, "Frames: " + std::to_string(frameCt) + "/10");
+
+	// Give the grabber time to block on the stall.
+	const int stallMS = 3000;
+	cam.stream->Stall(stallMS);
+	MSSleep(100);
+
+	long long pollMS = TimeMS([&]{ impl.PollFrame(); });
+	allPassed &= Report(os, "Poll while stalled", pollMS < 250 + slackMS, "MS: " + std::to_string(pollMS));
+
+	const double newFPS = 15.0;
+	long long setMS = TimeMS([&]{ impl.SetParam(StreamParams::StreamFPS, newFPS); });
+	allPassed &= Report(os, "Set property while stalled", setMS < 250 + slackMS, "MS: " + std::to_string(setMS));
+
+	// Once the stall is over, the property has been applied between grabs,
+	// and frames are delivered again.
+	MSSleep(stallMS);
+	cv::Ptr<cv::Mat> resumedFrame;
+	for(int i = 0; i < 10 && resumedFrame == nullptr; ++i)
+		resumedFrame = impl.PollFrame();
+
+	allPassed &= Report(os, "Resumed", resumedFrame != nullptr, std::string("Frame: ") + (resumedFrame != nullptr ? "yes" : "no"));
+	allPassed &= Report(
+		os,
+		"Property applied",
+		cam.stream->GetSetFPS() == newFPS,
+		"FPS: " + std::to_string(cam.stream->GetSetFPS()));
+
+	cam.stream->Stall(10 * stallMS);
+	MSSleep(100);
+
+	long long stopMS = TimeMS([&]{ impl.Deactivate(); });
+	cam.stream = nullptr;
+	impl.Shutdown();
+	allPassed &= Report(
+		os,
+		"Deactivate while stalled",
+		stopMS < standInReadTimeoutMS + slackMS,
+		"MS: " + std::to_string(stopMS));
+
+	os << (allPassed ? "Nothing was held up by the stalled stream." : "Some calls were held up by the stalled stream.") << std::endl;
+	return allPassed;
+}
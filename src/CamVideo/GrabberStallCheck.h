@@ -0,0 +1,28 @@
+#pragma once
+
+#include <ostream>
+
+/// <summary>
+/// A scripted check that a stalled stream doesn't hold up the low latency
+/// grabber thread's users (see CamImpl_OpenCVBase).
+///
+/// A stand-in stream delivers generated frames, and on request stalls the
+/// way a network stream does through FFmpeg: each grab blocks until the
+/// read timeout, and fails. While it's stalled:
+/// - Polling gives up on a new frame in about the grab timeout.
+/// - Setting a stream property returns promptly, and the property is
+///   applied between grabs.
+/// - Deactivating waits for at most the grab that's in progress.
+///
+/// Run with the --check-grab-stall command line option.
+/// </summary>
+class GrabberStallCheck
+{
+public:
+	/// <summary>
+	/// Run the check and print the results.
+	/// </summary>
+	/// <param name="os">The stream to print the results to.</param>
+	/// <returns>True if nothing was held up by the stalled stream.</returns>
+	static bool Run(std::ostream& os);
+};
@@ -5,26 +5,39 @@
 #include "../Utils/multiplatform.h"
 #include "../Utils/cvgStopwatch.h"
 #include "../Utils/cvgStopwatchLeft.h"
+#include "../Utils/cvgThreadPlacement.h"
+#include "../Utils/cvgQualityGovernor.h"
 
 #include <dcmtk/dcmdata/dcfilefo.h>
 #include <dcmtk/dcmdata/dcdeftag.h>
 #include <dcmtk/dcmdata/libi2d/i2dimgs.h>
-#include <dcmtk/dcmdata/libi2d/i2dbmps.h>
-#include <dcmtk/dcmdata/libi2d/i2djpgs.h>
-#include <dcmtk/dcmdata/libi2d/i2d.h>
 #include <dcmtk/dcmdata/dcdict.h>
-#include <dcmtk/ofstd/ofcmdln.h>
-#include <dcmtk/dcmdata/libi2d/i2dplsc.h>
+#include <dcmtk/dcmdata/dcuid.h>
+#include <dcmtk/dcmdata/dcostrmb.h>
 
 
 #include "DicomImg_RawBmp.h"
+#include "MultiFrameDicomWriter.h"
+#include "DicomCompress.h"
+#include "CaptureStorage.h"
+#include "VideoRetime.h"
+#include "SessionRecording.h"
 
 #include "../DicomUtils/DicomInjectorSet.h"
 #include "../DicomUtils/DicomMiscUtils.h"
 
 #include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
 #include "../Utils/cvgAssert.h"
 
+std::atomic_bool IManagedCam::padVideoFrames(false);
+std::atomic_bool IManagedCam::multiFrameBursts(true);
+std::mutex IManagedCam::snapLatencyAccess;
+IManagedCam::SnapLatencyStats IManagedCam::snapLatency;
+
 
 double IManagedCam::GetParam(StreamParams paramid)
 {
@@ -94,9 +107,19 @@ bool IManagedCam::SetCurrentFrame(cv::Ptr<cv::Mat> mat)
 
 SnapRequest::SPtr IManagedCam::RequestSnapshot(
 	const std::string& filename, 
-	SnapRequest::ProcessType procType)
+	SnapRequest::ProcessType procType,
+	SnapRequest::FrameSelect select,
+	int lookbackMS)
 {
-	SnapRequest::SPtr req = SnapRequest::MakeRequest(filename, procType);
+	SnapRequest::SPtr req = SnapRequest::MakeRequest(filename, procType, select, lookbackMS);
+	if(select != SnapRequest::FrameSelect::Next)
+	{
+		// The frame has already been polled, there's nothing to wait for.
+		req->status = SnapRequest::Status::Requested;
+		this->_QueueHistorySnapshot(req);
+		return req;
+	}
+
 	{
 		// Thread protected add to the to-process list.
 		std::lock_guard<std::mutex> guard(this->snapReqsAccess);
@@ -125,19 +148,34 @@ void IManagedCam::ClearSnapshotRequests()
 
 bool IManagedCam::_CloseVideo_NoMutex()
 {
+	// Let the queued frames finish writing before the writer is released.
+	this->videoStrand.Drain();
+
 	if(this->videoWrite.isOpened())
 		this->videoWrite.release();
 
+	if(this->videoTimestamps.is_open())
+		this->videoTimestamps.close();
+
+	// Also waits for the queued raw frames to be written.
+	this->rawWrite.Close();
+
 	if(this->activeVideoReq == nullptr)
 		return false;
 
+	if(this->activeVideoReq->droppedCt > 0)
+	{
+		std::cout << "Video " << this->activeVideoReq->filename << " dropped " << 
+			this->activeVideoReq->droppedCt << " frames the encoder couldn't keep up with." << std::endl;
+	}
+
 	this->activeVideoReq->status = VideoRequest::Status::Closed;
 	this->activeVideoReq = nullptr;
 
 	return true;
 }
 
-bool IManagedCam::_DumpImageToVideofile(const cv::Mat& img)
+bool IManagedCam::_DumpImageToVideofile(const cv::Mat& img, std::chrono::steady_clock::time_point captureTime)
 {
 	if(img.empty())
 	{
@@ -159,52 +197,222 @@ bool IManagedCam::_DumpImageToVideofile(const cv::Mat& img)
 		return true;
 	}
 
-	const int msFor30FPS = 33; // 1000 / 30
-
 	// If the videowrite has not been opened yet, open it locked
 	// to the image size. Every image streamed to the video will
 	// now need to match the dimensions, or else it's considered
 	// an error.
 	if(!this->videoWrite.isOpened())
 	{
-		int mp4FourCC = cv::VideoWriter::fourcc('a', 'v', 'c', '1');
-		this->videoWrite.open(this->activeVideoReq->filename, mp4FourCC, 30.0, img.size());
-		if(!this->videoWrite.isOpened())
-		{
-			this->activeVideoReq->err = "Could not open requested file.";
-			this->activeVideoReq->status = VideoRequest::Status::Error;
-			this->_CloseVideo_NoMutex();
+		// Single channel feeds are recorded as greyscale, instead of
+		// being expanded to BGR for every frame.
+		if(!this->_OpenVideoWriter(img.size(), img.channels() != 1, captureTime))
 			return false;
-		}
-		this->activeVideoReq->width		= img.size().width;
-		this->activeVideoReq->height	= img.size().height;
-		this->activeVideoReq->status	= VideoRequest::Status::StreamingOut;
+	}
+
+	// Already written from the history when the video was opened.
+	if(captureTime <= this->videoPreRollEnd)
+		return true;
 
-		this->videoGrabTimer.Reset(msFor30FPS);
+	// Without padding, every frame is written once.
+	int frameCt = 1;
+	if(this->videoPadded)
+	{
+		// Kept in microseconds, as rates like 60FPS aren't a whole number
+		// of milliseconds.
+		long long usPerFrame = (long long)(1000000.0 / this->videoFPS);
+		
+		// Safeguard for how much we pad. In the worst case scenario, 
+		// the device will be so slow that by the time it writes a frame, 
+		// the next frame's time has passed and we'll be busy writing video 
+		// padding for this single frame forever.
+		const int maxFramePadding = 10;
+		frameCt = 0;
+		while(this->videoGrabTimer.GrabMicroseconds(usPerFrame) && frameCt < maxFramePadding)
+			++frameCt;
+
+		if(frameCt == 0)
+			return true;
 	}
-	
-	// Safeguard for how much we pad. In the worst case scenario, 
-	// the device will be so slow that by the time it writes a frame, 
-	// the next 33ms have passed and we'll be busy writing video 
-	// padding for this single frame forever.
-	const int maxFramePadding = 10;
-	int i = 0;
-	while(this->videoGrabTimer.GrabMS(msFor30FPS) && i < maxFramePadding)
-	{
-		// If contents have already been streamed, just make sure the dimensions
-		// continue to be the same.
-		if(
-			this->activeVideoReq->width		!= img.size().width ||
-			this->activeVideoReq->height	!= img.size().height )
+
+	// If contents have already been streamed, just make sure the dimensions
+	// continue to be the same.
+	if(
+		this->activeVideoReq->width		!= img.size().width ||
+		this->activeVideoReq->height	!= img.size().height )
+	{
+		this->activeVideoReq->err = "Closed when attempting to add misshapened image.";
+		this->activeVideoReq->status = VideoRequest::Status::Error;
+		this->_CloseVideo_NoMutex();
+		return true;
+	}
+
+	// Capturing comes first, if the encoder is behind the frame is dropped
+	// rather than queued.
+	if(this->videoStrand.Pending() >= maxVideoBacklog)
+	{
+		++this->activeVideoReq->droppedCt;
+		return true;
+	}
+
+	// The encoding is handed off to the task pool. The copied Mat header
+	// shares the frame's pixels, which aren't modified once a frame has been 
+	// handled.
+	cv::Mat frame = img;
+	cv::VideoWriter* writer = &this->videoWrite;
+	std::ofstream* timestamps = &this->videoTimestamps;
+	double captureMS = 
+		std::chrono::duration<double, std::milli>(captureTime - this->videoStartTime).count();
+
+	this->videoStrand.Post(
+		[writer, timestamps, frame, frameCt, captureMS]
 		{
-			this->activeVideoReq->err = "Closed when attempting to add misshapened image.";
-			this->activeVideoReq->status = VideoRequest::Status::Error;
-			this->_CloseVideo_NoMutex();
-			break;
-		}
+			// Padded duplicates have the timestamp of the frame they repeat.
+			for(int i = 0; i < frameCt; ++i)
+			{
+				writer->write(frame);
+				if(timestamps->is_open())
+					*timestamps << captureMS << "\n";
+			}
+		});
+
+	std::shared_ptr<SessionRecording> session = this->activeVideoReq->session.lock();
+	if(session != nullptr)
+	{
+		session->LogFrame(
+			this->activeVideoReq->sessionStream, 
+			this->videoFrameCt, 
+			captureMS, 
+			this->acquisitionEpoch);
+	}
+	this->videoFrameCt += frameCt;
+
+	return true;
+}
+
+bool IManagedCam::_OpenVideoWriter(cv::Size size, bool isColor, std::chrono::steady_clock::time_point startTime)
+{
+	// The recording's timebase is the stream's frame rate.
+	this->videoFPS = this->GetTargetFPS();
+
+	// OpenCV writes the video itself, so its folder is recreated here if
+	// it was removed during the session.
+	CaptureStorage::EnsureParentFolder(this->activeVideoReq->filename);
+
+	int mp4FourCC = cv::VideoWriter::fourcc('a', 'v', 'c', '1');
+	this->videoWrite.open(this->activeVideoReq->filename, mp4FourCC, this->videoFPS, size, isColor);
+	if(!this->videoWrite.isOpened())
+	{
+		this->activeVideoReq->err = "Could not open requested file.";
+		this->activeVideoReq->status = VideoRequest::Status::Error;
+		this->_CloseVideo_NoMutex();
+		return false;
+	}
+	this->activeVideoReq->width		= size.width;
+	this->activeVideoReq->height	= size.height;
+	this->activeVideoReq->status	= VideoRequest::Status::StreamingOut;
+
+	// The video's frame rate is only nominal, the timestamps file has 
+	// when each frame was actually captured. It's in the same format 
+	// the Replay poll type reads.
+	std::string timestampsPath = VideoRetime::TimestampsPath(this->activeVideoReq->filename);
+	this->videoTimestamps.open(timestampsPath);
+	if(!this->videoTimestamps.is_open())
+		std::cout << "Could not create video timestamps file " << timestampsPath << std::endl;
+	this->videoTimestamps << std::fixed << std::setprecision(3);
+
+	// Streams of a session share the session's clock.
+	std::shared_ptr<SessionRecording> session = this->activeVideoReq->session.lock();
+	this->videoStartTime	= (session != nullptr) ? session->StartTime() : startTime;
+	this->videoPreRollEnd	= std::chrono::steady_clock::time_point::min();
+	this->videoPadded		= padVideoFrames;
+	this->videoFrameCt		= 0;
+
+	// Start with a frame's worth of time, so the first frame is written.
+	this->videoGrabTimer.Reset((int)std::ceil(1000.0 / this->videoFPS));
+	return true;
+}
+
+bool IManagedCam::_DumpHistoryToVideofile(const std::vector<FrameHistory::Entry>& frames)
+{
+	if(frames.empty() || this->activeVideoReq == nullptr)
+		return false;
+
+	const FrameHistory::Entry& first = frames.front();
+	if(!this->_OpenVideoWriter(first.size, CV_MAT_CN(first.type) != 1, first.captureTime))
+		return false;
+
+	// Frames from before the stream's resolution changed can't go in the
+	// video.
+	std::vector<FrameHistory::Entry> preRoll;
+	for(const FrameHistory::Entry& e : frames)
+	{
+		if(e.size == first.size && e.type == first.type)
+			preRoll.push_back(e);
+	}
+
+	cv::VideoWriter* writer = &this->videoWrite;
+	std::ofstream* timestamps = &this->videoTimestamps;
+	std::chrono::steady_clock::time_point startTime = this->videoStartTime;
+
+	this->videoStrand.Post(
+		[writer, timestamps, preRoll, startTime]
+		{
+			for(const FrameHistory::Entry& e : preRoll)
+			{
+				cv::Mat frame = FrameHistory::Decode(e);
+				if(frame.empty())
+					continue;
+
+				writer->write(frame);
+				if(timestamps->is_open())
+				{
+					*timestamps << 
+						std::chrono::duration<double, std::milli>(e.captureTime - startTime).count() << "\n";
+				}
+			}
+		});
+
+	this->videoPreRollEnd	= frames.back().captureTime;
+	this->videoFrameCt		+= preRoll.size();
+	return true;
+}
+
+bool IManagedCam::_DumpImageToRawfile(cv::Ptr<cv::Mat> img)
+{
+	if(img == nullptr || img->empty())
+	{
+		this->_CloseVideo_NoMutex();
+		return false;
+	}
+
+	if(this->activeVideoReq == nullptr)
+		return false;
+
+	if(this->activeVideoReq->_reqStopped)
+	{ 
+		this->_CloseVideo_NoMutex();
+		return true;
+	}
 
-		this->videoWrite.write(img);
-		++i;
+	RawCaptureWriter::FrameInfo info;
+	info.captureTime	= this->frameCaptureTime;
+	info.exposureUS		= (int)this->GetParam(StreamParams::ExposureMicroseconds);
+	info.threshold		= this->GetFrameThreshold();
+
+	if(!this->rawWrite.Submit(img, info))
+	{
+		std::string err = this->rawWrite.GetError();
+		this->activeVideoReq->err = err.empty() ? "Could not write to the raw capture." : err;
+		this->activeVideoReq->status = VideoRequest::Status::Error;
+		this->_CloseVideo_NoMutex();
+		return false;
+	}
+
+	if(this->activeVideoReq->status == VideoRequest::Status::Requested)
+	{
+		this->activeVideoReq->width		= img->size().width;
+		this->activeVideoReq->height	= img->size().height;
+		this->activeVideoReq->status	= VideoRequest::Status::StreamingOut;
 	}
 	return true;
 }
@@ -218,7 +426,17 @@ bool IManagedCam::CloseVideo()
 bool IManagedCam::IsRecordingVideo()
 {
 	std::lock_guard<std::mutex> guard(this->videoAccess);
-	return this->videoWrite.isOpened();
+	return this->videoWrite.isOpened() || this->rawWrite.IsOpen();
+}
+
+float IManagedCam::GetFrameThreshold()
+{
+	return -1.0f;
+}
+
+long long IManagedCam::GetSkippedFrameCt()
+{
+	return 0;
 }
 
 std::string IManagedCam::VideoFilepath()
@@ -231,13 +449,56 @@ std::string IManagedCam::VideoFilepath()
 }
 
 /// <summary>
-/// Save an OpenCV mat as a jpeg in a Dicom file.
+/// Write a DICOM file to memory, the same as DcmFileFormat::saveFile() would
+/// write it to disk.
 /// </summary>
-/// <param name="imgMat">The image to save.</param>
-/// <param name="cam">The camera containing extra camera Dicom data.</param>
-/// <param name="baseFilename">The filename to save the Dicom file as.</param>
-/// <returns>true if successful, else false.</returns>
-bool SaveMatAsDicomBmp(cv::Ptr<cv::Mat> imgMat, IManagedCam* cam, const std::string& baseFilename)
+/// <param name="dcmff">The file to write.</param>
+/// <param name="writeXfer">The transfer syntax to write it with.</param>
+/// <param name="out">The file's bytes. Its capacity is reused.</param>
+/// <returns>True if successful.</returns>
+static bool SerializeDicomFile(DcmFileFormat& dcmff, E_TransferSyntax writeXfer, std::vector<unsigned char>& out)
+{
+	// The stream hands its buffer back whenever it's filled.
+	const offile_off_t streamBytes = 1024 * 1024;
+	std::vector<unsigned char> streamBuffer((size_t)streamBytes);
+	DcmOutputBufferStream outStream(streamBuffer.data(), streamBytes);
+
+	auto fnTakeBuffer = 
+		[&outStream, &out]
+		{
+			void* written = nullptr;
+			offile_off_t writtenLen = 0;
+			outStream.flushBuffer(written, writtenLen);
+			if(writtenLen > 0)
+				out.insert(out.end(), (unsigned char*)written, (unsigned char*)written + writtenLen);
+		};
+
+	out.clear();
+	dcmff.transferInit();
+	OFCondition cond = EC_StreamNotifyClient;
+	while(cond == EC_StreamNotifyClient)
+	{
+		cond = dcmff.write(outStream, writeXfer, EET_UndefinedLength, nullptr, EGL_recalcGL);
+		fnTakeBuffer();
+	}
+	dcmff.transferEnd();
+
+	if(cond.bad())
+		return false;
+
+	outStream.flush();
+	fnTakeBuffer();
+	return true;
+}
+
+bool SaveMatAsDicomBmp(
+	cv::Ptr<cv::Mat> imgMat, 
+	IManagedCam* cam, 
+	const std::string& baseFilename, 
+	const std::string& qualityLevel,
+	long long acquisitionEpoch,
+	const std::vector<std::pair<std::string, std::string>>& extraContext,
+	std::function<void(bool)> onWritten)
 {
 	//////////////////////////////////////////////////
 	//	TEMPORARY CODE FOR DICOM
@@ -248,35 +509,44 @@ bool SaveMatAsDicomBmp(cv::Ptr<cv::Mat> imgMat, IManagedCam* cam, const std::str
 	// - Location of DicomImg_RawJpg needs to be confirmed.
 	// - Whether we do this raw in this location, or delegate to a formal system
 	//	should be thought-out.
+	//
+	// The header isn't built with Image2Dcm. Most of it doesn't change during
+	// a session, so it's cloned from the DicomInjectorSet's header template,
+	// and only what changes per snapshot is filled in.
+
+	static std::once_flag dictChecked;
+	std::call_once(
+		dictChecked,
+		[]
+		{
+			if (!dcmDataDict.isDictionaryLoaded())
+			{
+				std::cerr << 
+					"no data dictionary loaded, check environment variable: "
+					<< DCM_DICT_ENVIRONMENT_VARIABLE 
+					<< std::endl;
+			}
+		});
+
+	// Convert the pixels the same way Image2Dcm would have.
+	DicomImg_RawBmp inputImgSrc(imgMat);
+	Uint16 rows, cols, samplesPerPixel, bitsAlloc, bitsStored, highBit, pixelRepr, planConf, pixAspectH, pixAspectV;
+	OFString photoMetrInt;
+	char* pixData = nullptr;
+	Uint32 length = 0;
+	E_TransferSyntax writeXfer;
+	OFCondition cond = 
+		inputImgSrc.readPixelData(
+			rows, cols, samplesPerPixel, photoMetrInt, bitsAlloc, bitsStored, highBit, pixelRepr, 
+			planConf, pixAspectH, pixAspectV, pixData, length, writeXfer);
 
-	DicomInjectorSet& dicomInjSet = DicomInjectorSet::GetSingleton();
-
-	Image2Dcm i2d;
-	i2d.setValidityChecking(OFTrue, OFTrue, OFTrue); // using default param values from img2dcm DCMTK sample
-
-	I2DOutputPlug* outPlug = new I2DOutputPlugSC();
-	outPlug->setValidityChecking(OFTrue, OFTrue, OFTrue);
-
-	if (!dcmDataDict.isDictionaryLoaded())
+	if(cond.bad() || pixData == nullptr)
 	{
-		std::cerr << 
-			"no data dictionary loaded, check environment variable: "
-			<< DCM_DICT_ENVIRONMENT_VARIABLE 
-			<< std::endl;
+		delete [] pixData;
+		return false;
 	}
 
-	I2DImgSource* inputImgSrc = new DicomImg_RawBmp(imgMat);
-	inputImgSrc->setImageFile("snapshot"); // TODO: Better name
-	DcmDataset *resultObject = nullptr;
-	E_TransferSyntax writeXfer;
-
-	// !TODO: Error checking
-	OFCondition cond = i2d.convertFirstFrame(inputImgSrc, outPlug, 1, resultObject, writeXfer);
-	//
-	cond = i2d.updateOffsetTable();
-	cond = i2d.updateLossyCompressionInfo(inputImgSrc, 1, resultObject);
-	DcmFileFormat dcmff(resultObject);
-
+	DcmFileFormat dcmff;
 	DcmDataset* dicomData = dcmff.getDataset();
 	//
 	// ADD DICOM TIMESTAMPS
@@ -285,19 +555,61 @@ bool SaveMatAsDicomBmp(cv::Ptr<cv::Mat> imgMat, IManagedCam* cam, const std::str
 	// https://dicom.innolitics.com/ciods/cr-image/general-study/00080030
 	dicomData->putAndInsertString(DCM_StudyTime, DicomMiscUtils::GetCurrentTime().c_str());
 	//
-	// ADD DICOM INJECTION SET DATA
-	dicomInjSet.InjectDataInto(dicomData);
+	// ADD DICOM INJECTION SET DATA, CLONED FROM THE HEADER TEMPLATE
+	DicomInjectorSet::GetSingleton().InjectDataInto(dicomData);
 	//
 	// ADD DICOM CAMERA DATA
-	cam->InjectIntoDicom(dicomData);
-
-	cond = dcmff.saveFile((baseFilename + ".dcm").c_str(), writeXfer);
-
-	delete inputImgSrc;
-	delete outPlug;
-	delete resultObject;
+	if(cam != nullptr)
+		cam->InjectIntoDicom(dicomData);
+	//
+	// ADD THE PROCESSING QUALITY
+	if(!qualityLevel.empty())
+		InsertAcquisitionContextInfo(dicomData, "quality_level", qualityLevel);
+	//
+	// ADD THE ACQUISITION EPOCH, TO PAIR UP SNAPSHOTS OF DIFFERENT CAMERAS
+	if(acquisitionEpoch >= 0)
+		InsertAcquisitionContextInfo(dicomData, "acquisition_epoch", std::to_string(acquisitionEpoch));
+	//
+	// ADD ANYTHING ELSE THE CALLER KNOWS ABOUT THE IMAGE
+	for(const std::pair<std::string, std::string>& kv : extraContext)
+		InsertAcquisitionContextInfo(dicomData, kv.first, kv.second);
+	//
+	// ADD THE SECONDARY CAPTURE IDENTIFICATION
+	DicomMiscUtils::InsertSecondaryCaptureHeader(dicomData, UID_SecondaryCaptureImageStorage);
+	//
+	// ADD THE IMAGE PIXEL MODULE
+	dicomData->putAndInsertUint16(DCM_SamplesPerPixel,			samplesPerPixel);
+	dicomData->putAndInsertString(DCM_PhotometricInterpretation,	photoMetrInt.c_str());
+	dicomData->putAndInsertUint16(DCM_Rows,						rows);
+	dicomData->putAndInsertUint16(DCM_Columns,					cols);
+	dicomData->putAndInsertUint16(DCM_BitsAllocated,			bitsAlloc);
+	dicomData->putAndInsertUint16(DCM_BitsStored,				bitsStored);
+	dicomData->putAndInsertUint16(DCM_HighBit,					highBit);
+	dicomData->putAndInsertUint16(DCM_PixelRepresentation,		pixelRepr);
+	if(samplesPerPixel > 1)
+		dicomData->putAndInsertUint16(DCM_PlanarConfiguration,	planConf);
+	if(pixAspectH != pixAspectV)
+	{
+		std::string aspect = std::to_string(pixAspectV) + "\\" + std::to_string(pixAspectH);
+		dicomData->putAndInsertString(DCM_PixelAspectRatio, aspect.c_str());
+	}
+	cond = dicomData->putAndInsertUint8Array(DCM_PixelData, (const Uint8*)pixData, length);
+	delete [] pixData;
+	if(cond.bad())
+		return false;
+	//
+	// COMPRESS THE PIXEL DATA, IF SET TO. If it isn't compressed, writeXfer
+	// is left as the uncompressed syntax.
+	DicomCompress::CompressDataset(dicomData, DicomCompress::GetMethod(), writeXfer);
+
+	// The file is written to memory, and the CaptureStorage writes it to
+	// disk behind the caller.
+	std::vector<unsigned char> fileBytes;
+	fileBytes.reserve((size_t)length + 64 * 1024);
+	if(!SerializeDicomFile(dcmff, writeXfer, fileBytes))
+		return false;
 
-	return true;
+	return CaptureStorage::GetInstance().WriteFile(baseFilename + ".dcm", std::move(fileBytes), std::move(onWritten));
 }
 
 bool IManagedCam::SaveMatAsDicom_HandleReq(
@@ -310,11 +622,36 @@ bool IManagedCam::SaveMatAsDicom_HandleReq(
 	if(snreq->status == SnapRequest::Status::Error)
 		return false;
 
-	// Save and notify success.
-	if(SaveMatAsDicomBmp(imgMat, cam, snreq->filename))
+	// Save and notify success. The file is written behind the request, 
+	// which is marked as an error if that fails.
+	if(SaveMatAsDicomBmp(
+		imgMat, 
+		cam, 
+		snreq->filename, 
+		snreq->qualityLevel, 
+		snreq->acquisitionEpoch, 
+		{},
+		[snreq](bool written){ snreq->_SetWritten(written); }))
 	{
-		snreq->frameID = camFeedChanges;
-		snreq->status = SnapRequest::Status::Filled;
+		double latencyMS = 
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - snreq->requestTime).count();
+		{
+			std::lock_guard<std::mutex> guard(snapLatencyAccess);
+			if(snapLatency.snapCt == 0)
+			{
+				snapLatency.firstMS = latencyMS;
+				std::cout << "First snapshot saved " << latencyMS << " MS after being requested." << std::endl;
+			}
+			else
+			{
+				snapLatency.steadyTotalMS += latencyMS;
+				if(latencyMS > snapLatency.steadyMaxMS)
+					snapLatency.steadyMaxMS = latencyMS;
+			}
+			++snapLatency.snapCt;
+		}
+
+		snreq->_SetFilled(camFeedChanges);
 		return true;
 	}
 	
@@ -327,6 +664,357 @@ bool IManagedCam::SaveMatAsDicom_HandleReq(
 	return false;
 }
 
+void IManagedCam::_QueueSnapshotEncode(cv::Ptr<cv::Mat> imgMat, SnapRequest::SPtr snreq)
+{
+	int frameID = (int)this->camFeedChanges;
+
+	// Recorded now, as the level may change before the encode runs.
+	snreq->qualityLevel = to_string(cvgQualityGovernor::GetInstance().GetLevel());
+	snreq->acquisitionEpoch = this->acquisitionEpoch;
+
+	cvgTaskPool::GetInstance().Submit(
+		[this, imgMat, snreq, frameID]
+		{
+			SaveMatAsDicom_HandleReq(imgMat, this, snreq, frameID);
+		},
+		&this->snapEncodes);
+}
+
+void IManagedCam::_QueueHistorySnapshot(SnapRequest::SPtr snreq)
+{
+	std::chrono::steady_clock::time_point reqTime = std::chrono::steady_clock::now();
+
+	// Let the frames that are still being stored make it into the history.
+	this->history.Drain();
+	std::vector<FrameHistory::Entry> frames = 
+		this->history.GetSince(reqTime - std::chrono::milliseconds(snreq->lookbackMS));
+
+	// Only frames at the stage of processing the request allows.
+	frames.erase(
+		std::remove_if(
+			frames.begin(),
+			frames.end(),
+			[snreq](const FrameHistory::Entry& e)
+			{
+				return 
+					(snreq->processType == SnapRequest::ProcessType::HasTo && !e.processed) ||
+					(snreq->processType == SnapRequest::ProcessType::Cannot && e.processed);
+			}),
+		frames.end());
+
+	if(frames.empty())
+	{
+		snreq->err = "No frames in the stream's history to take the snapshot from.";
+		snreq->status = SnapRequest::Status::Error;
+		return;
+	}
+
+	int frameID = (int)this->camFeedChanges;
+	snreq->qualityLevel = to_string(cvgQualityGovernor::GetInstance().GetLevel());
+
+	cvgTaskPool::GetInstance().Submit(
+		[this, snreq, frames, reqTime, frameID]
+		{
+			if(snreq->status == SnapRequest::Status::Error)
+				return;
+
+			// For FrameSelect::Past, the first frame at or after the lookback.
+			size_t pickIdx = 0;
+			cv::Mat pick = FrameHistory::Decode(frames[0]);
+			double sharpness = 0.0;
+			if(snreq->frameSelect == SnapRequest::FrameSelect::Sharpest)
+			{
+				sharpness = pick.empty() ? -1.0 : FrameHistory::Sharpness(pick);
+				for(size_t i = 1; i < frames.size(); ++i)
+				{
+					cv::Mat frame = FrameHistory::Decode(frames[i]);
+					if(frame.empty())
+						continue;
+
+					double frameSharpness = FrameHistory::Sharpness(frame);
+					if(frameSharpness > sharpness)
+					{
+						pickIdx		= i;
+						pick		= frame;
+						sharpness	= frameSharpness;
+					}
+				}
+			}
+
+			if(pick.empty())
+			{
+				snreq->err = "Could not restore the frame from the stream's history.";
+				snreq->status = SnapRequest::Status::Error;
+				return;
+			}
+
+			double pretriggerMS = 
+				std::chrono::duration<double, std::milli>(reqTime - frames[pickIdx].captureTime).count();
+
+			std::stringstream sstrmPretrigger;
+			sstrmPretrigger << std::fixed << std::setprecision(1) << pretriggerMS;
+			std::vector<std::pair<std::string, std::string>> extraContext = 
+				{{"pretrigger_ms", sstrmPretrigger.str()}};
+
+			if(snreq->frameSelect == SnapRequest::FrameSelect::Sharpest)
+				extraContext.push_back({"sharpness", std::to_string(sharpness)});
+
+			snreq->acquisitionEpoch = frames[pickIdx].epoch;
+			if(SaveMatAsDicomBmp(
+				cv::makePtr<cv::Mat>(pick), 
+				this, 
+				snreq->filename, 
+				snreq->qualityLevel, 
+				snreq->acquisitionEpoch, 
+				extraContext,
+				[snreq](bool written){ snreq->_SetWritten(written); }))
+			{
+				snreq->_SetFilled(frameID);
+			}
+			else
+			{
+				snreq->err = "Error attempting to save file.";
+				snreq->status = SnapRequest::Status::Error;
+			}
+		},
+		&this->snapEncodes);
+}
+
+BurstRequest::SPtr IManagedCam::RequestBurst(
+	const std::string& filename,
+	int frameCt,
+	SnapRequest::ProcessType procType,
+	bool average)
+{
+	BurstRequest::SPtr req = BurstRequest::MakeRequest(filename, frameCt, procType, average, multiFrameBursts);
+
+	// The buffers are allocated here, so the stream's thread only has to 
+	// copy into them.
+	bool raw = 
+		procType == SnapRequest::ProcessType::Cannot ||
+		(procType == SnapRequest::ProcessType::Indifferent && !this->UsesImageProcessingChain());
+
+	if(raw)
+		req->Preallocate(cv::Size(this->polledWidth, this->polledHeight), this->polledType);
+	else
+	{
+		cv::Ptr<cv::Mat> cur = this->GetCurrentFrame();
+		if(cur != nullptr && !cur->empty())
+			req->Preallocate(cur->size(), cur->type());
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(this->snapReqsAccess);
+		req->status = BurstRequest::Status::Requested;
+		this->burstReqs.push_back(req);
+		++this->burstCt;
+	}
+	return req;
+}
+
+void IManagedCam::_CaptureBurstFrames(const cv::Mat& frame, bool processedStage, bool processing)
+{
+	for(size_t i = 0; i < this->activeBursts.size(); )
+	{
+		BurstRequest::SPtr burst = this->activeBursts[i];
+
+		// Bursts can be cancelled from outside.
+		if(burst->status == BurstRequest::Status::Error)
+		{
+			this->activeBursts.erase(this->activeBursts.begin() + i);
+			--this->burstCt;
+			continue;
+		}
+
+		// Same rules as snapshots for which stage the frames come from.
+		bool burstProcessed = 
+			burst->processType == SnapRequest::ProcessType::HasTo  || 
+			(burst->processType == SnapRequest::ProcessType::Indifferent && processing);
+
+		if(burstProcessed != processedStage)
+		{
+			++i;
+			continue;
+		}
+
+		if(burst->capturedCt == 0)
+			burst->skippedAtStart = this->GetSkippedFrameCt();
+
+		BurstRequest::FrameMeta meta;
+		meta.captureTime	= this->frameCaptureTime;
+		meta.epoch			= this->acquisitionEpoch;
+		meta.exposureUS		= (int)this->GetParam(StreamParams::ExposureMicroseconds);
+		RawCaptureWriter::GetLightState(meta.laserNIR, meta.laserWhite);
+
+		if(!burst->_AddFrame(frame, meta))
+		{
+			++i;
+			continue;
+		}
+
+		this->_QueueBurstSave(burst);
+		this->activeBursts.erase(this->activeBursts.begin() + i);
+		--this->burstCt;
+	}
+}
+
+void IManagedCam::_QueueBurstSave(BurstRequest::SPtr burst)
+{
+	burst->droppedCt = this->GetSkippedFrameCt() - burst->skippedAtStart;
+
+	std::stringstream sstrmReport;
+	sstrmReport << 
+		"Burst " << burst->filename << " captured " << burst->frames.size() << 
+		" frames at " << std::fixed << std::setprecision(1) << burst->captureFPS << " FPS" <<
+		" (stream target " << this->GetTargetFPS() << " FPS), " << 
+		burst->droppedCt << " skipped by the camera.";
+	std::cout << sstrmReport.str() << std::endl;
+
+	// Recorded now, as the level may change before the encodes run.
+	std::string qualityLevel = to_string(cvgQualityGovernor::GetInstance().GetLevel());
+	int frameCt = (int)burst->frames.size();
+
+	burst->pendingSaves = (burst->multiFrame ? 1 : frameCt) + (burst->average ? 1 : 0);
+	burst->status = BurstRequest::Status::Saving;
+
+	if(burst->multiFrame)
+	{
+		// Written by one task, in order, since the frames are appended to the
+		// same file.
+		cvgTaskPool::GetInstance().Submit(
+			[this, burst, frameCt, qualityLevel]
+			{
+				const cv::Mat& first = burst->frames[0];
+
+				std::vector<std::pair<std::string, std::string>> context = 
+					{{"burst_size", std::to_string(frameCt)}};
+				if(burst->frameMetas[0].epoch >= 0)
+					context.push_back({"acquisition_epoch", std::to_string(burst->frameMetas[0].epoch)});
+
+				MultiFrameDicomWriter writer;
+				bool saved = writer.Open(
+					burst->filename,
+					this,
+					first.size(),
+					first.type(),
+					qualityLevel,
+					context,
+					DicomCompress::GetMethod());
+
+				for(int i = 0; saved && i < frameCt; ++i)
+				{
+					const BurstRequest::FrameMeta& meta = burst->frameMetas[i];
+
+					MultiFrameDicomWriter::FrameInfo info;
+					info.wallUS		= MultiFrameDicomWriter::SteadyToWallUS(meta.captureTime);
+					info.epoch		= meta.epoch;
+					info.exposureUS	= meta.exposureUS;
+					info.laserNIR	= meta.laserNIR;
+					info.laserWhite	= meta.laserWhite;
+					saved = writer.AddFrame(burst->frames[i], info);
+				}
+
+				if(saved)
+					saved = writer.Close();
+
+				if(!saved)
+					std::cout << "Burst " << burst->filename << " failed to save: " << writer.GetError() << std::endl;
+
+				// The multi-frame file is written directly, so it's on disk once
+				// it's closed.
+				burst->_FinishSave(saved, burst->filename + ".dcm");
+			},
+			&this->snapEncodes);
+	}
+
+	for(int i = 0; !burst->multiFrame && i < frameCt; ++i)
+	{
+		cvgTaskPool::GetInstance().Submit(
+			[this, burst, i, frameCt, qualityLevel]
+			{
+				double offsetMS = 
+					std::chrono::duration<double, std::milli>(
+						burst->frameMetas[i].captureTime - burst->frameMetas[0].captureTime).count();
+
+				std::stringstream sstrmOffset;
+				sstrmOffset << std::fixed << std::setprecision(3) << offsetMS;
+
+				this->_SaveBurstFile(
+					burst,
+					burst->frames[i],
+					burst->filename + "_" + std::to_string(i),
+					qualityLevel,
+					burst->frameMetas[i].epoch,
+					{
+						{"burst_index",		std::to_string(i)},
+						{"burst_size",		std::to_string(frameCt)},
+						{"burst_offset_ms",	sstrmOffset.str()}
+					});
+			},
+			&this->snapEncodes);
+	}
+
+	if(burst->average)
+	{
+		cvgTaskPool::GetInstance().Submit(
+			[this, burst, frameCt, qualityLevel]
+			{
+				std::string avgFilename = burst->filename + "_avg";
+				cv::Mat averaged = BurstRequest::AverageFrames(burst->frames);
+				if(averaged.empty())
+				{
+					burst->_FinishSave(false, avgFilename + ".dcm");
+					return;
+				}
+
+				this->_SaveBurstFile(
+					burst,
+					averaged,
+					avgFilename,
+					qualityLevel,
+					burst->frameMetas[0].epoch,
+					{{"burst_average", std::to_string(frameCt)}});
+			},
+			&this->snapEncodes);
+	}
+}
+
+void IManagedCam::_SaveBurstFile(
+	BurstRequest::SPtr burst,
+	const cv::Mat& img,
+	const std::string& baseFilename,
+	const std::string& qualityLevel,
+	long long acquisitionEpoch,
+	const std::vector<std::pair<std::string, std::string>>& extraContext)
+{
+	std::string path = baseFilename + ".dcm";
+
+	// Once the file reaches the CaptureStorage, it reports the write, even
+	// if it fails before SaveMatAsDicomBmp() returns. A file that failed to
+	// encode never got there, so it's finished here instead.
+	std::shared_ptr<std::atomic_bool> reported = std::make_shared<std::atomic_bool>(false);
+	bool queued = SaveMatAsDicomBmp(
+		cv::makePtr<cv::Mat>(img),
+		this,
+		baseFilename,
+		qualityLevel,
+		acquisitionEpoch,
+		extraContext,
+		[burst, reported, path](bool written)
+		{
+			*reported = true;
+			burst->_FinishSave(written, path);
+		});
+
+	if(!queued && !*reported)
+		burst->_FinishSave(false, path);
+}
+
+void IManagedCam::_WaitForSnapshotEncodes()
+{
+	cvgTaskPool::GetInstance().Wait(this->snapEncodes);
+}
+
 bool IManagedCam::_FinalizeHandlingPolledImage(cv::Ptr<cv::Mat> ptr)
 {
 	if(ptr == nullptr)
@@ -341,8 +1029,17 @@ bool IManagedCam::_FinalizeHandlingPolledImage(cv::Ptr<cv::Mat> ptr)
 	{
 		std::lock_guard<std::mutex> guardReqs(this->snapReqsAccess);
 		std::swap(sptrSwap, this->snapReqs);
+
+		// Bursts start with this frame, and continue over the next ones.
+		for(BurstRequest::SPtr burst : this->burstReqs)
+			this->activeBursts.push_back(burst);
+		this->burstReqs.clear();
 	}
 
+	this->polledWidth	= ptr->cols;
+	this->polledHeight	= ptr->rows;
+	this->polledType	= ptr->type();
+
 	//		PROCESS AND CACHE VIDEO
 	// 
 	//////////////////////////////////////////////////
@@ -378,19 +1075,22 @@ bool IManagedCam::_FinalizeHandlingPolledImage(cv::Ptr<cv::Mat> ptr)
 		cv::Ptr<cv::Mat> saveMat = ptr;
 
 		for(SnapRequest::SPtr snreq : rawSnaps)
-		{	
-			SaveMatAsDicom_HandleReq(
-				saveMat, 
-				this, 
-				snreq, 
-				camFeedChanges);
-		}
+			this->_QueueSnapshotEncode(saveMat, snreq);
 	}
 
+	if(!this->activeBursts.empty())
+		this->_CaptureBurstFrames(*ptr, false, processing);
+
+	// Raw captures record the frame as it was polled.
+	cv::Ptr<cv::Mat> polled = ptr;
+
 	ptr = this->ProcessImage(ptr);
 
 	if(ptr)
+	{
 		this->SetCurrentFrame(ptr);
+		this->history.Push(ptr, this->frameCaptureTime, this->acquisitionEpoch, processing);
+	}
 
 	// If a ManagedCam subclass, give the composite system a copy
 	// of the frame.
@@ -400,9 +1100,13 @@ bool IManagedCam::_FinalizeHandlingPolledImage(cv::Ptr<cv::Mat> ptr)
 			this->GetID(), 
 			ptr,
 			this->UsesImageProcessingChain(),
-			this->GetParam(StreamParams::Alpha));
+			this->GetParam(StreamParams::Alpha),
+			this->acquisitionEpoch);
 	}
 
+	if(!this->activeBursts.empty() && ptr)
+		this->_CaptureBurstFrames(*ptr, true, processing);
+
 	// SAVE SNAPSHOTS OF IMAGE PROCESSED
 	//
 	// Everything left in sptrSwap should be things that need to be
@@ -412,13 +1116,7 @@ bool IManagedCam::_FinalizeHandlingPolledImage(cv::Ptr<cv::Mat> ptr)
 		// Attempt to save file and report the success status back to 
 		// the shared pointer.
 		for(SnapRequest::SPtr snreq : sptrSwap)
-		{
-			SaveMatAsDicom_HandleReq(
-				ptr, 
-				this, 
-				snreq,
-				this->camFeedChanges);
-		}
+			this->_QueueSnapshotEncode(ptr, snreq);
 	}
 
 	{
@@ -430,7 +1128,14 @@ bool IManagedCam::_FinalizeHandlingPolledImage(cv::Ptr<cv::Mat> ptr)
 		// error conditions.
 		std::lock_guard<std::mutex> guardVideo(this->videoAccess);
 		if(this->activeVideoReq != nullptr)
-			this->_DumpImageToVideofile(*ptr);
+		{
+			if(this->activeVideoReq->GetFormat() == VideoRequest::Format::Raw)
+				this->_DumpImageToRawfile(polled);
+			else if(this->activeVideoReq->GetSource() == VideoRequest::Source::Unprocessed)
+				this->_DumpImageToVideofile(*polled, this->frameCaptureTime);
+			else
+				this->_DumpImageToVideofile(*ptr, this->frameCaptureTime);
+		}
 	}
 
 	return true;
@@ -456,23 +1161,45 @@ bool IManagedCam::BootupPollingThread(int camIdx)
 				// This thread is expected to run until 
 				// CamStreamMgr::Shutdown() is called at the end
 				// of the app's lifetime.
+				std::string threadRole = 
+					(camIdx == SpecialCams::Composite) ? 
+						"composite" : 
+						"camera_" + std::to_string(camIdx);
+
+				cvgThreadPlacement::GetInstance().ApplyToCurrentThread(threadRole);
 
 				// Flag the command to start the video capturing for the thread
 				this->ThreadFn(camIdx);
+
+				// Queued work on the task pool references the camera.
+				this->_WaitForSnapshotEncodes();
+				this->videoStrand.Drain();
+				this->history.Drain();
+
+				cvgJitterMeter::Stats jitter = this->frameJitter.GetStats();
+				std::cout << "Thread " << threadRole << " frame interval - Mean MS: " << jitter.meanMS << " - Jitter MS: " << jitter.jitterMS << " - Max MS: " << jitter.maxMS << std::endl;
+
+				cvgThreadPlacement::GetInstance().UnregisterCurrentThread();
 				this->_isShutdown = true;
 			});
 
 	return true;
 }
 
-VideoRequest::SPtr IManagedCam::OpenVideo(const std::string& filename)
+VideoRequest::SPtr IManagedCam::OpenVideo(
+	const std::string& filename, 
+	VideoRequest::Format format,
+	VideoRequest::Source source,
+	std::shared_ptr<SessionRecording> session,
+	int sessionStream,
+	int preRollMS)
 {
 	std::lock_guard<std::mutex> guard(this->videoAccess);
 
 	if (filename.empty())
 	{
 		this->_CloseVideo_NoMutex();
-		VideoRequest::SPtr noneRet = VideoRequest::MakeRequest(0, 0, this->GetID(), filename);
+		VideoRequest::SPtr noneRet = VideoRequest::MakeRequest(0, 0, this->GetID(), filename, format);
 		noneRet->err = "Empty filename";
 		noneRet->status = VideoRequest::Status::Error;
 		return noneRet;
@@ -484,6 +1211,9 @@ VideoRequest::SPtr IManagedCam::OpenVideo(const std::string& filename)
 	{
 		if(
 			this->activeVideoReq->filename == filename && 
+			this->activeVideoReq->format == format &&
+			this->activeVideoReq->source == source &&
+			this->activeVideoReq->session.lock() == session &&
 			this->activeVideoReq->status == VideoRequest::Status::StreamingOut)
 		{
 			return this->activeVideoReq;
@@ -494,13 +1224,50 @@ VideoRequest::SPtr IManagedCam::OpenVideo(const std::string& filename)
 
 	// We may have a frame immediately write, but we'll open it
 	// tenatively first.
-	this->activeVideoReq = VideoRequest::MakeRequest(0, 0, this->GetID(), filename);
-	this->activeVideoReq->status = VideoRequest::Status::Requested;
+	this->activeVideoReq = VideoRequest::MakeRequest(0, 0, this->GetID(), filename, format);
+	this->activeVideoReq->source		= source;
+	this->activeVideoReq->session		= session;
+	this->activeVideoReq->sessionStream	= sessionStream;
+	this->activeVideoReq->status		= VideoRequest::Status::Requested;
+
+	// Raw captures only record frames polled after the request, each with 
+	// its own capture time.
+	if(format == VideoRequest::Format::Raw)
+	{
+		if(!this->rawWrite.Open(filename, this->GetID()))
+		{
+			VideoRequest::SPtr errRet = this->activeVideoReq;
+			this->_CloseVideo_NoMutex();
+			errRet->err = "Could not open requested raw capture directory.";
+			errRet->status = VideoRequest::Status::Error;
+			return errRet;
+		}
+		return this->activeVideoReq;
+	}
+
+	// The cached frame is already processed, and session streams only 
+	// record frames from the camera's thread, so they can be paired.
+	if(source == VideoRequest::Source::Processed && session == nullptr)
 	{
+		if(preRollMS > 0)
+		{
+			// Let the frames that are still being stored make it into the 
+			// history.
+			this->history.Drain();
+			std::vector<FrameHistory::Entry> preRoll = 
+				this->history.GetSince(std::chrono::steady_clock::now() - std::chrono::milliseconds(preRollMS));
+
+			if(!preRoll.empty())
+			{
+				this->_DumpHistoryToVideofile(preRoll);
+				return this->activeVideoReq;
+			}
+		}
+
 		// If we have a frame, that will set the size parameters.
 		std::lock_guard<std::mutex> imgGuard(imageAccess);
 		if(!curCamFrame.empty() && !curCamFrame->empty())
-			this->_DumpImageToVideofile(*this->curCamFrame);
+			this->_DumpImageToVideofile(*this->curCamFrame, std::chrono::steady_clock::now());
 	}
 	return this->activeVideoReq;
 }
@@ -532,6 +1299,12 @@ void IManagedCam::ApplySnapshotWatermarkText(
 		0xFF00FF);
 }
 
+IManagedCam::SnapLatencyStats IManagedCam::GetSnapLatency()
+{
+	std::lock_guard<std::mutex> guard(snapLatencyAccess);
+	return snapLatency;
+}
+
 void IManagedCam::InjectIntoDicom(DcmDataset* dicomData)
 {
 	// Do-nothing, see declaration for more details.
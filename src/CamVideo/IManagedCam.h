@@ -5,10 +5,15 @@
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include "SnapRequest.h"
+#include "BurstRequest.h"
 #include "VideoRequest.h"
+#include "RawCaptureWriter.h"
+#include "FrameHistory.h"
 #include "../Utils/VideoPollType.h"
 #include "../Utils/cvgCamFeedSource.h"
 #include "../Utils/cvgGrabTimer.h"
+#include "../Utils/cvgJitterMeter.h"
+#include "../Utils/cvgTaskPool.h"
 
 #include "CamImpl/ICamImpl.h"
 
@@ -16,6 +21,10 @@
 #include <thread>
 #include <memory>
 #include <vector>
+#include <chrono>
+#include <fstream>
+#include <atomic>
+#include <functional>
 
 #include "../DicomUtils/DicomInjector.h"
 #include "StreamParams.h"
@@ -88,6 +97,26 @@ class IManagedCam : public DicomInjector
 	friend class CamStreamMgr;
 
 public:
+	/// <summary>
+	/// How long snapshots took from being requested to being saved. The
+	/// first snapshot is kept apart from the rest, as it's the one that
+	/// pays any one-time costs (see CaptureWarmup).
+	/// </summary>
+	struct SnapLatencyStats
+	{
+		int snapCt = 0;
+		double firstMS = 0.0;
+
+		/// <summary>
+		/// The total and max of every snapshot after the first.
+		/// </summary>
+		double steadyTotalMS = 0.0;
+		double steadyMaxMS = 0.0;
+
+		inline double SteadyAvgMS() const
+		{ return (this->snapCt > 1) ? this->steadyTotalMS / (this->snapCt - 1) : 0.0; }
+	};
+
 	/// <summary>
 	/// The various running states of the manager.
 	/// </summary>
@@ -150,7 +179,7 @@ public:
 	std::vector<SnapRequest::SPtr> snapReqs;
 
 	/// <summary>
-	/// Mutex for thread locking BOTH activeVideoReq and videoWrite.
+	/// Mutex for thread locking activeVideoReq, videoWrite and rawWrite.
 	/// </summary>
 	std::mutex videoAccess;
 
@@ -167,21 +196,147 @@ public:
 	/// <summary>
 	/// The writer for saving the incomming stream as a video file. This should be 
 	/// thread locked with videoAccess before using.
+	/// 
+	/// The exception is writing frames, which is done from videoStrand. The strand
+	/// is drained before the writer is released.
 	/// </summary>
 	cv::VideoWriter videoWrite;
 
+	/// <summary>
+	/// Encodes frames into videoWrite on the task pool, in order, so the
+	/// camera's thread doesn't wait on the video encoder.
+	/// </summary>
+	cvgTaskPool::Strand videoStrand;
+
+	/// <summary>
+	/// The writer for video requests with the Raw format. This should be 
+	/// thread locked with videoAccess before using.
+	/// </summary>
+	RawCaptureWriter rawWrite;
+
+	/// <summary>
+	/// The snapshot DICOM encodes queued on the task pool that haven't
+	/// finished. They read the camera's DICOM data when they run, so they
+	/// need to be waited on before the camera's implementation or options 
+	/// are changed.
+	/// </summary>
+	cvgTaskPool::Group snapEncodes;
+
+	/// <summary>
+	/// The CamSyncGroup acquisition epoch of the frame being handled, or -1
+	/// if it wasn't acquired in sync with other cameras. Set by subclasses 
+	/// before _FinalizeHandlingPolledImage(), and only used by the camera 
+	/// thread.
+	/// </summary>
+	long long acquisitionEpoch = -1;
+
+	/// <summary>
+	/// When the frame being handled was captured. Set by subclasses before
+	/// _FinalizeHandlingPolledImage(), and only used by the camera thread.
+	/// </summary>
+	std::chrono::steady_clock::time_point frameCaptureTime;
+
 	/// <summary>
 	/// Timer for how much time needs to be accounted for in the recorded video. This makes
 	/// sure the video being recorded matches up to real-world time, even if padded frames
-	/// and frame drops occur.
+	/// and frame drops occur. Only used if videoPadded is set.
 	/// </summary>
 	cvgGrabTimer videoGrabTimer;
 
+	/// <summary>
+	/// The timestamps file written alongside videoWrite, with the capture
+	/// time of every frame in the video. Only written to from videoStrand.
+	/// </summary>
+	std::ofstream videoTimestamps;
+
+	/// <summary>
+	/// The capture time of the first frame of the video. Timestamps are
+	/// relative to it.
+	/// </summary>
+	std::chrono::steady_clock::time_point videoStartTime;
+
+	/// <summary>
+	/// The number of frames posted to be written to videoWrite.
+	/// </summary>
+	long long videoFrameCt = 0;
+
+	/// <summary>
+	/// The capture time of the last pre-roll frame written to the video
+	/// from the history. Live frames up to then are already in the video.
+	/// </summary>
+	std::chrono::steady_clock::time_point videoPreRollEnd;
+
+	/// <summary>
+	/// The most frames that can be waiting on videoStrand to be encoded. 
+	/// Past this, frames are dropped instead of making the camera's thread
+	/// (or memory) pay for an encoder that can't keep up.
+	/// </summary>
+	static const int maxVideoBacklog = 30;
+
+	/// <summary>
+	/// The frame rate videoWrite was opened with. The recording keeps
+	/// this timebase, even if the stream's frame rate changes.
+	/// </summary>
+	double videoFPS = 30.0;
+
+	/// <summary>
+	/// If true, videoWrite is padded with duplicate frames to keep a 
+	/// constant frame rate. Cached from padVideoFrames when the video 
+	/// is opened.
+	/// </summary>
+	bool videoPadded = false;
+
+	/// <summary>
+	/// If true, compressed videos are padded with duplicate frames to keep
+	/// a constant frame rate. Else, every frame is written once, and the
+	/// timestamps file records when each was captured.
+	/// </summary>
+	static std::atomic_bool padVideoFrames;
+
+	/// <summary>
+	/// If true, bursts are saved into one multi-frame DICOM file, else a
+	/// DICOM file per frame.
+	/// </summary>
+	static std::atomic_bool multiFrameBursts;
+
+	static std::mutex snapLatencyAccess;
+	static SnapLatencyStats snapLatency;
+
 	/// <summary>
 	/// Mutex to guard single thread access to the snap requests.
 	/// </summary>
 	std::mutex snapReqsAccess;
 
+	/// <summary>
+	/// The stream's recent frames, after image processing, for snapshots 
+	/// and videos that start from before they were requested.
+	/// </summary>
+	FrameHistory history;
+
+	/// <summary>
+	/// Burst requests that haven't started capturing. Guarded by 
+	/// snapReqsAccess.
+	/// </summary>
+	std::vector<BurstRequest::SPtr> burstReqs;
+
+	/// <summary>
+	/// Burst requests that are capturing. Only used by the stream's thread.
+	/// </summary>
+	std::vector<BurstRequest::SPtr> activeBursts;
+
+	/// <summary>
+	/// The number of burst requests that haven't finished capturing.
+	/// </summary>
+	std::atomic_int burstCt = 0;
+
+	/// <summary>
+	/// The size and type of the last frame polled, before image processing,
+	/// to allocate burst buffers for. Negative if unknown.
+	/// </summary>
+	std::atomic_int polledWidth = -1;
+	std::atomic_int polledHeight = -1;
+	std::atomic_int polledType = -1;
+
 	/// <summary>
 	/// Shared pointer of the most recent video frame.
 	/// </summary>
@@ -237,6 +392,12 @@ public:
 	/// </summary>
 	int streamFrameCt = 0;
 
+	/// <summary>
+	/// Measures the regularity of the intervals between processed frames.
+	/// Only used for diagnostic purposes.
+	/// </summary>
+	cvgJitterMeter frameJitter;
+
 	/// <summary>
 	/// The amount to blend in compositing - may only apply to 
 	/// thresholded feeds.
@@ -291,11 +452,101 @@ protected:
 	/// recording process if it detects any request errors or state errors.
 	/// </summary>
 	/// <param name="img">The OpenCV image to add to the video.</param>
+	/// <param name="captureTime">When the image was captured.</param>
 	/// <returns>
 	/// True if the frame was added to the video file successfully, else
 	/// false.
 	/// </returns>
-	bool _DumpImageToVideofile(const cv::Mat& img);
+	bool _DumpImageToVideofile(const cv::Mat& img, std::chrono::steady_clock::time_point captureTime);
+
+	/// <summary>
+	/// Open videoWrite for the active video request.
+	/// 
+	/// Has the same THREAD WARNING as _DumpImageToVideofile().
+	/// </summary>
+	/// <param name="size">The size of the video's frames.</param>
+	/// <param name="isColor">If the video's frames have colors.</param>
+	/// <param name="startTime">The capture time of the video's first frame.</param>
+	/// <returns>True if the video was opened, else the request is closed.</returns>
+	bool _OpenVideoWriter(cv::Size size, bool isColor, std::chrono::steady_clock::time_point startTime);
+
+	/// <summary>
+	/// Start the video being saved with frames from the history.
+	/// 
+	/// Has the same THREAD WARNING as _DumpImageToVideofile(). The frames 
+	/// are restored and encoded on videoStrand. If padding is enabled, 
+	/// they're still only written once each.
+	/// </summary>
+	/// <param name="frames">The frames to write, oldest first.</param>
+	/// <returns>True if the frames were queued to be written.</returns>
+	bool _DumpHistoryToVideofile(const std::vector<FrameHistory::Entry>& frames);
+
+	/// <summary>
+	/// Add another frame to the raw capture being saved.
+	/// 
+	/// Has the same THREAD WARNING as _DumpImageToVideofile(). Unlike 
+	/// compressed videos, frames are written once each, with their capture
+	/// time, instead of being padded to a fixed frame rate.
+	/// </summary>
+	/// <param name="img">
+	/// The frame to add, before image processing. It's referenced until it's
+	/// written, so it must not be modified.
+	/// </param>
+	/// <returns>
+	/// True if the frame was queued to be written, else false.
+	/// </returns>
+	bool _DumpImageToRawfile(cv::Ptr<cv::Mat> img);
+
+	/// <summary>
+	/// Queue a snapshot request to be saved as a DICOM file on the task pool.
+	/// </summary>
+	/// <param name="imgMat">The image to save.</param>
+	/// <param name="snreq">The snapshot request.</param>
+	void _QueueSnapshotEncode(cv::Ptr<cv::Mat> imgMat, SnapRequest::SPtr snreq);
+
+	/// <summary>
+	/// Queue a snapshot request for a frame from before the request, to be
+	/// picked from the history and saved on the task pool.
+	/// </summary>
+	/// <param name="snreq">
+	/// The snapshot request. Its status is set to an error if the history
+	/// has no frames to pick from.
+	/// </param>
+	void _QueueHistorySnapshot(SnapRequest::SPtr snreq);
+
+	/// <summary>
+	/// Copy a frame into the capturing bursts of a processing stage, and 
+	/// queue the bursts that are complete to be saved.
+	/// </summary>
+	/// <param name="frame">The frame to capture.</param>
+	/// <param name="processedStage">
+	/// If true, the frame is after image processing, else before.
+	/// </param>
+	/// <param name="processing">If the stream uses its image processing chain.</param>
+	void _CaptureBurstFrames(const cv::Mat& frame, bool processedStage, bool processing);
+
+	/// <summary>
+	/// Queue the frames of a complete burst to be saved as DICOM files on
+	/// the task pool.
+	/// </summary>
+	void _QueueBurstSave(BurstRequest::SPtr burst);
+
+	/// <summary>
+	/// Save one of a burst's files as a DICOM file, and finish it on the
+	/// burst once it's written behind the caller, or failed.
+	/// </summary>
+	void _SaveBurstFile(
+		BurstRequest::SPtr burst,
+		const cv::Mat& img,
+		const std::string& baseFilename,
+		const std::string& qualityLevel,
+		long long acquisitionEpoch,
+		const std::vector<std::pair<std::string, std::string>>& extraContext);
+
+	/// <summary>
+	/// Wait for all of the camera's queued snapshot encodes to finish.
+	/// </summary>
+	void _WaitForSnapshotEncodes();
 
 	/// <summary>
 	/// Adjust the streaming state to disable streaming.
@@ -382,25 +633,78 @@ public:
 	/// </summary>
 	/// <param name="filename">The filename to save.</param>
 	/// <param name="procType">Selection to save the image processed version or raw version.</param>
+	/// <param name="select">
+	/// Which frame to save. Frames from before the request are taken from
+	/// the history, which only has the frames as they were after image 
+	/// processing.
+	/// </param>
+	/// <param name="lookbackMS">
+	/// How far back to look for the frame, if select isn't FrameSelect::Next.
+	/// </param>
 	/// <returns>
 	/// The request object. This can be kept and observed to view the success
 	/// status when the request is fullfilled.
 	/// </returns>
 	SnapRequest::SPtr RequestSnapshot(
 		const std::string& filename, 
-		SnapRequest::ProcessType procType);
+		SnapRequest::ProcessType procType,
+		SnapRequest::FrameSelect select = SnapRequest::FrameSelect::Next,
+		int lookbackMS = 0);
 
 	/// <summary>
 	/// Clear all currently queued snapshot requests.
 	/// </summary>
 	void ClearSnapshotRequests();
 
+	/// <summary>
+	/// Queue a request to capture the next several frames as a burst. See
+	/// BurstRequest for more information.
+	/// </summary>
+	/// <param name="filename">The base filename to save the frames as.</param>
+	/// <param name="frameCt">The number of consecutive frames to capture.</param>
+	/// <param name="procType">Selection to save the image processed version or raw version.</param>
+	/// <param name="average">If true, an averaged frame is also saved.</param>
+	/// <returns>The request object.</returns>
+	BurstRequest::SPtr RequestBurst(
+		const std::string& filename,
+		int frameCt,
+		SnapRequest::ProcessType procType,
+		bool average);
+
+	/// <summary>
+	/// Query if a burst is being captured. While it is, the stream polls
+	/// as fast as frames are delivered, instead of pacing to its frame rate.
+	/// </summary>
+	inline bool IsBursting() const
+	{ return this->burstCt > 0; }
+
 	/// <summary>
 	/// Request saving the stream to a video.
 	/// </summary>
-	/// <param name="filename">The filename to save the video to.</param>
+	/// <param name="filename">
+	/// The filename to save the video to. For the Raw format, this is the 
+	/// directory of the recording.
+	/// </param>
+	/// <param name="format">How the video is saved.</param>
+	/// <param name="source">Which of the camera's frames are recorded.</param>
+	/// <param name="session">
+	/// The session the video is a stream of, or nullptr if it's recorded
+	/// on its own.
+	/// </param>
+	/// <param name="sessionStream">The index of the video in the session's streams.</param>
+	/// <param name="preRollMS">
+	/// How far back before the request the video starts, using frames from
+	/// the history. Only for compressed videos of processed frames that
+	/// aren't part of a session.
+	/// </param>
 	/// <returns>The VideoRequest representing the request.</returns>
-	VideoRequest::SPtr OpenVideo(const std::string& filename);
+	VideoRequest::SPtr OpenVideo(
+		const std::string& filename, 
+		VideoRequest::Format format = VideoRequest::Format::Compressed,
+		VideoRequest::Source source = VideoRequest::Source::Processed,
+		std::shared_ptr<SessionRecording> session = nullptr,
+		int sessionStream = -1,
+		int preRollMS = 0);
 
 	/// <summary>
 	/// Close the video that's currently being recorded.
@@ -467,6 +771,27 @@ public:
 	/// </summary>
 	virtual bool UsesImageProcessingChain() = 0;
 
+	/// <summary>
+	/// The frame rate the stream is paced and recorded at. Only called
+	/// from the stream's thread.
+	/// </summary>
+	virtual double GetTargetFPS() = 0;
+
+	/// <summary>
+	/// The threshold the image processing chain used for the last processed
+	/// frame, for recording alongside raw frames. Only called from the 
+	/// stream's thread.
+	/// </summary>
+	/// <returns>The threshold, or negative if frames aren't thresholded.</returns>
+	virtual float GetFrameThreshold();
+
+	/// <summary>
+	/// The number of frames the camera delivered but were replaced by a 
+	/// newer frame before they were polled, to check bursts for missing 
+	/// frames. Only called from the stream's thread.
+	/// </summary>
+	virtual long long GetSkippedFrameCt();
+
 public:
 	/// <summary>
 	/// Unified way for how watermark annotations should be applied
@@ -476,6 +801,25 @@ public:
 	/// <param name="text">The watermark text.</param>
 	void ApplySnapshotWatermarkText(cv::Mat& mat, const std::string& text);
 
+	/// <summary>
+	/// Set if compressed videos are padded with duplicate frames to keep
+	/// a constant frame rate. Applies to videos opened afterwards.
+	/// </summary>
+	static void SetVideoFramePadding(bool pad)
+	{ padVideoFrames = pad; }
+
+	/// <summary>
+	/// Set if bursts are saved into one multi-frame DICOM file, or a DICOM
+	/// file per frame. Applies to bursts requested afterwards.
+	/// </summary>
+	static void SetMultiFrameBursts(bool multiFrame)
+	{ multiFrameBursts = multiFrame; }
+
+	/// <summary>
+	/// Get how long snapshots of every camera have taken to be saved.
+	/// </summary>
+	static SnapLatencyStats GetSnapLatency();
+
 public:
 	//////////////////////////////////////////////////
 	//
@@ -529,4 +873,38 @@ public:
 bool InsertAcquisitionContextInfo(
 	DcmDataset* dicomData,
 	const std::string& key, 
-	const std::string& value);
\ No newline at end of file
+	const std::string& value);
+
+/// <summary>
+/// Save an OpenCV mat as a jpeg in a Dicom file.
+/// </summary>
+/// <param name="imgMat">The image to save.</param>
+/// <param name="cam">
+/// The camera containing extra camera Dicom data. May be nullptr if the
+/// image didn't come from a live camera.
+/// </param>
+/// <param name="baseFilename">The filename to save the Dicom file as.</param>
+/// <param name="qualityLevel">
+/// The quality governor's level the image was processed at. Ignored if empty.
+/// </param>
+/// <param name="acquisitionEpoch">
+/// The synchronized acquisition epoch of the image. Ignored if negative.
+/// </param>
+/// <param name="extraContext">
+/// Additional key/value pairs to add to the acquisition context.
+/// </param>
+/// <param name="onWritten">
+/// If not empty, called with whether the file made it to disk, once the
+/// CaptureStorage has written it or failed to. See CaptureStorage::WriteFile().
+/// </param>
+/// <returns>
+/// True if the file was encoded and queued to be written, else false.
+/// </returns>
+bool SaveMatAsDicomBmp(
+	cv::Ptr<cv::Mat> imgMat, 
+	IManagedCam* cam, 
+	const std::string& baseFilename, 
+	const std::string& qualityLevel,
+	long long acquisitionEpoch,
+	const std::vector<std::pair<std::string, std::string>>& extraContext = {},
+	std::function<void(bool)> onWritten = nullptr);
\ No newline at end of file
@@ -0,0 +1,346 @@
+#include "MJPEGCaptureCheck.h"
+#include "CamImpl/CamImpl_OpenCVBase.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace
+{
+	/// <summary>
+	/// The number of frames in the stand-in stream, before it loops.
+	/// </summary>
+	const int streamFrameCt = 8;
+
+	/// <summary>
+	/// The frame of the stand-in stream that doesn't decode.
+	/// </summary>
+	const int corruptFrame = 5;
+
+	/// <summary>
+	/// How long the stand-in stream takes to deliver a frame.
+	/// </summary>
+	const int standInFrameMS = 33;
+
+	const int frameWidth = 320;
+	const int frameHeight = 240;
+
+	/// <summary>
+	/// How far a decoded frame's level may be from what was encoded, for
+	/// JPEG's loss.
+	/// </summary>
+	const double levelTolerance = 4.0;
+
+	/// <summary>
+	/// The level every pixel of a frame of the stand-in stream is.
+	/// </summary>
+	double FrameLevel(int frame)
+	{
+		return 30.0 + 25.0 * (frame % streamFrameCt);
+	}
+
+	/// <summary>
+	/// Find which frame of the stand-in stream a decoded frame is.
+	/// </summary>
+	/// <returns>The frame's index, or -1 if it isn't one of them.</returns>
+	int IdentifyFrame(const cv::Mat& decoded)
+	{
+		if(decoded.cols != frameWidth || decoded.rows != frameHeight || decoded.channels() != 3)
+			return -1;
+
+		double level = cv::mean(decoded)[0];
+		for(int i = 0; i < streamFrameCt; ++i)
+		{
+			if(std::abs(level - FrameLevel(i)) <= levelTolerance)
+				return i;
+		}
+		return -1;
+	}
+
+	/// <summary>
+	/// A VideoCapture that stands in for a camera streaming MJPEG, without
+	/// a backend behind it. Frames are handed back compressed, as a single
+	/// row of bytes.
+	/// </summary>
+	class StandInMJPEGStream : public cv::VideoCapture
+	{
+	private:
+		std::vector<std::vector<unsigned char>> encoded;
+
+		/// <summary>
+		/// The index of the frame that was last grabbed.
+		/// </summary>
+		int grabbedIdx = -1;
+
+	public:
+		StandInMJPEGStream()
+		{
+			for(int i = 0; i < streamFrameCt; ++i)
+			{
+				std::vector<unsigned char> bytes;
+				if(i == corruptFrame)
+				{
+					const std::string notJPEG = "Not a JPEG frame.";
+					bytes.assign(notJPEG.begin(), notJPEG.end());
+				}
+				else
+				{
+					cv::Mat frame(frameHeight, frameWidth, CV_8UC3, cv::Scalar::all(FrameLevel(i)));
+					cv::imencode(".jpg", frame, bytes);
+				}
+				this->encoded.push_back(bytes);
+			}
+		}
+
+		/// <summary>
+		/// The index of the frame that was last grabbed, in the stream,
+		/// counting past where the stream loops.
+		/// </summary>
+		int GrabbedIndex() const
+		{ return this->grabbedIdx; }
+
+		bool grab() override
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(standInFrameMS));
+			++this->grabbedIdx;
+			return true;
+		}
+
+		bool retrieve(cv::OutputArray image, int flag = 0) override
+		{
+			if(this->grabbedIdx < 0)
+				return false;
+
+			std::vector<unsigned char>& bytes = this->encoded[this->grabbedIdx % streamFrameCt];
+			cv::Mat(1, (int)bytes.size(), CV_8UC1, bytes.data()).copyTo(image);
+			return true;
+		}
+
+		bool set(int propId, double value) override
+		{
+			return true;
+		}
+
+		double get(int propId) const override
+		{
+			switch(propId)
+			{
+			case cv::CAP_PROP_FOURCC:
+				return cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+
+			case cv::CAP_PROP_FRAME_WIDTH:
+				return frameWidth;
+
+			case cv::CAP_PROP_FRAME_HEIGHT:
+				return frameHeight;
+
+			case cv::CAP_PROP_FPS:
+				return 1000.0 / standInFrameMS;
+			}
+			return 0.0;
+		}
+	};
+
+	class StandInMJPEGCam : public CamImpl_OpenCVBase
+	{
+	public:
+		/// <summary>
+		/// The stream while the camera is active, owned by the camera.
+		/// </summary>
+		StandInMJPEGStream* stream = nullptr;
+
+	protected:
+		cv::VideoCapture* CreateVideoCapture() override
+		{
+			this->stream = new StandInMJPEGStream();
+			return this->stream;
+		}
+
+	public:
+		VideoPollType PollType() override
+		{ return VideoPollType::OpenCVUSB_Idx; }
+	};
+
+	bool Report(std::ostream& os, const std::string& name, bool passed, const std::string& detail)
+	{
+		os << "\t" << name << ": " << (passed ? "PASSED" : "FAILED") << " - " << detail << std::endl;
+		return passed;
+	}
+
+	std::string FrameName(int frame)
+	{
+		return frame < 0 ? std::string("none") : std::to_string(frame);
+	}
+
+	bool CheckFrames(std::ostream& os)
+	{
+		StandInMJPEGCam cam;
+		ICamImpl& impl = cam;
+
+		cvgCamFeedLocs opts;
+		opts.lowLatencyGrab = false;
+		impl.PullOptions(opts);
+
+		if(!impl.Initialize() || !impl.Activate())
+		{
+			os << "Could not activate the stand-in camera." << std::endl;
+			return false;
+		}
+
+		bool allPassed = true;
+
+		CaptureMode mode = cam.GetActiveMode();
+		allPassed &= Report(os, "Compressed mode", mode.IsCompressed(), "Mode: " + mode.ToString());
+
+		cv::Ptr<cv::Mat> first = impl.PollFrame();
+		allPassed &= Report(os, "Pipelined first poll", first == nullptr, std::string("Frame: ") + (first == nullptr ? "none" : "returned"));
+
+		// Poll k submits frame k, and returns frame k - 1, except after the
+		// corrupt frame, where there's nothing to return. The frame identified
+		// from each poll is kept by the poll's index.
+		std::vector<int> got(streamFrameCt + 1, -1);
+		bool inOrder = true;
+		std::string polled;
+		for(int k = 1; k <= streamFrameCt; ++k)
+		{
+			cv::Ptr<cv::Mat> frame = impl.PollFrame();
+			got[k] = (frame == nullptr) ? -1 : IdentifyFrame(*frame);
+
+			if(k - 1 != corruptFrame)
+				inOrder &= (got[k] == k - 1);
+
+			polled += (polled.empty() ? "" : ",") + FrameName(got[k]);
+		}
+		allPassed &= Report(os, "Pipelined frames", inOrder, "Polled: " + polled);
+
+		// Nothing is returned for the corrupt frame, and the frame after it
+		// still arrives on the poll after.
+		int corruptPoll = corruptFrame + 1;
+		allPassed &= Report(
+			os,
+			"Corrupt frame skipped",
+			got[corruptPoll] == -1 && got[corruptPoll + 1] == corruptFrame + 1,
+			"Poll " + std::to_string(corruptPoll) + ": " + FrameName(got[corruptPoll]) + 
+			", poll " + std::to_string(corruptPoll + 1) + ": " + FrameName(got[corruptPoll + 1]));
+
+		bool splitMatched = true;
+		std::string split;
+		for(int i = 0; i < 3; ++i)
+		{
+			if(!impl.SupportsSplitGrab() || !impl.GrabFrame())
+			{
+				splitMatched = false;
+				break;
+			}
+
+			int grabbed = cam.stream->GrabbedIndex() % streamFrameCt;
+			cv::Ptr<cv::Mat> frame = impl.RetrieveFrame();
+			int retrieved = (frame == nullptr) ? -1 : IdentifyFrame(*frame);
+
+			// The stream may loop around to the corrupt frame.
+			int expected = (grabbed == corruptFrame) ? -1 : grabbed;
+			splitMatched &= (retrieved == expected);
+			split += (split.empty() ? "" : ",") + FrameName(grabbed) + "->" + FrameName(retrieved);
+		}
+		allPassed &= Report(os, "Split grab decodes immediately", splitMatched, "Grabbed->Retrieved: " + split);
+
+		impl.Deactivate();
+		cam.stream = nullptr;
+		impl.Shutdown();
+
+		return allPassed;
+	}
+
+	CaptureMode MakeMode(int fourcc, int width, int height, double fps)
+	{
+		CaptureMode ret;
+		ret.fourcc	= fourcc;
+		ret.width	= width;
+		ret.height	= height;
+		ret.fps		= fps;
+		return ret;
+	}
+
+	bool CheckChoose(
+		std::ostream& os,
+		const std::string& name,
+		const std::vector<CaptureMode>& modes,
+		CaptureFormat format,
+		int width,
+		int height,
+		double fps,
+		bool expectFound,
+		const CaptureMode& expected)
+	{
+		std::vector<int> fourccs = CaptureModeNegotiator::CandidateFourCCs(format);
+
+		CaptureMode chosen;
+		bool found = CaptureModeNegotiator::Choose(modes, fourccs, width, height, fps, chosen);
+
+		bool passed = (found == expectFound);
+		if(passed && found)
+		{
+			passed =
+				chosen.fourcc == expected.fourcc &&
+				chosen.width == expected.width &&
+				chosen.height == expected.height &&
+				chosen.fps == expected.fps;
+		}
+
+		return Report(
+			os,
+			name,
+			passed,
+			"Chose: " + (found ? chosen.ToString() : std::string("none")) +
+			", expected: " + (expectFound ? expected.ToString() : std::string("none")));
+	}
+
+	bool CheckModes(std::ostream& os)
+	{
+		const int yuyv = cv::VideoWriter::fourcc('Y', 'U', 'Y', 'V');
+		const int mjpg = cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+		const int h264 = cv::VideoWriter::fourcc('H', '2', '6', '4');
+
+		// Like most USB cameras, YUYV is limited by the USB bandwidth at the
+		// higher resolutions, while MJPEG reaches full rate at all of them.
+		std::vector<CaptureMode> modes =
+		{
+			MakeMode(yuyv, 640,		480,	30.0),
+			MakeMode(yuyv, 1280,	720,	10.0),
+			MakeMode(yuyv, 1920,	1080,	5.0),
+			MakeMode(mjpg, 640,		480,	30.0),
+			MakeMode(mjpg, 1280,	720,	30.0),
+			MakeMode(mjpg, 1920,	1080,	30.0)
+		};
+
+		bool allPassed = true;
+		allPassed &= CheckChoose(os, "Mode uncompressed at full rate",	modes, CaptureFormat::BGR,	640,	480,	30.0, true, modes[0]);
+		allPassed &= CheckChoose(os, "Mode uncompressed at low rate",	modes, CaptureFormat::BGR,	1280,	720,	10.0, true, modes[1]);
+		allPassed &= CheckChoose(os, "Mode MJPEG for full rate",		modes, CaptureFormat::BGR,	1920,	1080,	30.0, true, modes[5]);
+		allPassed &= CheckChoose(os, "Mode MJPEG for greyscale",		modes, CaptureFormat::Grey,	1280,	720,	30.0, true, modes[4]);
+		allPassed &= CheckChoose(os, "Mode covering unlisted size",		modes, CaptureFormat::BGR,	1024,	768,	30.0, true, modes[5]);
+		allPassed &= CheckChoose(os, "Mode for any size",				modes, CaptureFormat::BGR,	0,		0,		30.0, true, modes[5]);
+		allPassed &= CheckChoose(os, "Mode closest to oversize",		modes, CaptureFormat::BGR,	3840,	2160,	30.0, true, modes[5]);
+		allPassed &= CheckChoose(os, "Mode fastest when none can reach", modes, CaptureFormat::BGR,	1920,	1080,	60.0, true, modes[5]);
+
+		std::vector<CaptureMode> unusable = { MakeMode(h264, 1920, 1080, 30.0) };
+		allPassed &= CheckChoose(os, "Mode with no usable formats",		unusable, CaptureFormat::BGR, 1920, 1080, 30.0, false, CaptureMode());
+
+		return allPassed;
+	}
+}
+
+bool MJPEGCaptureCheck::Run(std::ostream& os)
+{
+	os << "MJPEG capture check:" << std::endl;
+
+	bool allPassed = true;
+	allPassed &= CheckFrames(os);
+	allPassed &= CheckModes(os);
+
+	os << (allPassed ? "Every frame and mode was as expected." : "Some frames or modes were not as expected.") << std::endl;
+	return allPassed;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <ostream>
+
+/// <summary>
+/// A scripted check of MJPEG capture (see MJPEGDecodeWorker and
+/// CaptureModeNegotiator), without a camera.
+///
+/// A stand-in stream reports the MJPG pixel format and hands back a
+/// synthesized MJPEG byte stream - a JPEG per frame, each a different
+/// level, with one corrupt frame - the way FFmpeg and V4L2 do when they
+/// aren't converting frames. Polled through the camera implementation:
+/// - The first poll returns nothing, as decoding is pipelined one deep.
+/// - Every poll after returns the frame before it, decoded, in order.
+/// - The corrupt frame is skipped, without holding up the frames after.
+/// - A split grab decodes the grabbed frame immediately.
+///
+/// Then CaptureModeNegotiator::Choose() is checked against the mode list of
+/// a typical USB camera, whose higher resolutions only reach full rate
+/// with MJPEG.
+///
+/// Run with the --check-mjpeg-capture command line option.
+/// </summary>
+class MJPEGCaptureCheck
+{
+public:
+	/// <summary>
+	/// Run the check and print the results.
+	/// </summary>
+	/// <param name="os">The stream to print the results to.</param>
+	/// <returns>True if every frame and mode was as expected.</returns>
+	static bool Run(std::ostream& os);
+};
@@ -8,9 +8,15 @@
 #include "CamImpl/CamImpl_OCV_Web.h"
 #include "CamImpl/CamImpl_OCV_HWPath.h"
 #include "CamImpl/CamImpl_StaticImg.h"
+#include "CamImpl/CamImpl_Pipe.h"
+#include "CamImpl/CamImpl_Replay.h"
+#include "CamImpl/CamImpl_FaultInject.h"
 #include <iostream>
 #include "../Utils/cvgAssert.h"
 #include "../Utils/yen_threshold.h"
+#include "../Utils/cvgQualityGovernor.h"
+#include "ROIRect.h"
+#include "CamSyncGroup.h"
 
 
 #if !_WIN32
@@ -50,11 +56,26 @@ void ManagedCam::ThreadFn(int camIdx)
 {
 	this->_isStreamActive = false;
 
+	// The delay before the next connection attempt. This starts short so 
+	// a momentary hiccup is recovered from quickly, and doubles for each 
+	// failed attempt.
+	int backoffMS = reconnectBackoffMinMS;
+
+	// Set when the polling loop deactivated the implementation because the
+	// stream was lost. Some implementations (a static image) stay valid
+	// while deactivated, so validity can't tell us it needs reactivating.
+	bool needsReactivate = false;
+
 	// This will be the loop for the thread for the lifetime of the app
 	// once booted. This should NOT be confused with the polling loop
 	// of the camera, which will be an inner loop.
 	while(this->_sentShutdown == false)
 	{
+		// Options reloaded while nothing is streaming can just be 
+		// adopted before (re)connecting.
+		if(this->currentImpl == nullptr)
+			this->_ApplyPendingOptions();
+
 		// Local copy in case a thread somehow changes this->pollType;
 		VideoPollType pollTy = this->pollType;
 
@@ -68,13 +89,38 @@ void ManagedCam::ThreadFn(int camIdx)
 		if(pollTy != VideoPollType::Deactivated)
 		{ 
 			this->conState = State::Connecting;
+
+			if(this->frameStale)
+			{
+				std::lock_guard<std::mutex> guard(this->reconnectStatsMutex);
+				++this->reconnectStats.attemptCt;
+			}
+
+			// If the stream was lost, try to bring the existing implementation
+			// back before building a new one.
+			if(this->currentImpl != nullptr && (needsReactivate || !this->currentImpl->IsValid()))
+				needsReactivate = !this->_WarmRestartImplementation();
+
+			// An implementation that was given up on is rebuilt, and activated,
+			// from scratch.
+			if(this->currentImpl == nullptr)
+				needsReactivate = false;
+
 			this->SwitchImplementation(pollTy);
 		}
 		else
 			this->conState = State::Idling;
 
+		// If the options were reloaded with a change that couldn't be
+		// applied live, this is set to reconnect the implementation.
+		bool reconnect = false;
+
+		// If the stream ended without being asked to - the implementation
+		// became invalid or stopped delivering frames.
+		bool lostStream = false;
+
 		// If we have a camera implementation, start it up.
-		if(this->currentImpl != nullptr && this->currentImpl->IsValid())
+		if(this->currentImpl != nullptr && this->currentImpl->IsValid() && !needsReactivate)
 		{
 			this->streamWidth = -1;
 			this->streamHeight = -1;
@@ -82,6 +128,10 @@ void ManagedCam::ThreadFn(int camIdx)
 			cvgStopwatch swFPS;
 			cvgStopwatchLeft swLoopSleep;
 
+			// Time since the last frame, to detect stalls.
+			cvgStopwatch swStall;
+			bool gotFrame = false;
+
 			this->streamFrameCt = 0;
 
 			while( // Polling loop
@@ -91,11 +141,32 @@ void ManagedCam::ThreadFn(int camIdx)
 			{
 				this->conState = State::Polling;
 
+				if(this->_ApplyPendingOptions())
+				{
+					reconnect = true;
+					break;
+				}
+
 				// Poll the current frame from OpenCV.
-				cv::Ptr<cv::Mat> frame = this->currentImpl->PollFrame();
+				cv::Ptr<cv::Mat> frame = this->_PollFrame();
 
 				if(frame != nullptr && !frame.empty())
 				{
+					this->_RecordFrameAge(!gotFrame);
+
+					if(!gotFrame)
+					{
+						gotFrame = true;
+						backoffMS = reconnectBackoffMinMS;
+
+						// Only measure the intervals within a stream, not the
+						// time it took to (re)connect.
+						this->frameJitter.Reset();
+						this->warmRestartFailCt = 0;
+						this->_EndOutage();
+					}
+					swStall.Restart();
+
 					// First frame we take the dimension and assume the video size is constant.
 					// We could also put in a mechanism (into ICamImpl) to give us a frame size
 					// right after activation, but that currently doesn't exist.
@@ -108,40 +179,91 @@ void ManagedCam::ThreadFn(int camIdx)
 					// Pass it through to the image pipeline, and then 
 					// transfer it to the last frame cache to stage it for
 					// other threads (the main GUI thread) to access.
+					cvgStopwatch swStage;
 					_FinalizeHandlingPolledImage(frame);
+					cvgQualityGovernor::GetInstance().ReportStage(
+						"camera_" + std::to_string(this->cameraId), 
+						(double)swStage.Microseconds() / 1000.0);
 
 					++this->streamFrameCt;
 					this->msInterval = swFPS.Milliseconds();
+					this->frameJitter.Tick();
 
 					// The max is to accomodate if we get a 0. On RPi/Linux, input can start 
 					// breaking if the thread doesn't have a moment to breathe.
-					int msLeft = std::max(swLoopSleep.MSLeft33(), 2);
-					MSSleep(msLeft);
+					//
+					// Self paced implementations already waited for the frame to be due.
+					//
+					// While a burst is capturing, frames are polled as fast as they're
+					// delivered, so none are replaced before they're polled.
+					if(!this->currentImpl->IsSelfPaced())
+					{
+						int msLeft = 2;
+						if(!this->IsBursting())
+							msLeft = std::max(swLoopSleep.MSLeftForFPS(this->camOptions.streamFPS), 2);
+
+						MSSleep(msLeft);
+					}
 				}
 				else
 				{
+					// A device that's still "valid" but has stopped delivering
+					// frames needs to be reconnected just as much as one that
+					// reports being invalid.
+					if(swStall.Milliseconds(false) >= this->_StallTimeoutMS(!gotFrame))
+					{
+						std::cout << "Camera " << this->cameraId << " stalled, no frames for " << this->_StallTimeoutMS(!gotFrame) << "ms." << std::endl;
+						lostStream = true;
+						break;
+					}
+
 					// Some implementations block, others don't. For the non-blocking stream
 					// we have to make sure not to count them - and we'll give them some breathing
-					// room before we poll for a frame again.
-					MSSleep(10);
+					// room before we poll for a frame again. Less while bursting, so the 
+					// next frame isn't replaced before it's polled.
+					MSSleep(this->IsBursting() ? 1 : 10);
 				}
 			}
-			this->currentImpl->Deactivate();
-			this->_DeactivateStreamState();
+
+			// Don't hold the rest of the group up while we're not polling.
+			this->_LeaveSyncGroup();
+
+			if(!reconnect && !this->_sentShutdown && !this->currentImpl->IsValid())
+				lostStream = true;
+
+			if(reconnect)
+			{
+				// Delete the implementation (but keep the poll type) so the
+				// next loop will create a new one with the new options.
+				this->_ClearImplementation(true, false);
+			}
+			else
+			{
+				this->currentImpl->Deactivate();
+				needsReactivate = lostStream;
+			}
+
+			if(lostStream)
+			{
+				// Keep the last frame, and any recording, around while we 
+				// reconnect. The recording will pick up when the camera does.
+				this->_BeginOutage();
+				this->msInterval = 0;
+			}
+			else
+				this->_DeactivateStreamState();
 		}
 
 		// Are we just idling?
-		if(pollTy != VideoPollType::Deactivated)
+		if(pollTy != VideoPollType::Deactivated && !reconnect)
 		{
-			// If no active polling method is selected, we 
-			// wait a bit and recheck the polling method again 
-			// in a short while.
-			//
-			// The wait time is a balance between lowering computational
-			// overhead for just idling, and providing the user with
-			// an immediate response once a change happens.
+			// Wait a bit before the next connection attempt. The wait is
+			// short after a stream was just lost, and backs off while the
+			// camera stays unavailable, to balance recovering quickly against
+			// the overhead of constantly reconnecting to a missing device.
 			this->conState = State::Idling;
-			MSSleep(500);
+			MSSleep(backoffMS);
+			backoffMS = std::min(backoffMS * 2, reconnectBackoffMaxMS);
 		}
 	}
 
@@ -151,6 +273,275 @@ void ManagedCam::ThreadFn(int camIdx)
 }
 
 
+void ManagedCam::_BeginOutage()
+{
+	this->frameStale = true;
+
+	std::lock_guard<std::mutex> guard(this->reconnectStatsMutex);
+	if(this->reconnectStats.inOutage)
+		return;
+
+	std::cout << "Camera " << this->cameraId << " lost its stream, reconnecting." << std::endl;
+	this->reconnectStats.inOutage = true;
+	this->swOutage.Restart();
+}
+
+void ManagedCam::_EndOutage()
+{
+	this->frameStale = false;
+
+	std::lock_guard<std::mutex> guard(this->reconnectStatsMutex);
+	if(!this->reconnectStats.inOutage)
+		return;
+
+	int outageMS = this->swOutage.Milliseconds(false);
+
+	ReconnectStats& rs = this->reconnectStats;
+	rs.inOutage			= false;
+	rs.curOutageMS		= 0;
+	rs.lastOutageMS		= outageMS;
+	rs.longestOutageMS	= std::max(rs.longestOutageMS, outageMS);
+	rs.totalOutageMS	+= outageMS;
+	++rs.reconnectCt;
+
+	std::cout << "Camera " << this->cameraId << " reconnected after " << outageMS << "ms." << std::endl;
+}
+
+bool ManagedCam::_WarmRestartImplementation()
+{
+	if(this->currentImpl == nullptr)
+		return false;
+
+	// Everything from Initialize() and PullOptions() is kept, only
+	// the connection to the device is reopened.
+	this->currentImpl->Deactivate();
+	if(this->currentImpl->Activate() && this->currentImpl->IsValid())
+	{
+		this->warmRestartFailCt = 0;
+
+		std::lock_guard<std::mutex> guard(this->reconnectStatsMutex);
+		++this->reconnectStats.warmRestartCt;
+		return true;
+	}
+
+	++this->warmRestartFailCt;
+	if(this->warmRestartFailCt >= warmRestartAttempts)
+	{
+		// The implementation may be in a bad state, so give up on it.
+		// The poll type is kept so it will be rebuilt from scratch.
+		std::cout << "Camera " << this->cameraId << " could not be reactivated, rebuilding its implementation." << std::endl;
+		this->warmRestartFailCt = 0;
+		this->_ClearImplementation(true, false);
+	}
+	return false;
+}
+
+int ManagedCam::_StallTimeoutMS(bool firstFrame) const
+{
+	int ret = firstFrame ? firstFrameTimeoutMS : stallTimeoutMS;
+
+	// Long exposures legitimately have long gaps between frames.
+	int exposureMS = this->camOptions.videoExposureTime / 1000;
+	return std::max(ret, exposureMS * 3);
+}
+
+cv::Ptr<cv::Mat> ManagedCam::_PollFrame()
+{
+	CamSyncGroup& syncGroup = CamSyncGroup::GetInstance();
+	if(!syncGroup.IsEnabled() || !this->currentImpl->SupportsSplitGrab())
+	{
+		this->_LeaveSyncGroup();
+		this->acquisitionEpoch = -1;
+		return this->currentImpl->PollFrame();
+	}
+
+	if(!this->inSyncGroup)
+	{
+		syncGroup.Join(this->cameraId);
+		this->inSyncGroup = true;
+	}
+
+	// Only the grab is synchronized. Retrieving and decoding can take a
+	// while, and doesn't affect when the frame was captured.
+	long long epoch = syncGroup.ArriveAndWait(this->cameraId, syncTimeoutMS);
+	if(!this->currentImpl->GrabFrame())
+	{
+		this->acquisitionEpoch = -1;
+		return nullptr;
+	}
+
+	if(epoch >= 0)
+		syncGroup.ReportGrab(epoch, this->currentImpl->GetLastGrabTimeMS());
+
+	this->acquisitionEpoch = epoch;
+	return this->currentImpl->RetrieveFrame();
+}
+
+void ManagedCam::_LeaveSyncGroup()
+{
+	if(!this->inSyncGroup)
+		return;
+
+	CamSyncGroup::GetInstance().Leave(this->cameraId);
+	this->inSyncGroup = false;
+}
+
+void ManagedCam::_RecordFrameAge(bool firstFrame)
+{
+	double ageMS = this->currentImpl->GetLastFrameAgeMS();
+	long long skippedCt = this->currentImpl->GetSkippedFrameCt();
+
+	this->frameCaptureTime = std::chrono::steady_clock::now();
+	if(ageMS > 0.0)
+	{
+		this->frameCaptureTime -= 
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<double, std::milli>(ageMS));
+	}
+
+	std::lock_guard<std::mutex> guard(this->frameAgeMutex);
+	if(firstFrame)
+		this->frameAgeStats = FrameAgeStats();
+
+	this->frameAgeStats.skippedCt = skippedCt;
+	if(ageMS < 0.0)
+		return;
+
+	if(!this->frameAgeStats.measured)
+	{
+		this->frameAgeStats.measured = true;
+		this->frameAgeStats.avgMS = ageMS;
+	}
+	else
+		this->frameAgeStats.avgMS += (ageMS - this->frameAgeStats.avgMS) * 0.1;
+
+	this->frameAgeStats.lastMS = ageMS;
+	this->frameAgeStats.maxMS = std::max(this->frameAgeStats.maxMS, ageMS);
+}
+
+ManagedCam::FrameAgeStats ManagedCam::GetFrameAgeStats()
+{
+	std::lock_guard<std::mutex> guard(this->frameAgeMutex);
+	return this->frameAgeStats;
+}
+
+ManagedCam::ReconnectStats ManagedCam::GetReconnectStats()
+{
+	std::lock_guard<std::mutex> guard(this->reconnectStatsMutex);
+	ReconnectStats ret = this->reconnectStats;
+	if(ret.inOutage)
+		ret.curOutageMS = this->swOutage.Milliseconds(false);
+
+	return ret;
+}
+
+void ManagedCam::QueueOptionsReload(const cvgCamFeedSource& newOpts)
+{
+	std::lock_guard<std::mutex> guard(this->pendingOptionsMutex);
+	this->pendingOptions = newOpts;
+}
+
+// Utility to compare optional gain values, since the gain structs
+// don't define equality.
+static bool GainsEqual(const std::optional<CameraGain>& a, const std::optional<CameraGain>& b)
+{
+	if(a.has_value() != b.has_value())
+		return false;
+
+	return 
+		!a.has_value() ||
+		(a->analogGain == b->analogGain && a->digitalGain == b->digitalGain);
+}
+
+static bool GainsEqual(const std::optional<WhiteBalanceGain>& a, const std::optional<WhiteBalanceGain>& b)
+{
+	if(a.has_value() != b.has_value())
+		return false;
+
+	return 
+		!a.has_value() ||
+		(a->redGain == b->redGain && a->blueGain == b->blueGain);
+}
+
+bool ManagedCam::_ApplyPendingOptions()
+{
+	std::optional<cvgCamFeedSource> reloaded;
+	{
+		std::lock_guard<std::mutex> guard(this->pendingOptionsMutex);
+		reloaded.swap(this->pendingOptions);
+	}
+
+	if(!reloaded.has_value())
+		return false;
+
+	const cvgCamFeedSource& next = reloaded.value();
+	cvgCamFeedSource prev;
+
+	// Options that only matter to the ManagedCam (processing, threshold,
+	// menu target) are used straight from camOptions, so they take effect
+	// with this assignment. The UI thread and queued snapshot encodes read
+	// camOptions, so it's replaced with the lock held.
+	{
+		std::lock_guard<std::mutex> guard(this->camOptionsMutex);
+		prev = this->camOptions;
+		this->camOptions = next;
+	}
+
+	if(this->currentImpl == nullptr || !prev.SameDeviceAs(next))
+	{
+		std::cout << "Camera " << this->cameraId << " device changed from options reload, reconnecting." << std::endl;
+		this->pollType = next.GetUsedPoll();
+		return true;
+	}
+
+	bool needsReconnect = false;
+	auto applyLive = 
+		[this, &needsReconnect](bool changed, StreamParams paramid, double value)
+		{
+			if(!changed)
+				return;
+
+			if(!this->currentImpl->SetParam(paramid, value))
+				needsReconnect = true;
+		};
+
+	applyLive(prev.flipHorizontal		!= next.flipHorizontal,		StreamParams::FlipHorizontal,		next.flipHorizontal ? 1.0 : 0.0);
+	applyLive(prev.flipVertical			!= next.flipVertical,		StreamParams::FlipVertical,			next.flipVertical ? 1.0 : 0.0);
+	applyLive(prev.videoExposureTime	!= next.videoExposureTime,	StreamParams::ExposureMicroseconds,	next.videoExposureTime);
+	applyLive(prev.streamWidth			!= next.streamWidth,		StreamParams::StreamWidth,			next.streamWidth);
+	applyLive(prev.streamHeight			!= next.streamHeight,		StreamParams::StreamHeight,			next.streamHeight);
+	applyLive(prev.streamFPS			!= next.streamFPS,			StreamParams::StreamFPS,			next.streamFPS);
+
+	if(!GainsEqual(prev.cameraGain, next.cameraGain))
+	{
+		applyLive(true, StreamParams::AnalogGain,	next.cameraGain.has_value() ? next.cameraGain->analogGain	: 0.0);
+		applyLive(true, StreamParams::DigitalGain,	next.cameraGain.has_value() ? next.cameraGain->digitalGain	: 0.0);
+	}
+
+	if(!GainsEqual(prev.whitebalanceGain, next.whitebalanceGain))
+	{
+		applyLive(true, StreamParams::WhiteBalanceRed,	next.whitebalanceGain.has_value() ? next.whitebalanceGain->redGain	: 0.0);
+		applyLive(true, StreamParams::WhiteBalanceBlue,	next.whitebalanceGain.has_value() ? next.whitebalanceGain->blueGain : 0.0);
+	}
+
+	if(needsReconnect)
+	{
+		std::cout << "Camera " << this->cameraId << " could not apply reloaded options live, reconnecting." << std::endl;
+		return true;
+	}
+
+	// If the stream was resized in place, let the next frame
+	// redefine the stream dimensions.
+	if(prev.streamWidth != next.streamWidth || prev.streamHeight != next.streamHeight)
+	{
+		this->streamWidth = -1;
+		this->streamHeight = -1;
+	}
+
+	std::cout << "Camera " << this->cameraId << " applied reloaded options without reconnecting." << std::endl;
+	return false;
+}
+
 bool ManagedCam::SwitchImplementation(VideoPollType newImplType, bool delCurrent)
 {
 	//
@@ -203,6 +594,16 @@ bool ManagedCam::SwitchImplementation(VideoPollType newImplType, bool delCurrent
 		this->currentImpl = new CamImpl_StaticImg("");
 		break;
 
+	case VideoPollType::External:
+		std::cout << "External " << std::endl;
+		this->currentImpl = new CamImpl_Pipe("");
+		break;
+
+	case VideoPollType::Replay:
+		std::cout << "Replay " << std::endl;
+		this->currentImpl = new CamImpl_Replay("");
+		break;
+
 #if IS_RPI
 	case VideoPollType::MMAL:
 		this->currentImpl = new CamImpl_MMAL(0);
@@ -210,6 +611,15 @@ bool ManagedCam::SwitchImplementation(VideoPollType newImplType, bool delCurrent
 #endif
 	}
 
+	if(this->camOptions.faultInjection.has_value())
+	{
+		std::cout << "Injecting faults into camera " << this->cameraId << std::endl;
+		this->currentImpl = 
+			new CamImpl_FaultInject(
+				this->currentImpl, 
+				this->camOptions.faultInjection.value());
+	}
+
 	//
 	//		BOOT UP IMPLEMENTATION
 	//////////////////////////////////////////////////
@@ -224,6 +634,9 @@ bool ManagedCam::SwitchImplementation(VideoPollType newImplType, bool delCurrent
 	{
 		delete this->currentImpl;
 		this->currentImpl = nullptr;
+
+		this->pollType = newImplType;
+		return false;
 	}
 
 	this->currentImpl->PullOptions(this->camOptions);
@@ -247,21 +660,27 @@ cv::Ptr<cv::Mat> ManagedCam::ImgProc_Simple(cv::Ptr<cv::Mat> src, double thresho
 	if (src->elemSize() != 1)
 	{
 		cv::cvtColor(*src, *grey, cv::COLOR_RGBA2GRAY, 0);
+
+		cv::threshold(
+			*grey,
+			*grey,
+			threshold,
+			255,
+			cv::THRESH_BINARY);
 	}
 	else 
 	{ 
-		// We can't use this directly, because they're going to be edited
-		// as separate images outside this function.
-		src->copyTo(*grey);
+		// We can't threshold the source in place, because they're going to
+		// be edited as separate images outside this function. But there's no
+		// need to copy it first either, threshold straight into the output.
+		cv::threshold(
+			*src,
+			*grey,
+			threshold,
+			255,
+			cv::THRESH_BINARY);
 	}
 
-	cv::threshold(
-		*grey,
-		*grey,
-		threshold,
-		255,
-		cv::THRESH_BINARY);
-
 	return grey;
 }
 
@@ -380,56 +799,116 @@ cv::Ptr<cv::Mat> ManagedCam::ImgProc_TwoStDevFromMean(cv::Ptr<cv::Mat> src, doub
 
 cv::Ptr<cv::Mat> ManagedCam::ProcessImage(cv::Ptr<cv::Mat> inImg)
 {
+	// The UI thread modifies the processing options, so the frame is 
+	// processed with a copy of them.
+	ProcessingType processing;
+	int thresholdExplicit;
+	std::optional<ProcessingROI> processingROI;
+	{
+		std::lock_guard<std::mutex> guard(this->camOptionsMutex);
+		processing			= this->camOptions.processing;
+		thresholdExplicit	= this->camOptions.thresholdExplicit;
+		processingROI		= this->camOptions.processingROI;
+	}
+
+	// Only the region of interest is processed. The rest of the frame
+	// is filled in at the end.
+	cv::Rect roiRect = _GetProcessingRect(inImg->size(), processingROI);
+	bool fullFrame = (roiRect.size() == inImg->size());
+	cv::Ptr<cv::Mat> roiImg = fullFrame ? inImg : cv::Ptr<cv::Mat>(new cv::Mat((*inImg)(roiRect)));
+
 	cv::Ptr<cv::Mat> binaryMask;
 	int remapMin = 0;
-	// When modifying this function, make sure to sync with IsThresholded().
-	switch (this->camOptions.processing)
-	{
-	case ProcessingType::None:
-		return inImg;
 
-	case ProcessingType::yen_threshold:
-		{
-			double fmthDouble;
-			binaryMask = ImgProc_YenThreshold(inImg, false, fmthDouble);
-			remapMin = (int)fmthDouble;
-		}
-		break;
+	cvgQualityGovernor& governor = cvgQualityGovernor::GetInstance();
 
-	case ProcessingType::yen_threshold_compressed:
+	// If the quality governor is reducing the mask rate, every other 
+	// frame reuses the previous frame's mask.
+	if(
+		governor.IsAtLeast(cvgQualityGovernor::Level::HalfRateMask) &&
+		!this->lastMaskReused &&
+		this->lastMask != nullptr &&
+		this->lastMaskProcessing == processing &&
+		this->lastMaskRect == roiRect)
+	{
+		binaryMask = this->lastMask;
+		remapMin = this->lastMaskRemapMin;
+		this->lastMaskReused = true;
+	}
+	else
+	{
+		// If the quality governor is reducing the mask resolution, the
+		// mask is made from a half resolution frame, and scaled back up.
+		bool halfResMask = governor.IsAtLeast(cvgQualityGovernor::Level::HalfResMask);
+		cv::Ptr<cv::Mat> maskSrc = roiImg;
+		if(halfResMask)
 		{
-			double fmthDouble;
-			binaryMask = ImgProc_YenThreshold(inImg, true, fmthDouble);
-			remapMin = (int)fmthDouble;
+			maskSrc = new cv::Mat();
+			cv::resize(*roiImg, *maskSrc, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
 		}
-		break;
 
-	case ProcessingType::two_stdev_from_mean:
+		// When modifying this function, make sure to sync with IsThresholded().
+		switch (processing)
 		{
-			double fmthDouble;
-			binaryMask = ImgProc_TwoStDevFromMean(inImg, fmthDouble);
-			remapMin = (int)fmthDouble;
+		case ProcessingType::None:
+			return inImg;
+
+		case ProcessingType::yen_threshold:
+			{
+				double fmthDouble;
+				binaryMask = ImgProc_YenThreshold(maskSrc, false, fmthDouble);
+				remapMin = (int)fmthDouble;
+			}
+			break;
+
+		case ProcessingType::yen_threshold_compressed:
+			{
+				double fmthDouble;
+				binaryMask = ImgProc_YenThreshold(maskSrc, true, fmthDouble);
+				remapMin = (int)fmthDouble;
+			}
+			break;
+
+		case ProcessingType::two_stdev_from_mean:
+			{
+				double fmthDouble;
+				binaryMask = ImgProc_TwoStDevFromMean(maskSrc, fmthDouble);
+				remapMin = (int)fmthDouble;
+			}
+			break;
+
+		case ProcessingType::static_threshold:
+			{
+				binaryMask = ImgProc_Simple(maskSrc, thresholdExplicit);
+				remapMin = (int)thresholdExplicit;
+			}
+			break;
+
+		default:
+			cvgAssert(false,"Unhandled processing switch");
 		}
-		break;
 
-	case ProcessingType::static_threshold:
+		cvgAssert(binaryMask != nullptr, "Image processing did not send back an expected valid image.");
+
+		if(halfResMask)
 		{
-			binaryMask = ImgProc_Simple(inImg, this->camOptions.thresholdExplicit);
-			remapMin = (int)this->camOptions.thresholdExplicit;
+			cv::Ptr<cv::Mat> fullResMask = new cv::Mat();
+			cv::resize(*binaryMask, *fullResMask, roiImg->size(), 0.0, 0.0, cv::INTER_NEAREST);
+			binaryMask = fullResMask;
 		}
-		break;
 
-	default:
-		cvgAssert(false,"Unhandled processing switch");
+		this->lastMask				= binaryMask;
+		this->lastMaskRemapMin		= remapMin;
+		this->lastMaskProcessing	= processing;
+		this->lastMaskRect			= roiRect;
+		this->lastMaskReused		= false;
 	}
 
-	cvgAssert(binaryMask != nullptr, "Image processing did not send back an expected valid image.");
-
 	// Apply remapping of the thing to heatmap from [0,255] to [thresh,255] so 
 	// that the entire ROYGBIV color space can be used, regardless of what thresh is.
 	// 
 	// https://github.com/Achilefu-Lab/CVG-Tietronix/issues/40
-	cv::Mat remapped = (*inImg - this->camOptions.thresholdExplicit) * 255.0f/(255.0f - remapMin);
+	cv::Mat remapped = (*roiImg - thresholdExplicit) * 255.0f/(255.0f - remapMin);
 	cv::Ptr<cv::Mat> ret = cv::Ptr<cv::Mat>(new cv::Mat());
 	// The result will be an RGB
 	cv::applyColorMap(remapped, *ret, cv::COLORMAP_JET);
@@ -438,12 +917,83 @@ cv::Ptr<cv::Mat> ManagedCam::ProcessImage(cv::Ptr<cv::Mat> inImg)
 	
 	std::vector<cv::Mat> chansToMerge = {channels[0], channels[1], channels[2], *binaryMask};
 	cv::merge(&chansToMerge[0], chansToMerge.size(), *ret);
-	return ret;
+
+	if(fullFrame)
+		return ret;
+
+	// Outside of the region, either pass through the frame, or leave it
+	// empty. Either way, it's a single pass over the frame.
+	cv::Ptr<cv::Mat> fullRet = cv::Ptr<cv::Mat>(new cv::Mat());
+	const ProcessingROI& roiOpts = processingROI.value();
+	if(roiOpts.passthrough)
+	{
+		switch(inImg->channels())
+		{
+		case 1:
+			cv::cvtColor(*inImg, *fullRet, cv::COLOR_GRAY2BGRA);
+			break;
+		case 3:
+			cv::cvtColor(*inImg, *fullRet, cv::COLOR_BGR2BGRA);
+			break;
+		default:
+			inImg->copyTo(*fullRet);
+		}
+	}
+	else
+		*fullRet = cv::Mat::zeros(inImg->size(), ret->type());
+
+	ret->copyTo((*fullRet)(roiRect));
+	return fullRet;
+}
+
+cv::Rect ManagedCam::_GetProcessingRect(const cv::Size& frameSz, const std::optional<ProcessingROI>& roiOpts)
+{
+	ROIRect frameRect(0, 0, frameSz.width, frameSz.height);
+	if(!roiOpts.has_value())
+		return frameRect.ToCVRect();
+
+	const ProcessingROI& roi = roiOpts.value();
+	if(roi.IsFullFrame())
+		return frameRect.ToCVRect();
+
+	ROIRect roiRect(
+		(int)(roi.x * frameSz.width), 
+		(int)(roi.y * frameSz.height), 
+		(int)(roi.w * frameSz.width), 
+		(int)(roi.h * frameSz.height));
+
+	ROIRect clipped = ROIRect::Intersect(frameRect, roiRect);
+
+	// A region too small to process falls back to the entire frame.
+	if(clipped.w < 2 || clipped.h < 2)
+		return frameRect.ToCVRect();
+
+	return clipped.ToCVRect();
 }
 
 bool ManagedCam::IsThresholded()
 {
-	return this->camOptions.processing != ProcessingType::None;
+	return this->GetProcessingType() != ProcessingType::None;
+}
+
+double ManagedCam::GetTargetFPS()
+{
+	std::lock_guard<std::mutex> guard(this->camOptionsMutex);
+	return this->camOptions.streamFPS;
+}
+
+long long ManagedCam::GetSkippedFrameCt()
+{
+	std::lock_guard<std::mutex> guard(this->frameAgeMutex);
+	return this->frameAgeStats.skippedCt;
+}
+
+float ManagedCam::GetFrameThreshold()
+{
+	if(!this->IsThresholded())
+		return -1.0f;
+
+	return (float)this->lastMaskRemapMin;
 }
 
 bool ManagedCam::UsesImageProcessingChain()
@@ -458,17 +1008,38 @@ void ManagedCam::SetPoll(VideoPollType pollTy)
 
 ProcessingType ManagedCam::GetProcessingType() const
 {
+	std::lock_guard<std::mutex> guard(this->camOptionsMutex);
 	return this->camOptions.processing;
 }
 
 double ManagedCam::GetParam( StreamParams paramid)
 {
+	std::unique_lock<std::mutex> optsLock(this->camOptionsMutex);
 	switch(paramid)
 	{
 	case StreamParams::StaticThreshold:
 		return (double)this->camOptions.thresholdExplicit;
 		break;
+
+	case StreamParams::ProcessingROIX:
+		return this->camOptions.processingROI.has_value() ? this->camOptions.processingROI->x : 0.0;
+
+	case StreamParams::ProcessingROIY:
+		return this->camOptions.processingROI.has_value() ? this->camOptions.processingROI->y : 0.0;
+
+	case StreamParams::ProcessingROIWidth:
+		return this->camOptions.processingROI.has_value() ? this->camOptions.processingROI->w : 1.0;
+
+	case StreamParams::ProcessingROIHeight:
+		return this->camOptions.processingROI.has_value() ? this->camOptions.processingROI->h : 1.0;
+
+	case StreamParams::ExposureMicroseconds:
+		return (double)this->camOptions.videoExposureTime;
+
+	default:
+		break;
 	}
+	optsLock.unlock();
 
 	return this->IManagedCam::GetParam(paramid);
 }
@@ -478,7 +1049,42 @@ bool ManagedCam::SetParam( StreamParams paramid, double value)
 	switch(paramid)
 	{
 	case StreamParams::StaticThreshold:
-		this->camOptions.thresholdExplicit = (int)std::clamp(value, 0.0, 255.0);
+		{
+			std::lock_guard<std::mutex> guard(this->camOptionsMutex);
+			this->camOptions.thresholdExplicit = (int)std::clamp(value, 0.0, 255.0);
+		}
+		return true;
+
+	case StreamParams::ProcessingROIX:
+	case StreamParams::ProcessingROIY:
+	case StreamParams::ProcessingROIWidth:
+	case StreamParams::ProcessingROIHeight:
+	case StreamParams::ProcessingROICentered:
+		{
+			std::lock_guard<std::mutex> guard(this->camOptionsMutex);
+			if(!this->camOptions.processingROI.has_value())
+				this->camOptions.processingROI = ProcessingROI();
+
+			ProcessingROI& roi = this->camOptions.processingROI.value();
+			float fval = (float)std::clamp(value, 0.0, 1.0);
+			switch(paramid)
+			{
+			case StreamParams::ProcessingROIX:
+				roi.x = fval;
+				break;
+			case StreamParams::ProcessingROIY:
+				roi.y = fval;
+				break;
+			case StreamParams::ProcessingROIWidth:
+				roi.w = fval;
+				break;
+			case StreamParams::ProcessingROIHeight:
+				roi.h = fval;
+				break;
+			default:
+				roi.SetCentered(fval);
+			}
+		}
 		return true;
 
 	// Add all other cases that are designed to be handled by the 
@@ -492,6 +1098,7 @@ bool ManagedCam::SetParam( StreamParams paramid, double value)
 
 bool ManagedCam::SetProcessingType(ProcessingType pt)
 {
+	std::lock_guard<std::mutex> guard(this->camOptionsMutex);
 	this->camOptions.processing = pt;
 	return true;
 }
@@ -500,6 +1107,10 @@ void ManagedCam::_ClearImplementation(bool delCurrent, bool resetPollTy)
 {
 	if(this->currentImpl != nullptr)
 	{
+		// Queued snapshot encodes read the implementation for their 
+		// DICOM data.
+		this->_WaitForSnapshotEncodes();
+
 		this->currentImpl->Deactivate();
 
 		if(delCurrent)
@@ -575,12 +1186,29 @@ void ManagedCam::InjectIntoDicom(DcmDataset* dicomData)
 		currentImpl->DelegatedInjectIntoDicom(dicomData);
 
 
+	// Snapshots are encoded off the camera thread, so the options are
+	// copied with the lock held.
+	cvgCamFeedSource opts;
+	{
+		std::lock_guard<std::mutex> guard(this->camOptionsMutex);
+		opts = this->camOptions;
+	}
+
 	// Arbitrary camera data listed in Aquisition context
-	InsertAcquisitionContextInfo(dicomData, "threshold_method",	to_string(this->GetProcessingType()));
-	InsertAcquisitionContextInfo(dicomData, "stream_type",		to_string(this->camOptions.GetUsedPoll()));
+	InsertAcquisitionContextInfo(dicomData, "threshold_method",	to_string(opts.processing));
+	InsertAcquisitionContextInfo(dicomData, "stream_type",		to_string(opts.GetUsedPoll()));
+
+	if(opts.processingROI.has_value() && !opts.processingROI->IsFullFrame())
+	{
+		const ProcessingROI& roi = opts.processingROI.value();
+		InsertAcquisitionContextInfo(
+			dicomData, 
+			"processing_roi", 
+			std::to_string(roi.x) + "," + std::to_string(roi.y) + "," + std::to_string(roi.w) + "," + std::to_string(roi.h));
+	}
 
 	// And then thresholding specific stuff, if any.
-	switch(GetProcessingType())
+	switch(opts.processing)
 	{
 	case ProcessingType::None:
 		break;
@@ -594,7 +1222,7 @@ void ManagedCam::InjectIntoDicom(DcmDataset* dicomData)
 	case ProcessingType::static_threshold:
 		dicomData->putAndInsertString(
 			DCM_AcquisitionContextDescription, 
-			(std::string("Threshold: ") + std::to_string(this->camOptions.thresholdExplicit)).c_str());
+			(std::string("Threshold: ") + std::to_string(opts.thresholdExplicit)).c_str());
 		break;
 
 	case ProcessingType::two_stdev_from_mean:
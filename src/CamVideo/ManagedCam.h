@@ -1,5 +1,7 @@
 #pragma once
 #include "IManagedCam.h"
+#include "../Utils/cvgStopwatch.h"
+#include <atomic>
 
 /// <summary>
 /// Subclass of IManagedCam to represent a video feed.
@@ -8,6 +10,118 @@ class ManagedCam : public IManagedCam
 {
 	friend class CamStreamMgr;
 
+public:
+	/// <summary>
+	/// Bookkeeping of how often, and how long, a camera has lost its
+	/// stream and had to reconnect.
+	/// </summary>
+	struct ReconnectStats
+	{
+		/// <summary>
+		/// The number of outages that have been recovered from.
+		/// </summary>
+		int reconnectCt = 0;
+
+		/// <summary>
+		/// The number of attempts made to reconnect, successful or not.
+		/// </summary>
+		int attemptCt = 0;
+
+		/// <summary>
+		/// The number of attempts that reactivated the existing camera
+		/// implementation instead of rebuilding it.
+		/// </summary>
+		int warmRestartCt = 0;
+
+		/// <summary>
+		/// If true, the camera is currently in an outage.
+		/// </summary>
+		bool inOutage = false;
+
+		/// <summary>
+		/// If inOutage, how long the current outage has lasted.
+		/// </summary>
+		int curOutageMS = 0;
+
+		/// <summary>
+		/// The duration of the last recovered outage.
+		/// </summary>
+		int lastOutageMS = 0;
+
+		/// <summary>
+		/// The duration of the longest recovered outage.
+		/// </summary>
+		int longestOutageMS = 0;
+
+		/// <summary>
+		/// The total duration of all recovered outages.
+		/// </summary>
+		long long totalOutageMS = 0;
+	};
+
+	/// <summary>
+	/// How old frames are when they're polled from the camera 
+	/// implementation, since the camera last connected.
+	/// </summary>
+	struct FrameAgeStats
+	{
+		/// <summary>
+		/// If false, the camera implementation can't measure the age of
+		/// its frames, and the other values are unused.
+		/// </summary>
+		bool measured = false;
+
+		double lastMS = 0.0;
+
+		/// <summary>
+		/// The moving average of the frame ages.
+		/// </summary>
+		double avgMS = 0.0;
+
+		double maxMS = 0.0;
+
+		/// <summary>
+		/// The number of frames the implementation received, but that were
+		/// replaced by newer frames before they were polled.
+		/// </summary>
+		long long skippedCt = 0;
+	};
+
+	/// <summary>
+	/// The delay before the first reconnect attempt. Each failed
+	/// attempt doubles the delay, up to reconnectBackoffMaxMS.
+	/// </summary>
+	static constexpr int reconnectBackoffMinMS = 10;
+
+	/// <summary>
+	/// The longest delay between reconnect attempts.
+	/// </summary>
+	static constexpr int reconnectBackoffMaxMS = 1000;
+
+	/// <summary>
+	/// The number of failed attempts to reactivate the current 
+	/// implementation before it's deleted and rebuilt from scratch.
+	/// </summary>
+	static constexpr int warmRestartAttempts = 3;
+
+	/// <summary>
+	/// If a streaming camera hasn't delivered a frame for this many
+	/// milliseconds, it's considered to have stalled and is reconnected.
+	/// </summary>
+	static constexpr int stallTimeoutMS = 500;
+
+	/// <summary>
+	/// The stall timeout for the first frame after connecting, since
+	/// cameras can take a while to start streaming.
+	/// </summary>
+	static constexpr int firstFrameTimeoutMS = 3000;
+
+	/// <summary>
+	/// With synchronized acquisition, the longest to wait at the 
+	/// CamSyncGroup barrier for the other cameras before grabbing anyways.
+	/// </summary>
+	static constexpr int syncTimeoutMS = 100;
+
 public:
 
 	/// <summary>
@@ -27,9 +141,19 @@ public:
 	/// <summary>
 	/// A cache of the camera options to define the ManagedCam's stream
 	/// locations and behaviours.
+	/// 
+	/// Only the camera thread replaces it (see _ApplyPendingOptions()), and
+	/// the UI thread modifies the processing options. Both do so with 
+	/// camOptionsMutex locked, and any thread reading it, other than the 
+	/// camera thread reading options the UI doesn't modify, locks it too.
 	/// </summary>
 	cvgCamFeedSource camOptions;
 
+	/// <summary>
+	/// Guards camOptions.
+	/// </summary>
+	mutable std::mutex camOptionsMutex;
+
 	/// <summary>
 	/// The polling implementation. See this->pollType, as well as 
 	/// the various subclasses of ICamImpl for more details.
@@ -38,6 +162,153 @@ public:
 
 protected:
 
+	/// <summary>
+	/// Guards pendingOptions.
+	/// </summary>
+	std::mutex pendingOptionsMutex;
+
+	/// <summary>
+	/// Reloaded options waiting to be applied by the camera thread.
+	/// See QueueOptionsReload().
+	/// </summary>
+	std::optional<cvgCamFeedSource> pendingOptions;
+
+	/// <summary>
+	/// If true, the stream was lost and the current frame is the last
+	/// good frame from before the outage.
+	/// </summary>
+	std::atomic_bool frameStale = false;
+
+	/// <summary>
+	/// Guards reconnectStats.
+	/// </summary>
+	std::mutex reconnectStatsMutex;
+
+	ReconnectStats reconnectStats;
+
+	/// <summary>
+	/// Guards frameAgeStats.
+	/// </summary>
+	std::mutex frameAgeMutex;
+
+	FrameAgeStats frameAgeStats;
+
+	/// <summary>
+	/// Measures the duration of the current outage.
+	/// </summary>
+	cvgStopwatch swOutage;
+
+	/// <summary>
+	/// The number of consecutive failed attempts to reactivate the
+	/// current implementation. Only used by the camera thread.
+	/// </summary>
+	int warmRestartFailCt = 0;
+
+	/// <summary>
+	/// If true, the camera is in the CamSyncGroup. Only used by the 
+	/// camera thread.
+	/// </summary>
+	bool inSyncGroup = false;
+
+	/// <summary>
+	/// The last threshold mask computed by ProcessImage(), for reusing when
+	/// the quality governor reduces the mask rate. Only used by the camera 
+	/// thread.
+	/// </summary>
+	cv::Ptr<cv::Mat> lastMask;
+
+	/// <summary>
+	/// The remap minimum found with lastMask.
+	/// </summary>
+	int lastMaskRemapMin = 0;
+
+	/// <summary>
+	/// The processing type lastMask was made with.
+	/// </summary>
+	ProcessingType lastMaskProcessing = ProcessingType::None;
+
+	/// <summary>
+	/// If true, lastMask was reused for the previous frame, so the next
+	/// frame needs a new one.
+	/// </summary>
+	bool lastMaskReused = false;
+
+	/// <summary>
+	/// The region of the frame lastMask was made for.
+	/// </summary>
+	cv::Rect lastMaskRect;
+
+protected:
+
+	/// <summary>
+	/// Flag the frame as stale and start timing an outage, if one 
+	/// isn't already in progress.
+	/// </summary>
+	void _BeginOutage();
+
+	/// <summary>
+	/// If an outage is in progress, record it as recovered. This should
+	/// be called when a new frame is received.
+	/// </summary>
+	void _EndOutage();
+
+	/// <summary>
+	/// Deactivate and reactivate the current implementation, to reconnect
+	/// to the device while reusing everything else the implementation has
+	/// already set up.
+	/// 
+	/// If this fails warmRestartAttempts times in a row, the implementation
+	/// is deleted so it will be rebuilt from scratch.
+	/// </summary>
+	/// <returns>True if the implementation was reactivated.</returns>
+	bool _WarmRestartImplementation();
+
+	/// <summary>
+	/// Record the age of the frame that was just polled from the current
+	/// implementation, and when it was captured.
+	/// </summary>
+	/// <param name="firstFrame">
+	/// If true, it's the first frame since connecting, and the previous
+	/// statistics are cleared.
+	/// </param>
+	void _RecordFrameAge(bool firstFrame);
+
+	/// <summary>
+	/// Poll the next frame from the current implementation.
+	/// 
+	/// If synchronized acquisition is enabled and the implementation 
+	/// supports it, the grab is synchronized with the other cameras 
+	/// through the CamSyncGroup, and acquisitionEpoch is set to the
+	/// epoch it was grabbed in. Else, acquisitionEpoch is set to -1.
+	/// </summary>
+	/// <returns>The polled frame, or nullptr if there's none.</returns>
+	cv::Ptr<cv::Mat> _PollFrame();
+
+	/// <summary>
+	/// Leave the CamSyncGroup, if the camera is in it.
+	/// </summary>
+	void _LeaveSyncGroup();
+
+	/// <summary>
+	/// The milliseconds to wait without a frame before a stream is
+	/// considered stalled.
+	/// </summary>
+	/// <param name="firstFrame">If true, no frame has been received yet.</param>
+	int _StallTimeoutMS(bool firstFrame) const;
+
+	/// <summary>
+	/// Apply options queued by QueueOptionsReload(), if any. This must
+	/// only be called from the camera thread.
+	/// 
+	/// Differences that the running implementation can handle are applied
+	/// to it with ICamImpl::SetParam().
+	/// </summary>
+	/// <returns>
+	/// True if the changes require the camera implementation to be 
+	/// reconnected. Else, false.
+	/// </returns>
+	bool _ApplyPendingOptions();
+
 	/// <summary>
 	/// Null the camera implementation.
 	/// </summary>
@@ -67,6 +338,17 @@ protected:
 	/// <returns>The alpha-channeled heatmap.</returns>
 	cv::Ptr<cv::Mat> ProcessImage(cv::Ptr<cv::Mat> inImg) override;
 
+	/// <summary>
+	/// Get the region of a frame that image processing is limited to.
+	/// </summary>
+	/// <param name="frameSz">The dimensions of the frame.</param>
+	/// <param name="roiOpts">A copy of camOptions.processingROI.</param>
+	/// <returns>
+	/// The region in pixels, clipped to the frame. If there's no region
+	/// set, the entire frame.
+	/// </returns>
+	static cv::Rect _GetProcessingRect(const cv::Size& frameSz, const std::optional<ProcessingROI>& roiOpts);
+
 	void _DeactivateStreamState(bool deactivateShould = false) override;
 
 public:
@@ -76,6 +358,34 @@ public:
 
 	void ThreadFn(int camIdx) override;
 
+	/// <summary>
+	/// Queue new camera options to be applied by the camera thread.
+	/// 
+	/// Changes that can be done on a running camera (exposure, gains,
+	/// flips, processing, ...) are applied in place. The camera is only
+	/// reconnected if the device identity changes, or if the implementation
+	/// can't apply a change live.
+	/// </summary>
+	/// <param name="newOpts">The reloaded camera options.</param>
+	void QueueOptionsReload(const cvgCamFeedSource& newOpts);
+
+	/// <summary>
+	/// Query if the current frame is the last good frame from before
+	/// the camera lost its stream.
+	/// </summary>
+	inline bool IsFrameStale() const
+	{ return this->frameStale; }
+
+	/// <summary>
+	/// Get a copy of the camera's reconnect bookkeeping.
+	/// </summary>
+	ReconnectStats GetReconnectStats();
+
+	/// <summary>
+	/// Get a copy of how old the camera's frames are when polled.
+	/// </summary>
+	FrameAgeStats GetFrameAgeStats();
+
 	/// <summary>
 	/// Query if the camera settings are set for the image feed to go through
 	/// thresholding image processing.
@@ -84,6 +394,11 @@ public:
 
 	bool UsesImageProcessingChain() override;
 
+	double GetTargetFPS() override;
+
+	float GetFrameThreshold() override;
+	long long GetSkippedFrameCt() override;
+
 	/// <summary>
 	/// Set the polling type of the camera.
 	/// </summary>
@@ -13,6 +13,8 @@
 #include "../Utils/cvgStopwatch.h"
 #include "../Utils/cvgStopwatchLeft.h"
 #include "../Utils/multiplatform.h"
+#include "../Utils/cvgTaskPool.h"
+#include "../Utils/cvgQualityGovernor.h"
 
 // Imitating how compositing happens in OpenGL for StateHMDOp
 #include "ROIRect.h"
@@ -24,6 +26,7 @@ bool ManagedComposite::cacheAvailable;
 std::map<int, CompCacheInfo> ManagedComposite::globalCache;
 std::mutex ManagedComposite::cacheMutex;
 bool ManagedComposite::modSinceLastCache = true;
+std::atomic<double> ManagedComposite::targetFPS = 30.0;
 
 CompCacheInfo::CompCacheInfo()
 {}
@@ -31,21 +34,24 @@ CompCacheInfo::CompCacheInfo()
 CompCacheInfo::CompCacheInfo(
 	cv::Ptr<cv::Mat> img, 
 	bool thresholded, 
-	float opacity)
+	float opacity,
+	long long epoch)
 {
 	this->img			= img;
 	this->thresholded	= thresholded;
 	this->opacity		= opacity;
+	this->epoch			= epoch;
 }
 
 bool ManagedComposite::CacheCameraFrame(
 	int id, 
 	cv::Ptr<cv::Mat> img, 
 	bool thresholded, 
-	float opacity)
+	float opacity,
+	long long epoch)
 {
 
-	CompCacheInfo cInfo(img, thresholded, opacity);
+	CompCacheInfo cInfo(img, thresholded, opacity, epoch);
 
 	std::lock_guard<std::mutex> guard(cacheMutex);
 	if(!cacheAvailable)
@@ -56,6 +62,38 @@ bool ManagedComposite::CacheCameraFrame(
 	return true;
 }
 
+bool ManagedComposite::_EpochsMatch(const std::map<int, CompCacheInfo>& cache, long long& epoch)
+{
+	// Frames that weren't acquired in sync have an epoch of -1.
+	epoch = -1;
+	for(auto it : cache)
+	{
+		if(it.second.epoch > epoch)
+			epoch = it.second.epoch;
+	}
+
+	// Only a frame from the epoch right before the newest is worth waiting
+	// on. Anything older is from a camera that's dropped out of the group,
+	// and its frame isn't going to be updated any time soon.
+	for(auto it : cache)
+	{
+		if(epoch >= 0 && it.second.epoch == epoch - 1)
+			return false;
+	}
+	return true;
+}
+
+void ManagedComposite::SetTargetFPS(double fps)
+{
+	if(fps > 0.0)
+		targetFPS = fps;
+}
+
+double ManagedComposite::GetTargetFPS()
+{
+	return targetFPS;
+}
+
 cv::Ptr<cv::Mat> ManagedComposite::ProcessImage(cv::Ptr<cv::Mat> inImg)
 {
 	// No processing performed, just relay it.
@@ -101,12 +139,17 @@ void ManagedComposite::ThreadFn(int camIdx)
 	cvgStopwatch swFPS;
 	cvgStopwatchLeft swLoopSleep;
 
+	// Time since the last recomposite, for how long to wait on epochs
+	// to match.
+	cvgStopwatch swEpochWait;
+
 	this->streamFrameCt = 0;
 	{ 
 		// Scope so the local variable to initialize the starting
 		// nothing-image doesn't live for the entire life of the 
 		// threa function.
 		cv::Ptr<cv::Mat> initFrame = new cv::Mat(this->streamHeight, this->streamWidth, CV_8UC3);
+		this->frameCaptureTime = std::chrono::steady_clock::now();
 		this->_FinalizeHandlingPolledImage(initFrame);
 	}
 
@@ -114,9 +157,34 @@ void ManagedComposite::ThreadFn(int camIdx)
 	// pushed data from external sources.
 	while(this->_sentShutdown == false)
 	{
+		cvgQualityGovernor& governor = cvgQualityGovernor::GetInstance();
+
+		// If the quality governor is reducing the composite rate, every
+		// other frame is skipped and the previous composite is reused.
+		bool skipForRate = 
+			governor.IsAtLeast(cvgQualityGovernor::Level::HalfRateComposite) &&
+			(this->streamFrameCt % 2) == 1;
+
+		// With synchronized acquisition, recompositing is held off until 
+		// every camera has delivered its frame of the newest epoch, so frames
+		// grabbed at different times aren't blended together. This is only
+		// waited on for so long, in case a camera missed the epoch.
+		bool waitForEpoch = false;
+		if(this->modSinceLastCache && !skipForRate)
+		{
+			std::lock_guard<std::mutex> epochGuard(cacheMutex);
+			long long newestEpoch;
+			waitForEpoch = 
+				!_EpochsMatch(globalCache, newestEpoch) && 
+				swEpochWait.Milliseconds(false) < (int)(epochWaitMaxFrames * 1000.0 / targetFPS);
+		}
+
 		// If anything new, recomposite
-		if(this->modSinceLastCache)
+		if(this->modSinceLastCache && !skipForRate && !waitForEpoch)
 		{
+			cvgStopwatch swStage;
+			swEpochWait.Restart();
+
 			// We make a copy so afterwards, we have free reign on a snapshot of 
 			// the globalCache without keeping it locked for as long as we need
 			// it for however long compositing takes
@@ -136,55 +204,89 @@ void ManagedComposite::ThreadFn(int camIdx)
 				cacheCpy = globalCache;
 			}
 
+			// The composite is tagged with the epoch of its frames, for 
+			// snapshots of the composite.
+			_EpochsMatch(cacheCpy, this->acquisitionEpoch);
+
+			// If the quality governor is reducing the composite resolution, it's
+			// composited at half resolution and scaled up to the output size at 
+			// the end. The output size stays the same, because recordings are 
+			// locked to it.
+			bool halfRes = governor.IsAtLeast(cvgQualityGovernor::Level::HalfResComposite);
+			int compWidth	= halfRes ? this->streamWidth / 2	: this->streamWidth;
+			int compHeight	= halfRes ? this->streamHeight / 2	: this->streamHeight;
+
 			// The composite target. For now we'll start with black at the final
 			// save dimensions and add aall contributing images on top, similar
 			// (as similar as possible) to how StateHMDOp works.
 			cv::Ptr<cv::Mat> accumframe = 
 				new cv::Mat(
-					this->streamHeight, 
-					this->streamWidth, 
+					compHeight, 
+					compWidth, 
 					CV_8UC3,
 					cv::Scalar(0, 0, 0));
 
+			std::vector<CompCacheInfo> tiles;
 			for(auto it : cacheCpy)
-			{
-				auto matCache = it.second.img;
-
-				float vaspect = (float)matCache->rows / (float)matCache->cols;
-				cvgRect rect = cvgRect::MakeWidthAspect(this->streamWidth, vaspect);
-				cv::Mat cpy;
-				cv::resize(
-					*it.second.img, 
-					cpy, 
-					cv::Size(
-						(int)rect.w, 
-						(int)rect.h));
-
-				// Single channel image needs to be converted to RGB, need to figure
-				// out if we make it thresholded red, or greyscale.
-				if(cpy.channels() == 1)
+				tiles.push_back(it.second);
+
+			// Scaling and color converting each tile is independent of the
+			// others, so they're prepared in parallel on the task pool. The 
+			// blitting afterwards is done in order, because it accumulates 
+			// into the same frame.
+			std::vector<cv::Mat> tileMats(tiles.size());
+			cvgTaskPool::GetInstance().ParallelFor(
+				0, 
+				(int)tiles.size(),
+				[compWidth, &tiles, &tileMats](int start, int end)
 				{
-					// https://stackoverflow.com/questions/26065253/opencv-set-a-channel-to-a-value-c
-					cpy *= it.second.opacity; // Ret
-
-					std::vector<cv::Mat> chansComp;
-					if(it.second.thresholded)
+					for(int i = start; i < end; ++i)
 					{
-						// Make red
-						chansComp.push_back(cv::Mat(cpy.rows, cpy.cols, CV_8UC1, cv::Scalar(0)));	// B
-						chansComp.push_back(cv::Mat(cpy.rows, cpy.cols, CV_8UC1, cv::Scalar(0)));	// G
-						chansComp.push_back(cpy); // R
+						const CompCacheInfo& tile = tiles[i];
+						auto matCache = tile.img;
+
+						float vaspect = (float)matCache->rows / (float)matCache->cols;
+						cvgRect rect = cvgRect::MakeWidthAspect(compWidth, vaspect);
+						cv::Mat cpy;
+						cv::resize(
+							*tile.img, 
+							cpy, 
+							cv::Size(
+								(int)rect.w, 
+								(int)rect.h));
+
+						// Single channel image needs to be converted to RGB, need to figure
+						// out if we make it thresholded red, or greyscale.
+						if(cpy.channels() == 1)
+						{
+							// https://stackoverflow.com/questions/26065253/opencv-set-a-channel-to-a-value-c
+							cpy *= tile.opacity; // Ret
+
+							std::vector<cv::Mat> chansComp;
+							if(tile.thresholded)
+							{
+								// Make red
+								chansComp.push_back(cv::Mat(cpy.rows, cpy.cols, CV_8UC1, cv::Scalar(0)));	// B
+								chansComp.push_back(cv::Mat(cpy.rows, cpy.cols, CV_8UC1, cv::Scalar(0)));	// G
+								chansComp.push_back(cpy); // R
+							}
+							else
+							{
+								// Make greyscale
+								chansComp.push_back(cpy);	// B
+								chansComp.push_back(cpy);	// G
+								chansComp.push_back(cpy);	// R
+							}
+							
+							cv::merge(chansComp, cpy);
+						}
+						tileMats[i] = cpy;
 					}
-					else
-					{
-						// Make greyscale
-						chansComp.push_back(cpy);	// B
-						chansComp.push_back(cpy);	// G
-						chansComp.push_back(cpy);	// R
-					}
-					
-					cv::merge(chansComp, cpy);
-				}
+				},
+				(int)tiles.size());
+
+			for(cv::Mat& cpy : tileMats)
+			{
 
 				// For how OpenCV functions work, images need to be of the same
 				// size (and probably the same channel count) - but we may not
@@ -202,12 +304,12 @@ void ManagedComposite::ThreadFn(int camIdx)
 				//////////////////////////////////////////////////
 
 				// The rect of the whole destination region.
-				ROIRect roiActDst(0, 0, this->streamWidth, this->streamHeight);
+				ROIRect roiActDst(0, 0, compWidth, compHeight);
 				//
 				// The rect of the DST where the DST will be placed into.
 				ROIRect roiVirtDst(
-					(this->streamWidth - cpy.cols)/2,		// Centered
-					(this->streamHeight - cpy.rows)/2,		// Centered
+					(compWidth - cpy.cols)/2,		// Centered
+					(compHeight - cpy.rows)/2,		// Centered
 					cpy.cols, 
 					cpy.rows);
 				//
@@ -287,7 +389,16 @@ void ManagedComposite::ThreadFn(int camIdx)
 				cv::add(acRoi, cpyRoi, acRoi);
 			}
 
+			if(halfRes)
+			{
+				cv::Ptr<cv::Mat> fullRes = new cv::Mat();
+				cv::resize(*accumframe, *fullRes, cv::Size(this->streamWidth, this->streamHeight));
+				accumframe = fullRes;
+			}
+
+			this->frameCaptureTime = std::chrono::steady_clock::now();
 			_FinalizeHandlingPolledImage(accumframe);
+			governor.ReportStage("composite", (double)swStage.Microseconds() / 1000.0);
 		}
 		else
 		{ 
@@ -298,7 +409,8 @@ void ManagedComposite::ThreadFn(int camIdx)
 
 		++this->streamFrameCt;
 		this->msInterval = swFPS.Milliseconds();
-		int msLeft = swLoopSleep.MSLeft33();
+		this->frameJitter.Tick();
+		int msLeft = swLoopSleep.MSLeftForFPS(targetFPS);
 		MSSleep(msLeft);
 				
 	}
@@ -2,6 +2,7 @@
 
 #include "IManagedCam.h"
 #include <map>
+#include <atomic>
 
 /// <summary>
 /// Structure to cache image for compositing, with extra
@@ -30,9 +31,15 @@ public:
 	/// </summary>
 	float opacity = 1.0f;
 
+	/// <summary>
+	/// The acquisition epoch the image was grabbed in, or -1 if it wasn't
+	/// acquired in sync with other cameras. See CamSyncGroup.
+	/// </summary>
+	long long epoch = -1;
+
 public:
 	CompCacheInfo();
-	CompCacheInfo(cv::Ptr<cv::Mat> img, bool thresholded, float opacity);
+	CompCacheInfo(cv::Ptr<cv::Mat> img, bool thresholded, float opacity, long long epoch);
 };
 
 /// <summary>
@@ -67,7 +74,28 @@ private:
 	/// </summary>
 	static bool modSinceLastCache;
 
+	/// <summary>
+	/// The frame rate to composite at. See SetTargetFPS().
+	/// </summary>
+	static std::atomic<double> targetFPS;
+
+	/// <summary>
+	/// With synchronized acquisition, the longest to hold off recompositing
+	/// while waiting for every camera's frame of the same epoch, in frames.
+	/// </summary>
+	static constexpr int epochWaitMaxFrames = 2;
+
 private:
+	/// <summary>
+	/// Check if every cached frame that was acquired in sync was from the
+	/// same epoch. Frames more than an epoch behind the newest are ignored.
+	/// </summary>
+	/// <param name="cache">The cache to check.</param>
+	/// <param name="epoch">
+	/// Output parameter. The newest epoch in the cache, or -1 if there are
+	/// no synchronized frames.
+	/// </param>
+	static bool _EpochsMatch(const std::map<int, CompCacheInfo>& cache, long long& epoch);
 
 protected:
 	void _EndShutdown() override;
@@ -78,7 +106,17 @@ public:
 	/// The interface for other IManagedCam object to submit their
 	/// current frames to be queued for compositing.
 	/// </summary>
-	static bool CacheCameraFrame(int id, cv::Ptr<cv::Mat> img, bool thresholded, float opacity);
+	/// <param name="epoch">
+	/// The acquisition epoch the frame was grabbed in, or -1 if it wasn't
+	/// acquired in sync with other cameras.
+	/// </param>
+	static bool CacheCameraFrame(int id, cv::Ptr<cv::Mat> img, bool thresholded, float opacity, long long epoch);
+
+	/// <summary>
+	/// Set the frame rate to composite at. This should match the fastest
+	/// video feed, so none of its frames are missed.
+	/// </summary>
+	static void SetTargetFPS(double fps);
 
 	cv::Ptr<cv::Mat> ProcessImage(cv::Ptr<cv::Mat> inImg) override;
 
@@ -88,6 +126,8 @@ public:
 
 	bool UsesImageProcessingChain() override;
 
+	double GetTargetFPS() override;
+
 	virtual void ThreadFn(int camIdx) override;
 
 	virtual CamType GetCamType() override;
@@ -0,0 +1,418 @@
+#include "MultiFrameDicomWriter.h"
+#include "IManagedCam.h"
+#include "CaptureStorage.h"
+#include <opencv2/imgproc.hpp>
+
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcuid.h>
+#include <dcmtk/dcmdata/dcsequen.h>
+#include <dcmtk/dcmdata/dcitem.h>
+
+#include "../DicomUtils/DicomInjectorSet.h"
+#include "../DicomUtils/DicomMiscUtils.h"
+
+#include <cstdio>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	/// <summary>
+	/// The transfer syntax of a file's pixel data.
+	/// </summary>
+	E_TransferSyntax XferFor(DicomCompress::Method compression)
+	{
+		switch(compression)
+		{
+		case DicomCompress::Method::RLE:
+			return EXS_RLELossless;
+
+		case DicomCompress::Method::JPEGLS:
+			return EXS_JPEGLSLossless;
+
+		default:
+			return EXS_LittleEndianExplicit;
+		}
+	}
+}
+
+MultiFrameDicomWriter::MultiFrameDicomWriter()
+{}
+
+MultiFrameDicomWriter::~MultiFrameDicomWriter()
+{
+	this->_Discard();
+}
+
+bool MultiFrameDicomWriter::Open(
+	const std::string& baseFilename,
+	IManagedCam* cam,
+	cv::Size size,
+	int type,
+	const std::string& qualityLevel,
+	const std::vector<std::pair<std::string, std::string>>& extraContext,
+	DicomCompress::Method compression)
+{
+	this->_Discard();
+	this->err.clear();
+
+	int channels = CV_MAT_CN(type);
+	if(CV_MAT_DEPTH(type) != CV_8U || (channels != 1 && channels != 3 && channels != 4))
+	{
+		this->_SetError("Multi-frame DICOMs can only be written from 8-bit mono, BGR or BGRA frames.");
+		return false;
+	}
+
+	if(size.width <= 0 || size.height <= 0 || size.width > 0xFFFF || size.height > 0xFFFF)
+	{
+		this->_SetError("Invalid frame size for a multi-frame DICOM.");
+		return false;
+	}
+
+	bool mono = (channels == 1);
+	int samplesPerPixel = mono ? 1 : 3;
+
+	this->filename		= baseFilename + ".dcm";
+	this->pixelFilename	= this->filename + ".pixels";
+	this->frameSize		= size;
+	this->frameType		= type;
+	this->frameBytes	= (size_t)size.width * size.height * samplesPerPixel;
+	this->pixelBytes	= 0;
+	this->frameInfos.clear();
+	this->compressStats	= DicomCompress::Stats();
+	this->compression	= compression;
+	if(!DicomCompress::IsSupported(compression))
+	{
+		std::cout << "DICOM compression " << to_string(compression) << " isn't available in this build, " <<
+			this->filename << " is written as RLE." << std::endl;
+		this->compression = DicomCompress::Method::RLE;
+	}
+
+	// The file isn't written through the CaptureStorage, so its folder is
+	// recreated here if it was removed during the session.
+	CaptureStorage::EnsureParentFolder(this->filename);
+	this->pixelFile.open(this->pixelFilename, std::ios::binary | std::ios::trunc);
+	if(!this->pixelFile.is_open())
+	{
+		this->_SetError("Could not create " + this->pixelFilename);
+		return false;
+	}
+
+	this->header.reset(new DcmFileFormat());
+	DcmDataset* dicomData = this->header->getDataset();
+	//
+	// ADD DICOM TIMESTAMPS
+	dicomData->putAndInsertString(DCM_StudyDate, DicomMiscUtils::GetCurrentDateString().c_str());
+	dicomData->putAndInsertString(DCM_StudyTime, DicomMiscUtils::GetCurrentTime().c_str());
+	//
+	// ADD DICOM INJECTION SET DATA
+	DicomInjectorSet::GetSingleton().InjectDataInto(dicomData);
+	//
+	// ADD DICOM CAMERA DATA
+	if(cam != nullptr)
+		cam->InjectIntoDicom(dicomData);
+	//
+	// ADD THE PROCESSING QUALITY
+	if(!qualityLevel.empty())
+		InsertAcquisitionContextInfo(dicomData, "quality_level", qualityLevel);
+	//
+	// ADD ANYTHING ELSE THE CALLER KNOWS ABOUT THE FRAMES
+	for(const std::pair<std::string, std::string>& kv : extraContext)
+		InsertAcquisitionContextInfo(dicomData, kv.first, kv.second);
+	//
+	// ADD THE SECONDARY CAPTURE IDENTIFICATION, THE SAME AS Image2Dcm WOULD.
+	DicomMiscUtils::InsertSecondaryCaptureHeader(
+		dicomData,
+		mono ?
+			UID_MultiframeGrayscaleByteSecondaryCaptureImageStorage :
+			UID_MultiframeTrueColorSecondaryCaptureImageStorage);
+	dicomData->putAndInsertString(DCM_InstanceNumber, "1");
+	//
+	// ADD THE IMAGE PIXEL DESCRIPTION
+	dicomData->putAndInsertUint16(DCM_SamplesPerPixel,			(Uint16)samplesPerPixel);
+	dicomData->putAndInsertString(DCM_PhotometricInterpretation,	mono ? "MONOCHROME2" : "RGB");
+	dicomData->putAndInsertUint16(DCM_Rows,						(Uint16)size.height);
+	dicomData->putAndInsertUint16(DCM_Columns,					(Uint16)size.width);
+	dicomData->putAndInsertUint16(DCM_BitsAllocated,			8);
+	dicomData->putAndInsertUint16(DCM_BitsStored,				8);
+	dicomData->putAndInsertUint16(DCM_HighBit,					7);
+	dicomData->putAndInsertUint16(DCM_PixelRepresentation,		0);
+	if(!mono)
+		dicomData->putAndInsertUint16(DCM_PlanarConfiguration,	0);
+
+	return true;
+}
+
+bool MultiFrameDicomWriter::AddFrame(const cv::Mat& frame, const FrameInfo& info)
+{
+	if(!this->IsOpen())
+	{
+		this->_SetError("The multi-frame DICOM isn't open.");
+		return false;
+	}
+
+	if(frame.size() != this->frameSize || frame.type() != this->frameType)
+	{
+		this->_SetError("The frame doesn't match the multi-frame DICOM's size and type.");
+		return false;
+	}
+
+	if(!this->HasRoomForFrame())
+	{
+		this->_SetError("The multi-frame DICOM is full.");
+		return false;
+	}
+
+	// The same conversions as DicomImg_RawBmp: BGR is reordered to RGB, and
+	// BGRA has its alpha applied, since it can't be stored.
+	const cv::Mat* toWrite = &frame;
+	if(frame.channels() == 3)
+	{
+		cv::cvtColor(frame, this->converted, cv::COLOR_BGR2RGB);
+		toWrite = &this->converted;
+	}
+	else if(frame.channels() == 4)
+	{
+		cv::Mat alpha;
+		cv::extractChannel(frame, alpha, 3);
+		cv::cvtColor(alpha, alpha, cv::COLOR_GRAY2RGB);
+		cv::cvtColor(frame, this->converted, cv::COLOR_BGRA2RGB);
+		cv::multiply(this->converted, alpha, this->converted, 1.0/255.0);
+		toWrite = &this->converted;
+	}
+
+	if(this->compression != DicomCompress::Method::None)
+	{
+		if(!toWrite->isContinuous())
+		{
+			toWrite->copyTo(this->converted);
+			toWrite = &this->converted;
+		}
+
+		std::chrono::steady_clock::time_point encodeStart = std::chrono::steady_clock::now();
+		bool frameEncoded = 
+			(this->compression == DicomCompress::Method::JPEGLS) ?
+				DicomCompress::EncodeJPEGLSFrame(toWrite->data, toWrite->rows, toWrite->cols, toWrite->channels(), this->encoded) :
+				DicomCompress::EncodeRLEFrame(toWrite->data, toWrite->rows, toWrite->cols, toWrite->channels(), false, this->encoded);
+
+		if(!frameEncoded)
+		{
+			this->_SetError("Could not " + to_string(this->compression) + " encode a frame.");
+			return false;
+		}
+		this->compressStats.encodeMS += 
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - encodeStart).count();
+		++this->compressStats.frameCt;
+		this->compressStats.rawBytes		+= (long long)this->frameBytes;
+		this->compressStats.encodedBytes	+= (long long)this->encoded.size();
+
+		// Each frame is an item (FFFE,E000) of the encapsulated pixel data.
+		uint32_t length = (uint32_t)this->encoded.size();
+		unsigned char itemHeader[8] =
+		{
+			0xFE, 0xFF, 0x00, 0xE0,
+			(unsigned char)(length >> 0),
+			(unsigned char)(length >> 8),
+			(unsigned char)(length >> 16),
+			(unsigned char)(length >> 24)
+		};
+		this->pixelFile.write((const char*)itemHeader, sizeof(itemHeader));
+		this->pixelFile.write((const char*)this->encoded.data(), this->encoded.size());
+		this->pixelBytes += sizeof(itemHeader) + this->encoded.size();
+	}
+	else
+	{
+		size_t rowBytes = (size_t)toWrite->cols * toWrite->elemSize();
+		if(toWrite->isContinuous())
+			this->pixelFile.write((const char*)toWrite->data, rowBytes * toWrite->rows);
+		else
+		{
+			for(int y = 0; y < toWrite->rows; ++y)
+				this->pixelFile.write((const char*)toWrite->ptr(y), rowBytes);
+		}
+		this->pixelBytes += this->frameBytes;
+	}
+
+	if(!this->pixelFile.good())
+	{
+		this->_SetError("Could not write to " + this->pixelFilename);
+		return false;
+	}
+
+	this->frameInfos.push_back(info);
+	return true;
+}
+
+bool MultiFrameDicomWriter::_AddPerFrameValues()
+{
+	DcmDataset* dicomData = this->header->getDataset();
+	size_t frameCt = this->frameInfos.size();
+
+	dicomData->putAndInsertString(DCM_NumberOfFrames, std::to_string(frameCt).c_str());
+
+	// The multi-frame secondary capture IODs step frames by a frame time.
+	// It's the average, the real times are in the per-frame groups.
+	double frameTimeMS = 0.0;
+	if(frameCt > 1)
+	{
+		frameTimeMS =
+			(double)(this->frameInfos.back().wallUS - this->frameInfos.front().wallUS) /
+			(1000.0 * (double)(frameCt - 1));
+	}
+	std::stringstream sstrmFrameTime;
+	sstrmFrameTime << std::fixed << std::setprecision(3) << frameTimeMS;
+	dicomData->putAndInsertString(DCM_FrameTime, sstrmFrameTime.str().c_str());
+	dicomData->putAndInsertTagKey(DCM_FrameIncrementPointer, DCM_FrameTime);
+
+	DcmSequenceOfItems* perFrameSeq = new DcmSequenceOfItems(DCM_PerFrameFunctionalGroupsSequence);
+	for(size_t i = 0; i < frameCt; ++i)
+	{
+		const FrameInfo& info = this->frameInfos[i];
+
+		DcmItem* frameItem = new DcmItem();
+		perFrameSeq->append(frameItem);
+
+		DcmItem* contentItem;
+		if(!frameItem->findOrCreateSequenceItem(DCM_FrameContentSequence, contentItem, 0).good())
+		{
+			delete perFrameSeq;
+			return false;
+		}
+
+		std::string frameDateTime = DicomMiscUtils::GetDateTimeString(info.wallUS);
+		contentItem->putAndInsertUint16(DCM_FrameAcquisitionNumber, (Uint16)(i + 1));
+		contentItem->putAndInsertString(DCM_FrameAcquisitionDateTime, frameDateTime.c_str());
+		contentItem->putAndInsertString(DCM_FrameReferenceDateTime, frameDateTime.c_str());
+		if(info.exposureUS > 0)
+			contentItem->putAndInsertFloat64(DCM_FrameAcquisitionDuration, (double)info.exposureUS / 1000.0);
+
+		// There's no standard attribute for the lights, so they're noted in
+		// the frame comments with the same names as the raw capture context.
+		std::stringstream sstrmComments;
+		sstrmComments << std::fixed << std::setprecision(3) <<
+			"laser_nir=" << info.laserNIR << "; laser_white=" << info.laserWhite;
+		if(info.epoch >= 0)
+			sstrmComments << "; acquisition_epoch=" << info.epoch;
+		contentItem->putAndInsertString(DCM_FrameComments, sstrmComments.str().c_str());
+	}
+	return dicomData->insert(perFrameSeq, OFTrue).good();
+}
+
+bool MultiFrameDicomWriter::_AppendPixelData()
+{
+	std::ifstream pixelIn(this->pixelFilename, std::ios::binary);
+	std::ofstream dcmOut(this->filename, std::ios::binary | std::ios::app);
+	if(!pixelIn.is_open() || !dcmOut.is_open())
+		return false;
+
+	bool encapsulated = (this->compression != DicomCompress::Method::None);
+
+	// Pixel Data (7FE0,0010), explicit VR little endian, as OB. Compressed
+	// pixel data is an undefined length sequence of items.
+	uint32_t length = 
+		encapsulated ? 
+			0xFFFFFFFF : 
+			(uint32_t)(this->pixelBytes + (this->pixelBytes % 2));
+
+	unsigned char elementHeader[12] =
+	{
+		0xE0, 0x7F, 0x10, 0x00,
+		'O', 'B', 0x00, 0x00,
+		(unsigned char)(length >> 0),
+		(unsigned char)(length >> 8),
+		(unsigned char)(length >> 16),
+		(unsigned char)(length >> 24)
+	};
+	dcmOut.write((const char*)elementHeader, sizeof(elementHeader));
+
+	// An empty basic offset table item.
+	const unsigned char offsetTable[8] = {0xFE, 0xFF, 0x00, 0xE0, 0x00, 0x00, 0x00, 0x00};
+	if(encapsulated)
+		dcmOut.write((const char*)offsetTable, sizeof(offsetTable));
+
+	std::vector<char> buffer(4 * 1024 * 1024);
+	while(pixelIn)
+	{
+		pixelIn.read(buffer.data(), buffer.size());
+		dcmOut.write(buffer.data(), pixelIn.gcount());
+	}
+
+	// The sequence delimitation item (FFFE,E0DD).
+	const unsigned char seqDelimiter[8] = {0xFE, 0xFF, 0xDD, 0xE0, 0x00, 0x00, 0x00, 0x00};
+	if(encapsulated)
+		dcmOut.write((const char*)seqDelimiter, sizeof(seqDelimiter));
+	else if(this->pixelBytes % 2 != 0)
+	{
+		// Values have to be an even length.
+		dcmOut.put(0);
+	}
+
+	return dcmOut.good();
+}
+
+bool MultiFrameDicomWriter::Close()
+{
+	if(!this->IsOpen())
+		return false;
+
+	this->pixelFile.close();
+
+	bool written = false;
+	if(this->frameInfos.empty())
+		this->_SetError("No frames were added to the multi-frame DICOM.");
+	else if(!this->_AddPerFrameValues())
+		this->_SetError("Could not add the per-frame values to the multi-frame DICOM.");
+	else if(!this->header->saveFile(
+		this->filename.c_str(),
+		XferFor(this->compression),
+		EET_UndefinedLength,
+		EGL_withoutGL).good())
+	{
+		this->_SetError("Could not write " + this->filename);
+		std::remove(this->filename.c_str());
+	}
+	else if(!this->_AppendPixelData())
+	{
+		this->_SetError("Could not write the pixel data of " + this->filename);
+		std::remove(this->filename.c_str());
+	}
+	else
+	{
+		written = true;
+		if(this->compression != DicomCompress::Method::None)
+			DicomCompress::AddToTotals(this->compressStats);
+	}
+
+	this->_Discard();
+	return written;
+}
+
+void MultiFrameDicomWriter::_Discard()
+{
+	if(this->pixelFile.is_open())
+		this->pixelFile.close();
+
+	if(!this->pixelFilename.empty())
+		std::remove(this->pixelFilename.c_str());
+
+	this->pixelFilename.clear();
+	this->header.reset();
+}
+
+void MultiFrameDicomWriter::_SetError(const std::string& msg)
+{
+	this->err = msg;
+}
+
+int64_t MultiFrameDicomWriter::SteadyToWallUS(std::chrono::steady_clock::time_point t)
+{
+	std::chrono::system_clock::time_point wallNow = std::chrono::system_clock::now();
+	std::chrono::steady_clock::time_point steadyNow = std::chrono::steady_clock::now();
+
+	std::chrono::system_clock::time_point wall =
+		wallNow - std::chrono::duration_cast<std::chrono::system_clock::duration>(steadyNow - t);
+
+	return std::chrono::duration_cast<std::chrono::microseconds>(wall.time_since_epoch()).count();
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include "DicomCompress.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+
+class IManagedCam;
+class DcmFileFormat;
+
+/// <summary>
+/// Streams frames into a single multi-frame DICOM file, for bursts and
+/// recordings, instead of a single-frame DICOM file per frame.
+///
+/// The header dataset is built once, when the file is opened. Each added
+/// frame's pixels are appended to a pixel file next to the output, so
+/// frames aren't kept in memory; only their per-frame values are. When
+/// the file is closed, the per-frame functional groups (capture time,
+/// exposure and laser state) are added to the header, it's written to
+/// the output, and the pixels are copied in after it.
+///
+/// Pixel data is stored as 8-bit MONOCHROME2 or RGB, either uncompressed, or
+/// RLE or JPEG-LS compressed a frame at a time (see DicomCompress). If the
+/// program wasn't built with JPEG-LS, it's written as RLE instead, see 
+/// Compression(). An uncompressed file can't hold more than maxPixelBytes of
+/// pixel data, see HasRoomForFrame().
+///
+/// A writer is not thread-safe; only one thread at a time should use it.
+/// </summary>
+class MultiFrameDicomWriter
+{
+public:
+	/// <summary>
+	/// The values recorded for each frame.
+	/// </summary>
+	struct FrameInfo
+	{
+		/// <summary>
+		/// When the frame was captured, in microseconds since the Unix epoch.
+		/// </summary>
+		int64_t wallUS = 0;
+
+		/// <summary>
+		/// The CamSyncGroup acquisition epoch, or -1.
+		/// </summary>
+		long long epoch = -1;
+
+		/// <summary>
+		/// The camera's exposure time, in microseconds. 0 if automatic.
+		/// </summary>
+		int exposureUS = 0;
+
+		/// <summary>
+		/// The NIR and white light intensities, from 0.0 (off) to 1.0.
+		/// </summary>
+		float laserNIR = 0.0f;
+		float laserWhite = 0.0f;
+	};
+
+	/// <summary>
+	/// The most pixel data an uncompressed DICOM file can hold, the largest
+	/// even 32-bit length.
+	/// </summary>
+	static const uint64_t maxPixelBytes = 0xFFFFFFFE;
+
+private:
+	/// <summary>
+	/// The output filename, including the ".dcm".
+	/// </summary>
+	std::string filename;
+
+	/// <summary>
+	/// The file the pixel data is appended to until the writer is closed.
+	/// </summary>
+	std::string pixelFilename;
+	std::ofstream pixelFile;
+
+	/// <summary>
+	/// The header dataset, without the pixel data or per-frame values.
+	/// </summary>
+	std::unique_ptr<DcmFileFormat> header;
+
+	cv::Size frameSize;
+	int frameType = -1;
+
+	/// <summary>
+	/// The compression actually used. If not None, the pixel file holds a
+	/// pixel item per frame.
+	/// </summary>
+	DicomCompress::Method compression = DicomCompress::Method::None;
+
+	/// <summary>
+	/// Reused buffer for encoding frames.
+	/// </summary>
+	std::vector<unsigned char> encoded;
+
+	DicomCompress::Stats compressStats;
+
+	/// <summary>
+	/// The bytes of pixel data per frame, after conversion.
+	/// </summary>
+	size_t frameBytes = 0;
+
+	uint64_t pixelBytes = 0;
+
+	std::vector<FrameInfo> frameInfos;
+
+	/// <summary>
+	/// Reused buffer for converting frames to the DICOM pixel layout.
+	/// </summary>
+	cv::Mat converted;
+
+	std::string err;
+
+private:
+	/// <summary>
+	/// Add the frame count and per-frame functional groups to the header.
+	/// </summary>
+	bool _AddPerFrameValues();
+
+	/// <summary>
+	/// Append the pixel data element, and the contents of the pixel file,
+	/// to the end of the written header.
+	/// </summary>
+	bool _AppendPixelData();
+
+	/// <summary>
+	/// Close and delete the pixel file, and release the header.
+	/// </summary>
+	void _Discard();
+
+	void _SetError(const std::string& msg);
+
+public:
+	MultiFrameDicomWriter();
+	~MultiFrameDicomWriter();
+
+	MultiFrameDicomWriter(const MultiFrameDicomWriter&) = delete;
+	MultiFrameDicomWriter& operator=(const MultiFrameDicomWriter&) = delete;
+
+	/// <summary>
+	/// Start a multi-frame DICOM file, discarding any file already open.
+	/// </summary>
+	/// <param name="baseFilename">The filename to save as, without the ".dcm".</param>
+	/// <param name="cam">
+	/// The camera containing extra camera Dicom data. May be nullptr if the
+	/// frames didn't come from a live camera.
+	/// </param>
+	/// <param name="size">The size every frame must be.</param>
+	/// <param name="type">
+	/// The type every frame must be, 8-bit with 1, 3 (BGR) or 4 (BGRA)
+	/// channels.
+	/// </param>
+	/// <param name="qualityLevel">
+	/// The quality governor's level the frames were processed at. Ignored if
+	/// empty.
+	/// </param>
+	/// <param name="extraContext">
+	/// Additional key/value pairs to add to the acquisition context.
+	/// </param>
+	/// <param name="compression">
+	/// The compression of the pixel data. JPEG-LS falls back to RLE if the
+	/// program wasn't built with it.
+	/// </param>
+	/// <returns>False if the file couldn't be started.</returns>
+	bool Open(
+		const std::string& baseFilename,
+		IManagedCam* cam,
+		cv::Size size,
+		int type,
+		const std::string& qualityLevel,
+		const std::vector<std::pair<std::string, std::string>>& extraContext = {},
+		DicomCompress::Method compression = DicomCompress::Method::None);
+
+	/// <summary>
+	/// Append a frame.
+	/// </summary>
+	/// <returns>
+	/// False if the writer isn't open, the frame doesn't match the size and
+	/// type it was opened with, the file is full, or the frame couldn't be
+	/// written.
+	/// </returns>
+	bool AddFrame(const cv::Mat& frame, const FrameInfo& info);
+
+	/// <summary>
+	/// Write the DICOM file. If no frames were added, nothing is written.
+	/// </summary>
+	/// <returns>True if the file was written.</returns>
+	bool Close();
+
+	inline bool IsOpen() const
+	{ return this->header != nullptr; }
+
+	inline int FrameCt() const
+	{ return (int)this->frameInfos.size(); }
+
+	inline const std::string& Filename() const
+	{ return this->filename; }
+
+	/// <summary>
+	/// The compression the file was opened with, after any fallback.
+	/// </summary>
+	inline DicomCompress::Method Compression() const
+	{ return this->compression; }
+
+	/// <summary>
+	/// Check if another frame fits in the file. If not, the caller should
+	/// close it and continue in another file. Compressed files have no limit.
+	/// </summary>
+	inline bool HasRoomForFrame() const
+	{ 
+		return 
+			this->compression != DicomCompress::Method::None || 
+			this->pixelBytes + this->frameBytes <= maxPixelBytes; 
+	}
+
+	/// <summary>
+	/// Get the reason the last operation failed, or an empty string.
+	/// </summary>
+	inline const std::string& GetError() const
+	{ return this->err; }
+
+	/// <summary>
+	/// Convert a steady clock time to microseconds since the Unix epoch,
+	/// assuming the clocks haven't drifted since the time.
+	/// </summary>
+	static int64_t SteadyToWallUS(std::chrono::steady_clock::time_point t);
+};
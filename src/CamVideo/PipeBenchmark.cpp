@@ -0,0 +1,147 @@
+#include "PipeBenchmark.h"
+#include "CamImpl/CamImpl_Pipe.h"
+#include "../Utils/cvgStopwatchLeft.h"
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <iomanip>
+
+namespace
+{
+	typedef std::chrono::steady_clock BenchClock;
+
+	const int frameWidth	= 1280;
+	const int frameHeight	= 720;
+	const int frameChans	= 3;
+
+	// How often the generator exits, to include restarting in the results.
+	const int secondsPerRestart = 5;
+
+	// Stamps further off than this are from a different clock, or a frame
+	// that's out of sync.
+	const double maxStampLatencyMS = 10000.0;
+
+#if _WIN32
+	const char* pythonCmd = "python";
+#else
+	const char* pythonCmd = "python3";
+#endif
+
+	/// <summary>
+	/// Get the time the generator wrote the frame, stamped into its
+	/// first 8 bytes.
+	/// </summary>
+	long long ReadStampNS(const cv::Mat& frame)
+	{
+		unsigned long long stamp = 0;
+		for(int i = 7; i >= 0; --i)
+			stamp = (stamp << 8) | frame.data[i];
+
+		return (long long)stamp;
+	}
+}
+
+bool PipeBenchmark::Run(std::ostream& os, int seconds, double fps)
+{
+	std::stringstream cmd;
+	cmd << pythonCmd << " pipe_testgen.py" <<
+		" --width "			<< frameWidth <<
+		" --height "		<< frameHeight <<
+		" --chans "			<< frameChans <<
+		" --fps "			<< fps <<
+		" --exit-after "	<< (int)(fps * secondsPerRestart) <<
+		" --stamp";
+
+	cvgCamFeedLocs opts;
+	opts.externalPipeCmd	= cmd.str();
+	opts.pipeWidth			= frameWidth;
+	opts.pipeHeight			= frameHeight;
+	opts.channelCtFromPipe	= frameChans;
+	opts.streamFPS			= fps;
+	opts.flipHorizontal		= false;
+	opts.flipVertical		= false;
+
+	os << "Benchmarking an external pipe at " << frameWidth << "x" << frameHeight << "x" << frameChans <<
+		", " << fps << " FPS, for " << seconds << " seconds." << std::endl;
+	os << "\t" << opts.externalPipeCmd << std::endl;
+
+	CamImpl_Pipe pipe("");
+	pipe.Initialize();
+	pipe.PullOptions(opts);
+	if(!pipe.Activate())
+	{
+		os << "Could not start the generator." << std::endl;
+		return false;
+	}
+
+	long long polledCt = 0;
+	long long unstampedCt = 0;
+	std::vector<double> latencies;
+
+	BenchClock::time_point start = BenchClock::now();
+	BenchClock::time_point end = start + std::chrono::seconds(seconds);
+
+	// Polled the same way as ManagedCam's polling loop.
+	cvgStopwatchLeft swLoopSleep;
+	while(BenchClock::now() < end)
+	{
+		cv::Ptr<cv::Mat> frame = pipe.PollFrame();
+		if(frame == nullptr || frame->empty())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
+		}
+
+		long long nowNS =
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+				BenchClock::now().time_since_epoch()).count();
+
+		++polledCt;
+		double latencyMS = (double)(nowNS - ReadStampNS(*frame)) / 1000000.0;
+		if(latencyMS >= 0.0 && latencyMS < maxStampLatencyMS)
+			latencies.push_back(latencyMS);
+		else
+			++unstampedCt;
+
+		frame = nullptr;
+		std::this_thread::sleep_for(std::chrono::milliseconds(std::max(swLoopSleep.MSLeftForFPS(fps), 2)));
+	}
+
+	double elapsedSec = std::chrono::duration<double>(BenchClock::now() - start).count();
+	CamImpl_Pipe::PipeStats stats = pipe.GetStats();
+	pipe.Deactivate();
+	pipe.Shutdown();
+
+	os << std::fixed << std::setprecision(2);
+	os << "\tRead - Frames: " << stats.frameCt <<
+		" - FPS: " << (double)stats.frameCt / elapsedSec <<
+		" - MB/s: " << (double)stats.bytesRead / elapsedSec / (1024.0 * 1024.0) << std::endl;
+
+	os << "\tPolled - Frames: " << polledCt <<
+		" - FPS: " << (double)polledCt / elapsedSec <<
+		" - Skipped: " << stats.skippedCt << std::endl;
+
+	if(!latencies.empty())
+	{
+		std::sort(latencies.begin(), latencies.end());
+		double total = 0.0;
+		for(double ms : latencies)
+			total += ms;
+
+		os << "\tLatency - Avg MS: " << total / (double)latencies.size() <<
+			" - Median MS: " << latencies[latencies.size() / 2] <<
+			" - P95 MS: " << latencies[(latencies.size() * 95) / 100] <<
+			" - Max MS: " << latencies.back() << std::endl;
+	}
+	os << "\tUnstamped frames: " << unstampedCt << std::endl;
+
+	os << "\tRestarts: " << stats.restartCt <<
+		" - Partial frames: " << stats.partialCt <<
+		" - Unpooled buffers: " << stats.unpooledCt << std::endl;
+
+	return true;
+}
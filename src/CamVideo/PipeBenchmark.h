@@ -0,0 +1,30 @@
+#pragma once
+
+#include <ostream>
+
+/// <summary>
+/// A benchmark of the External poll type (CamImpl_Pipe), streaming from the
+/// synthetic generator script, pipe_testgen.py, in the working directory.
+///
+/// The generator streams 1280x720 BGR frames, stamped with when they were
+/// written, and exits every few seconds to also measure restarting. Frames
+/// are polled the same way a camera thread would, and the throughput and
+/// latency (from the generator writing a frame, to it being polled) are
+/// reported. Latency is only measured on Linux, where the generator's clock
+/// is the same as ours.
+///
+/// Run with the --benchmark-pipe command line option, and optionally
+/// --benchmark-fps to test a higher frame rate.
+/// </summary>
+class PipeBenchmark
+{
+public:
+	/// <summary>
+	/// Run the benchmark and print the results.
+	/// </summary>
+	/// <param name="os">The stream to print the results to.</param>
+	/// <param name="seconds">How long to stream for.</param>
+	/// <param name="fps">The frame rate to generate and poll frames at.</param>
+	/// <returns>False if the generator couldn't be started.</returns>
+	static bool Run(std::ostream& os, int seconds, double fps = 30.0);
+};
@@ -0,0 +1,211 @@
+#include "RawCaptureConvert.h"
+#include "RawCaptureReader.h"
+#include "IManagedCam.h"
+#include "MultiFrameDicomWriter.h"
+#include "DicomCompress.h"
+#include "CaptureStorage.h"
+#include <opencv2/videoio.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <iostream>
+#include <cmath>
+
+bool RawCaptureConvert::ToVideo(const std::string& rawDir, const std::string& videoPath)
+{
+	RawCaptureReader reader;
+	if(!reader.Open(rawDir))
+		return false;
+
+	size_t frameCt = reader.FrameCount();
+	if(frameCt == 0)
+	{
+		std::cout << "Raw capture " << rawDir << " has no frames to convert." << std::endl;
+		return false;
+	}
+
+	int64_t firstUS	= reader.FrameCaptureUS(0);
+	int64_t lastUS	= reader.FrameCaptureUS(frameCt - 1);
+
+	double fps = 30.0;
+	if(frameCt > 1 && lastUS > firstUS)
+		fps = (double)(frameCt - 1) * 1000000.0 / (double)(lastUS - firstUS);
+
+	const RawRecordingHeader& header = reader.Header();
+	cv::VideoWriter writer;
+	int mp4FourCC = cv::VideoWriter::fourcc('a', 'v', 'c', '1');
+	writer.open(videoPath, mp4FourCC, fps, cv::Size(header.width, header.height), header.channels != 1);
+	if(!writer.isOpened())
+	{
+		std::cout << "Could not open video file " << videoPath << std::endl;
+		return false;
+	}
+
+	// Each output frame shows the last frame captured by its time, the
+	// same as a live recording would have.
+	double usPerFrame = 1000000.0 / fps;
+	size_t outCt = (size_t)std::llround((double)(lastUS - firstUS) / usPerFrame) + 1;
+	for(size_t i = 0; i < outCt; ++i)
+	{
+		int64_t outUS = firstUS + (int64_t)std::llround(i * usPerFrame);
+
+		RawFrameHeader frameHeader;
+		cv::Mat frame;
+		if(!reader.GetFrame(reader.FindFrameAt(outUS), frameHeader, frame))
+		{
+			std::cout << "Could not read a frame of raw capture " << rawDir << std::endl;
+			return false;
+		}
+		writer.write(frame);
+	}
+
+	std::cout << "Converted " << frameCt << " raw frames to " << outCt << " video frames at " << fps << " FPS." << std::endl;
+	return true;
+}
+
+bool RawCaptureConvert::ToDicom(const std::string& rawDir, const std::string& dicomDir)
+{
+	RawCaptureReader reader;
+	if(!reader.Open(rawDir))
+		return false;
+
+	boost::system::error_code ec;
+	boost::filesystem::create_directories(dicomDir, ec);
+	if(!boost::filesystem::is_directory(dicomDir))
+	{
+		std::cout << "Could not create DICOM directory " << dicomDir << std::endl;
+		return false;
+	}
+
+	long long errorsBefore = CaptureStorage::GetInstance().GetStats().errorCt;
+
+	const RawRecordingHeader& header = reader.Header();
+	for(size_t i = 0; i < reader.FrameCount(); ++i)
+	{
+		RawFrameHeader frameHeader;
+		cv::Mat frame;
+		if(!reader.GetFrame(i, frameHeader, frame))
+		{
+			std::cout << "Could not read frame " << i << " of raw capture " << rawDir << std::endl;
+			return false;
+		}
+
+		std::vector<std::pair<std::string, std::string>> context =
+		{
+			{"camera_id",	std::to_string(header.camId)},
+			{"sequence",	std::to_string(frameHeader.sequence)},
+			{"capture_us",	std::to_string(frameHeader.captureUS)},
+			{"exposure_us",	std::to_string(frameHeader.exposureUS)},
+			{"threshold",	std::to_string(frameHeader.threshold)},
+			{"laser_nir",	std::to_string(frameHeader.laserNIR)},
+			{"laser_white",	std::to_string(frameHeader.laserWhite)}
+		};
+
+		// The DICOM encoder needs a frame it can own.
+		cv::Ptr<cv::Mat> owned = new cv::Mat(frame.clone());
+
+		char frameName[32];
+		snprintf(frameName, sizeof(frameName), "frame_%06d", (int)i);
+		std::string basePath = (boost::filesystem::path(dicomDir) / frameName).string();
+		if(!SaveMatAsDicomBmp(owned, nullptr, basePath, std::string(), -1, context))
+		{
+			std::cout << "Could not save DICOM " << basePath << std::endl;
+			return false;
+		}
+	}
+
+	// The files are written behind the conversion, make sure they all were.
+	CaptureStorage& storage = CaptureStorage::GetInstance();
+	storage.WaitIdle();
+	if(storage.GetStats().errorCt != errorsBefore)
+	{
+		std::cout << "Could not write every DICOM file to " << dicomDir << std::endl;
+		return false;
+	}
+
+	std::cout << "Converted " << reader.FrameCount() << " raw frames to DICOM files in " << dicomDir << std::endl;
+	return true;
+}
+
+bool RawCaptureConvert::ToMultiFrameDicom(const std::string& rawDir, const std::string& dicomPath)
+{
+	RawCaptureReader reader;
+	if(!reader.Open(rawDir))
+		return false;
+
+	if(reader.FrameCount() == 0)
+	{
+		std::cout << "Raw capture " << rawDir << " has no frames to convert." << std::endl;
+		return false;
+	}
+
+	const RawRecordingHeader& header = reader.Header();
+	std::string basePath = (boost::filesystem::path(dicomPath).parent_path() / boost::filesystem::path(dicomPath).stem()).string();
+	std::vector<std::pair<std::string, std::string>> context = 
+		{{"camera_id", std::to_string(header.camId)}};
+
+	MultiFrameDicomWriter writer;
+	int fileCt = 0;
+	for(size_t i = 0; i < reader.FrameCount(); ++i)
+	{
+		RawFrameHeader frameHeader;
+		cv::Mat frame;
+		if(!reader.GetFrame(i, frameHeader, frame))
+		{
+			std::cout << "Could not read frame " << i << " of raw capture " << rawDir << std::endl;
+			return false;
+		}
+
+		if(writer.IsOpen() && !writer.HasRoomForFrame())
+		{
+			if(!writer.Close())
+			{
+				std::cout << "Could not save DICOM " << writer.Filename() << ": " << writer.GetError() << std::endl;
+				return false;
+			}
+		}
+
+		if(!writer.IsOpen())
+		{
+			std::string filePath = (fileCt == 0) ? basePath : basePath + "_" + std::to_string(fileCt);
+			++fileCt;
+
+			if(!writer.Open(filePath, nullptr, frame.size(), frame.type(), std::string(), context, DicomCompress::GetMethod()))
+			{
+				std::cout << "Could not start DICOM " << filePath << ": " << writer.GetError() << std::endl;
+				return false;
+			}
+		}
+
+		MultiFrameDicomWriter::FrameInfo info;
+		info.wallUS		= header.startWallUS + (frameHeader.captureUS - header.startSteadyUS);
+		info.exposureUS	= frameHeader.exposureUS;
+		info.laserNIR	= frameHeader.laserNIR;
+		info.laserWhite	= frameHeader.laserWhite;
+		if(!writer.AddFrame(frame, info))
+		{
+			std::cout << "Could not add frame " << i << " to DICOM " << writer.Filename() << ": " << writer.GetError() << std::endl;
+			return false;
+		}
+	}
+
+	if(!writer.Close())
+	{
+		std::cout << "Could not save DICOM " << writer.Filename() << ": " << writer.GetError() << std::endl;
+		return false;
+	}
+
+	std::cout << "Converted " << reader.FrameCount() << " raw frames to " << fileCt << " multi-frame DICOM file(s) at " << dicomPath << std::endl;
+	return true;
+}
+
+bool RawCaptureConvert::Convert(const std::string& rawDir, const std::string& outPath)
+{
+	std::string ext = boost::algorithm::to_lower_copy(boost::filesystem::path(outPath).extension().string());
+	if(ext == ".mp4" || ext == ".mkv")
+		return ToVideo(rawDir, outPath);
+
+	if(ext == ".dcm")
+		return ToMultiFrameDicom(rawDir, outPath);
+
+	return ToDicom(rawDir, outPath);
+}
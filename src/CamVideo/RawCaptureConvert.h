@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+
+/// <summary>
+/// Converts raw capture recordings (see RawCaptureWriter) into formats for
+/// viewing and archiving.
+/// </summary>
+class RawCaptureConvert
+{
+public:
+	/// <summary>
+	/// Convert a recording to a compressed video file.
+	///
+	/// The video's frame rate is the recording's average frame rate. Frames
+	/// are placed by their capture times, so gaps in the recording are filled
+	/// by repeating the frame before them.
+	/// </summary>
+	/// <param name="rawDir">The recording's directory.</param>
+	/// <param name="videoPath">The video file to write.</param>
+	/// <returns>True if the video was written.</returns>
+	static bool ToVideo(const std::string& rawDir, const std::string& videoPath);
+
+	/// <summary>
+	/// Convert every frame of a recording to a DICOM file. The frame's
+	/// header values are stored in the DICOM's acquisition context.
+	/// </summary>
+	/// <param name="rawDir">The recording's directory.</param>
+	/// <param name="dicomDir">
+	/// The directory to write the DICOM files to. It's created if it doesn't
+	/// exist.
+	/// </param>
+	/// <returns>True if every frame was written.</returns>
+	static bool ToDicom(const std::string& rawDir, const std::string& dicomDir);
+
+	/// <summary>
+	/// Convert a recording to a multi-frame DICOM file (see
+	/// MultiFrameDicomWriter), with each frame's header values in its
+	/// per-frame functional groups.
+	///
+	/// Frames are streamed from the recording, so it's never all in memory.
+	/// If the recording is too large for one file, it continues in files
+	/// numbered with "_1", "_2", etc.
+	/// </summary>
+	/// <param name="rawDir">The recording's directory.</param>
+	/// <param name="dicomPath">The DICOM file to write, ending in ".dcm".</param>
+	/// <returns>True if every frame was written.</returns>
+	static bool ToMultiFrameDicom(const std::string& rawDir, const std::string& dicomPath);
+
+	/// <summary>
+	/// Convert a recording to a video if the output path has a video file
+	/// extension (.mp4 or .mkv), to a multi-frame DICOM if it ends in .dcm,
+	/// else to a directory of DICOM files.
+	/// </summary>
+	static bool Convert(const std::string& rawDir, const std::string& outPath);
+};
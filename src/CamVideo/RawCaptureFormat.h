@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <cstdio>
+
+// The on-disk layout of raw capture recordings. See RawCaptureWriter and
+// RawCaptureReader.
+//
+// A recording is a directory containing:
+// - index.bin: A RawRecordingHeader, followed by a RawIndexEntry for
+//   every frame, in the order they were written.
+// - chunk_NNNN.bin: Frame records, back to back, each starting at a
+//   multiple of rawFrameAlign. A frame record is a RawFrameHeader,
+//   followed by the frame's rows of pixels with no padding. Chunks are
+//   preallocated, and truncated to what was used when they're finished,
+//   so an unfinished chunk ends in zeros.
+//
+// All values are little endian.
+
+const uint32_t rawRecordingMagic	= 0x52475643;	// "CVGR"
+const uint32_t rawFrameMagic		= 0x46475643;	// "CVGF"
+const uint32_t rawFormatVersion		= 1;
+
+/// <summary>
+/// The alignment of frame records in a chunk.
+/// </summary>
+const size_t rawFrameAlign = 64;
+
+const char* const szRawIndexFilename = "index.bin";
+
+inline std::string RawChunkFilename(int chunkIdx)
+{
+	char buf[32];
+	snprintf(buf, sizeof(buf), "chunk_%04d.bin", chunkIdx);
+	return buf;
+}
+
+#pragma pack(push, 1)
+
+/// <summary>
+/// The header at the start of a recording's index file.
+/// </summary>
+struct RawRecordingHeader
+{
+	uint32_t magic			= rawRecordingMagic;
+	uint32_t version		= rawFormatVersion;
+
+	/// <summary>
+	/// The dimensions of every frame. The pixels are 8 bits per channel,
+	/// with 1 channel for greyscale (e.g., NIR), or 3 channels for BGR.
+	/// </summary>
+	int32_t width			= 0;
+	int32_t height			= 0;
+	int32_t channels		= 0;
+
+	/// <summary>
+	/// The ID of the camera that was recorded.
+	/// </summary>
+	int32_t camId			= -1;
+
+	/// <summary>
+	/// When the recording started, as microseconds since the Unix epoch,
+	/// and as microseconds of the steady clock. Frame capture times are
+	/// in the steady clock, so these relate them to the wall clock.
+	/// </summary>
+	int64_t startWallUS		= 0;
+	int64_t startSteadyUS	= 0;
+
+	/// <summary>
+	/// The size chunk files were preallocated at.
+	/// </summary>
+	uint64_t chunkBytes		= 0;
+
+	/// <summary>
+	/// The number of frames in the recording. Only set once the recording
+	/// is closed; if it's 0, the recording was interrupted and the index
+	/// may be missing its last entries.
+	/// </summary>
+	uint64_t frameCt		= 0;
+
+	uint8_t reserved[64]	= {};
+};
+
+/// <summary>
+/// The header of a frame record in a chunk.
+/// </summary>
+struct RawFrameHeader
+{
+	uint32_t magic			= rawFrameMagic;
+
+	/// <summary>
+	/// The size of this header, to allow it to grow in later versions.
+	/// </summary>
+	uint32_t headerBytes	= sizeof(RawFrameHeader);
+
+	/// <summary>
+	/// The frame's position in the recording, starting at 0.
+	/// </summary>
+	uint64_t sequence		= 0;
+
+	/// <summary>
+	/// When the frame was captured, in microseconds of the steady clock.
+	/// </summary>
+	int64_t captureUS		= 0;
+
+	int32_t width			= 0;
+	int32_t height			= 0;
+	int32_t channels		= 0;
+
+	/// <summary>
+	/// The camera's exposure time, in microseconds. 0 if automatic.
+	/// </summary>
+	int32_t exposureUS		= 0;
+
+	/// <summary>
+	/// The threshold the camera's image processing used for the frame, or
+	/// negative if the frame wasn't thresholded.
+	/// </summary>
+	float threshold			= -1.0f;
+
+	/// <summary>
+	/// The NIR and white light intensities, from 0.0 (off) to 1.0.
+	/// </summary>
+	float laserNIR			= 0.0f;
+	float laserWhite		= 0.0f;
+
+	/// <summary>
+	/// The size of the pixel data following the header.
+	/// </summary>
+	uint32_t dataBytes		= 0;
+
+	uint32_t reserved[2]	= {};
+};
+
+/// <summary>
+/// An entry in a recording's index, to find a frame without scanning the
+/// chunks.
+/// </summary>
+struct RawIndexEntry
+{
+	uint64_t sequence		= 0;
+	int64_t captureUS		= 0;
+	uint32_t chunk			= 0;
+	uint32_t reserved		= 0;
+
+	/// <summary>
+	/// The offset of the frame's RawFrameHeader in its chunk.
+	/// </summary>
+	uint64_t offset			= 0;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(RawRecordingHeader)	== 120, "RawRecordingHeader is part of the file format.");
+static_assert(sizeof(RawFrameHeader)		== 64,	"RawFrameHeader is part of the file format.");
+static_assert(sizeof(RawIndexEntry)			== 32,	"RawIndexEntry is part of the file format.");
+
+/// <summary>
+/// Round a size up to the alignment of frame records.
+/// </summary>
+inline size_t RawAlignUp(size_t bytes)
+{
+	return (bytes + rawFrameAlign - 1) / rawFrameAlign * rawFrameAlign;
+}
@@ -0,0 +1,172 @@
+#include "RawCaptureReader.h"
+#include <boost/filesystem.hpp>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+RawCaptureReader::RawCaptureReader()
+{}
+
+RawCaptureReader::~RawCaptureReader()
+{
+	this->Close();
+}
+
+bool RawCaptureReader::Open(const std::string& dirPath)
+{
+	this->Close();
+
+	boost::filesystem::path indexPath = boost::filesystem::path(dirPath) / szRawIndexFilename;
+	FILE* indexFile = fopen(indexPath.string().c_str(), "rb");
+	if(indexFile == nullptr)
+	{
+		std::cout << "Could not open raw capture index " << indexPath.string() << std::endl;
+		return false;
+	}
+
+	if(
+		fread(&this->header, sizeof(this->header), 1, indexFile) != 1 ||
+		this->header.magic != rawRecordingMagic)
+	{
+		std::cout << "Raw capture index " << indexPath.string() << " is not a raw capture recording." << std::endl;
+		fclose(indexFile);
+		return false;
+	}
+
+	if(this->header.version > rawFormatVersion)
+	{
+		std::cout << "Raw capture " << dirPath << " is from a newer version, and can't be read." << std::endl;
+		fclose(indexFile);
+		return false;
+	}
+
+	RawIndexEntry entry;
+	while(fread(&entry, sizeof(entry), 1, indexFile) == 1)
+		this->index.push_back(entry);
+	fclose(indexFile);
+
+	this->dirPath = dirPath;
+
+	// A frame count is only written once the recording is closed. If it's
+	// missing or doesn't match, the index can't be trusted to have every
+	// frame.
+	if(this->header.frameCt == 0 || this->header.frameCt != this->index.size())
+	{
+		std::cout << "Raw capture " << dirPath << " was not closed properly, rebuilding its index." << std::endl;
+		this->_RebuildIndex();
+		this->recovered = true;
+	}
+
+	return true;
+}
+
+void RawCaptureReader::Close()
+{
+	this->dirPath.clear();
+	this->header = RawRecordingHeader();
+	this->index.clear();
+	this->chunks.clear();
+	this->recovered = false;
+}
+
+cvgMappedFile* RawCaptureReader::_GetChunk(uint32_t chunkIdx)
+{
+	if(chunkIdx >= this->chunks.size())
+		this->chunks.resize(chunkIdx + 1);
+
+	if(this->chunks[chunkIdx] == nullptr)
+	{
+		boost::filesystem::path chunkPath = boost::filesystem::path(this->dirPath) / RawChunkFilename(chunkIdx);
+
+		std::unique_ptr<cvgMappedFile> chunk = std::make_unique<cvgMappedFile>();
+		if(!chunk->Open(chunkPath.string()))
+			return nullptr;
+
+		this->chunks[chunkIdx] = std::move(chunk);
+	}
+	return this->chunks[chunkIdx].get();
+}
+
+bool RawCaptureReader::_IsValidRecord(const cvgMappedFile& chunk, uint64_t offset, RawFrameHeader& outHeader) const
+{
+	if(offset + sizeof(RawFrameHeader) > chunk.Size())
+		return false;
+
+	memcpy(&outHeader, chunk.Data() + offset, sizeof(RawFrameHeader));
+	if(outHeader.magic != rawFrameMagic || outHeader.headerBytes < sizeof(RawFrameHeader))
+		return false;
+
+	uint64_t expectedBytes = (uint64_t)outHeader.width * outHeader.height * outHeader.channels;
+	if(outHeader.width <= 0 || outHeader.height <= 0 || outHeader.dataBytes != expectedBytes)
+		return false;
+
+	return offset + outHeader.headerBytes + outHeader.dataBytes <= chunk.Size();
+}
+
+void RawCaptureReader::_RebuildIndex()
+{
+	this->index.clear();
+
+	for(uint32_t chunkIdx = 0; ; ++chunkIdx)
+	{
+		cvgMappedFile* chunk = this->_GetChunk(chunkIdx);
+		if(chunk == nullptr)
+			break;
+
+		// Records are back to back, so the scan stops at the first gap, which
+		// is the unwritten end of the chunk.
+		uint64_t offset = 0;
+		RawFrameHeader frameHeader;
+		while(this->_IsValidRecord(*chunk, offset, frameHeader))
+		{
+			RawIndexEntry entry;
+			entry.sequence	= frameHeader.sequence;
+			entry.captureUS	= frameHeader.captureUS;
+			entry.chunk		= chunkIdx;
+			entry.offset	= offset;
+			this->index.push_back(entry);
+
+			if(this->header.width == 0)
+			{
+				this->header.width		= frameHeader.width;
+				this->header.height		= frameHeader.height;
+				this->header.channels	= frameHeader.channels;
+			}
+
+			offset += RawAlignUp(frameHeader.headerBytes + frameHeader.dataBytes);
+		}
+	}
+
+	this->header.frameCt = this->index.size();
+}
+
+bool RawCaptureReader::GetFrame(size_t frameIdx, RawFrameHeader& outHeader, cv::Mat& outFrame)
+{
+	if(frameIdx >= this->index.size())
+		return false;
+
+	const RawIndexEntry& entry = this->index[frameIdx];
+	cvgMappedFile* chunk = this->_GetChunk(entry.chunk);
+	if(chunk == nullptr || !this->_IsValidRecord(*chunk, entry.offset, outHeader))
+		return false;
+
+	// The mapping is read-only, the Mat is only a view of it.
+	unsigned char* pixels = const_cast<unsigned char*>(chunk->Data() + entry.offset + outHeader.headerBytes);
+	outFrame = cv::Mat(outHeader.height, outHeader.width, CV_8UC(outHeader.channels), pixels);
+	return true;
+}
+
+size_t RawCaptureReader::FindFrameAt(int64_t captureUS) const
+{
+	std::vector<RawIndexEntry>::const_iterator it =
+		std::upper_bound(
+			this->index.begin(),
+			this->index.end(),
+			captureUS,
+			[](int64_t us, const RawIndexEntry& e){ return us < e.captureUS; });
+
+	if(it == this->index.begin())
+		return 0;
+
+	return (size_t)(it - this->index.begin()) - 1;
+}
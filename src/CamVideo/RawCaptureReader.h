@@ -0,0 +1,115 @@
+#pragma once
+
+#include "RawCaptureFormat.h"
+#include "../Utils/cvgMappedFile.h"
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+
+/// <summary>
+/// Reads recordings made by RawCaptureWriter.
+///
+/// Chunks are memory mapped as frames in them are read, and frames are
+/// returned as views of the mapping, without copying.
+///
+/// If the recording wasn't closed properly (e.g., the app crashed or lost
+/// power), the index is rebuilt by scanning the chunks for frame records.
+/// </summary>
+class RawCaptureReader
+{
+private:
+	std::string dirPath;
+
+	RawRecordingHeader header;
+
+	std::vector<RawIndexEntry> index;
+
+	/// <summary>
+	/// The chunks that have been mapped, by chunk index. Entries are
+	/// nullptr until a frame in the chunk is read.
+	/// </summary>
+	std::vector<std::unique_ptr<cvgMappedFile>> chunks;
+
+	/// <summary>
+	/// If true, the index was rebuilt from the chunks.
+	/// </summary>
+	bool recovered = false;
+
+private:
+	/// <summary>
+	/// Get the mapping of a chunk, mapping it if it hasn't been yet.
+	/// </summary>
+	/// <returns>The mapped chunk, or nullptr if it couldn't be mapped.</returns>
+	cvgMappedFile* _GetChunk(uint32_t chunkIdx);
+
+	/// <summary>
+	/// Rebuild the index by scanning every chunk for frame records.
+	/// </summary>
+	void _RebuildIndex();
+
+	/// <summary>
+	/// Check if a frame record at an offset of a chunk is complete.
+	/// </summary>
+	bool _IsValidRecord(const cvgMappedFile& chunk, uint64_t offset, RawFrameHeader& outHeader) const;
+
+public:
+	RawCaptureReader();
+	~RawCaptureReader();
+
+	RawCaptureReader(const RawCaptureReader&) = delete;
+	RawCaptureReader& operator=(const RawCaptureReader&) = delete;
+
+	/// <summary>
+	/// Open a recording, closing any recording already open.
+	/// </summary>
+	/// <param name="dirPath">The recording's directory.</param>
+	/// <returns>False if the recording couldn't be read.</returns>
+	bool Open(const std::string& dirPath);
+
+	void Close();
+
+	inline size_t FrameCount() const
+	{ return this->index.size(); }
+
+	inline const RawRecordingHeader& Header() const
+	{ return this->header; }
+
+	/// <summary>
+	/// If true, the recording wasn't closed properly, and its index was
+	/// rebuilt from its chunks.
+	/// </summary>
+	inline bool WasRecovered() const
+	{ return this->recovered; }
+
+	/// <summary>
+	/// Read a frame.
+	/// </summary>
+	/// <param name="frameIdx">The index of the frame, from 0 to FrameCount().</param>
+	/// <param name="outHeader">Output parameter. The frame's header.</param>
+	/// <param name="outFrame">
+	/// Output parameter. The frame's pixels. This is a view of the mapped
+	/// chunk that's only valid while the reader is open, and must not be
+	/// modified. Clone it to keep it.
+	/// </param>
+	/// <returns>False if the frame couldn't be read.</returns>
+	bool GetFrame(size_t frameIdx, RawFrameHeader& outHeader, cv::Mat& outFrame);
+
+	/// <summary>
+	/// Find the last frame captured at, or before, a time.
+	/// </summary>
+	/// <param name="captureUS">
+	/// The time, in the same steady clock microseconds as RawFrameHeader::captureUS.
+	/// </param>
+	/// <returns>
+	/// The index of the frame. If the time is before the first frame, the
+	/// first frame is returned.
+	/// </returns>
+	size_t FindFrameAt(int64_t captureUS) const;
+
+	/// <summary>
+	/// Get the capture time of a frame, from the index.
+	/// </summary>
+	inline int64_t FrameCaptureUS(size_t frameIdx) const
+	{ return this->index[frameIdx].captureUS; }
+};
@@ -0,0 +1,348 @@
+#include "RawCaptureWriter.h"
+#include "CaptureStorage.h"
+#include <boost/filesystem.hpp>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+std::atomic<float> RawCaptureWriter::lightNIR = 0.0f;
+std::atomic<float> RawCaptureWriter::lightWhite = 0.0f;
+
+static long long MicrosecondsSinceEpoch(std::chrono::steady_clock::time_point tp)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(tp.time_since_epoch()).count();
+}
+
+RawCaptureWriter::RawCaptureWriter()
+{}
+
+RawCaptureWriter::~RawCaptureWriter()
+{
+	this->Close();
+}
+
+bool RawCaptureWriter::Open(const std::string& dirPath, int camId, size_t chunkBytes)
+{
+	this->Close();
+
+	boost::system::error_code ec;
+	boost::filesystem::create_directories(dirPath, ec);
+	if(!boost::filesystem::is_directory(dirPath))
+	{
+		std::cout << "Could not create raw capture directory " << dirPath << std::endl;
+		return false;
+	}
+
+	boost::filesystem::path indexPath = boost::filesystem::path(dirPath) / szRawIndexFilename;
+	this->indexFile = fopen(indexPath.string().c_str(), "wb");
+	if(this->indexFile == nullptr)
+	{
+		std::cout << "Could not create raw capture index " << indexPath.string() << std::endl;
+		return false;
+	}
+
+	this->dirPath		= dirPath;
+	this->chunkBytes	= RawAlignUp(chunkBytes);
+	this->curChunkIdx	= -1;
+	this->curChunkUsed	= 0;
+
+	this->header				= RawRecordingHeader();
+	this->header.camId			= camId;
+	this->header.chunkBytes		= this->chunkBytes;
+	this->header.startWallUS	=
+		std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+	this->header.startSteadyUS	= MicrosecondsSinceEpoch(std::chrono::steady_clock::now());
+	this->_WriteHeader();
+
+	{
+		std::lock_guard<std::mutex> guard(this->queueMutex);
+		this->queue.clear();
+		this->width		= -1;
+		this->height	= -1;
+		this->channels	= -1;
+		this->err.clear();
+		this->stats		= Stats();
+	}
+
+	this->writeRunning = true;
+	this->writeThread = std::thread([this]{ this->_WriteThreadFn(); });
+	return true;
+}
+
+bool RawCaptureWriter::Submit(cv::Ptr<cv::Mat> frame, const FrameInfo& info)
+{
+	if(!this->writeRunning || frame == nullptr || frame->empty())
+		return false;
+
+	std::unique_lock<std::mutex> lock(this->queueMutex);
+	if(!this->err.empty())
+		return false;
+
+	if(frame->depth() != CV_8U || (frame->channels() != 1 && frame->channels() != 3))
+	{
+		this->err = "Raw capture only supports 8 bit frames with 1 or 3 channels.";
+		return false;
+	}
+
+	if(this->width == -1)
+	{
+		this->width		= frame->cols;
+		this->height	= frame->rows;
+		this->channels	= frame->channels();
+	}
+	else if(
+		frame->cols			!= this->width	||
+		frame->rows			!= this->height	||
+		frame->channels()	!= this->channels)
+	{
+		this->err = "Frame dimensions changed during the raw capture.";
+		return false;
+	}
+
+	if(this->queue.size() >= maxQueuedFrames)
+	{
+		++this->stats.droppedCt;
+		return true;
+	}
+
+	QueuedFrame qf;
+	qf.frame		= frame;
+	qf.info			= info;
+	qf.laserNIR		= lightNIR;
+	qf.laserWhite	= lightWhite;
+	this->queue.push_back(qf);
+
+	lock.unlock();
+	this->queueCond.notify_one();
+	return true;
+}
+
+void RawCaptureWriter::Close()
+{
+	if(!this->writeRunning)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(this->queueMutex);
+		this->writeRunning = false;
+	}
+	this->queueCond.notify_all();
+	this->writeThread.join();
+
+	if(this->curChunk != nullptr)
+		this->curChunk->CloseAndTruncate(this->curChunkUsed);
+
+	// A chunk preallocated but never written to isn't part of the recording.
+	if(this->nextChunk != nullptr)
+	{
+		this->nextChunk->Close();
+		boost::system::error_code ec;
+		boost::filesystem::remove(
+			boost::filesystem::path(this->dirPath) / RawChunkFilename(this->curChunkIdx + 1),
+			ec);
+	}
+	this->curChunk	= nullptr;
+	this->nextChunk	= nullptr;
+
+	Stats finalStats = this->GetStats();
+	this->header.frameCt = (uint64_t)finalStats.frameCt;
+	this->_WriteHeader();
+
+	fclose(this->indexFile);
+	this->indexFile = nullptr;
+
+	std::cout << "Raw capture " << this->dirPath << " closed with " << finalStats.frameCt << " frames";
+	if(finalStats.droppedCt > 0)
+		std::cout << ", dropped " << finalStats.droppedCt << " frames";
+	std::cout << "." << std::endl;
+}
+
+void RawCaptureWriter::_WriteThreadFn()
+{
+	std::unique_lock<std::mutex> lock(this->queueMutex);
+	while(true)
+	{
+		this->queueCond.wait(lock, [this]{ return !this->queue.empty() || !this->writeRunning; });
+
+		// Queued frames are still written when closing.
+		if(this->queue.empty())
+			break;
+
+		QueuedFrame qf = this->queue.front();
+		this->queue.pop_front();
+		bool failed = !this->err.empty();
+		lock.unlock();
+
+		if(!failed && !this->_WriteFrame(qf))
+		{
+			// Nothing more is written, but the queue is still emptied.
+			this->_SetError("Could not write to raw capture " + this->dirPath);
+		}
+
+		lock.lock();
+	}
+}
+
+bool RawCaptureWriter::_WriteFrame(const QueuedFrame& qf)
+{
+	const cv::Mat& frame = *qf.frame;
+	size_t rowBytes		= (size_t)frame.cols * frame.elemSize();
+	size_t dataBytes	= rowBytes * frame.rows;
+	size_t recordBytes	= RawAlignUp(sizeof(RawFrameHeader) + dataBytes);
+
+	if(this->curChunk == nullptr)
+	{
+		// The first frame's dimensions are the recording's.
+		this->header.width		= frame.cols;
+		this->header.height		= frame.rows;
+		this->header.channels	= frame.channels();
+		this->_WriteHeader();
+	}
+
+	if(this->curChunk == nullptr || this->curChunkUsed + recordBytes > this->curChunk->Size())
+	{
+		if(!this->_AdvanceChunk(recordBytes))
+			return false;
+	}
+
+	long long frameCt = 0;
+	{
+		std::lock_guard<std::mutex> guard(this->queueMutex);
+		frameCt = this->stats.frameCt;
+	}
+
+	RawFrameHeader frameHeader;
+	frameHeader.sequence	= (uint64_t)frameCt;
+	frameHeader.captureUS	= MicrosecondsSinceEpoch(qf.info.captureTime);
+	frameHeader.width		= frame.cols;
+	frameHeader.height		= frame.rows;
+	frameHeader.channels	= frame.channels();
+	frameHeader.exposureUS	= qf.info.exposureUS;
+	frameHeader.threshold	= qf.info.threshold;
+	frameHeader.laserNIR	= qf.laserNIR;
+	frameHeader.laserWhite	= qf.laserWhite;
+	frameHeader.dataBytes	= (uint32_t)dataBytes;
+
+	unsigned char* dst = this->curChunk->MutableData() + this->curChunkUsed;
+	memcpy(dst, &frameHeader, sizeof(frameHeader));
+	dst += sizeof(frameHeader);
+
+	if(frame.isContinuous())
+		memcpy(dst, frame.data, dataBytes);
+	else
+	{
+		for(int y = 0; y < frame.rows; ++y)
+			memcpy(dst + y * rowBytes, frame.ptr(y), rowBytes);
+	}
+
+	RawIndexEntry entry;
+	entry.sequence	= frameHeader.sequence;
+	entry.captureUS	= frameHeader.captureUS;
+	entry.chunk		= (uint32_t)this->curChunkIdx;
+	entry.offset	= (uint64_t)this->curChunkUsed;
+	if(fwrite(&entry, sizeof(entry), 1, this->indexFile) != 1)
+		return false;
+
+	this->curChunkUsed += recordBytes;
+	++frameCt;
+
+	// Get the next chunk ready well before it's needed, so switching
+	// chunks doesn't stall on allocating one.
+	if(this->nextChunk == nullptr && this->curChunkUsed > this->curChunk->Size() / 2)
+		this->_PreallocateNextChunk(recordBytes);
+
+	if(frameCt % flushInterval == 0)
+	{
+		this->curChunk->Flush();
+		fflush(this->indexFile);
+	}
+
+	std::lock_guard<std::mutex> guard(this->queueMutex);
+	this->stats.frameCt = frameCt;
+	this->stats.bytesWritten += (long long)recordBytes;
+	return true;
+}
+
+bool RawCaptureWriter::_AdvanceChunk(size_t minBytes)
+{
+	if(this->curChunk != nullptr)
+		this->curChunk->CloseAndTruncate(this->curChunkUsed);
+
+	if(this->nextChunk == nullptr || this->nextChunk->Size() < minBytes)
+		this->_PreallocateNextChunk(minBytes);
+
+	this->curChunk		= std::move(this->nextChunk);
+	this->curChunkUsed	= 0;
+	++this->curChunkIdx;
+
+	if(this->curChunk == nullptr)
+		return false;
+
+	std::lock_guard<std::mutex> guard(this->queueMutex);
+	++this->stats.chunkCt;
+	return true;
+}
+
+void RawCaptureWriter::_PreallocateNextChunk(size_t minBytes)
+{
+	boost::filesystem::path chunkPath =
+		boost::filesystem::path(this->dirPath) / RawChunkFilename(this->curChunkIdx + 1);
+
+	size_t chunkSize = std::max(this->chunkBytes, minBytes);
+
+	// Stop the recording before it fills the card, instead of when it does.
+	if(!CaptureStorage::GetInstance().HasRoomFor(chunkSize))
+	{
+		std::cout << "Not enough free space for raw capture chunk " << chunkPath.string() << std::endl;
+		this->nextChunk = nullptr;
+		return;
+	}
+
+	this->nextChunk = std::make_unique<cvgMappedFile>();
+	if(!this->nextChunk->Create(chunkPath.string(), chunkSize))
+	{
+		std::cout << "Could not create raw capture chunk " << chunkPath.string() << std::endl;
+		this->nextChunk = nullptr;
+	}
+}
+
+void RawCaptureWriter::_WriteHeader()
+{
+	fseek(this->indexFile, 0, SEEK_SET);
+	fwrite(&this->header, sizeof(this->header), 1, this->indexFile);
+	fseek(this->indexFile, 0, SEEK_END);
+}
+
+void RawCaptureWriter::_SetError(const std::string& msg)
+{
+	std::cout << msg << std::endl;
+
+	std::lock_guard<std::mutex> guard(this->queueMutex);
+	if(this->err.empty())
+		this->err = msg;
+}
+
+std::string RawCaptureWriter::GetError()
+{
+	std::lock_guard<std::mutex> guard(this->queueMutex);
+	return this->err;
+}
+
+RawCaptureWriter::Stats RawCaptureWriter::GetStats()
+{
+	std::lock_guard<std::mutex> guard(this->queueMutex);
+	return this->stats;
+}
+
+void RawCaptureWriter::SetLightState(float nir, float white)
+{
+	lightNIR	= nir;
+	lightWhite	= white;
+}
+
+void RawCaptureWriter::GetLightState(float& nir, float& white)
+{
+	nir		= lightNIR;
+	white	= lightWhite;
+}
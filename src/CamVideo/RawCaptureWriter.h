@@ -0,0 +1,246 @@
+#pragma once
+
+#include "RawCaptureFormat.h"
+#include "../Utils/cvgMappedFile.h"
+#include <opencv2/core.hpp>
+#include <string>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+/// <summary>
+/// Records frames losslessly, in the raw capture format (see
+/// RawCaptureFormat.h), as an alternative to compressed video files.
+///
+/// Submitted frames are queued, and written by a background thread into
+/// memory mapped chunk files that are preallocated before they're needed.
+/// The camera thread only ever queues a reference to the frame.
+///
+/// Only 8 bit frames, with 1 or 3 channels, are supported. The first frame
+/// decides the dimensions of the recording.
+/// </summary>
+class RawCaptureWriter
+{
+public:
+	/// <summary>
+	/// The default size of chunk files, 256MB.
+	/// </summary>
+	static const size_t defaultChunkBytes = 256 * 1024 * 1024;
+
+	/// <summary>
+	/// The most frames that can be queued to be written. If the disk can't
+	/// keep up, frames past this are dropped instead of using up memory.
+	/// </summary>
+	static const size_t maxQueuedFrames = 64;
+
+	/// <summary>
+	/// The number of frames written between flushing the chunk and index to
+	/// disk.
+	/// </summary>
+	static const int flushInterval = 30;
+
+	/// <summary>
+	/// Per-frame values recorded in the frame's header, along with the frame.
+	/// </summary>
+	struct FrameInfo
+	{
+		std::chrono::steady_clock::time_point captureTime;
+
+		/// <summary>
+		/// The camera's exposure time, in microseconds. 0 if automatic.
+		/// </summary>
+		int exposureUS = 0;
+
+		/// <summary>
+		/// The threshold used to process the frame, or negative if it
+		/// wasn't thresholded.
+		/// </summary>
+		float threshold = -1.0f;
+	};
+
+	struct Stats
+	{
+		/// <summary>
+		/// The number of frames written to disk.
+		/// </summary>
+		long long frameCt = 0;
+
+		/// <summary>
+		/// The number of frames dropped because the queue was full.
+		/// </summary>
+		long long droppedCt = 0;
+
+		/// <summary>
+		/// The number of chunk files started.
+		/// </summary>
+		int chunkCt = 0;
+
+		/// <summary>
+		/// The number of bytes of frame records written to chunks.
+		/// </summary>
+		long long bytesWritten = 0;
+	};
+
+private:
+	struct QueuedFrame
+	{
+		cv::Ptr<cv::Mat> frame;
+		FrameInfo info;
+		float laserNIR = 0.0f;
+		float laserWhite = 0.0f;
+	};
+
+	/// <summary>
+	/// The directory of the recording.
+	/// </summary>
+	std::string dirPath;
+
+	size_t chunkBytes = defaultChunkBytes;
+
+	/// <summary>
+	/// The recording's header, rewritten to the index when the dimensions
+	/// are known, and when the recording is closed.
+	/// </summary>
+	RawRecordingHeader header;
+
+	/// <summary>
+	/// The index file. Only used by the writer thread once it's started.
+	/// </summary>
+	FILE* indexFile = nullptr;
+
+	/// <summary>
+	/// The chunk being written to, and the chunk that will be written to
+	/// once it's full. Only used by the writer thread.
+	/// </summary>
+	std::unique_ptr<cvgMappedFile> curChunk;
+	std::unique_ptr<cvgMappedFile> nextChunk;
+
+	/// <summary>
+	/// The index of curChunk, and how many of its bytes have been used.
+	/// </summary>
+	int curChunkIdx = -1;
+	size_t curChunkUsed = 0;
+
+	std::thread writeThread;
+	std::atomic_bool writeRunning = false;
+
+	/// <summary>
+	/// Guards everything below.
+	/// </summary>
+	std::mutex queueMutex;
+
+	/// <summary>
+	/// Notified when a frame is queued, or the writer thread is stopped.
+	/// </summary>
+	std::condition_variable queueCond;
+
+	std::deque<QueuedFrame> queue;
+
+	/// <summary>
+	/// The dimensions of the recording, or -1 before the first frame.
+	/// </summary>
+	int width = -1;
+	int height = -1;
+	int channels = -1;
+
+	/// <summary>
+	/// If non-empty, the recording failed and no more frames are written.
+	/// </summary>
+	std::string err;
+
+	Stats stats;
+
+	static std::atomic<float> lightNIR;
+	static std::atomic<float> lightWhite;
+
+private:
+	void _WriteThreadFn();
+
+	/// <summary>
+	/// Write a frame record into the current chunk, and its index entry.
+	/// Only called from the writer thread.
+	/// </summary>
+	/// <returns>False if the frame couldn't be written.</returns>
+	bool _WriteFrame(const QueuedFrame& qf);
+
+	/// <summary>
+	/// Finish the current chunk, and start writing to the next one.
+	/// </summary>
+	/// <param name="minBytes">The space the next chunk needs to have.</param>
+	/// <returns>False if the next chunk couldn't be created.</returns>
+	bool _AdvanceChunk(size_t minBytes);
+
+	/// <summary>
+	/// Create the chunk after the current one, ahead of time.
+	/// </summary>
+	void _PreallocateNextChunk(size_t minBytes);
+
+	/// <summary>
+	/// Write the recording header to the start of the index file.
+	/// </summary>
+	void _WriteHeader();
+
+	void _SetError(const std::string& msg);
+
+public:
+	RawCaptureWriter();
+	~RawCaptureWriter();
+
+	RawCaptureWriter(const RawCaptureWriter&) = delete;
+	RawCaptureWriter& operator=(const RawCaptureWriter&) = delete;
+
+	/// <summary>
+	/// Start a recording, closing any recording already open.
+	/// </summary>
+	/// <param name="dirPath">
+	/// The directory to record into. It's created if it doesn't exist.
+	/// </param>
+	/// <param name="camId">The ID of the camera being recorded.</param>
+	/// <param name="chunkBytes">The size to preallocate chunk files at.</param>
+	/// <returns>False if the recording couldn't be started.</returns>
+	bool Open(const std::string& dirPath, int camId, size_t chunkBytes = defaultChunkBytes);
+
+	/// <summary>
+	/// Queue a frame to be written. The frame's pixels must not be modified
+	/// afterwards, as they're referenced instead of copied.
+	/// </summary>
+	/// <returns>
+	/// False if the recording isn't open, has failed, or the frame doesn't
+	/// match the recording. A frame dropped because the queue is full is
+	/// not a failure, and returns true.
+	/// </returns>
+	bool Submit(cv::Ptr<cv::Mat> frame, const FrameInfo& info);
+
+	/// <summary>
+	/// Finish writing the queued frames, and close the recording.
+	/// </summary>
+	void Close();
+
+	inline bool IsOpen() const
+	{ return this->writeRunning; }
+
+	inline const std::string& DirPath() const
+	{ return this->dirPath; }
+
+	/// <summary>
+	/// Get the reason the recording failed, or an empty string.
+	/// </summary>
+	std::string GetError();
+
+	Stats GetStats();
+
+	/// <summary>
+	/// Set the light intensities recorded with frames. Called by the
+	/// LaserSys when the lights are changed.
+	/// </summary>
+	static void SetLightState(float nir, float white);
+
+	/// <summary>
+	/// Get the light intensities last set with SetLightState().
+	/// </summary>
+	static void GetLightState(float& nir, float& white);
+};
@@ -0,0 +1,100 @@
+#include "SessionRecording.h"
+#include "IManagedCam.h"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <unordered_map>
+
+static const char* szSessionIndexFilename = "session_index.csv";
+
+SessionRecording::SessionRecording(const std::string& dirPath)
+{
+	this->dirPath	= dirPath;
+	this->startTime	= std::chrono::steady_clock::now();
+}
+
+void SessionRecording::LogFrame(int streamIdx, long long frameIdx, double captureMS, long long epoch)
+{
+	std::lock_guard<std::mutex> guard(this->logMutex);
+	if(streamIdx < 0 || streamIdx >= this->frameLogs.size())
+		return;
+
+	this->frameLogs[streamIdx].push_back({frameIdx, captureMS, epoch});
+}
+
+long long SessionRecording::_FindPair(
+	const std::vector<FrameLog>& log, 
+	const std::unordered_map<long long, long long>& epochFrames,
+	const FrameLog& ref)
+{
+	if(ref.epoch >= 0)
+	{
+		std::unordered_map<long long, long long>::const_iterator itEpoch = epochFrames.find(ref.epoch);
+		if(itEpoch != epochFrames.end())
+			return itEpoch->second;
+	}
+
+	std::vector<FrameLog>::const_iterator it =
+		std::upper_bound(
+			log.begin(),
+			log.end(),
+			ref.captureMS,
+			[](double ms, const FrameLog& fl){ return ms < fl.captureMS; });
+
+	if(it == log.begin())
+		return -1;
+
+	return (it - 1)->frameIdx;
+}
+
+bool SessionRecording::WriteIndex()
+{
+	std::string indexPath = (boost::filesystem::path(this->dirPath) / szSessionIndexFilename).string();
+	std::ofstream indexFile(indexPath);
+	if(!indexFile.is_open())
+	{
+		std::cout << "Could not write session index " << indexPath << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(this->logMutex);
+	if(this->frameLogs.empty())
+		return true;
+
+	indexFile << "session_ms,epoch";
+	for(const Stream& s : this->streams)
+		indexFile << "," << s.name;
+	indexFile << "\n";
+
+	// The first frame of each stream with each acquisition epoch.
+	std::vector<std::unordered_map<long long, long long>> epochFrames(this->frameLogs.size());
+	for(size_t i = 0; i < this->frameLogs.size(); ++i)
+	{
+		for(const FrameLog& fl : this->frameLogs[i])
+		{
+			if(fl.epoch >= 0)
+				epochFrames[i].emplace(fl.epoch, fl.frameIdx);
+		}
+	}
+
+	indexFile << std::fixed << std::setprecision(3);
+	for(const FrameLog& ref : this->frameLogs[0])
+	{
+		indexFile << ref.captureMS << "," << ref.epoch << "," << ref.frameIdx;
+		for(size_t i = 1; i < this->frameLogs.size(); ++i)
+			indexFile << "," << _FindPair(this->frameLogs[i], epochFrames[i], ref);
+		indexFile << "\n";
+	}
+
+	std::cout << "Session " << this->dirPath << " recorded " << this->streams.size() << " streams, with " << this->frameLogs[0].size() << " frames of " << this->streams[0].name << "." << std::endl;
+	return true;
+}
+
+std::string SessionRecording::StreamName(int camId, VideoRequest::Source source)
+{
+	std::string name = (camId == SpecialCams::Composite) ? "composite" : "cam" + std::to_string(camId);
+	name += (source == VideoRequest::Source::Unprocessed) ? "_raw" : "_processed";
+	return name;
+}
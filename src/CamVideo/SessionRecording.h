@@ -0,0 +1,150 @@
+#pragma once
+
+#include "VideoRequest.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+
+/// <summary>
+/// A recording of several streams at once, started with
+/// CamStreamMgr::RecordSession().
+///
+/// Each stream is recorded to its own video file in the session's
+/// directory, encoded on its camera's strand of the task pool, so the
+/// streams are encoded in parallel and off of the camera threads. All the
+/// streams' timestamps files are relative to the same session start time.
+///
+/// When the session is stopped, a frame pairing index (session_index.csv)
+/// is written, to find the frames of each stream that go together.
+/// </summary>
+class SessionRecording
+{
+	friend class CamStreamMgr;
+
+public:
+	/// <summary>
+	/// A stream to record in a session.
+	/// </summary>
+	struct StreamReq
+	{
+		/// <summary>
+		/// The camera ID, or SpecialCams::Composite.
+		/// </summary>
+		int camId;
+
+		/// <summary>
+		/// If the camera's frames are recorded before or after processing.
+		/// </summary>
+		VideoRequest::Source source;
+	};
+
+	struct Stream
+	{
+		int camId;
+		VideoRequest::Source source;
+
+		/// <summary>
+		/// The name of the stream, used for its filename and in the index.
+		/// </summary>
+		std::string name;
+
+		VideoRequest::SPtr req;
+	};
+
+	typedef std::shared_ptr<SessionRecording> SPtr;
+
+private:
+	/// <summary>
+	/// A frame written to a stream's video.
+	/// </summary>
+	struct FrameLog
+	{
+		/// <summary>
+		/// The index of the frame in the stream's video.
+		/// </summary>
+		long long frameIdx;
+
+		/// <summary>
+		/// The capture time, relative to the session start.
+		/// </summary>
+		double captureMS;
+
+		/// <summary>
+		/// The CamSyncGroup acquisition epoch, or -1.
+		/// </summary>
+		long long epoch;
+	};
+
+	std::string dirPath;
+
+	/// <summary>
+	/// The shared clock's start, that all streams' timestamps are
+	/// relative to.
+	/// </summary>
+	std::chrono::steady_clock::time_point startTime;
+
+	/// <summary>
+	/// The streams, only modified by CamStreamMgr while the session is
+	/// started.
+	/// </summary>
+	std::vector<Stream> streams;
+
+	/// <summary>
+	/// Guards frameLogs.
+	/// </summary>
+	std::mutex logMutex;
+
+	/// <summary>
+	/// The frames written to each stream, in the same order as streams.
+	/// </summary>
+	std::vector<std::vector<FrameLog>> frameLogs;
+
+private:
+	/// <summary>
+	/// Find the frame of a stream to pair with a frame of the first stream.
+	/// Frames with the same acquisition epoch are paired, else the last
+	/// frame captured at or before the first stream's frame.
+	/// </summary>
+	/// <param name="log">The frames of the stream to find a pair in.</param>
+	/// <param name="epochFrames">The stream's frames, by acquisition epoch.</param>
+	/// <param name="ref">The frame of the first stream.</param>
+	/// <returns>The index of the paired frame, or -1 if there isn't one.</returns>
+	static long long _FindPair(
+		const std::vector<FrameLog>& log, 
+		const std::unordered_map<long long, long long>& epochFrames,
+		const FrameLog& ref);
+
+public:
+	SessionRecording(const std::string& dirPath);
+
+	inline const std::string& DirPath() const
+	{ return this->dirPath; }
+
+	inline std::chrono::steady_clock::time_point StartTime() const
+	{ return this->startTime; }
+
+	inline const std::vector<Stream>& Streams() const
+	{ return this->streams; }
+
+	/// <summary>
+	/// Record that a frame was written to a stream's video. Called from
+	/// the stream's camera thread.
+	/// </summary>
+	void LogFrame(int streamIdx, long long frameIdx, double captureMS, long long epoch);
+
+	/// <summary>
+	/// Write the frame pairing index to the session's directory. Each row
+	/// is a frame of the first stream, with the index of the frame of
+	/// every other stream that pairs with it.
+	/// </summary>
+	/// <returns>True if the index was written.</returns>
+	bool WriteIndex();
+
+	/// <summary>
+	/// Get the default name of a stream.
+	/// </summary>
+	static std::string StreamName(int camId, VideoRequest::Source source);
+};
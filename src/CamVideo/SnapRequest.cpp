@@ -13,13 +13,50 @@ bool SnapRequest::Cancel()
 	return true;
 }
 
-SnapRequest::SPtr SnapRequest::MakeRequest(const std::string& filename, ProcessType processType)
+void SnapRequest::_SetFilled(long long filledFrameID)
+{
+	std::lock_guard<std::mutex> guard(this->writeAccess);
+	this->frameID = filledFrameID;
+	if(this->writeStatus == WriteStatus::Failed)
+		return;
+
+	this->status = Status::Filled;
+}
+
+void SnapRequest::_SetWritten(bool written)
+{
+	std::lock_guard<std::mutex> guard(this->writeAccess);
+	if(written)
+	{
+		this->writeStatus = WriteStatus::Written;
+		return;
+	}
+
+	this->writeStatus = WriteStatus::Failed;
+	this->err = "The snapshot was encoded, but could not be written to " + this->filename + ".dcm";
+	this->status = Status::Error;
+}
+
+SnapRequest::WriteStatus SnapRequest::GetWriteStatus()
+{
+	std::lock_guard<std::mutex> guard(this->writeAccess);
+	return this->writeStatus;
+}
+
+SnapRequest::SPtr SnapRequest::MakeRequest(
+	const std::string& filename, 
+	ProcessType processType, 
+	FrameSelect select, 
+	int lookbackMS)
 {
 	SnapRequest* newReq = new SnapRequest();
 	newReq->filename	= filename;
 	newReq->frameID		= -1;
 	newReq->status		= Status::Unknown;
 	newReq->processType = processType;
+	newReq->frameSelect	= select;
+	newReq->lookbackMS	= lookbackMS;
+	newReq->requestTime	= std::chrono::steady_clock::now();
 
 	return SnapRequest::SPtr(newReq);
 }
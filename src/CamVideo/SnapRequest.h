@@ -1,7 +1,9 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <chrono>
 #include <unordered_map>
+#include <mutex>
 class CamStreamMgr;
 
 /// <summary>
@@ -37,6 +39,29 @@ public:
 		Indifferent
 	};
 
+	/// <summary>
+	/// Which frame the snapshot is taken from.
+	/// </summary>
+	enum class FrameSelect
+	{
+		/// <summary>
+		/// The next frame polled after the request.
+		/// </summary>
+		Next,
+
+		/// <summary>
+		/// The frame captured lookbackMS before the request, taken from
+		/// the stream's FrameHistory.
+		/// </summary>
+		Past,
+
+		/// <summary>
+		/// The sharpest frame captured within lookbackMS before the request,
+		/// taken from the stream's FrameHistory.
+		/// </summary>
+		Sharpest
+	};
+
 	/// <summary>
 	/// The status of the request.
 	/// </summary>
@@ -51,8 +76,10 @@ public:
 		Requested,
 
 		/// <summary>
-		/// The request has been successfully filled. A valid image
-		/// should be expected at the requested filepath.
+		/// The request has been successfully filled: the image was encoded
+		/// and its file queued to be written behind the request (see 
+		/// CaptureStorage). GetWriteStatus() tells when it's on disk. If 
+		/// writing it fails, the status becomes Error.
 		/// </summary>
 		Filled,
 
@@ -63,6 +90,27 @@ public:
 		Error
 	};
 
+	/// <summary>
+	/// Whether the snapshot's file is on disk.
+	/// </summary>
+	enum class WriteStatus
+	{
+		/// <summary>
+		/// The file hasn't been written yet.
+		/// </summary>
+		Pending,
+
+		/// <summary>
+		/// The file has been written and synced.
+		/// </summary>
+		Written,
+
+		/// <summary>
+		/// The file couldn't be written, the status is Error.
+		/// </summary>
+		Failed
+	};
+
 
 private:
 	// There's no making this object directly. Only through MakeRequest(),
@@ -93,14 +141,69 @@ private:
 
 	ProcessType processType;
 
+	FrameSelect frameSelect = FrameSelect::Next;
+
+	/// <summary>
+	/// How far back before the request to look for the frame, for 
+	/// snapshots that aren't FrameSelect::Next.
+	/// </summary>
+	int lookbackMS = 0;
+
+	/// <summary>
+	/// The quality governor's level when the snapshot was taken. 
+	/// See cvgQualityGovernor.
+	/// </summary>
+	std::string qualityLevel;
+
+	/// <summary>
+	/// The acquisition epoch of the frame the snapshot was taken from, or
+	/// -1 if it wasn't acquired in sync with other cameras. Snapshots of 
+	/// different cameras with the same epoch were grabbed together. 
+	/// See CamSyncGroup.
+	/// </summary>
+	long long acquisitionEpoch = -1;
+
+	/// <summary>
+	/// When the request was made, to measure how long it took to be saved.
+	/// </summary>
+	std::chrono::steady_clock::time_point requestTime;
+
+	/// <summary>
+	/// Guards writeStatus, and the status changes that depend on it, as
+	/// the file can finish writing before or after the request is filled.
+	/// </summary>
+	std::mutex writeAccess;
+	WriteStatus writeStatus = WriteStatus::Pending;
+
+private:
+	/// <summary>
+	/// Mark the request filled, once its file is queued to be written. If
+	/// writing it already failed, it's marked as an error instead.
+	/// </summary>
+	/// <param name="filledFrameID">The frame the snapshot was taken from.</param>
+	void _SetFilled(long long filledFrameID);
+
+	/// <summary>
+	/// Called by the CaptureStorage once the file is written, or failed.
+	/// </summary>
+	void _SetWritten(bool written);
+
 public:
 	inline std::string Filename() const
 	{ return this->filename; }
 
+	inline long long GetAcquisitionEpoch() const
+	{ return this->acquisitionEpoch; }
+
+	inline FrameSelect GetFrameSelect() const
+	{ return this->frameSelect; }
+
 public:
 	inline Status GetStatus() 
 	{return this->status; }
 
+	WriteStatus GetWriteStatus();
+
 	/// <summary>
 	/// The error. Only set if the status is Status::Error.
 	/// </summary>
@@ -116,8 +219,16 @@ public:
 	/// </summary>
 	/// <param name="filename">The request's filename.</param>
 	/// <param name="processType>The requirement for what stage of processing to record</param>
+	/// <param name="select">Which frame to take the snapshot from.</param>
+	/// <param name="lookbackMS">
+	/// How far back to look for the frame, if select isn't FrameSelect::Next.
+	/// </param>
 	/// <returns>The created request.</returns>
-	static SPtr MakeRequest(const std::string& filename, ProcessType pt);
+	static SPtr MakeRequest(
+		const std::string& filename, 
+		ProcessType pt, 
+		FrameSelect select = FrameSelect::Next, 
+		int lookbackMS = 0);
 
 	/// <summary>
 	/// Generate a SnapRequest containing an error state.
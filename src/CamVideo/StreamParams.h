@@ -35,5 +35,81 @@ enum StreamParams
 	/// the camera directly, and from using this StreamParams. This is used to override
 	/// the per-cam option, dynamically at runtime.
 	/// </summary>
-	ExposureMicroseconds
+	ExposureMicroseconds,
+
+	/// <summary>
+	/// If the camera frames should be flipped horizontally (0 or 1).
+	/// </summary>
+	FlipHorizontal,
+
+	/// <summary>
+	/// If the camera frames should be flipped vertically (0 or 1).
+	/// </summary>
+	FlipVertical,
+
+	/// <summary>
+	/// The preferred width of the camera stream. Implementations that 
+	/// can't resize a running stream will return false from SetParam().
+	/// </summary>
+	StreamWidth,
+
+	/// <summary>
+	/// The preferred height of the camera stream. Implementations that 
+	/// can't resize a running stream will return false from SetParam().
+	/// </summary>
+	StreamHeight,
+
+	/// <summary>
+	/// The preferred frame rate of the camera stream. Implementations that
+	/// can't change the rate of a running stream will return false from 
+	/// SetParam().
+	/// </summary>
+	StreamFPS,
+
+	/// <summary>
+	/// Explicit analog gain. A value of 0 or less means automatic.
+	/// </summary>
+	AnalogGain,
+
+	/// <summary>
+	/// Explicit digital gain. A value of 0 or less means automatic.
+	/// </summary>
+	DigitalGain,
+
+	/// <summary>
+	/// Explicit red white balance gain. A value of 0 or less means automatic.
+	/// </summary>
+	WhiteBalanceRed,
+
+	/// <summary>
+	/// Explicit blue white balance gain. A value of 0 or less means automatic.
+	/// </summary>
+	WhiteBalanceBlue,
+
+	/// <summary>
+	/// The left of the image processing region, normalized to the frame width.
+	/// See ProcessingROI.
+	/// </summary>
+	ProcessingROIX,
+
+	/// <summary>
+	/// The top of the image processing region, normalized to the frame height.
+	/// </summary>
+	ProcessingROIY,
+
+	/// <summary>
+	/// The width of the image processing region, normalized to the frame width.
+	/// </summary>
+	ProcessingROIWidth,
+
+	/// <summary>
+	/// The height of the image processing region, normalized to the frame height.
+	/// </summary>
+	ProcessingROIHeight,
+
+	/// <summary>
+	/// Set the image processing region to a centered square (in normalized 
+	/// coordinates) of this size. Only used for SetParam().
+	/// </summary>
+	ProcessingROICentered
 };
\ No newline at end of file
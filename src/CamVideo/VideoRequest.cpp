@@ -4,17 +4,19 @@ VideoRequest::VideoRequest(
 	int width, 
 	int height, 
 	int camId, 
-	const std::string& filename)
+	const std::string& filename,
+	Format format)
 {
 	this->width		= width;
 	this->height	= height;
 	this->camId		= camId;
 	this->filename	= filename;
+	this->format	= format;
 }
 
 VideoRequest::SPtr VideoRequest::MakeError(const std::string& err)
 {
-	VideoRequest* newReq = new VideoRequest(-1,-1, 0, "");
+	VideoRequest* newReq = new VideoRequest(-1,-1, 0, "", Format::Compressed);
 	newReq->err = err;
 	return VideoRequest::SPtr(newReq);
 }
@@ -23,8 +25,9 @@ VideoRequest::SPtr VideoRequest::MakeRequest(
 	int width, 
 	int height, 
 	int camId, 
-	const std::string& filename)
+	const std::string& filename,
+	Format format)
 {
-	VideoRequest* newReq = new VideoRequest(width, height, camId, filename);
+	VideoRequest* newReq = new VideoRequest(width, height, camId, filename, format);
 	return VideoRequest::SPtr(newReq);
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <string>
 #include <memory>
 
+class SessionRecording;
+
 /// <summary>
 /// When a video recording request is made for a camera, a 
 /// VideoRequest::SPtr object is passed back - which is 
@@ -58,6 +60,39 @@ public:
 		Error
 	};
 
+	/// <summary>
+	/// How the video is saved.
+	/// </summary>
+	enum class Format
+	{
+		/// <summary>
+		/// A compressed (lossy) video file.
+		/// </summary>
+		Compressed,
+
+		/// <summary>
+		/// A lossless raw capture recording, see RawCaptureWriter. The
+		/// filename is the recording's directory.
+		/// </summary>
+		Raw
+	};
+
+	/// <summary>
+	/// Which of the camera's frames are recorded.
+	/// </summary>
+	enum class Source
+	{
+		/// <summary>
+		/// The frames after the camera's image processing, as shown.
+		/// </summary>
+		Processed,
+
+		/// <summary>
+		/// The frames as they were polled from the camera.
+		/// </summary>
+		Unprocessed
+	};
+
 private:
 	/// <summary>
 	/// Cached copy of the video with.
@@ -83,6 +118,32 @@ private:
 	/// </summary>
 	std::string filename;
 
+	/// <summary>
+	/// How the video is saved.
+	/// </summary>
+	Format format = Format::Compressed;
+
+	/// <summary>
+	/// Which of the camera's frames are recorded.
+	/// </summary>
+	Source source = Source::Processed;
+
+	/// <summary>
+	/// The session the video is a stream of, or empty if it's recorded
+	/// on its own. Weak, as the session holds on to its streams' requests.
+	/// </summary>
+	std::weak_ptr<SessionRecording> session;
+
+	/// <summary>
+	/// The index of the video in the session's streams.
+	/// </summary>
+	int sessionStream = -1;
+
+	/// <summary>
+	/// The number of frames dropped because the encoder fell behind.
+	/// </summary>
+	long long droppedCt = 0;
+
 	/// <summary>
 	/// The current status of the VideoRequest.
 	/// </summary>
@@ -102,7 +163,7 @@ private:
 private:
 	// Only MakeRequest should instance these items, therefor 
 	// ensuring all items are contained as shared pointers.
-	VideoRequest(int width, int height, int camId, const std::string& filename);
+	VideoRequest(int width, int height, int camId, const std::string& filename, Format format);
 
 public:
 	/// <summary>
@@ -128,6 +189,9 @@ public:
 
 	inline int CamId() {return this->camId; }
 	inline std::string Filename(){return this->filename; }
+	inline Format GetFormat(){return this->format; }
+	inline Source GetSource(){return this->source; }
+	inline long long DroppedFrames(){return this->droppedCt; }
 	inline Status GetStatus(){return this->status;}
 
 	/// <summary>
@@ -162,7 +226,8 @@ private:
 	/// <param name="height">The starting height cached in the request.</param>
 	/// <param name="camId">The camera ID the request was specified for.</param>
 	/// <param name="filename">The video filename the request was specified for.</param>
+	/// <param name="format">How the video is saved.</param>
 	/// <returns>The created request, with the state defaulted to Unknown.</returns>
-	static SPtr MakeRequest(int width, int height, int camId, const std::string& filename);
+	static SPtr MakeRequest(int width, int height, int camId, const std::string& filename, Format format);
 
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "VideoRetime.h"
+#include <opencv2/videoio.hpp>
+#include <iostream>
+#include <fstream>
+#include <cmath>
+
+std::string VideoRetime::TimestampsPath(const std::string& videoPath)
+{
+	return videoPath + ".timestamps";
+}
+
+bool VideoRetime::LoadTimestamps(const std::string& timestampsPath, std::vector<double>& outMS)
+{
+	outMS.clear();
+
+	std::ifstream timestampsFile(timestampsPath);
+	if(!timestampsFile.is_open())
+	{
+		std::cout << "Could not open video timestamps " << timestampsPath << std::endl;
+		return false;
+	}
+
+	double ms = 0.0;
+	while(timestampsFile >> ms)
+	{
+		if(!outMS.empty() && ms < outMS.back())
+		{
+			std::cout << "Video timestamps " << timestampsPath << " go backwards." << std::endl;
+			return false;
+		}
+		outMS.push_back(ms);
+	}
+	return true;
+}
+
+bool VideoRetime::ToConstantRate(const std::string& videoPath, const std::string& outPath, double fps)
+{
+	std::vector<double> timesMS;
+	if(!LoadTimestamps(TimestampsPath(videoPath), timesMS))
+		return false;
+
+	cv::VideoCapture input(videoPath);
+	if(!input.isOpened())
+	{
+		std::cout << "Could not open video " << videoPath << std::endl;
+		return false;
+	}
+
+	// If the recording was interrupted, the video and timestamps may not
+	// have the same number of frames. Only frames with both are used.
+	size_t frameCt = timesMS.size();
+	double videoFrameCt = input.get(cv::CAP_PROP_FRAME_COUNT);
+	if(videoFrameCt > 0.0 && (size_t)videoFrameCt < frameCt)
+		frameCt = (size_t)videoFrameCt;
+
+	cv::Mat curFrame;
+	if(frameCt == 0 || !input.read(curFrame))
+	{
+		std::cout << "Video " << videoPath << " has no frames to export." << std::endl;
+		return false;
+	}
+
+	double durationMS = timesMS[frameCt - 1] - timesMS[0];
+	if(fps <= 0.0)
+	{
+		fps = 30.0;
+		if(frameCt > 1 && durationMS > 0.0)
+			fps = (double)(frameCt - 1) * 1000.0 / durationMS;
+	}
+
+	cv::VideoWriter output;
+	int mp4FourCC = cv::VideoWriter::fourcc('a', 'v', 'c', '1');
+	output.open(outPath, mp4FourCC, fps, curFrame.size(), curFrame.channels() != 1);
+	if(!output.isOpened())
+	{
+		std::cout << "Could not open video file " << outPath << std::endl;
+		return false;
+	}
+
+	double msPerFrame = 1000.0 / fps;
+	size_t outCt = (size_t)std::llround(durationMS / msPerFrame) + 1;
+	size_t curIdx = 0;
+	for(size_t i = 0; i < outCt; ++i)
+	{
+		double outMS = timesMS[0] + i * msPerFrame;
+
+		// Advance to the last frame captured by the output frame's time.
+		while(curIdx + 1 < frameCt && timesMS[curIdx + 1] <= outMS)
+		{
+			cv::Mat nextFrame;
+			if(!input.read(nextFrame))
+			{
+				frameCt = curIdx + 1;
+				break;
+			}
+			curFrame = nextFrame;
+			++curIdx;
+		}
+		output.write(curFrame);
+	}
+
+	std::cout << "Exported " << frameCt << " recorded frames to " << outCt << " frames at " << fps << " FPS." << std::endl;
+	return true;
+}
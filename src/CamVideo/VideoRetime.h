@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Reconstructs the real timing of recorded videos.
+///
+/// Unless frame padding is enabled, compressed videos are recorded with
+/// every frame written once, at a nominal frame rate, and a timestamps
+/// file (the video's filename + ".timestamps") with the capture time of
+/// each frame in milliseconds, one per line.
+/// </summary>
+class VideoRetime
+{
+public:
+	/// <summary>
+	/// Get the path of a video's timestamps file.
+	/// </summary>
+	static std::string TimestampsPath(const std::string& videoPath);
+
+	/// <summary>
+	/// Load a timestamps file.
+	/// </summary>
+	/// <param name="timestampsPath">The file to load.</param>
+	/// <param name="outMS">
+	/// Output parameter. The timestamp of each frame, in milliseconds.
+	/// </param>
+	/// <returns>
+	/// False if the file couldn't be read, or the timestamps go backwards.
+	/// </returns>
+	static bool LoadTimestamps(const std::string& timestampsPath, std::vector<double>& outMS);
+
+	/// <summary>
+	/// Export a video at a constant frame rate, with frames placed at their
+	/// real capture times.
+	///
+	/// Each output frame shows the last frame captured by its time, so
+	/// frames are repeated over gaps, and frames captured faster than the
+	/// output rate are dropped.
+	/// </summary>
+	/// <param name="videoPath">The recorded video.</param>
+	/// <param name="outPath">The video file to write.</param>
+	/// <param name="fps">
+	/// The output frame rate. If 0 or less, the recording's average frame
+	/// rate is used.
+	/// </param>
+	/// <returns>True if the video was exported.</returns>
+	static bool ToConstantRate(const std::string& videoPath, const std::string& outPath, double fps = 0.0);
+};
@@ -1,5 +1,8 @@
 #include "Carousel.h"
+#include "CarouselIconCache.h"
 #include "../UISys/CacheRecordUtils.h"
+#include <filesystem>
+#include <iostream>
 
 CarouselMoment::CarouselMoment()
 {
@@ -174,24 +177,23 @@ void Carousel::Clear()
 
 bool Carousel::LoadAssets(bool force)
 {
+	// Icons aren't loaded here anymore, they're requested from the
+	// CarouselIconCache when they're close enough to the selection
+	// to be rendered (see RefreshIconResidency()). Still report missing
+	// files early so bad AppOptions are caught on startup.
 	int fails = 0;
 	for(int i = 0; i < this->entries.size(); ++i)
 	{
 		this->entries[i].cachedIndex = i;
 
-		if(this->entries[i].IsImageLoaded() && !force)
-			continue;
-
-		TexObj::SPtr load = 
-			TexObj::MakeSharedLODE(this->entries[i].iconFilepath);
+		if(force)
+			this->entries[i].icon = nullptr;
 
-		if(load == nullptr)
+		if(!std::filesystem::exists(this->entries[i].iconFilepath))
 		{
+			std::cerr << "Missing expected carousel icon " << this->entries[i].iconFilepath << std::endl;
 			++fails;
-			continue;
 		}
-
-		this->entries[i].icon = load;
 	}
 
 	this->labelFont = FontMgr::GetInstance().GetFont(10);
@@ -199,6 +201,36 @@ bool Carousel::LoadAssets(bool force)
 	return (fails == 0);
 }
 
+void Carousel::ReleaseIcons()
+{
+	for(Entry& e : this->entries)
+		e.icon = nullptr;
+}
+
+void Carousel::RefreshIconResidency()
+{
+	CarouselIconCache& iconCache = CarouselIconCache::GetInstance();
+	iconCache.ProcessDecoded();
+
+	// Cover both where the carousel is animating from, and where it's
+	// animating to.
+	int lo = std::min(this->currentEntry, (int)std::floor(this->currentShown)) - this->iconLoadRadius;
+	int hi = std::max(this->currentEntry, (int)std::ceil(this->currentShown)) + this->iconLoadRadius;
+
+	for(int i = 0; i < this->entries.size(); ++i)
+	{
+		Entry& e = this->entries[i];
+		if(i < lo || i > hi)
+		{
+			// Let go so the cache is allowed to evict it.
+			e.icon = nullptr;
+			continue;
+		}
+
+		if(!e.IsImageLoaded())
+			e.icon = iconCache.Request(e.iconFilepath, i == this->currentEntry);
+	}
+}
 
 void Carousel::EndAnimation(const CarouselStyle& style, bool updateCache)
 {
@@ -433,6 +465,8 @@ void Carousel::Render(
 	// we render it so we can painter's algorithm it correct in respect
 	// to its neighboring entries.
 
+	this->RefreshIconResidency();
+
 	std::vector<Entry*> order;
 	this->ProcessUpdateAndDrawOrder( x, y, style, scale, order);
 
@@ -451,21 +485,28 @@ void Carousel::Render(
 
 		// RENDER THE ICON
 		//////////////////////////////////////////////////
+		UIRect rectIco(
+			x + e->clientRect.pos.x + e->drawDetails.relIcon.pos.x,
+			y + e->clientRect.pos.y + e->drawDetails.relIcon.pos.y,
+			e->drawDetails.relIcon.dim.x,
+			e->drawDetails.relIcon.dim.y);
+
+		UIColor4 icoCol = modColor.Modulate(e->drawDetails.iconColor);
 		if(e->IsImageLoaded())
 		{ 
 			glEnable(GL_TEXTURE_2D);
-			UIColor4 icoCol = modColor.Modulate(e->drawDetails.iconColor);
 			glColor4fv(icoCol.ar);
 			e->icon->GLBind();
-
-			UIRect rectIco(
-				x + e->clientRect.pos.x + e->drawDetails.relIcon.pos.x,
-				y + e->clientRect.pos.y + e->drawDetails.relIcon.pos.y,
-				e->drawDetails.relIcon.dim.x,
-				e->drawDetails.relIcon.dim.y);
-			//
 			rectIco.GLQuadTex();
 		}
+		else
+		{
+			// Placeholder while the icon is loading (or out of range),
+			// a faint untextured square where the icon would be.
+			const float placeholderAlpha = 0.25f;
+			glColor4f(icoCol.r, icoCol.g, icoCol.b, icoCol.a * placeholderAlpha);
+			rectIco.GLQuad();
+		}
 
 		// RENDER THE TEXT
 		//////////////////////////////////////////////////
@@ -238,6 +238,10 @@ public:
 	public:
 		/// <summary>
 		/// The loaded icon for the carousel.
+		/// 
+		/// Icons are loaded on demand through the CarouselIconCache,
+		/// and this will be null while the icon is still loading, or
+		/// when the entry is too far from the selection to need it.
 		/// </summary>
 		TexObj::SPtr icon;
 
@@ -312,8 +316,21 @@ public:
 	// It's arguable if this is the best location for this variable.
 	FontWU labelFont;
 
+	/// <summary>
+	/// How many entries away from the selected (and shown) entry to
+	/// keep icons loaded. Entries further away are drawn with a
+	/// placeholder and their icons are allowed to be evicted.
+	/// </summary>
+	int iconLoadRadius = 2;
+
 protected:
 
+	/// <summary>
+	/// Request icons for entries near the selection from the
+	/// CarouselIconCache, and release the ones that are out of range.
+	/// </summary>
+	void RefreshIconResidency();
+
 	void ProcessUpdateAndDrawOrder(
 		float x, 
 		float y, 
@@ -333,12 +350,22 @@ public:
 	void Clear();
 
 	/// <summary>
-	/// Load the font and image assets for the Carousel. Note that once
-	/// this is done, the carousel cannot have any more entries added 
-	/// to it.
+	/// Load the font assets for the Carousel, and prepare the entries
+	/// for rendering. Note that once this is done, the carousel cannot 
+	/// have any more entries added to it.
+	/// 
+	/// Icons are not loaded here, they're loaded lazily when rendered.
 	/// </summary>
+	/// <param name="force">If true, drop any icons already held.</param>
+	/// <returns>False if any of the icon files are missing.</returns>
 	bool LoadAssets(bool force = false);
 
+	/// <summary>
+	/// Drop the carousel's references to its icon textures. This should
+	/// be done while the OpenGL context is still alive.
+	/// </summary>
+	void ReleaseIcons();
+
 	/// <summary>
 	/// If the Carousel is in the middle a transition animation, jump
 	/// the animation to be at the selected entry.
@@ -0,0 +1,209 @@
+#include "CarouselIconCache.h"
+#include <algorithm>
+
+CarouselIconCache CarouselIconCache::_inst;
+
+CarouselIconCache& CarouselIconCache::GetInstance()
+{
+	return _inst;
+}
+
+void CarouselIconCache::ShutdownMgr()
+{
+	_inst.StopWorker();
+
+	{
+		std::lock_guard<std::mutex> guard(_inst.queueMutex);
+		_inst.toDecode.clear();
+		_inst.decoded.clear();
+	}
+	_inst.inFlight.clear();
+	_inst.resident.clear();
+	_inst.lru.clear();
+}
+
+CarouselIconCache::~CarouselIconCache()
+{
+	// The textures should have already been released in ShutdownMgr()
+	// while OpenGL was still available, but make sure the thread
+	// isn't left dangling.
+	this->StopWorker();
+}
+
+void CarouselIconCache::StopWorker()
+{
+	if(this->worker == nullptr)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(this->queueMutex);
+		this->stopWorker = true;
+	}
+	this->queueCond.notify_all();
+
+	this->worker->join();
+	delete this->worker;
+	this->worker = nullptr;
+	this->stopWorker = false;
+}
+
+void CarouselIconCache::WorkerThreadFn()
+{
+	while(true)
+	{
+		std::string path;
+		{
+			std::unique_lock<std::mutex> lock(this->queueMutex);
+			this->queueCond.wait(
+				lock,
+				[this]{ return this->stopWorker || !this->toDecode.empty(); });
+
+			if(this->stopWorker)
+				return;
+
+			path = this->toDecode.front();
+			this->toDecode.pop_front();
+		}
+
+		// Decode outside of the lock, this is the expensive part.
+		DecodedIcon di;
+		di.path = path;
+		di.success = TexObj::DecodeLODE(path, di.pixels, di.width, di.height);
+
+		std::lock_guard<std::mutex> guard(this->queueMutex);
+		this->decoded.push_back(std::move(di));
+	}
+}
+
+TexObj::SPtr CarouselIconCache::Request(const std::string& path, bool priority)
+{
+	if(path.empty())
+		return nullptr;
+
+	auto itRes = this->resident.find(path);
+	if(itRes != this->resident.end())
+	{
+		// Move to the front of the LRU
+		this->lru.splice(this->lru.begin(), this->lru, itRes->second.lruIt);
+		return itRes->second.tex;
+	}
+
+	if(this->failed.find(path) != this->failed.end())
+		return nullptr;
+
+	if(this->inFlight.find(path) != this->inFlight.end())
+		return nullptr;
+
+	this->inFlight.insert(path);
+	{
+		std::lock_guard<std::mutex> guard(this->queueMutex);
+		if(priority)
+			this->toDecode.push_front(path);
+		else
+			this->toDecode.push_back(path);
+	}
+
+	if(this->worker == nullptr)
+		this->worker = new std::thread(&CarouselIconCache::WorkerThreadFn, this);
+
+	this->queueCond.notify_one();
+	return nullptr;
+}
+
+int CarouselIconCache::ProcessDecoded(int maxUploads)
+{
+	std::vector<DecodedIcon> toUpload;
+	{
+		std::lock_guard<std::mutex> guard(this->queueMutex);
+		while(!this->decoded.empty() && (int)toUpload.size() < maxUploads)
+		{
+			toUpload.push_back(std::move(this->decoded.front()));
+			this->decoded.pop_front();
+		}
+	}
+
+	int uploaded = 0;
+	for(DecodedIcon& di : toUpload)
+	{
+		this->inFlight.erase(di.path);
+
+		if(!di.success)
+		{
+			this->failed.insert(di.path);
+			continue;
+		}
+
+		TexObj::SPtr tex = std::make_shared<TexObj>();
+		tex->TransferFromRGBA(&di.pixels[0], di.width, di.height);
+
+		this->lru.push_front(di.path);
+		ResidentIcon ri;
+		ri.tex = tex;
+		ri.lruIt = this->lru.begin();
+		this->resident[di.path] = ri;
+
+		++this->loadedCt;
+		++uploaded;
+	}
+
+	this->EvictOverCap();
+	return uploaded;
+}
+
+void CarouselIconCache::EvictOverCap()
+{
+	auto it = this->lru.end();
+	while((int)this->resident.size() > this->maxResident && it != this->lru.begin())
+	{
+		--it;
+
+		auto itRes = this->resident.find(*it);
+
+		// If something other than the cache is still holding the
+		// texture (i.e., it's being drawn), evicting it wouldn't free
+		// anything - so skip it.
+		if(itRes->second.tex.use_count() > 1)
+			continue;
+
+		this->resident.erase(itRes);
+		it = this->lru.erase(it);
+		++this->evictedCt;
+	}
+}
+
+void CarouselIconCache::SetMaxResident(int maxCt)
+{
+	this->maxResident = std::max(1, maxCt);
+	this->EvictOverCap();
+}
+
+void CarouselIconCache::Clear()
+{
+	this->failed.clear();
+
+	for(auto it = this->lru.begin(); it != this->lru.end(); )
+	{
+		auto itRes = this->resident.find(*it);
+		if(itRes->second.tex.use_count() > 1)
+		{
+			++it;
+			continue;
+		}
+
+		this->resident.erase(itRes);
+		it = this->lru.erase(it);
+		++this->evictedCt;
+	}
+}
+
+CarouselIconCache::Stats CarouselIconCache::GetStats() const
+{
+	Stats ret;
+	ret.resident	= (int)this->resident.size();
+	ret.maxResident	= this->maxResident;
+	ret.pending		= (int)this->inFlight.size();
+	ret.failed		= (int)this->failed.size();
+	ret.loaded		= this->loadedCt;
+	ret.evicted		= this->evictedCt;
+	return ret;
+}
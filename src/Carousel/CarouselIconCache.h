@@ -0,0 +1,216 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <set>
+#include <list>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "../TexObj.h"
+
+/// <summary>
+/// On-demand loader and LRU cache for carousel icon textures.
+///
+/// Icons are requested by filepath. PNG decoding happens on a worker
+/// thread, and the OpenGL upload is deferred until ProcessDecoded() is
+/// called from the main (OpenGL) thread. The number of resident textures
+/// is capped, and the least recently requested icons that aren't being
+/// held by anyone else are evicted when over the cap.
+///
+/// Unless otherwise specified, functions are expected to be called from
+/// the main thread.
+/// </summary>
+class CarouselIconCache
+{
+public:
+	/// <summary>
+	/// A snapshot of the cache's bookkeeping, for debug readouts.
+	/// </summary>
+	struct Stats
+	{
+		/// <summary>
+		/// The number of icon textures currently uploaded.
+		/// </summary>
+		int resident = 0;
+
+		/// <summary>
+		/// The maximum number of resident textures before eviction.
+		/// </summary>
+		int maxResident = 0;
+
+		/// <summary>
+		/// The number of icons queued or decoded, but not yet uploaded.
+		/// </summary>
+		int pending = 0;
+
+		/// <summary>
+		/// The number of icon filepaths that could not be loaded.
+		/// </summary>
+		int failed = 0;
+
+		/// <summary>
+		/// The total number of icon textures that have been uploaded.
+		/// </summary>
+		long long loaded = 0;
+
+		/// <summary>
+		/// The total number of icon textures that have been evicted.
+		/// </summary>
+		long long evicted = 0;
+	};
+
+private:
+
+	/// <summary>
+	/// The results of the worker thread decoding a PNG.
+	/// </summary>
+	struct DecodedIcon
+	{
+		std::string path;
+		std::vector<unsigned char> pixels;
+		unsigned width = 0;
+		unsigned height = 0;
+		bool success = false;
+	};
+
+	/// <summary>
+	/// An uploaded icon, and its position in the LRU list.
+	/// </summary>
+	struct ResidentIcon
+	{
+		TexObj::SPtr tex;
+		std::list<std::string>::iterator lruIt;
+	};
+
+	/// <summary>
+	/// Singleton instance.
+	/// </summary>
+	static CarouselIconCache _inst;
+
+	//		MAIN THREAD ONLY
+	//////////////////////////////////////////////////
+
+	/// <summary>
+	/// The uploaded icons, by filepath.
+	/// </summary>
+	std::map<std::string, ResidentIcon> resident;
+
+	/// <summary>
+	/// Filepaths of resident icons, with the most recently requested
+	/// at the front.
+	/// </summary>
+	std::list<std::string> lru;
+
+	/// <summary>
+	/// Filepaths that have been sent to the worker thread but not yet
+	/// uploaded.
+	/// </summary>
+	std::set<std::string> inFlight;
+
+	/// <summary>
+	/// Filepaths that failed to decode. These will not be re-requested
+	/// until Clear() is called.
+	/// </summary>
+	std::set<std::string> failed;
+
+	int maxResident = 16;
+	long long loadedCt = 0;
+	long long evictedCt = 0;
+
+	//		SHARED WITH THE WORKER THREAD
+	//////////////////////////////////////////////////
+
+	/// <summary>
+	/// Guards toDecode, decoded and stopWorker.
+	/// </summary>
+	std::mutex queueMutex;
+
+	/// <summary>
+	/// Signals the worker thread that toDecode or stopWorker has changed.
+	/// </summary>
+	std::condition_variable queueCond;
+
+	/// <summary>
+	/// Filepaths waiting to be decoded by the worker thread.
+	/// </summary>
+	std::deque<std::string> toDecode;
+
+	/// <summary>
+	/// Decoded pixel data waiting to be uploaded on the main thread.
+	/// </summary>
+	std::deque<DecodedIcon> decoded;
+
+	bool stopWorker = false;
+
+	std::thread* worker = nullptr;
+
+private:
+	void WorkerThreadFn();
+
+	/// <summary>
+	/// Evict least recently used textures until there are no more
+	/// than maxResident, or until nothing else can be evicted.
+	/// </summary>
+	void EvictOverCap();
+
+	/// <summary>
+	/// Stop and join the worker thread, if it's running.
+	/// </summary>
+	void StopWorker();
+
+public:
+	/// <summary>
+	/// Public accessor to the singleton instance.
+	/// </summary>
+	static CarouselIconCache& GetInstance();
+
+	/// <summary>
+	/// This should be called at the end of the application's lifetime,
+	/// while the OpenGL context is still alive, to stop the worker
+	/// thread and release the textures.
+	/// </summary>
+	static void ShutdownMgr();
+
+	~CarouselIconCache();
+
+	/// <summary>
+	/// Request the texture for an icon.
+	/// </summary>
+	/// <param name="path">The filepath of the PNG icon.</param>
+	/// <param name="priority">
+	/// If true, the icon is decoded before other queued requests.
+	/// </param>
+	/// <returns>
+	/// The texture if it's resident. Else, nullptr, and the icon is queued
+	/// to be decoded if it isn't already.
+	/// </returns>
+	TexObj::SPtr Request(const std::string& path, bool priority = false);
+
+	/// <summary>
+	/// Upload icons the worker thread has finished decoding, and then
+	/// evict textures over the resident cap.
+	/// </summary>
+	/// <param name="maxUploads">
+	/// The maximum number of textures to upload in this call, to avoid
+	/// stalling a frame.
+	/// </param>
+	/// <returns>The number of textures uploaded.</returns>
+	int ProcessDecoded(int maxUploads = 2);
+
+	/// <summary>
+	/// Set the maximum number of resident textures. Values less than 1
+	/// are clamped to 1.
+	/// </summary>
+	void SetMaxResident(int maxCt);
+
+	/// <summary>
+	/// Release all resident textures that aren't held elsewhere, and
+	/// forget about previous failures.
+	/// </summary>
+	void Clear();
+
+	Stats GetStats() const;
+};
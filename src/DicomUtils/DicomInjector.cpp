@@ -5,6 +5,12 @@ void* DicomInjector::GetInjectorObject()
 	return this;
 }
 
+void DicomInjector::InjectStaticIntoDicom(DcmDataset* dicomData)
+{}
+
+void DicomInjector::InjectIntoDicom(DcmDataset* dicomData)
+{}
+
 DicomInjector::~DicomInjector()
 {}
 
@@ -18,6 +24,11 @@ void* DicomInjectorRef::GetInjectorObject()
 	return this->ref;
 }
 
+void DicomInjectorRef::InjectStaticIntoDicom(DcmDataset* dicomData)
+{
+	this->ref->InjectStaticIntoDicom(dicomData);
+}
+
 void DicomInjectorRef::InjectIntoDicom(DcmDataset* dicomData)
 {
 	this->ref->InjectIntoDicom(dicomData);
@@ -6,6 +6,12 @@
 /// <summary>
 /// A base class for an object that can insert data about itself
 /// into a dicom dataset.
+/// 
+/// The data is split in two: the data that doesn't change during a
+/// session (InjectStaticIntoDicom()), and the data that can change between
+/// snapshots (InjectIntoDicom()). The static data is only injected when a
+/// DicomInjectorSet builds its header template, which every snapshot 
+/// is cloned from.
 /// </summary>
 class DicomInjector
 {
@@ -22,10 +28,21 @@ public:
 	virtual void* GetInjectorObject();
 
 	/// <summary>
-	/// Add the object's dicom data into a dataset.
+	/// Add the object's dicom data that doesn't change during a session
+	/// into a dataset.
+	/// 
+	/// If this data changes, DicomInjectorSet::InvalidateTemplate() needs
+	/// to be called for it to be injected again.
+	/// </summary>
+	/// <param name="dicomData">The dicom dataset to insert data into.</param>
+	virtual void InjectStaticIntoDicom(DcmDataset* dicomData);
+
+	/// <summary>
+	/// Add the object's dicom data that can change between snapshots
+	/// into a dataset.
 	/// </summary>
 	/// <param name="dicomData">The dicom dataset to insert data into.</param>
-	virtual void InjectIntoDicom(DcmDataset* dicomData) = 0;
+	virtual void InjectIntoDicom(DcmDataset* dicomData);
 
 	virtual ~DicomInjector();
 };
@@ -54,6 +71,9 @@ public:
 
 	void* GetInjectorObject() override;
 
+	// Delegates to ref->InjectStaticIntoDicom().
+	void InjectStaticIntoDicom(DcmDataset* dicomData) override;
+
 	// Delegates to ref->InjectIntoDicom().
 	void InjectIntoDicom(DcmDataset* dicomData) override;
 };
@@ -20,6 +20,7 @@ bool DicomInjectorSet::AddInjectorPtr(DicomInjectorPtr ptr)
 		return false;
 
 	this->injectors.push_back(ptr);
+	this->headerTemplate.reset();
 	return true;
 }
 
@@ -31,6 +32,7 @@ bool DicomInjectorSet::AddInjectorRef(DicomInjector* ptr)
 		return false;
 
 	this->injectors.push_back(DicomInjectorPtr(new DicomInjectorRef(ptr)));
+	this->headerTemplate.reset();
 	return true;
 }
 
@@ -47,24 +49,74 @@ bool DicomInjectorSet::RemoveInjector(DicomInjector* ptr, bool objRef)
 		if(it->get()->GetInjectorObject() == ptr)
 		{
 			this->injectors.erase(it);
+			this->headerTemplate.reset();
 			return true;
 		}
 	}
 	return false;
 }
 
-void DicomInjectorSet::InjectDataInto(DcmDataset* ds)
+void DicomInjectorSet::_EnsureTemplate()
+{
+	if(this->headerTemplate != nullptr)
+		return;
+
+	this->headerTemplate.reset(new DcmDataset());
+	for(int i = 0; i < this->injectors.size(); ++i)
+		this->injectors[i]->InjectStaticIntoDicom(this->headerTemplate.get());
+
+	++this->templateBuildCt;
+}
+
+void DicomInjectorSet::InjectDataInto(DcmDataset* ds, bool useTemplate)
 {
 	std::lock_guard<std::mutex> guard(this->accessMutex);
+
+	if(useTemplate)
+	{
+		this->_EnsureTemplate();
+
+		// Copy the elements, instead of the whole dataset, so anything 
+		// already in ds that the template doesn't have is kept.
+		for(unsigned long i = 0; i < this->headerTemplate->card(); ++i)
+		{
+			DcmElement* elem = this->headerTemplate->getElement(i);
+			ds->insert(OFstatic_cast(DcmElement*, elem->clone()), OFTrue);
+		}
+	}
+	else
+	{
+		for(int i = 0; i < this->injectors.size(); ++i)
+			this->injectors[i]->InjectStaticIntoDicom(ds);
+	}
 	
 	for(int i = 0; i < this->injectors.size(); ++i)
 		this->injectors[i]->InjectIntoDicom(ds);
 }
 
+void DicomInjectorSet::PrepareTemplate()
+{
+	std::lock_guard<std::mutex> guard(this->accessMutex);
+	this->_EnsureTemplate();
+}
+
+void DicomInjectorSet::InvalidateTemplate()
+{
+	std::lock_guard<std::mutex> guard(this->accessMutex);
+	this->headerTemplate.reset();
+}
+
+int DicomInjectorSet::GetTemplateBuildCt()
+{
+	std::lock_guard<std::mutex> guard(this->accessMutex);
+	return this->templateBuildCt;
+}
+
 void DicomInjectorSet::Clear()
 {
 	std::lock_guard<std::mutex> guard(this->accessMutex);
 	this->injectors.clear();
+	this->headerTemplate.reset();
 }
 
 DicomInjectorSet& DicomInjectorSet::GetSingleton()
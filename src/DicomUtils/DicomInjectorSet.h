@@ -1,6 +1,7 @@
 #pragma once
 #include <mutex>
 #include <vector>
+#include <memory>
 #include "DicomInjector.h"
 
 /// <summary>
@@ -9,6 +10,11 @@
 /// This allows multiple injects to be stored into a single collection
 /// and allow them to add add their dicom data at once.
 /// 
+/// The static data of the injectors (see DicomInjector::InjectStaticIntoDicom())
+/// is only injected once, into a header template. Injecting into a dataset
+/// copies the template's elements in, and only asks the injectors for their 
+/// data that changes between snapshots.
+/// 
 /// While nothing is stopping multiple DicomInjectorSets
 /// from being instanced, the main way its intended to be
 /// used is with the singleton (see DicomInjectorSet::GetSingleton()).
@@ -34,6 +40,25 @@ protected:
 	/// </summary>
 	std::vector<DicomInjectorPtr> injectors;
 
+	/// <summary>
+	/// The static data of all the injectors. Built when first needed, and 
+	/// reset whenever the injectors, or their static data, change.
+	/// </summary>
+	std::unique_ptr<DcmDataset> headerTemplate;
+
+	/// <summary>
+	/// The number of times the header template has been built.
+	/// </summary>
+	int templateBuildCt = 0;
+
+protected:
+	/// <summary>
+	/// Build the header template, if it isn't already built. 
+	/// 
+	/// Expects accessMutex to be locked.
+	/// </summary>
+	void _EnsureTemplate();
+
 public:
 
 	/// <summary>
@@ -75,7 +100,29 @@ public:
 	/// Have all contained injectors insert their data into a dicom dataset.
 	/// </summary>
 	/// <param name="ds">The dicom dataset to add data into.</param>
-	void InjectDataInto(DcmDataset* ds);
+	/// <param name="useTemplate">
+	/// If true, the static data is copied from the header template. Else the
+	/// injectors are asked for their static data too, which is slower.
+	/// </param>
+	void InjectDataInto(DcmDataset* ds, bool useTemplate = true);
+
+	/// <summary>
+	/// Build the header template ahead of time, so the first snapshot 
+	/// doesn't have to.
+	/// </summary>
+	void PrepareTemplate();
+
+	/// <summary>
+	/// Throw away the header template, so it will be rebuilt. This should be
+	/// called whenever an injector's static data changes, such as when the 
+	/// session is reloaded.
+	/// </summary>
+	void InvalidateTemplate();
+
+	/// <summary>
+	/// Get the number of times the header template has been built.
+	/// </summary>
+	int GetTemplateBuildCt();
 
 	/// <summary>
 	/// Clear all injectors in the set.
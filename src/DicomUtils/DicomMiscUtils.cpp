@@ -7,8 +7,11 @@
 #endif
 
 #include <dcmtk/dcmdata/libi2d/i2d.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcuid.h>
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
 #include <ctime>
 #include <sstream>
 #include <ostream>
@@ -43,6 +46,30 @@ namespace DicomMiscUtils
 
 	}
 
+	std::string GetDateTimeString(long long unixMicroseconds)
+	{
+		boost::posix_time::ptime utcTime = 
+			boost::posix_time::from_time_t(0) + boost::posix_time::microseconds(unixMicroseconds);
+
+		boost::posix_time::ptime localTime = 
+			boost::date_time::c_local_adjustor<boost::posix_time::ptime>::utc_to_local(utcTime);
+
+		boost::gregorian::date date = localTime.date();
+		boost::posix_time::time_duration tod = localTime.time_of_day();
+
+		std::stringstream sstrm;
+		sstrm <<
+			std::setw(4) << std::setfill('0') << date.year() <<
+			std::setw(2) << std::setfill('0') << date.month().as_number() <<
+			std::setw(2) << std::setfill('0') << date.day() <<
+			std::setw(2) << std::setfill('0') << tod.hours() <<
+			std::setw(2) << std::setfill('0') << tod.minutes() <<
+			std::setw(2) << std::setfill('0') << tod.seconds() << "." <<
+			std::setw(6) << std::setfill('0') << (tod.total_microseconds() % 1000000);
+
+		return sstrm.str();
+	}
+
 	bool InsertDicomString(DcmDataset* dset, const DcmTag& tag, const std::string& value, bool insertIfEmpty)
 	{
 		if(insertIfEmpty == false && value.empty())
@@ -50,4 +77,43 @@ namespace DicomMiscUtils
 
 		return dset->putAndInsertString(tag, value.c_str()).good();
 	}
+
+	void InsertSecondaryCaptureHeader(DcmDataset* dset, const char* sopClassUID)
+	{
+		char uid[100];
+		dset->putAndInsertString(DCM_SOPClassUID, sopClassUID);
+		dset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT));
+		if(!dset->tagExistsWithValue(DCM_StudyInstanceUID))
+			dset->putAndInsertString(DCM_StudyInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_STUDY_UID_ROOT));
+		if(!dset->tagExistsWithValue(DCM_SeriesInstanceUID))
+			dset->putAndInsertString(DCM_SeriesInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_SERIES_UID_ROOT));
+		if(!dset->tagExistsWithValue(DCM_Modality))
+			dset->putAndInsertString(DCM_Modality, "OT");
+		if(!dset->tagExists(DCM_SpecificCharacterSet))
+			dset->putAndInsertString(DCM_SpecificCharacterSet, "ISO_IR 100");
+
+		dset->putAndInsertString(DCM_ConversionType, "WSD");
+
+		// Type 2 attributes have to be present, but can be empty.
+		const DcmTagKey type2Tags[] = 
+		{
+			DCM_PatientName,
+			DCM_PatientID,
+			DCM_PatientBirthDate,
+			DCM_PatientSex,
+			DCM_StudyDate,
+			DCM_StudyTime,
+			DCM_ReferringPhysicianName,
+			DCM_StudyID,
+			DCM_AccessionNumber,
+			DCM_SeriesNumber,
+			DCM_InstanceNumber,
+			DCM_PatientOrientation
+		};
+		for(const DcmTagKey& tag : type2Tags)
+		{
+			if(!dset->tagExists(tag))
+				dset->insertEmptyElement(tag);
+		}
+	}
 }
\ No newline at end of file
@@ -22,9 +22,26 @@ namespace DicomMiscUtils
 	/// </summary>
 	std::string GetCurrentTime();
 
+	/// <summary>
+	/// Get a time as a dicom date time string, in the machine's local
+	/// time, with microseconds.
+	/// </summary>
+	/// <param name="unixMicroseconds">The time, in microseconds since the Unix epoch.</param>
+	std::string GetDateTimeString(long long unixMicroseconds);
+
 	bool InsertDicomString(
 		DcmDataset* dset, 
 		const DcmTag& tag, 
 		const std::string& value, 
 		bool insertIfEmpty);
+
+	/// <summary>
+	/// Add the secondary capture identification the same as DCMTK's Image2Dcm
+	/// would, when it checks validity: new UIDs (the study and series UIDs only
+	/// if they're missing), the conversion type, and empty values for missing
+	/// type 2 attributes.
+	/// </summary>
+	/// <param name="dset">The dataset to add to.</param>
+	/// <param name="sopClassUID">The SOP class, such as UID_SecondaryCaptureImageStorage.</param>
+	void InsertSecondaryCaptureHeader(DcmDataset* dset, const char* sopClassUID);
 }
\ No newline at end of file
@@ -2,6 +2,13 @@
 #include "MainWin.h"
 #include <iostream>
 #include "CamVideo/CamStreamMgr.h"
+#include "CamVideo/CamImpl/CamImpl_OCV_HWPath.h"
+#include "CamVideo/CamSyncGroup.h"
+#include "CamVideo/FrameHistory.h"
+#include "CamVideo/DicomCompress.h"
+#include "CamVideo/CaptureStorage.h"
+#include "Utils/cvgTaskPool.h"
+#include "Utils/cvgQualityGovernor.h"
 #include "UISys/UISys.h"
 #include "HMDOpApp.h"
 
@@ -147,10 +154,41 @@ void GLWin::LoadHMDAppOptions(const cvgOptions& opts)
 	UISys::ToggleDebugView(opts.drawUIDebug);
 	//
 	this->fullscreen	= opts.fullscreen;
+	//
+	CamImpl_OCV_HWPath::SetSerializeOpens(!opts.camParallelOpen);
+	cvgThreadPlacement::GetInstance().SetPlacements(opts.threadPlacements, opts.opencvThreads);
+	cvgQualityGovernor::GetInstance().SetEnabled(opts.qualityGovernor);
+	CamSyncGroup::GetInstance().SetEnabled(opts.syncAcquisition);
+	IManagedCam::SetVideoFramePadding(opts.videoFramePadding);
+	IManagedCam::SetMultiFrameBursts(opts.burstMultiFrameDicom);
+	DicomCompress::SetMethod(StringToDicomCompression(opts.dicomCompression));
+
+	FrameHistory::Settings historySettings;
+	historySettings.budgetBytes	= (opts.frameHistoryMB > 0) ? (size_t)opts.frameHistoryMB * 1024 * 1024 : 0;
+	historySettings.maxMS		= (int)(opts.frameHistorySeconds * 1000.0f);
+	historySettings.storage		= StringToFrameHistoryStorage(opts.frameHistoryStorage);
+	historySettings.downscale	= opts.frameHistoryDownscale;
+	historySettings.jpegQuality	= opts.frameHistoryJPEGQuality;
+	FrameHistory::SetSettings(historySettings);
+
+	CaptureStorage::Settings storageSettings;
+	storageSettings.bufferBytes		= (opts.storageBufferMB > 0) ? (size_t)opts.storageBufferMB * 1024 * 1024 : 0;
+	storageSettings.syncBatch		= opts.storageSyncBatch;
+	storageSettings.warnFreeBytes	= (opts.storageWarnFreeMB > 0) ? (uint64_t)opts.storageWarnFreeMB * 1024 * 1024 : 0;
+	storageSettings.preallocate		= opts.storagePreallocate;
+	storageSettings.useIOUring		= opts.storageIOUring;
+	CaptureStorage::GetInstance().SetSettings(storageSettings);
+
+	// The pool is only started once, its worker count isn't changed by
+	// reloading the options.
+	if(opts.taskPoolThreads >= 0 && !cvgTaskPool::GetInstance().IsRunning())
+		cvgTaskPool::GetInstance().Start(opts.taskPoolThreads, opts.taskPoolOpenCV);
 }
 
 void GLWin::SaveOptions(const std::string& saveFilepath) const
 {
+	// Saving isn't a change to react to.
+	this->typedParent->IgnoreOwnOptionsWrite();
 	this->cachedOptions.SaveToFile(saveFilepath);
 }
 
@@ -217,14 +255,14 @@ void GLWin::OnPaint(wxPaintEvent& evt)
 
 	if(!this->initStaticResources)
 	{ 
-
-		this->InitStaticGraphicResources();
-		this->fontMousePos = FontMgr::GetInstance().GetFont(10);
-
 		// If we've just initialized, then we've never successfully 
 		// handled a resize and updated the viewport state yet.
 		this->_SetupGLDimensions();
-		this->typedParent->InitializeAppStateMachine();
+
+		// The static graphic resources and the state machine are 
+		// initialized as part of the startup graph.
+		this->typedParent->RunStartupGraph();
+		this->fontMousePos = FontMgr::GetInstance().GetFont(10);
 	}
 
 	glColor3f(1.0f, 1.0f, 1.0f);
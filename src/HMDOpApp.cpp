@@ -6,6 +6,17 @@
 #include <iostream>
 #include <fstream>
 #include "Utils/cvgOptions.h"
+#include "Utils/cvgTaskPool.h"
+#include "Utils/cvgTaskPoolBenchmark.h"
+#include "CamVideo/PipeBenchmark.h"
+#include "CamVideo/BurstBenchmark.h"
+#include "CamVideo/DicomWriteBenchmark.h"
+#include "CamVideo/FaultRecoveryCheck.h"
+#include "CamVideo/GrabberStallCheck.h"
+#include "CamVideo/MJPEGCaptureCheck.h"
+#include "CamVideo/RawCaptureConvert.h"
+#include "CamVideo/VideoRetime.h"
+#include "CamVideo/CaptureStorage.h"
 #include "OpSession.h"
 #include "Session_Toml.h"
 #include "GenVer.h"
@@ -18,6 +29,18 @@ bool HMDOpApp::OnInit()
     bool createOptionsFile = false;
     bool createSessionFile = false;
     bool showHelp = false;
+    bool benchmarkTaskPool = false;
+    bool benchmarkPipe = false;
+    bool benchmarkBurst = false;
+    bool benchmarkDicom = false;
+    bool checkFaultRecovery = false;
+    bool checkGrabStall = false;
+    bool checkMJPEGCapture = false;
+    double benchmarkFPS = 30.0;
+    std::string convertRawSrc;
+    std::string convertRawDst;
+    std::string retimeSrc;
+    std::string retimeDst;
 
     // Custom AppOptions.json load location
     wxArrayString cmdArgs = this->argv.GetArguments();
@@ -41,6 +64,71 @@ bool HMDOpApp::OnInit()
             continue;
         }
 
+        if(cmdArgs[i] == "--benchmark-taskpool")
+        {
+            benchmarkTaskPool = true;
+            continue;
+        }
+
+        if(cmdArgs[i] == "--benchmark-pipe")
+        {
+            benchmarkPipe = true;
+            continue;
+        }
+
+        if(cmdArgs[i] == "--benchmark-burst")
+        {
+            benchmarkBurst = true;
+            continue;
+        }
+
+        if(cmdArgs[i] == "--benchmark-dicom")
+        {
+            benchmarkDicom = true;
+            continue;
+        }
+
+        if(cmdArgs[i] == "--check-fault-recovery")
+        {
+            checkFaultRecovery = true;
+            continue;
+        }
+
+        if(cmdArgs[i] == "--check-grab-stall")
+        {
+            checkGrabStall = true;
+            continue;
+        }
+
+        if(cmdArgs[i] == "--check-mjpeg-capture")
+        {
+            checkMJPEGCapture = true;
+            continue;
+        }
+
+        if(cmdArgs[i] == "--convert-raw" && i + 2 < cmdArgs.size())
+        {
+            convertRawSrc = cmdArgs[i + 1].ToStdString();
+            convertRawDst = cmdArgs[i + 2].ToStdString();
+            i += 2;
+            continue;
+        }
+
+        if(cmdArgs[i] == "--retime-video" && i + 2 < cmdArgs.size())
+        {
+            retimeSrc = cmdArgs[i + 1].ToStdString();
+            retimeDst = cmdArgs[i + 2].ToStdString();
+            i += 2;
+            continue;
+        }
+
+        if(cmdArgs[i] == "--benchmark-fps" && i + 1 < cmdArgs.size())
+        {
+            cmdArgs[i + 1].ToDouble(&benchmarkFPS);
+            ++i;
+            continue;
+        }
+
         // Any other flags are unknown and ignored.
         if(cmdArgs[i].starts_with("-"))
             continue;
@@ -62,6 +150,40 @@ bool HMDOpApp::OnInit()
         std::cout << "        Create a new default AppOptions JSON file." << std::endl;
         std::cout << "    hmdopapp --create-session [sessfile]" << std::endl;
         std::cout << "        Create a new default TOML file." << std::endl;
+        std::cout << "    hmdopapp --benchmark-taskpool" << std::endl;
+        std::cout << "        Compare the dedicated camera threads against the shared task pool" << std::endl;
+        std::cout << "        with simulated cameras, and exit." << std::endl;
+        std::cout << "    hmdopapp --benchmark-taskpool --benchmark-fps [fps]" << std::endl;
+        std::cout << "        Run the task pool benchmark at a frame rate other than 30 FPS," << std::endl;
+        std::cout << "        e.g., 60, to check the frame rate can be sustained." << std::endl;
+        std::cout << "    hmdopapp --benchmark-pipe [--benchmark-fps [fps]]" << std::endl;
+        std::cout << "        Measure the throughput and latency of an external pipe camera, streaming" << std::endl;
+        std::cout << "        from pipe_testgen.py in the working directory, and exit." << std::endl;
+        std::cout << "    hmdopapp --benchmark-burst [--benchmark-fps [fps]]" << std::endl;
+        std::cout << "        Check burst snapshots can capture every frame of a simulated sensor at" << std::endl;
+        std::cout << "        its full rate, and exit." << std::endl;
+        std::cout << "    hmdopapp --benchmark-dicom" << std::endl;
+        std::cout << "        Compare the write throughput of a DICOM file per frame against one" << std::endl;
+        std::cout << "        multi-frame DICOM file, uncompressed and losslessly compressed, check" << std::endl;
+        std::cout << "        every file decodes back bit-exact, time building snapshot headers from" << std::endl;
+        std::cout << "        the session's header template, and exit." << std::endl;
+        std::cout << "    hmdopapp --check-fault-recovery" << std::endl;
+        std::cout << "        Stream a generated image through simulated frame drops, stalls and" << std::endl;
+        std::cout << "        disconnects, check the camera recovers from each, and exit." << std::endl;
+        std::cout << "    hmdopapp --check-grab-stall" << std::endl;
+        std::cout << "        Stall a stand-in stream under the low latency grabber, check polling," << std::endl;
+        std::cout << "        setting properties and stopping aren't held up by it, and exit." << std::endl;
+        std::cout << "    hmdopapp --check-mjpeg-capture" << std::endl;
+        std::cout << "        Poll a synthesized MJPEG stream through a stand-in camera, check the" << std::endl;
+        std::cout << "        frames decode in order, check the capture modes chosen for a typical" << std::endl;
+        std::cout << "        USB camera, and exit." << std::endl;
+        std::cout << "    hmdopapp --convert-raw [rawdir] [output]" << std::endl;
+        std::cout << "        Convert a raw capture recording to a video file if output ends in .mp4" << std::endl;
+        std::cout << "        or .mkv, to a multi-frame DICOM file if it ends in .dcm, else to a" << std::endl;
+        std::cout << "        directory of DICOM files, and exit." << std::endl;
+        std::cout << "    hmdopapp --retime-video [video] [output]" << std::endl;
+        std::cout << "        Export a recorded video at a constant frame rate, with frames placed at" << std::endl;
+        std::cout << "        the capture times in its .timestamps file, and exit." << std::endl;
         std::cout << "    hmdopapp [optsfile]" << std::endl;
         std::cout << "        Open the GUI with a specific AppOptions file." << std::endl;
         std::cout << std::endl << std::endl;
@@ -70,10 +192,66 @@ bool HMDOpApp::OnInit()
         std::cout << "        The AppOptions json file. Defaulted to AppOptions.json." << std::endl;
         std::cout << "    sessfile" << std::endl;
         std::cout << "        The sessions toml file. Defaulted to Session.toml." << std::endl;
+        std::cout << "    rawdir" << std::endl;
+        std::cout << "        The directory of a raw capture recording (raw_recording in AppOptions)." << std::endl;
 
         exit(1);
     }
 
+    if(benchmarkTaskPool)
+    {
+        cvgTaskPoolBenchmark::Run(std::cout, 10, benchmarkFPS);
+        exit(0);
+    }
+
+    if(benchmarkPipe)
+    {
+        PipeBenchmark::Run(std::cout, 10, benchmarkFPS);
+        exit(0);
+    }
+
+    if(benchmarkBurst)
+    {
+        bool fullRate = BurstBenchmark::Run(std::cout, 20, benchmarkFPS);
+        exit(fullRate ? 0 : 1);
+    }
+
+    if(benchmarkDicom)
+    {
+        bool written = DicomWriteBenchmark::Run(std::cout, 60);
+        exit(written ? 0 : 1);
+    }
+
+    if(checkFaultRecovery)
+    {
+        bool recovered = FaultRecoveryCheck::Run(std::cout);
+        exit(recovered ? 0 : 1);
+    }
+
+    if(checkGrabStall)
+    {
+        bool responsive = GrabberStallCheck::Run(std::cout);
+        exit(responsive ? 0 : 1);
+    }
+
+    if(checkMJPEGCapture)
+    {
+        bool decoded = MJPEGCaptureCheck::Run(std::cout);
+        exit(decoded ? 0 : 1);
+    }
+
+    if(!convertRawSrc.empty())
+    {
+        bool converted = RawCaptureConvert::Convert(convertRawSrc, convertRawDst);
+        exit(converted ? 0 : 1);
+    }
+
+    if(!retimeSrc.empty())
+    {
+        bool retimed = VideoRetime::ToConstantRate(retimeSrc, retimeDst);
+        exit(retimed ? 0 : 1);
+    }
+
     // If a create document param was found, the don't run the UI at all,
     // we just create the requested documents and exit.
     if(createOptionsFile || createSessionFile)
@@ -105,6 +283,10 @@ bool HMDOpApp::OnInit()
 int HMDOpApp::OnExit()
 {
     CamStreamMgr::ShutdownMgr();
+    // After the cameras, so their queued encodes can finish.
+    cvgTaskPool::GetInstance().Shutdown();
+    // After the task pool, so the snapshots it encoded are written.
+    CaptureStorage::GetInstance().Shutdown();
     FontMgr::ShutdownMgr();
 
     return this->wxApp::OnExit();
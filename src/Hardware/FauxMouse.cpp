@@ -1,4 +1,5 @@
 #include "FauxMouse.h"
+#include "../Utils/cvgThreadPlacement.h"
 
 // All this stuff should really only be available for RPi, and not
 // Windows/Visual Studio, but we add it and expose some stuff just
@@ -103,10 +104,14 @@ bool FauxMouse::Initialize()
 		new std::thread(
 			[this]
 			{
+				cvgThreadPlacement::GetInstance().ApplyToCurrentThread("fauxmouse");
+
 				this->keepRunning = true;
 				this->threadRunning = true;
 				ThreadPollFn(this);
 				this->threadRunning = false;
+
+				cvgThreadPlacement::GetInstance().UnregisterCurrentThread();
 			});
 
 	std::cout << "Using FauxMouse" << std::endl;
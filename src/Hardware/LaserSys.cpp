@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <iostream>
 #include "../Utils/cvgAssert.h"
+#include "../CamVideo/RawCaptureWriter.h"
 
 // Something is defining macros for min and max, 
 // which we'll need to undo.
@@ -108,6 +109,9 @@ void LaserSys::SetLight(Light l, float intensity)
 		this->intensityWhite = intensity;
 		break;
 	}
+
+	// Recorded with every raw captured frame.
+	RawCaptureWriter::SetLightState(this->intensityNIR, this->intensityWhite);
 }
 
 void LaserSys::SetDefault(Light l, float intensity, DefaultSetMode setMode)
@@ -201,7 +205,7 @@ DicomInjector* LaserSys::GetInjector()
 	return this;
 }
 
-void LaserSys::InjectIntoDicom(DcmDataset* dicomData)
+void LaserSys::InjectStaticIntoDicom(DcmDataset* dicomData)
 {
 	// TODO: Sample dicom injection
 	dicomData->putAndInsertFloat32(
@@ -211,12 +215,20 @@ void LaserSys::InjectIntoDicom(DcmDataset* dicomData)
 	if(!dicomData->findOrCreateSequenceItem(DCM_DeviceSequence, deviceInfo, -2).good())
 		return;
 
-	float nirPercent = this->intensityNIR * 100.0f;
-	std::string strPercent = std::to_string(nirPercent) + "%";
-	deviceInfo->putAndInsertString(DCM_OutputPower, strPercent.c_str());
-
 	deviceInfo->putAndInsertString(DCM_CodeMeaning, "Laser System for IR viewing of contrast dye.");
 	deviceInfo->putAndInsertString(DCM_DeviceDescription, "Laser System");
 	deviceInfo->putAndInsertString(DCM_Manufacturer, "__Manufacturer_TBD__");
 	deviceInfo->putAndInsertString(DCM_DeviceID, "__DeviceID_TBD__");
+}
+
+void LaserSys::InjectIntoDicom(DcmDataset* dicomData)
+{
+	// The device item added by InjectStaticIntoDicom().
+	DcmItem* deviceInfo;
+	if(!dicomData->findOrCreateSequenceItem(DCM_DeviceSequence, deviceInfo, -1).good())
+		return;
+
+	float nirPercent = this->intensityNIR * 100.0f;
+	std::string strPercent = std::to_string(nirPercent) + "%";
+	deviceInfo->putAndInsertString(DCM_OutputPower, strPercent.c_str());
 }
\ No newline at end of file
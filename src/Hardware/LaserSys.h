@@ -142,5 +142,8 @@ public:
 	//	DicomInjector FUNCTIONS
 	//
 	//////////////////////////////////////////////////
+	void InjectStaticIntoDicom(DcmDataset* dicomData) override;
+
+	// The output power, which changes with the laser intensity.
 	void InjectIntoDicom(DcmDataset* dicomData) override;
 };
\ No newline at end of file
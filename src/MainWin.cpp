@@ -25,9 +25,14 @@
 #include "AppVersionDicom.h"
 #include <vector>
 #include <sstream>
+#include <iomanip>
 #include "Utils/cvgAssert.h"
 #include "Utils/TimeUtils.h"
+#include "Utils/cvgTaskPool.h"
+#include "CamVideo/CaptureStorage.h"
 #include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcdict.h>
+#include "TexObj.h"
 
 #include "States/StateIntro.h"
 #include "States/StateInitCameras.h"
@@ -44,6 +49,8 @@ wxBEGIN_EVENT_TABLE(MainWin, wxFrame)
 	EVT_MENU		(wxID_EXIT,  MainWin::OnExit)
 	EVT_MENU		(wxID_SAVE,  MainWin::OnAccelerator_SaveCurOptions)
 	EVT_MENU		((int)CommandID::Fullscreen,  MainWin::OnAccelerator_ToggleFullscreen)
+	EVT_MENU		((int)CommandID::DumpThreads,  MainWin::OnAccelerator_DumpThreads)
+	EVT_MENU		((int)CommandID::ToggleSession,  MainWin::OnAccelerator_ToggleSession)
 	
 	EVT_SET_FOCUS	(MainWin::OnFocus			)
 	EVT_SIZE		(MainWin::OnResize			)	
@@ -76,7 +83,20 @@ MainWin::MainWin(const wxString& title, const wxPoint& pos, const wxSize& size)
 
 	//////////////////////////////////////////////////
 
+	double optionsStartMS = this->startupGraph.MSSinceEpoch();
 	this->ReloadAppOptions();
+	this->startupGraph.RecordEvent("ParseOptions", optionsStartMS, this->startupGraph.MSSinceEpoch());
+	this->startupGraph.SetTimelineJSONPath(this->innerGLWin->cachedOptions.startupTimelinePath);
+
+	// The placement options were just loaded, and this is the main thread.
+	cvgThreadPlacement::GetInstance().ApplyToCurrentThread("main");
+
+	// Watch the options file so edits take effect without a restart.
+	// The callback is on the watcher's thread, so defer the actual 
+	// reload to the main thread.
+	this->optionsWatcher.Start(
+		wxGetApp().appOptionsLoc,
+		[this]{ this->CallAfter([this]{ this->HotReloadAppOptions(); }); });
 
 	//
 	//		HARDWARE INIT AND MANAGEMENT	
@@ -109,6 +129,8 @@ MainWin::MainWin(const wxString& title, const wxPoint& pos, const wxSize& size)
 	entries.push_back(wxAcceleratorEntry(wxACCEL_ALT, WXK_F4, wxID_EXIT));
 	entries.push_back(wxAcceleratorEntry(wxACCEL_CTRL, 'S', wxID_SAVE));
 	entries.push_back(wxAcceleratorEntry(wxACCEL_ALT, WXK_RETURN, (int)CommandID::Fullscreen));
+	entries.push_back(wxAcceleratorEntry(wxACCEL_CTRL, 'T', (int)CommandID::DumpThreads));
+	entries.push_back(wxAcceleratorEntry(wxACCEL_CTRL, 'R', (int)CommandID::ToggleSession));
 
 	// Setup Alt+F4 to exit the app (we lost that when we stripped the app
 	// to be bare-bone since that keyboard accelerator was originally handled
@@ -153,6 +175,8 @@ bool MainWin::InitializeSession()
 		switch(lr)
 		{
 		case OpSession::LoadRet::Success:
+			// The session's Dicom data is in the header template.
+			DicomInjectorSet::GetSingleton().InvalidateTemplate();
 			return true;
 
 		case OpSession::LoadRet::OpenError:
@@ -208,6 +232,60 @@ void MainWin::PerformMaintenenceCycle()
 {
 	this->ClearFinishedSnaps();
 	this->ClearFinishedRecordings();
+	this->_CheckStartupCamerasReady();
+}
+
+void MainWin::DumpThreadDiagnostics(std::ostream& os)
+{
+	cvgThreadPlacement::GetInstance().DumpPlacement(os);
+
+	CamStreamMgr& camMgr = CamStreamMgr::GetInstance();
+
+	std::vector<int> streamIds;
+	for(int i = 0; i < this->innerGLWin->cachedOptions.feedOpts.size(); ++i)
+		streamIds.push_back(i);
+
+	streamIds.push_back(SpecialCams::Composite);
+
+	os << "Frame intervals:" << std::endl;
+	for(int id : streamIds)
+	{
+		cvgJitterMeter::Stats jitter = camMgr.GetFrameJitter(id);
+		os << std::fixed << std::setprecision(2) << 
+			"\t" << ((id == SpecialCams::Composite) ? std::string("composite") : "camera_" + std::to_string(id)) <<
+			" - Frames: " << jitter.sampleCt << 
+			" - Mean MS: " << jitter.meanMS << 
+			" - Jitter MS: " << jitter.jitterMS << 
+			" - Min MS: " << jitter.minMS << 
+			" - Max MS: " << jitter.maxMS << std::endl;
+	}
+
+	cvgTaskPool::GetInstance().DumpMetrics(os);
+}
+
+void MainWin::_CheckStartupCamerasReady()
+{
+	if(this->camBootStartMS < 0.0)
+		return;
+
+	CamStreamMgr& camMgr = CamStreamMgr::GetInstance();
+	for(int i = 0; i < this->camBootCt; ++i)
+	{
+		if(
+			camMgr.GetState(i) != ManagedCam::State::Polling || 
+			camMgr.GetCurrentFrame(i) == nullptr)
+		{
+			return;
+		}
+	}
+
+	this->startupGraph.RecordEvent("CamerasReady", this->camBootStartMS, this->startupGraph.MSSinceEpoch());
+	std::cout << "All cameras ready " << (this->startupGraph.MSSinceEpoch() - this->camBootStartMS) << "ms after booting." << std::endl;
+
+	// All the pipeline threads have booted, so this is the first point
+	// the placement can be fully reported.
+	cvgThreadPlacement::GetInstance().DumpPlacement(std::cout);
+	this->camBootStartMS = -1.0;
 }
 
 void MainWin::PlayAudio_CameraSnap()
@@ -247,66 +325,52 @@ std::string MainWin::GetSessionsFolder() const
 
 std::string MainWin::EnsureAndGetCapturesFolder() const
 {
-	std::string folderLoc = this->GetSessionsFolder();
-		
-
-	// Check if the subfolders exist, if not, make them ahead of time.
-	// NOTE: This is just creating the request. We may want to defer this
-	// to when the requests are actually handled. 
-	//
-	// We don't rely on the return value of wxMkDir. For some reason it's
-	// always failing even when it creates a valid folder. Instead we 
-	// recheck the existence of the folder.
-	if(!wxDirExists("Captures"))
-	{
-		wxMkDir("Captures", wxS_DIR_DEFAULT);
-		if(!wxDirExists("Captures"))
-			return "";
-	}
-
-	if(!wxDirExists(folderLoc))
-	{
-		wxMkDir(folderLoc, wxS_DIR_DEFAULT);
-		if(!wxDirExists(folderLoc))
-			return "";
-
-		// If we need to create the session folder for the first time, also
-		// drop in the AppOptions.json and Session.json for clerical reasons,
-		// in case that data needs to be revisited after the operation.
-		bool sessionWritten = false;
-		bool appOptsWritten = false;
-	
-		if(wxFileExists(wxGetApp().sessionLoc))
-			sessionWritten = wxCopyFile(wxGetApp().sessionLoc, folderLoc + "/Session.toml", false);
-
-		const std::string& appOptsLoc = wxGetApp().appOptionsLoc;
-		if(wxFileExists(appOptsLoc.c_str()))
+	// The CaptureStorage creates the folder the first time it's asked for,
+	// and after that returns it without checking the disk, since this is
+	// called for every capture request. If the folder is removed during
+	// the session, it's recreated when a capture is written to it: by the
+	// storage for snapshots, and with CaptureStorage::EnsureParentFolder()
+	// by videos and multi-frame DICOMs when they're opened. Raw captures
+	// and sessions create their own directories.
+	return CaptureStorage::GetInstance().EnsureSessionFolder(
+		this->GetSessionsFolder(),
+		[](const std::string& folderLoc)
 		{
-			// The AppOptions.json location is only "AppOptions.json" by default but
-			// can be reassigned via commandline - and can be an absolute value. So
-			// when taking its filename for the copy destination, we need to make sure
-			// we're appending a filename and not an absolute path.
-			wxFileName appOptsFilename(appOptsLoc);
-			//
-			appOptsWritten = wxCopyFile(appOptsLoc, folderLoc + "/" + appOptsFilename.GetFullName());
-		}
-
-		if(!sessionWritten)
-			std::cerr << "Could not copy clerical version of " << wxGetApp().sessionLoc << " into session folder; invalid folder/file or file already existed." << std::endl;
-
-		if(!appOptsWritten)
-			std::cerr << "Could not copy clerical version of AppOptions.json into session folder; invalid folder/file or file already existed." << std::endl;
+			// If we need to create the session folder for the first time, also
+			// drop in the AppOptions.json and Session.json for clerical reasons,
+			// in case that data needs to be revisited after the operation.
+			bool sessionWritten = false;
+			bool appOptsWritten = false;
+	
+			if(wxFileExists(wxGetApp().sessionLoc))
+				sessionWritten = wxCopyFile(wxGetApp().sessionLoc, folderLoc + "/Session.toml", false);
 
+			const std::string& appOptsLoc = wxGetApp().appOptionsLoc;
+			if(wxFileExists(appOptsLoc.c_str()))
+			{
+				// The AppOptions.json location is only "AppOptions.json" by default but
+				// can be reassigned via commandline - and can be an absolute value. So
+				// when taking its filename for the copy destination, we need to make sure
+				// we're appending a filename and not an absolute path.
+				wxFileName appOptsFilename(appOptsLoc);
+				//
+				appOptsWritten = wxCopyFile(appOptsLoc, folderLoc + "/" + appOptsFilename.GetFullName());
+			}
 
-	}
+			if(!sessionWritten)
+				std::cerr << "Could not copy clerical version of " << wxGetApp().sessionLoc << " into session folder; invalid folder/file or file already existed." << std::endl;
 
-	return folderLoc;
+			if(!appOptsWritten)
+				std::cerr << "Could not copy clerical version of AppOptions.json into session folder; invalid folder/file or file already existed." << std::endl;
+		});
 }
 
 SnapRequest::SPtr MainWin::RequestSnap(
 	int idx, 
 	const std::string& prefix, 
-	SnapRequest::ProcessType procType)
+	SnapRequest::ProcessType procType,
+	SnapRequest::FrameSelect select,
+	int lookbackMS)
 {
 	CamStreamMgr & camMgr = CamStreamMgr::GetInstance();
 	if(camMgr.GetState(idx) != ManagedCam::State::Polling)
@@ -324,7 +388,7 @@ SnapRequest::SPtr MainWin::RequestSnap(
 
 	++this->snapCtr;
 
-	SnapRequest::SPtr snreq = camMgr.RequestSnapshot(idx, filepath, procType);
+	SnapRequest::SPtr snreq = camMgr.RequestSnapshot(idx, filepath, procType, select, lookbackMS);
 	this->waitingSnaps.push_back(snreq);
 	this->cameraSnap.Play();
 	return snreq;
@@ -341,9 +405,13 @@ VideoRequest::SPtr MainWin::RecordVideo(int idx, const std::string& prefix)
 	if(folderLoc.empty())
 		return VideoRequest::MakeError("Could not allocate capture session folder");
 
+	// Raw captures are a directory instead of a single file.
+	bool raw = this->innerGLWin->cachedOptions.rawRecording;
+	VideoRequest::Format format = raw ? VideoRequest::Format::Raw : VideoRequest::Format::Compressed;
+
 	// Build snapshot image filename
 	std::stringstream sstrmFilepath;
-	sstrmFilepath << folderLoc << "/Video_" << FileDateTimeNow() << "_" << prefix << "_" << this->videoCtr << ".mkv";
+	sstrmFilepath << folderLoc << "/Video_" << FileDateTimeNow() << "_" << prefix << "_" << this->videoCtr << (raw ? ".cvgraw" : ".mkv");
 	std::string filepath = sstrmFilepath.str();
 
 	++this->videoCtr;
@@ -351,7 +419,8 @@ VideoRequest::SPtr MainWin::RecordVideo(int idx, const std::string& prefix)
 	// The video recording may cancel another video recording in another
 	// file. We will handle that later by cleaning recordingVideos during the
 	// regular maintenence cycle.
-	VideoRequest::SPtr snreq = camMgr.RecordVideo(idx, filepath);
+	int preRollMS = (int)(this->innerGLWin->cachedOptions.videoPreRollSeconds * 1000.0f);
+	VideoRequest::SPtr snreq = camMgr.RecordVideo(idx, filepath, format, preRollMS);
 	this->recordingVideos.push_back(snreq);
 	// A different audio should be played for video (and perhaps one when 
 	// we detect the recording has been stopped - in the maintainence cycle).
@@ -372,11 +441,83 @@ bool MainWin::StopRecording(int idx)
 	return camMgr.StopRecording(idx);
 }
 
+SessionRecording::SPtr MainWin::RecordSession(const std::string& prefix)
+{
+	this->StopSession();
+
+	std::string folderLoc = this->EnsureAndGetCapturesFolder();
+	if(folderLoc.empty())
+		return nullptr;
+
+	// Every camera as it was captured, and the composite as it was shown.
+	std::vector<SessionRecording::StreamReq> streams;
+	for(int i = 0; i < this->innerGLWin->cachedOptions.feedOpts.size(); ++i)
+		streams.push_back({i, VideoRequest::Source::Unprocessed});
+	streams.push_back({SpecialCams::Composite, VideoRequest::Source::Processed});
+
+	std::stringstream sstrmDirpath;
+	sstrmDirpath << folderLoc << "/Session_" << FileDateTimeNow() << "_" << prefix << "_" << this->videoCtr;
+	++this->videoCtr;
+
+	CamStreamMgr & camMgr = CamStreamMgr::GetInstance();
+	this->activeSession = camMgr.RecordSession(sstrmDirpath.str(), streams);
+	if(this->activeSession == nullptr)
+		return nullptr;
+
+	for(const SessionRecording::Stream& s : this->activeSession->Streams())
+		this->recordingVideos.push_back(s.req);
+
+	this->cameraSnap.Play();
+	return this->activeSession;
+}
+
+bool MainWin::StopSession()
+{
+	if(this->activeSession == nullptr)
+		return false;
+
+	CamStreamMgr & camMgr = CamStreamMgr::GetInstance();
+	bool ret = camMgr.StopSession(this->activeSession);
+	this->activeSession = nullptr;
+	return ret;
+}
+
 void MainWin::ReloadAppOptions()
 {
 	this->innerGLWin->InitializeOptions();
 }
 
+void MainWin::IgnoreOwnOptionsWrite()
+{
+	// Long enough for the write, and the watcher to see it.
+	this->optionsWatcher.IgnoreChangesFor(1000);
+}
+
+bool MainWin::HotReloadAppOptions()
+{
+	const std::string& optsLoc = wxGetApp().appOptionsLoc;
+
+	// Load into a temporary first. If the file is mid-save or has a 
+	// syntax error, keep running with what we have instead of falling
+	// back to defaults (and overwriting the file, like InitializeOptions()
+	// would).
+	cvgOptions reloaded(0, false);
+	if(!reloaded.LoadFromFile(optsLoc))
+	{
+		std::cerr << "Could not reload options from " << optsLoc << ", keeping current options." << std::endl;
+		return false;
+	}
+
+	std::cout << "Reloading options from " << optsLoc << std::endl;
+	this->innerGLWin->cachedOptions = reloaded;
+	this->innerGLWin->LoadHMDAppOptions();
+
+	// If the cameras haven't been booted yet, they'll pick up the 
+	// new cachedOptions when they are.
+	CamStreamMgr::GetInstance().ReloadCameraOptions(reloaded.feedOpts);
+	return true;
+}
+
 void MainWin::InitializeAppStateMachine()
 {
 	this->PopulateStates();
@@ -384,6 +525,122 @@ void MainWin::InitializeAppStateMachine()
 	this->ChangeState(BaseState::AppState::Intro);
 }
 
+void MainWin::RunStartupGraph()
+{
+	typedef cvgStartupGraph::Affinity Affinity;
+
+	// The PNG decoding is split by asset directory so they can decode
+	// in parallel. The actual OpenGL uploads still happen on the main
+	// thread when the assets are loaded, but will pick up the preloaded
+	// pixels. CarIcons isn't included, it's loaded lazily by the 
+	// CarouselIconCache.
+	static const std::vector<std::string> preloadDirs = 
+	{
+		"Assets",
+		"Assets/ButtonAnno",
+		"Assets/Loading",
+		"Assets/MenubarIcos",
+		"Assets/Mousepad",
+		"Assets/Splash",
+		"Assets/UIPlates"
+	};
+
+	std::vector<std::string> decodeTasks;
+	for(const std::string& dir : preloadDirs)
+	{
+		std::string taskName = "Decode:" + dir;
+		decodeTasks.push_back(taskName);
+
+		this->startupGraph.AddTask(
+			taskName, 
+			{},
+			[dir]
+			{
+				TexObj::PreloadLODEDirectory(dir);
+				return true;
+			});
+	}
+
+	// Loading the dictionary happens lazily the first time it's 
+	// accessed, which would otherwise be the first snapshot.
+	this->startupGraph.AddTask(
+		"DicomDictionary",
+		{},
+		[]
+		{
+			if(!dcmDataDict.isDictionaryLoaded())
+			{
+				std::cerr << "Could not load DICOM data dictionary, check environment variable: " << DCM_DICT_ENVIRONMENT_VARIABLE << std::endl;
+				return false;
+			}
+			return true;
+		});
+
+	// This only starts the camera threads, which each connect to their 
+	// camera independently. When they're all streaming is recorded later
+	// as the CamerasReady event, see _CheckStartupCamerasReady().
+	const std::vector<cvgCamFeedSource> feedOpts = this->innerGLWin->cachedOptions.feedOpts;
+	this->startupGraph.AddTask(
+		"BootCameras",
+		{},
+		[this, feedOpts]
+		{
+			double bootStartMS = this->startupGraph.MSSinceEpoch();
+			if(!CamStreamMgr::GetInstance().BootConnectionToCamera(feedOpts))
+				return false;
+
+			this->camBootStartMS = bootStartMS;
+			this->camBootCt = (int)feedOpts.size();
+			return true;
+		});
+
+	// Everything that touches OpenGL (or FontMgr, which isn't threadsafe)
+	// runs on the main thread, while the worker tasks run in the background.
+	this->startupGraph.AddTask(
+		"Fonts",
+		{},
+		[]
+		{
+			// Sizes used by the UI, so they don't load mid-frame later.
+			for(int fontSz : {10, 12, 24, 40, 50, 100})
+				FontMgr::GetInstance().GetFont(fontSz);
+
+			return true;
+		},
+		Affinity::MainThread);
+
+	this->startupGraph.AddTask(
+		"StaticGraphics",
+		{"Decode:Assets/Loading"},
+		[this]
+		{
+			this->innerGLWin->InitStaticGraphicResources();
+			return true;
+		},
+		Affinity::MainThread);
+
+	std::vector<std::string> stateDeps = decodeTasks;
+	stateDeps.push_back("Fonts");
+	stateDeps.push_back("StaticGraphics");
+	this->startupGraph.AddTask(
+		"StateMachine",
+		stateDeps,
+		[this]
+		{
+			this->InitializeAppStateMachine();
+			return true;
+		},
+		Affinity::MainThread);
+
+	this->startupGraph.Run();
+
+	// Anything preloaded that wasn't used by now is for something that's 
+	// loaded later, or not at all. Either way, don't keep it around.
+	TexObj::ClearPreloaded();
+
+	this->startupGraph.PrintTimeline(std::cout);
+}
+
 void MainWin::PopulateStates()
 {
 	HMDOpApp& app = wxGetApp();
@@ -484,6 +741,10 @@ void MainWin::OnResize(wxSizeEvent& evt)
 
 void MainWin::OnExit(wxCommandEvent& event)
 {
+	this->optionsWatcher.Stop();
+	// Finish the session while the cameras are still running, so its 
+	// index is written.
+	this->StopSession();
 	this->innerGLWin->ReleaseStaticGraphicResources();
 	this->States_AppShutdown();
 	this->Close( true );
@@ -502,6 +763,28 @@ void MainWin::OnAccelerator_ToggleFullscreen(wxCommandEvent& evt)
 	this->SetWindowFullscreen(!isFull);
 }
 
+void MainWin::OnAccelerator_DumpThreads(wxCommandEvent& evt)
+{
+	this->DumpThreadDiagnostics(std::cout);
+}
+
+void MainWin::OnAccelerator_ToggleSession(wxCommandEvent& evt)
+{
+	if(this->IsRecordingSession())
+	{
+		std::cout << "Pressed shortcut key to stop the session recording." << std::endl;
+		this->StopSession();
+		return;
+	}
+
+	std::cout << "Pressed shortcut key to start a session recording." << std::endl;
+	SessionRecording::SPtr session = this->RecordSession("session");
+	if(session == nullptr)
+		std::cout << "The session recording could not be started." << std::endl;
+	else
+		std::cout << "Recording session to " << session->DirPath() << std::endl;
+}
+
 void MainWin::SetWindowFullscreen(bool fullscreen)
 {
 	if (fullscreen)
@@ -13,6 +13,9 @@
 #include "OpSession.h"
 #include "CamVideo/SnapRequest.h"
 #include "CamVideo/VideoRequest.h"
+#include "CamVideo/SessionRecording.h"
+#include "Utils/cvgFileWatcher.h"
+#include "Utils/cvgStartupGraph.h"
 
 /// <summary>
 /// The main application top-level window.
@@ -23,7 +26,9 @@ class MainWin:
 public:
     enum class CommandID
     {
-        Fullscreen = 0
+        Fullscreen = 0,
+        DumpThreads,
+        ToggleSession
     };
 private:
 
@@ -57,7 +62,38 @@ private:
     /// </summary>
     int originalWindowFlags = 0;
 
+    /// <summary>
+    /// Watches the AppOptions file so edits can be applied while
+    /// the application is running. See HotReloadAppOptions().
+    /// </summary>
+    cvgFileWatcher optionsWatcher;
+
+    /// <summary>
+    /// When the startup graph booted the cameras, on the startupGraph's 
+    /// clock. Negative if the cameras weren't booted by the startup graph,
+    /// or if the CamerasReady event was already recorded.
+    /// </summary>
+    double camBootStartMS = -1.0;
+
+    /// <summary>
+    /// The number of cameras booted by the startup graph.
+    /// </summary>
+    int camBootCt = 0;
+
+    /// <summary>
+    /// Check if all the cameras booted by the startup graph have a
+    /// frame, and if so, record the CamerasReady event in the startup
+    /// timeline. Called every maintenance cycle until that happens.
+    /// </summary>
+    void _CheckStartupCamerasReady();
+
 public:
+    /// <summary>
+    /// The startup tasks, and the timeline of how long startup took.
+    /// See RunStartupGraph().
+    /// </summary>
+    cvgStartupGraph startupGraph;
+
     inline BaseState* CurrState()
     { return this->curState; }
 
@@ -79,6 +115,11 @@ public:
     /// </summary>
     std::vector<VideoRequest::SPtr> recordingVideos;
 
+    /// <summary>
+    /// The session being recorded, or nullptr.
+    /// </summary>
+    SessionRecording::SPtr activeSession;
+
     /// <summary>
     /// Sound to be played when a snapshot request is performed.
     /// </summary>
@@ -110,6 +151,13 @@ public:
     /// </summary>
     void PerformMaintenenceCycle();
 
+    /// <summary>
+    /// Print where the app's threads are running and at what priority,
+    /// and how regularly each camera thread is delivering frames. Used
+    /// to compare the thread_placement options against the defaults.
+    /// </summary>
+    void DumpThreadDiagnostics(std::ostream& os);
+
     void PlayAudio_CameraSnap();
 
     inline int GetSnapCounter() const
@@ -162,11 +210,24 @@ public:
     /// The filename prefix. An arbitrary string that can be changed in the filename pattern.
     /// </param>
     /// <param name="procType">The processing type to capture a snapshot of.</param>
+    /// <param name="select">
+    /// Which frame to capture. Frames from before the request need the frame
+    /// history to be enabled (frame_history_mb in the app options).
+    /// </param>
+    /// <param name="lookbackMS">
+    /// How far back to look for the frame, if select isn't FrameSelect::Next.
+    /// </param>
     /// <returns>The SnapRequest from CamStreamMgr.</returns>
-    SnapRequest::SPtr RequestSnap(int idx, const std::string& prefix, SnapRequest::ProcessType procType);
+    SnapRequest::SPtr RequestSnap(
+        int idx, 
+        const std::string& prefix, 
+        SnapRequest::ProcessType procType,
+        SnapRequest::FrameSelect select = SnapRequest::FrameSelect::Next,
+        int lookbackMS = 0);
 
     /// <summary>
-    /// Set a camera to start saving to a video file.
+    /// Set a camera to start saving to a video file. Compressed videos
+    /// start video_preroll_seconds (from the app options) in the past.
     /// </summary>
     /// <param name="idx">The index of the video to record</param>
     /// <param name="prefix">The prefix to apply to the video.</param>
@@ -189,6 +250,23 @@ public:
     /// <returns>True if the request was successful.</returns>
     bool StopRecording(int idx);
 
+    /// <summary>
+    /// Start recording every camera's unprocessed feed and the composite
+    /// together, as a session. Stops any session already recording.
+    /// </summary>
+    /// <param name="prefix">The prefix to apply to the session's directory.</param>
+    /// <returns>The session, or nullptr if it couldn't be started.</returns>
+    SessionRecording::SPtr RecordSession(const std::string& prefix);
+
+    /// <summary>
+    /// Stop the session being recorded, and write its frame pairing index.
+    /// </summary>
+    /// <returns>True if a session was stopped.</returns>
+    bool StopSession();
+
+    inline bool IsRecordingSession() const
+    { return this->activeSession != nullptr; }
+
     //////////////////////////////////////////////////
     //
     //      OPTIONS UTILITIES
@@ -200,6 +278,23 @@ public:
     /// options will be immediately 
     /// </summary>
     void ReloadAppOptions();
+
+    /// <summary>
+    /// Reload app options while the application is running, and apply
+    /// the changes to the running systems. Camera changes are diffed
+    /// against what's running so cameras are only reconnected if needed.
+    /// 
+    /// Unlike ReloadAppOptions(), if the file can't be parsed, the current
+    /// options are kept and the file is left untouched.
+    /// </summary>
+    /// <returns>True if the options were reloaded.</returns>
+    bool HotReloadAppOptions();
+
+    /// <summary>
+    /// Stop the options file watcher from reloading the options because
+    /// of a write the application is about to make to the file itself.
+    /// </summary>
+    void IgnoreOwnOptionsWrite();
     
 
     //////////////////////////////////////////////////
@@ -218,6 +313,18 @@ public:
     /// </summary>
     void InitializeAppStateMachine();
 
+    /// <summary>
+    /// Run the application's startup work, as a graph of tasks that
+    /// are run concurrently where possible: camera bring-up, loading the
+    /// DICOM dictionary, decoding image assets, loading fonts, and 
+    /// initializing the state machine. This will be called by GLWin the 
+    /// first time it draws, with its OpenGL context current.
+    /// 
+    /// The timeline of the tasks is printed afterwards, and saved as
+    /// JSON if the startup_timeline_json option is set.
+    /// </summary>
+    void RunStartupGraph();
+
     /// <summary>
     /// Create the applications states and store them into this->states.
     /// </summary>
@@ -254,6 +361,8 @@ public:
 
     void OnAccelerator_SaveCurOptions(wxCommandEvent& evt);
     void OnAccelerator_ToggleFullscreen(wxCommandEvent& evt);
+    void OnAccelerator_DumpThreads(wxCommandEvent& evt);
+    void OnAccelerator_ToggleSession(wxCommandEvent& evt);
 
     std::string GetSessionsFolder() const;
 
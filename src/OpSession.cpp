@@ -221,7 +221,7 @@ bool OpSession::LoadFromToml(toml::table& inToml)
 	return true;
 }
 
-void OpSession::InjectIntoDicom(DcmDataset* dicomData)
+void OpSession::InjectStaticIntoDicom(DcmDataset* dicomData)
 {
 
 	//////////////////////////////////////////////////
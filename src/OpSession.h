@@ -128,5 +128,8 @@ public:
 	//	DicomInjector FUNCTIONS
 	//
 	//////////////////////////////////////////////////
-	void InjectIntoDicom(DcmDataset* dicomData) override;
+
+	// All of the session data is static, it's loaded once when the
+	// program starts.
+	void InjectStaticIntoDicom(DcmDataset* dicomData) override;
 };
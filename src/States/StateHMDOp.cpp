@@ -1,11 +1,18 @@
 #include "StateHMDOp.h"
 #include "StateIncludes.h"
 #include "../CamVideo/CamStreamMgr.h"
+#include "../CamVideo/CamSyncGroup.h"
+#include "../CamVideo/DicomCompress.h"
+#include "../CamVideo/CaptureWarmup.h"
+#include "../CamVideo/CaptureStorage.h"
 #include "../Utils/cvgShapes.h"
+#include "../Utils/cvgTaskPool.h"
+#include "../Utils/cvgQualityGovernor.h"
 #include "../Utils/cvgAssert.h"
 #include "../UISys/UIPlate.h"
 #include "../UISys/UIButton.h"
 #include "../UISys/UIVBulkSlider.h"
+#include "../Carousel/CarouselIconCache.h"
 #include <cmath>
 #include <dcmtk/dcmdata/dcdeftag.h>
 
@@ -311,6 +318,7 @@ StateHMDOp::StateHMDOp(HMDOpApp* app, GLWin* view, MainWin* core)
 		{
 			this->sliderSysThresh = this->CreateSliderSystem(&this->uiSys, UIID::CamSet_Threshold_SlideThresh,	"Thresh", 0.0f, 255.0f, 127.0f, UIRect(), this->camBtnThresh);
 			this->sliderSysDispUp = this->CreateSliderSystem(&this->uiSys, UIID::CamSet_Threshold_DispUp,		"DispUp", 0.0f, 1.0f, 0.25f, UIRect(), this->camBtnThresh);
+			this->sliderSysROI = this->CreateSliderSystem(&this->uiSys, UIID::CamSet_Threshold_ROI,				"ROI", 0.1f, 1.0f, 1.0f, UIRect(), this->camBtnThresh);
 		}
 		//btnIt += BtnStride;
 	}
@@ -456,6 +464,12 @@ void StateHMDOp::Draw(const wxSize& sz)
 		//if(camMgr.IsThresholded(camIt))
 		//	glColor4f(1.0f, 0.0f, 0.0f, alpha);
 		//else
+		if(camMgr.IsFrameStale(camIt))
+		{
+			// Dim the last good frame while the camera reconnects.
+			glColor4f(0.5f, 0.5f, 0.5f, alpha);
+		}
+		else
 			glColor4f(1.0f, 1.0f, 1.0f, alpha);
 
 		glBegin(GL_QUADS);
@@ -473,10 +487,166 @@ void StateHMDOp::Draw(const wxSize& sz)
 		const int camCt = 2;
 		for(int i = 0; i < camCt; ++i)
 		{
+			ManagedCam::ReconnectStats rs = camMgr.GetReconnectStats(i);
+			cvgJitterMeter::Stats jitter = camMgr.GetFrameJitter(i);
+
 			std::stringstream sstrm;
-			sstrm << "Cam: " << i << " - MS: " << camMgr.GetMSFrameTime(i);
+			sstrm << "Cam: " << i << " - MS: " << camMgr.GetMSFrameTime(i) << 
+				" - Jitter MS: " << std::fixed << std::setprecision(1) << jitter.jitterMS <<
+				" - Max MS: " << jitter.maxMS <<
+				" - Reconnects: " << rs.reconnectCt << 
+				" - Last Outage MS: " << rs.lastOutageMS <<
+				" - Longest Outage MS: " << rs.longestOutageMS;
+
+			ManagedCam::FrameAgeStats age = camMgr.GetFrameAgeStats(i);
+			if(age.measured)
+			{
+				sstrm << 
+					" - Age MS: " << age.avgMS << 
+					" (max " << age.maxMS << ")" <<
+					" - Skipped: " << age.skippedCt;
+			}
+
+			if(rs.inOutage)
+				sstrm << " - OUTAGE MS: " << rs.curOutageMS;
+
 			this->fontInsTitle.RenderFont(sstrm.str().c_str(), 0, sz.y - (20 * camCt) + (20 * i));
 		}
+
+		CarouselIconCache::Stats iconStats = CarouselIconCache::GetInstance().GetStats();
+		std::stringstream sstrmIcons;
+		sstrmIcons << 
+			"Icons: " << iconStats.resident << "/" << iconStats.maxResident << 
+			" - Pending: " << iconStats.pending << 
+			" - Evicted: " << iconStats.evicted;
+		this->fontInsTitle.RenderFont(sstrmIcons.str().c_str(), 0, sz.y - (20 * (camCt + 1)));
+
+		cvgTaskPool::Metrics poolStats = cvgTaskPool::GetInstance().GetMetrics();
+		std::stringstream sstrmPool;
+		sstrmPool << std::fixed << std::setprecision(1) <<
+			"Pool: " << poolStats.workerCt << 
+			" - Queue: " << poolStats.queueDepth << 
+			" (max " << poolStats.maxQueueDepth << ")" <<
+			" - Steals: " << poolStats.stealCt << 
+			" - Queue US: " << poolStats.avgQueueUS << 
+			" - Run US: " << poolStats.avgRunUS;
+		this->fontInsTitle.RenderFont(sstrmPool.str().c_str(), 0, sz.y - (20 * (camCt + 2)));
+
+		cvgQualityGovernor::Status govStatus = cvgQualityGovernor::GetInstance().GetStatus();
+		std::stringstream sstrmGov;
+		sstrmGov << std::fixed << std::setprecision(2) <<
+			"Quality: " << to_string(govStatus.level) << 
+			" - Load: " << govStatus.load << 
+			" (" << govStatus.slowestStage << ")" <<
+			" - Step Downs: " << govStatus.stepDownCt << 
+			" - Step Ups: " << govStatus.stepUpCt;
+		this->fontInsTitle.RenderFont(sstrmGov.str().c_str(), 0, sz.y - (20 * (camCt + 3)));
+
+		std::vector<int> historyIds = {0, 1, SpecialCams::Composite};
+		std::stringstream sstrmHistory;
+		sstrmHistory << std::fixed << std::setprecision(1) << "History MB:";
+		double historyTotalMB = 0.0;
+		for(int id : historyIds)
+		{
+			FrameHistory::Stats hs = camMgr.GetHistoryStats(id);
+			double mb = hs.bytes / (1024.0 * 1024.0);
+			historyTotalMB += mb;
+
+			sstrmHistory << 
+				" " << ((id == SpecialCams::Composite) ? std::string("Comp") : "Cam " + std::to_string(id)) <<
+				": " << mb << " (" << hs.frameCt << " frames, " << (hs.spanMS / 1000.0) << " s)";
+
+			if(hs.droppedCt > 0)
+				sstrmHistory << " Dropped: " << hs.droppedCt;
+
+			sstrmHistory << " -";
+		}
+		sstrmHistory << " Total: " << historyTotalMB << " / " << (FrameHistory::GetSettings().budgetBytes / (1024.0 * 1024.0)) * historyIds.size();
+		this->fontInsTitle.RenderFont(sstrmHistory.str().c_str(), 0, sz.y - (20 * (camCt + 5)));
+
+		DicomCompress::Stats dicomStats = DicomCompress::GetTotals();
+		std::stringstream sstrmDicom;
+		sstrmDicom << std::fixed << std::setprecision(2) <<
+			"DICOM: " << to_string(DicomCompress::GetMethod()) << 
+			" - Frames: " << dicomStats.frameCt << 
+			" - Ratio: " << dicomStats.Ratio() << 
+			" - Encode MS: " << ((dicomStats.frameCt > 0) ? dicomStats.encodeMS / (double)dicomStats.frameCt : 0.0) << 
+			" - Uncompressed: " << dicomStats.skippedCt;
+		this->fontInsTitle.RenderFont(sstrmDicom.str().c_str(), 0, sz.y - (20 * (camCt + 6)));
+
+		IManagedCam::SnapLatencyStats snapLatency = IManagedCam::GetSnapLatency();
+		CaptureWarmup::Timings warmup = CaptureWarmup::GetTimings();
+		std::stringstream sstrmSnaps;
+		sstrmSnaps << std::fixed << std::setprecision(2) <<
+			"Snaps: " << snapLatency.snapCt << 
+			" - First MS: " << snapLatency.firstMS << 
+			" - Steady MS: " << snapLatency.SteadyAvgMS() << 
+			" (max " << snapLatency.steadyMaxMS << ")" <<
+			" - Warm-up MS: ";
+		if(warmup.done)
+			sstrmSnaps << warmup.TotalMS();
+		else
+			sstrmSnaps << "pending";
+		this->fontInsTitle.RenderFont(sstrmSnaps.str().c_str(), 0, sz.y - (20 * (camCt + 7)));
+
+		CaptureStorage::Stats storageStats = CaptureStorage::GetInstance().GetStats();
+		std::stringstream sstrmStorage;
+		sstrmStorage << std::fixed << std::setprecision(2) <<
+			"Storage: " << (storageStats.ioUring ? "io_uring" : "posix") <<
+			" - Free MB: " << (storageStats.freeBytes / (1024 * 1024)) <<
+			" - Queued MB: " << (storageStats.queuedBytes / (1024.0 * 1024.0)) << 
+			" (peak " << (storageStats.peakQueuedBytes / (1024.0 * 1024.0)) << ")" <<
+			" - Files: " << storageStats.fileCt << 
+			" - MB/s: " << storageStats.MBPerSec() << 
+			" - Latency MS: " << storageStats.AvgLatencyMS() << 
+			" (max " << storageStats.latencyMaxMS << ")" <<
+			" - Write-through: " << storageStats.writeThroughCt << 
+			" - Errors: " << storageStats.errorCt;
+		this->fontInsTitle.RenderFont(sstrmStorage.str().c_str(), 0, sz.y - (20 * (camCt + 8)));
+
+		if(CamSyncGroup::GetInstance().IsEnabled())
+		{
+			CamSyncGroup::SkewStats skew = CamSyncGroup::GetInstance().GetStats();
+			std::stringstream sstrmSync;
+			sstrmSync << std::fixed << std::setprecision(2) <<
+				"Sync: " << skew.memberCt << " cams" <<
+				" - Skew MS: " << skew.avgSkewMS << 
+				" (max " << skew.maxSkewMS << ")" <<
+				" - Epochs: " << skew.epochCt << 
+				" - Partial: " << skew.partialEpochCt;
+			this->fontInsTitle.RenderFont(sstrmSync.str().c_str(), 0, sz.y - (20 * (camCt + 4)));
+		}
+	}
+
+	// If a camera is reconnecting, what's being shown is its last good
+	// frame, and the user needs to know it's not live.
+	for(int camIt = 0; camIt < 2; ++camIt)
+	{
+		if(!camMgr.IsFrameStale(camIt))
+			continue;
+
+		std::stringstream sstrm;
+		sstrm << "Camera " << camIt << " reconnecting...";
+
+		glColor3f(1.0f, 1.0f, 0.0f);
+		this->fontInsTitle.RenderFont(
+			sstrm.str().c_str(), 
+			cameraWindowRgn.x + 10.0f, 
+			cameraWindowRgn.y + 30.0f + 20.0f * camIt);
+	}
+
+	// Captures stop being saved when the disk is full, so warn before then.
+	CaptureStorage& storage = CaptureStorage::GetInstance();
+	if(storage.IsLowOnSpace())
+	{
+		std::stringstream sstrm;
+		sstrm << "Storage low: " << (storage.GetStats().freeBytes / (1024 * 1024)) << " MB free";
+
+		glColor3f(1.0f, 0.25f, 0.25f);
+		this->fontInsTitle.RenderFont(
+			sstrm.str().c_str(), 
+			cameraWindowRgn.x + 10.0f, 
+			cameraWindowRgn.y + 30.0f + 20.0f * 2);
 	}
 
 	this->vertMenuPlate->SetLocPos(cameraWindowRgn.EndX() + 10.0f, cameraWindowRgn.y + 25.0f);
@@ -836,6 +1006,7 @@ void StateHMDOp::_SyncThresholdSlider()
 
 	CamStreamMgr& cmgr = CamStreamMgr::GetInstance();
 	this->sliderSysThresh.slider->SetCurValue(cmgr.GetParam(targIdx, StreamParams::StaticThreshold));
+	this->sliderSysROI.slider->SetCurValue(cmgr.GetParam(targIdx, StreamParams::ProcessingROIWidth));
 }
 
 void StateHMDOp::ExitedActive() 
@@ -850,6 +1021,8 @@ void StateHMDOp::Initialize()
 	this->fontInsTitle = FontMgr::GetInstance().GetFont(24);
 	this->fontLaserOn = FontMgr::GetInstance().GetFont(12);
 
+	CarouselIconCache::GetInstance().SetMaxResident(this->GetView()->cachedOptions.caroIconCacheMax);
+
 	this->caroBody.Append(this->GetView()->cachedOptions.caroBody);
 	this->caroBody.LoadAssets();
 	this->caroSeries.Append(this->GetView()->cachedOptions.caroSysSeries);
@@ -900,6 +1073,11 @@ void StateHMDOp::ClosingApp()
 	// Get rid of icons while we know the OpenGL context is still
 	// alive.
 	this->mousepadUI.Shutdown();
+
+	this->caroBody.ReleaseIcons();
+	this->caroSeries.ReleaseIcons();
+	this->caroOrient.ReleaseIcons();
+	CarouselIconCache::ShutdownMgr();
 }
 
 StateHMDOp::~StateHMDOp()
@@ -1480,6 +1658,9 @@ void StateHMDOp::OnUISink_Clicked(UIBase* uib, int mouseBtn, const UIVec2& mouse
 	case UIID::CamSet_Threshold_DispUp:
 		break;
 
+	case UIID::CamSet_Threshold_ROI:
+		break;
+
 	case UIID::CamSet_Threshold_Back:
 		this->camButtonGrid->Show();
 		break;
@@ -1514,6 +1695,18 @@ void StateHMDOp::OnUISink_ChangeValue(UIBase* uib, float value, int vid)
 		}
 		break;
 
+	case UIID::CamSet_Threshold_ROI:
+		{
+			int targIdx = this->GetView()->cachedOptions.FindMenuTargetIndex();
+			if(targIdx == -1)
+				return;
+
+			// The slider sizes a processing region centered on the frame.
+			CamStreamMgr& cmgr = CamStreamMgr::GetInstance();
+			cmgr.SetParam(targIdx, StreamParams::ProcessingROICentered, value);
+		}
+		break;
+
 	case UIID::CamSet_Opacity_Meter:
 		{
 			int targIdx = this->GetView()->cachedOptions.FindMenuTargetIndex();
@@ -129,6 +129,7 @@ public:
 		CamSet_Opacity_Meter,
 		CamSet_Opacity_Back,
 		CamSet_Calibrate_Slider,
+		CamSet_Threshold_ROI,
 		// Exit Button
 		Exit_Confirm
 	};
@@ -340,6 +341,7 @@ public:
 	UIButton* camBtnThresh			= nullptr;
 	PlateSliderPair sliderSysThresh;
 	PlateSliderPair sliderSysDispUp;
+	PlateSliderPair sliderSysROI;
 
 	//////////////////////////////////////////////////
 	//
@@ -562,6 +564,9 @@ public:
 	//		DicomInjector overrides
 	//
 	//////////////////////////////////////////////////
+
+	// The carousel selections can change between snapshots, so 
+	// nothing is static.
 	void InjectIntoDicom(DcmDataset* dicomData) override;
 public:
 
@@ -1,6 +1,7 @@
 #include "StateInitCameras.h"
 #include "StateIncludes.h"
 #include "../CamVideo/CamStreamMgr.h"
+#include "../CamVideo/CaptureWarmup.h"
 #include "../LoadAnim.h"
 
 
@@ -59,6 +60,33 @@ void StateInitCameras::ClearVideoTextures()
 	this->camTextureRegistry.ClearTextures();
 }
 
+void StateInitCameras::StartCaptureWarmup()
+{
+	if(this->warmupStarted)
+		return;
+
+	this->warmupStarted = true;
+
+	std::vector<cv::Ptr<cv::Mat>> sampleFrames;
+	for(int camIt = 0; camIt < 2; ++camIt)
+		sampleFrames.push_back(CamStreamMgr::GetInstance().GetCurrentFrame(camIt));
+
+	// The folder is created here on the UI thread, where capture requests
+	// create it, instead of racing them from the task pool.
+	MainWin* core = this->GetCoreWindow();
+	double folderMS = 
+		CaptureWarmup::EnsureFolder(
+			std::cout, 
+			[core]{ return core->EnsureAndGetCapturesFolder(); });
+
+	cvgTaskPool::GetInstance().Submit(
+		[sampleFrames, folderMS]
+		{
+			CaptureWarmup::Run(std::cout, sampleFrames, folderMS);
+		},
+		&this->warmupTask);
+}
+
 void StateInitCameras::Draw(const wxSize& sz)
 {
 	// If any camera is not ready, this gets
@@ -197,6 +225,9 @@ void StateInitCameras::Draw(const wxSize& sz)
 		// We're piggybacking off the beep mechanism to also update
 		// exposure for the first frame when both cameras are available.
 		this->GetView()->ResetExposureSetting();
+
+		// And to warm up capturing, with frames from the cameras.
+		this->StartCaptureWarmup();
 	}
 }
 
@@ -215,15 +246,18 @@ void StateInitCameras::EnteredActive()
 	this->playBeepLatch = false;
 
 	this->nextState = false;
-	CamStreamMgr::GetInstance().BootConnectionToCamera(
-		this->GetView()->cachedOptions.feedOpts);
 
+	// The cameras were already booted by the startup graph's BootCameras
+	// task (see MainWin), this state only waits for them to stream.
 	this->loadAnimTimer.Restart();
 }
 
 void StateInitCameras::ExitedActive() 
 {
 	this->ClearVideoTextures();
+
+	// If the cameras were skipped before they were ready.
+	this->StartCaptureWarmup();
 }
 
 void StateInitCameras::Initialize() 
@@ -235,6 +269,7 @@ void StateInitCameras::Initialize()
 void StateInitCameras::ClosingApp() 
 {
 	this->ClearVideoTextures();
+	cvgTaskPool::GetInstance().Wait(this->warmupTask);
 }
 
 void StateInitCameras::OnKeydown(wxKeyCode key)
@@ -8,6 +8,7 @@
 #include "../TexObj.h"
 #include "../Utils/cvgCamTextureRegistry.h"
 #include "../Utils/VideoPollType.h"
+#include "../Utils/cvgTaskPool.h"
 #include <map>
 
 /// <summary>
@@ -55,6 +56,16 @@ public:
 	/// </summary>
 	bool playBeepLatch = false;
 
+	/// <summary>
+	/// If true, the capture warm-up has been started.
+	/// </summary>
+	bool warmupStarted = false;
+
+	/// <summary>
+	/// The capture warm-up task, see StartCaptureWarmup().
+	/// </summary>
+	cvgTaskPool::Group warmupTask;
+
 public:
 	StateInitCameras(HMDOpApp* app, GLWin* view, MainWin* core);
 
@@ -82,6 +93,15 @@ public:
 	/// </summary>
 	void ClearVideoTextures();
 
+	/// <summary>
+	/// Start the capture warm-up (see CaptureWarmup) on the task pool, with
+	/// the cameras' current frames, if it hasn't been started already.
+	/// 
+	/// It's started once the cameras are ready, or when leaving the state
+	/// if they never were, so it's done before the first snapshot.
+	/// </summary>
+	void StartCaptureWarmup();
+
 	~StateInitCameras();
 
 	//////////////////////////////////////////////////
@@ -5,6 +5,28 @@
 #include <iostream>
 #include <GL/glu.h>
 #include <filesystem>
+#include <map>
+#include <mutex>
+
+/// <summary>
+/// PNG pixels decoded ahead of time by TexObj::PreloadLODEDirectory().
+/// </summary>
+struct PreloadedPNG
+{
+	std::vector<unsigned char> pixels;
+	unsigned width = 0;
+	unsigned height = 0;
+};
+
+/// <summary>
+/// Preloaded PNGs, keyed by the filepath they would be requested with.
+/// </summary>
+static std::map<std::string, PreloadedPNG> preloadedPNGs;
+
+/// <summary>
+/// Guards preloadedPNGs, since it's filled from worker threads.
+/// </summary>
+static std::mutex preloadedPNGsMutex;
 
 bool CheckTextureSourceExists(const std::string& filepath)
 {
@@ -113,21 +135,42 @@ bool TexObj::LoadFromImage(const std::string& imgFilepath)
 
 bool TexObj::LODEFromImage(const std::string& imgFilepath)
 {
-	if(!CheckTextureSourceExists(imgFilepath))
-		return false;
-
 	std::vector<unsigned char> image;
 	unsigned width, height;
 
+	if(
+		!TakePreloaded(imgFilepath, image, width, height) &&
+		!DecodeLODE(imgFilepath, image, width, height))
+	{
+		return false;
+	}
+
+	this->TransferFromRGBA(&image[0], width, height);
+	return true;
+}
+
+bool TexObj::DecodeLODE(
+	const std::string& imgFilepath, 
+	std::vector<unsigned char>& outPixels, 
+	unsigned& outWidth, 
+	unsigned& outHeight)
+{
+	if(!CheckTextureSourceExists(imgFilepath))
+		return false;
+
 	// https://raw.githubusercontent.com/lvandeve/lodepng/master/examples/example_decode.cpp
-	unsigned error = lodepng::decode(image, width, height, imgFilepath.c_str());
+	unsigned error = lodepng::decode(outPixels, outWidth, outHeight, imgFilepath.c_str());
 
-	if(error)
+	if(error || outPixels.empty())
 	{
 		std::cerr << "Could not load into lodePNG " << imgFilepath.c_str() <<std::endl;
 		return false;
 	}
+	return true;
+}
 
+void TexObj::TransferFromRGBA(const unsigned char* pixels, int width, int height)
+{
 	if(this->IsValid())
 		this->Destroy();
 
@@ -145,17 +188,6 @@ bool TexObj::LODEFromImage(const std::string& imgFilepath)
 
 	glBindTexture(GL_TEXTURE_2D, this->texID);
 
-	//glTexImage2D(
-	//	GL_TEXTURE_2D, 
-	//	0, 
-	//	GL_RGBA8, 
-	//	width, 
-	//	height, 
-	//	0, 
-	//	GL_RGBA, 
-	//	GL_UNSIGNED_BYTE,
-	//	&image[0]);
-
 	gluBuild2DMipmaps(
 		GL_TEXTURE_2D, 
 		4, 
@@ -163,11 +195,10 @@ bool TexObj::LODEFromImage(const std::string& imgFilepath)
 		height, 
 		GL_RGBA, 
 		GL_UNSIGNED_BYTE, 
-		&image[0]);
+		pixels);
 
 	this->width = width;
 	this->height = height;
-	return true;
 }
 
 TexObj::ELoadRet TexObj::LODEIfEmpty(const std::string& imgFilepath)
@@ -213,3 +244,57 @@ TexObj::SPtr TexObj::MakeSharedLODE(const std::string& imgFilepath)
 	}
 	return TexObj::SPtr(ret);
 }
+
+int TexObj::PreloadLODEDirectory(const std::string& dir)
+{
+	if(!std::filesystem::is_directory(dir))
+	{
+		std::cerr << "Could not preload missing image directory " << dir << std::endl;
+		return 0;
+	}
+
+	int loadedCt = 0;
+	for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir))
+	{
+		if(!entry.is_regular_file() || entry.path().extension() != ".png")
+			continue;
+
+		// Keyed the same way the assets are requested in code, which
+		// is always with forward slashes.
+		std::string filepath = dir + "/" + entry.path().filename().string();
+
+		PreloadedPNG png;
+		if(!DecodeLODE(filepath, png.pixels, png.width, png.height))
+			continue;
+
+		std::lock_guard<std::mutex> guard(preloadedPNGsMutex);
+		preloadedPNGs[filepath] = std::move(png);
+		++loadedCt;
+	}
+	return loadedCt;
+}
+
+void TexObj::ClearPreloaded()
+{
+	std::lock_guard<std::mutex> guard(preloadedPNGsMutex);
+	preloadedPNGs.clear();
+}
+
+bool TexObj::TakePreloaded(
+	const std::string& imgFilepath, 
+	std::vector<unsigned char>& outPixels, 
+	unsigned& outWidth, 
+	unsigned& outHeight)
+{
+	std::lock_guard<std::mutex> guard(preloadedPNGsMutex);
+
+	auto itFind = preloadedPNGs.find(imgFilepath);
+	if(itFind == preloadedPNGs.end())
+		return false;
+
+	outPixels	= std::move(itFind->second.pixels);
+	outWidth	= itFind->second.width;
+	outHeight	= itFind->second.height;
+	preloadedPNGs.erase(itFind);
+	return true;
+}
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <opencv2/imgcodecs.hpp>
 #include <memory>
+#include <vector>
 
 /// <summary>
 /// Utility class to manage OpenGL textures as objects, as
@@ -98,6 +99,16 @@ public:
 	/// <returns>The status of the request.</returns>
 	ELoadRet LODEIfEmpty(const std::string& imgFilepath);
 
+	/// <summary>
+	/// Upload RGBA pixel data into the TexObj, with mipmaps.
+	/// 
+	/// This must be called from the thread that owns the OpenGL context.
+	/// </summary>
+	/// <param name="pixels">The RGBA pixels, 4 bytes per pixel.</param>
+	/// <param name="width">The width of the image, in pixels.</param>
+	/// <param name="height">The height of the image, in pixels.</param>
+	void TransferFromRGBA(const unsigned char* pixels, int width, int height);
+
 	/// <summary>
 	/// Bind the OpenGL texture.
 	/// Only valid if the image data isn't empty.
@@ -140,5 +151,55 @@ public:
 	/// <param name="imgFilepath">The filepath of the PNG image to load.</param>
 	/// <returns>The loaded image object; or null if loading was not successful.</returns>
 	static SPtr MakeSharedLODE(const std::string& imgFilepath);
+
+	/// <summary>
+	/// Decode a PNG file into RGBA pixels using LodePNG.
+	/// 
+	/// No OpenGL calls are made, so this is safe to call from worker
+	/// threads. The results can be handed to TransferFromRGBA() later
+	/// on the main thread.
+	/// </summary>
+	/// <param name="imgFilepath">The filepath of the PNG to decode.</param>
+	/// <param name="outPixels">The output RGBA pixels.</param>
+	/// <param name="outWidth">The output image width.</param>
+	/// <param name="outHeight">The output image height.</param>
+	/// <returns>True if the image was decoded successfully, else false.</returns>
+	static bool DecodeLODE(
+		const std::string& imgFilepath, 
+		std::vector<unsigned char>& outPixels, 
+		unsigned& outWidth, 
+		unsigned& outHeight);
+
+	/// <summary>
+	/// Decode all the PNGs in a directory (non-recursively) ahead of time, 
+	/// so that later loads of those files through LODEFromImage() only 
+	/// need to do the OpenGL upload.
+	/// 
+	/// No OpenGL calls are made, so this is safe to call from worker
+	/// threads, and multiple directories can be preloaded concurrently.
+	/// </summary>
+	/// <param name="dir">
+	/// The directory to preload. Files are matched by the path dir + "/" + filename,
+	/// so this should be in the same form the files are requested with.
+	/// </param>
+	/// <returns>The number of PNGs decoded.</returns>
+	static int PreloadLODEDirectory(const std::string& dir);
+
+	/// <summary>
+	/// Release any preloaded PNG data that was never used.
+	/// </summary>
+	static void ClearPreloaded();
+
+private:
+	/// <summary>
+	/// Take the pixels of a preloaded PNG, if there is one. The preloaded
+	/// data is removed once taken.
+	/// </summary>
+	/// <returns>True if preloaded data was found for the filepath.</returns>
+	static bool TakePreloaded(
+		const std::string& imgFilepath, 
+		std::vector<unsigned char>& outPixels, 
+		unsigned& outWidth, 
+		unsigned& outHeight);
 };
 
@@ -0,0 +1,64 @@
+#pragma once
+
+// Settings for CamImpl_FaultInject, which wraps a real camera implementation
+// and randomly simulates the hiccups a camera can have in practice. This is
+// only meant for development, to exercise the reconnect logic in ManagedCam
+// without having to physically pull cables.
+//
+// All chances are per poll (or per activation attempt), in the range [0.0, 1.0].
+
+struct CamFaultProfile
+{
+	/// <summary>
+	/// The chance a poll returns no frame.
+	/// </summary>
+	float dropChance = 0.0f;
+
+	/// <summary>
+	/// The chance a poll starts a stall, where the camera still reports being
+	/// valid but stops delivering frames for stallMS.
+	/// </summary>
+	float stallChance = 0.0f;
+
+	/// <summary>
+	/// How long a stall lasts, in milliseconds.
+	/// </summary>
+	int stallMS = 1000;
+
+	/// <summary>
+	/// The chance a poll disconnects the camera, where it reports being
+	/// invalid until it's reactivated.
+	/// </summary>
+	float disconnectChance = 0.0f;
+
+	/// <summary>
+	/// How long a disconnect lasts, in milliseconds. Activation attempts during
+	/// this time will fail.
+	/// </summary>
+	int disconnectMS = 300;
+
+	/// <summary>
+	/// The chance an activation attempt fails, even if not disconnected.
+	/// </summary>
+	float activateFailChance = 0.0f;
+
+	/// <summary>
+	/// The random seed. A value of 0 will use a non-deterministic seed.
+	/// </summary>
+	unsigned int seed = 0;
+
+	bool operator==(const CamFaultProfile& other) const
+	{
+		return
+			this->dropChance			== other.dropChance			&&
+			this->stallChance			== other.stallChance		&&
+			this->stallMS				== other.stallMS			&&
+			this->disconnectChance		== other.disconnectChance	&&
+			this->disconnectMS			== other.disconnectMS		&&
+			this->activateFailChance	== other.activateFailChance	&&
+			this->seed					== other.seed;
+	}
+
+	bool operator!=(const CamFaultProfile& other) const
+	{ return !(*this == other); }
+};
@@ -0,0 +1,30 @@
+#include "CaptureFormat.h"
+
+std::string to_string(CaptureFormat fmt)
+{
+	switch (fmt)
+	{
+	case CaptureFormat::BGR:
+		return "bgr";
+
+	case CaptureFormat::YUYV:
+		return "yuyv";
+
+	case CaptureFormat::Grey:
+		return "grey";
+	}
+
+	return "bgr";
+}
+
+CaptureFormat StringToCaptureFormat(const std::string& str)
+{
+	if (str == "yuyv")
+		return CaptureFormat::YUYV;
+
+	if (str == "grey")
+		return CaptureFormat::Grey;
+
+	//if (str == "bgr")
+	return CaptureFormat::BGR;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+/// <summary>
+/// The pixel format to request from a camera, for camera implementations
+/// that support choosing it (the OpenCV based ones).
+/// 
+/// If the capture mode is negotiated, this is the preferred format. Another
+/// format may be used if it's the only way to reach the frame rate, but the
+/// frames are still delivered with the channels of the requested format.
+/// </summary>
+enum class CaptureFormat {
+	/// <summary>
+	/// Let the capture backend convert frames to 3 channel BGR.
+	/// </summary>
+	BGR,
+
+	/// <summary>
+	/// Request YUYV (YUV 4:2:2) frames, and only keep the Y (luma) 
+	/// samples as a single channel image. For monochrome feeds.
+	/// </summary>
+	YUYV,
+
+	/// <summary>
+	/// Request 8 bit greyscale (V4L2 GREY) frames, kept as a single
+	/// channel image. For monochrome feeds.
+	/// </summary>
+	Grey,
+};
+
+/// <summary>
+/// Convert a CaptureFormat to a serialiable string value.
+/// 
+/// The name convention is made to match std::to_string() functions.
+/// </summary>
+/// <param name="fmt">The CaptureFormat to get the name of.</param>
+/// <returns>
+/// A serializable string version of CaptureFormat that can be converted
+/// back with StringToCaptureFormat().
+/// </returns>
+std::string to_string(CaptureFormat fmt);
+
+/// <summary>
+/// Convert a serialized string to a CaptureFormat.
+/// </summary>
+/// <param name="str">The name of a CaptureFormat to convert to an enum.</param>
+/// <returns>
+/// An enum version of a CaptureFormat string. If the string is not recognized,
+/// it is defaulted to CaptureFormat::BGR.
+/// </returns>
+CaptureFormat StringToCaptureFormat(const std::string& str);
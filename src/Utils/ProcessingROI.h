@@ -0,0 +1,74 @@
+#pragma once
+
+// The region of a camera's frames that image processing is limited to. Outside
+// of the region, the processed frame is either left empty, or passed through
+// unprocessed.
+//
+// The region is normalized to the frame's dimensions, so it doesn't need to
+// be changed if the camera's resolution changes.
+
+struct ProcessingROI
+{
+	/// <summary>
+	/// The left of the region, in the range [0.0, 1.0].
+	/// </summary>
+	float x = 0.0f;
+
+	/// <summary>
+	/// The top of the region, in the range [0.0, 1.0].
+	/// </summary>
+	float y = 0.0f;
+
+	/// <summary>
+	/// The width of the region, in the range [0.0, 1.0].
+	/// </summary>
+	float w = 1.0f;
+
+	/// <summary>
+	/// The height of the region, in the range [0.0, 1.0].
+	/// </summary>
+	float h = 1.0f;
+
+	/// <summary>
+	/// If true, pixels outside of the region are passed through unprocessed
+	/// and fully opaque. Else, they're zeroed (and fully transparent).
+	/// </summary>
+	bool passthrough = false;
+
+	/// <summary>
+	/// Check if the region covers the entire frame.
+	/// </summary>
+	bool IsFullFrame() const
+	{
+		return
+			this->x <= 0.0f &&
+			this->y <= 0.0f &&
+			this->x + this->w >= 1.0f &&
+			this->y + this->h >= 1.0f;
+	}
+
+	/// <summary>
+	/// Set the region to a rectangle centered on the frame.
+	/// </summary>
+	/// <param name="scale">The width and height of the region.</param>
+	void SetCentered(float scale)
+	{
+		this->w = scale;
+		this->h = scale;
+		this->x = (1.0f - scale) * 0.5f;
+		this->y = (1.0f - scale) * 0.5f;
+	}
+
+	bool operator==(const ProcessingROI& other) const
+	{
+		return
+			this->x				== other.x	&&
+			this->y				== other.y	&&
+			this->w				== other.w	&&
+			this->h				== other.h	&&
+			this->passthrough	== other.passthrough;
+	}
+
+	bool operator!=(const ProcessingROI& other) const
+	{ return !(*this == other); }
+};
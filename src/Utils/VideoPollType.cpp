@@ -19,6 +19,9 @@ std::string to_string(VideoPollType ty)
 	case VideoPollType::Image:
 		return "static";
 
+	case VideoPollType::Replay:
+		return "replay";
+
 	case VideoPollType::MMAL:
 		return "mmal";
 	}
@@ -42,6 +45,9 @@ VideoPollType StringToPollType(const std::string& str)
 	if(str == "static")
 		return VideoPollType::Image;
 
+	if(str == "replay")
+		return VideoPollType::Replay;
+
 	if(str == "mmal")
 		return VideoPollType::MMAL;
 
@@ -38,7 +38,13 @@ enum class VideoPollType
 	/// <summary>
 	/// Simulate polling by showing a text image.
 	/// </summary>
-	Image
+	Image,
+
+	/// <summary>
+	/// Simulate polling by replaying a recorded raw frame file, or a
+	/// directory of images.
+	/// </summary>
+	Replay
 };
 
 /// <summary>
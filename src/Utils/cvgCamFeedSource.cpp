@@ -15,8 +15,16 @@ static const char* szKey_PipeCmd		= "pipe_cmd";
 static const char* szKey_PipeChans		= "pipe_chans";
 static const char* szKey_PipeWidth		= "pipe_width";
 static const char* szKey_PipeHeight		= "pipe_height";
+static const char* szKey_ReplayPath		= "replay_path";
+static const char* szKey_ReplayFPS		= "replay_fps";
+static const char* szKey_ReplayLoop		= "replay_loop";
+static const char* szKey_ReplayStamps	= "replay_timestamps";
 static const char* szKey_StreamWidth	= "stream_width";
 static const char* szKey_StreamHeight	= "stream_height";
+static const char* szKey_StreamFPS		= "stream_fps";
+static const char* szKey_CaptureFormat	= "capture_format";
+static const char* szKey_NegotiateMode	= "negotiate_capture_mode";
+static const char* szKey_LowLatencyGrab	= "low_latency_grab";
 static const char* szKey_StaticImg		= "static_img";
 static const char* szKey_MenuTarg		= "menu_targ";
 static const char* szKey_Processing		= "processing";
@@ -26,6 +34,24 @@ static const char* szKey_VideoExpMicro	= "video_exposure_micro";
 static const char* szKey_MMAL_WBGain	= "mmal_wb_gain";
 static const char* szKey_MMAL_ADGain	= "mmal_ad_gain";
 static const char* szKey_MMAL_SpamGains	= "mmal_spam_gain";
+static const char* szKey_FaultInject	= "fault_inject";
+static const char* szKey_ProcROI		= "processing_roi";
+
+// Keys inside of the szKey_FaultInject object.
+static const char* szKey_FI_Drop			= "drop";
+static const char* szKey_FI_Stall			= "stall";
+static const char* szKey_FI_StallMS			= "stall_ms";
+static const char* szKey_FI_Disconnect		= "disconnect";
+static const char* szKey_FI_DisconnectMS	= "disconnect_ms";
+static const char* szKey_FI_ActivateFail	= "activate_fail";
+static const char* szKey_FI_Seed			= "seed";
+
+// Keys inside of the szKey_ProcROI object.
+static const char* szKey_ROI_X				= "x";
+static const char* szKey_ROI_Y				= "y";
+static const char* szKey_ROI_W				= "w";
+static const char* szKey_ROI_H				= "h";
+static const char* szKey_ROI_Passthrough	= "passthrough";
 
 json cvgCamFeedSource::AsJSON() const
 {
@@ -50,8 +76,16 @@ json cvgCamFeedSource::AsJSON() const
 	ret[szKey_PipeChans		] = this->channelCtFromPipe;
 	ret[szKey_PipeWidth		] = this->pipeWidth;
 	ret[szKey_PipeHeight	] = this->pipeHeight;
+	ret[szKey_ReplayPath	] = this->replayPath;
+	ret[szKey_ReplayFPS		] = this->replayFPS;
+	ret[szKey_ReplayLoop	] = this->replayLoop;
+	ret[szKey_ReplayStamps	] = this->replayTimestamps;
 	ret[szKey_StreamWidth	] = this->streamWidth;
 	ret[szKey_StreamHeight	] = this->streamHeight;
+	ret[szKey_StreamFPS		] = this->streamFPS;
+	ret[szKey_CaptureFormat	] = to_string(this->captureFormat);
+	ret[szKey_NegotiateMode	] = this->negotiateCaptureMode;
+	ret[szKey_LowLatencyGrab] = this->lowLatencyGrab;
 	ret[szKey_StaticImg		] = this->staticImagePath;
 	ret[szKey_MenuTarg		] = this->menuTarg;
 	ret[szKey_FlipHoriz		] = this->flipHorizontal;
@@ -75,6 +109,34 @@ json cvgCamFeedSource::AsJSON() const
 	}
 	ret[szKey_MMAL_WBGain] = jsrWBGain;
 
+	// Fault injection is a development tool, so it's only saved if it
+	// was explicitly specified.
+	if(this->faultInjection.has_value())
+	{
+		const CamFaultProfile& fi = this->faultInjection.value();
+		json jsFault = json::object();
+		jsFault[szKey_FI_Drop			] = fi.dropChance;
+		jsFault[szKey_FI_Stall			] = fi.stallChance;
+		jsFault[szKey_FI_StallMS		] = fi.stallMS;
+		jsFault[szKey_FI_Disconnect		] = fi.disconnectChance;
+		jsFault[szKey_FI_DisconnectMS	] = fi.disconnectMS;
+		jsFault[szKey_FI_ActivateFail	] = fi.activateFailChance;
+		jsFault[szKey_FI_Seed			] = fi.seed;
+		ret[szKey_FaultInject] = jsFault;
+	}
+
+	if(this->processingROI.has_value())
+	{
+		const ProcessingROI& roi = this->processingROI.value();
+		json jsROI = json::object();
+		jsROI[szKey_ROI_X			] = roi.x;
+		jsROI[szKey_ROI_Y			] = roi.y;
+		jsROI[szKey_ROI_W			] = roi.w;
+		jsROI[szKey_ROI_H			] = roi.h;
+		jsROI[szKey_ROI_Passthrough	] = roi.passthrough;
+		ret[szKey_ProcROI] = jsROI;
+	}
+
 	if(this->processing == ProcessingType::static_threshold)
 		ret[szKey_Processing] = this->thresholdExplicit;
 	else
@@ -113,7 +175,7 @@ void cvgCamFeedSource::ApplyJSON(const json& js)
 	if(js.contains(szKey_PipeCmd) && js[szKey_PipeCmd].is_string())
 		this->externalPipeCmd = js[szKey_PipeCmd];
 
-	if(js.contains(szKey_PipeChans) && js[szKey_PipeChans].is_string())
+	if(js.contains(szKey_PipeChans) && js[szKey_PipeChans].is_number_integer())
 		this->channelCtFromPipe = js[szKey_PipeChans];
 
 	if(js.contains(szKey_PipeWidth) && js[szKey_PipeWidth].is_number())
@@ -122,12 +184,36 @@ void cvgCamFeedSource::ApplyJSON(const json& js)
 	if(js.contains(szKey_PipeHeight) && js[szKey_PipeHeight].is_number())
 		this->pipeHeight = js[szKey_PipeHeight];
 
+	if(js.contains(szKey_ReplayPath) && js[szKey_ReplayPath].is_string())
+		this->replayPath = js[szKey_ReplayPath];
+
+	if(js.contains(szKey_ReplayFPS) && js[szKey_ReplayFPS].is_number() && js[szKey_ReplayFPS] >= 0)
+		this->replayFPS = js[szKey_ReplayFPS];
+
+	if(js.contains(szKey_ReplayLoop) && js[szKey_ReplayLoop].is_boolean())
+		this->replayLoop = js[szKey_ReplayLoop];
+
+	if(js.contains(szKey_ReplayStamps) && js[szKey_ReplayStamps].is_boolean())
+		this->replayTimestamps = js[szKey_ReplayStamps];
+
 	if(js.contains(szKey_StreamWidth) && js[szKey_StreamWidth].is_number_integer())
 		this->streamWidth = js[szKey_StreamWidth];
 
 	if(js.contains(szKey_StreamHeight) && js[szKey_StreamHeight].is_number_integer())
 		this->streamHeight = js[szKey_StreamHeight];
 
+	if(js.contains(szKey_StreamFPS) && js[szKey_StreamFPS].is_number() && js[szKey_StreamFPS] > 0)
+		this->streamFPS = js[szKey_StreamFPS];
+
+	if(js.contains(szKey_CaptureFormat) && js[szKey_CaptureFormat].is_string())
+		this->captureFormat = StringToCaptureFormat(js[szKey_CaptureFormat]);
+
+	if(js.contains(szKey_NegotiateMode) && js[szKey_NegotiateMode].is_boolean())
+		this->negotiateCaptureMode = js[szKey_NegotiateMode];
+
+	if(js.contains(szKey_LowLatencyGrab) && js[szKey_LowLatencyGrab].is_boolean())
+		this->lowLatencyGrab = js[szKey_LowLatencyGrab];
+
 	if(js.contains(szKey_StaticImg) && js[szKey_StaticImg].is_string())
 		this->staticImagePath = js[szKey_StaticImg];
 
@@ -170,6 +256,58 @@ void cvgCamFeedSource::ApplyJSON(const json& js)
 	if(js.contains(szKey_MMAL_SpamGains) && js[szKey_MMAL_SpamGains].is_boolean())
 		this->spamGains = js[szKey_MMAL_SpamGains];
 
+	if(js.contains(szKey_FaultInject) && js[szKey_FaultInject].is_object())
+	{
+		const json& jsFault = js[szKey_FaultInject];
+		CamFaultProfile fi;
+
+		if(jsFault.contains(szKey_FI_Drop) && jsFault[szKey_FI_Drop].is_number())
+			fi.dropChance = jsFault[szKey_FI_Drop];
+
+		if(jsFault.contains(szKey_FI_Stall) && jsFault[szKey_FI_Stall].is_number())
+			fi.stallChance = jsFault[szKey_FI_Stall];
+
+		if(jsFault.contains(szKey_FI_StallMS) && jsFault[szKey_FI_StallMS].is_number_integer())
+			fi.stallMS = jsFault[szKey_FI_StallMS];
+
+		if(jsFault.contains(szKey_FI_Disconnect) && jsFault[szKey_FI_Disconnect].is_number())
+			fi.disconnectChance = jsFault[szKey_FI_Disconnect];
+
+		if(jsFault.contains(szKey_FI_DisconnectMS) && jsFault[szKey_FI_DisconnectMS].is_number_integer())
+			fi.disconnectMS = jsFault[szKey_FI_DisconnectMS];
+
+		if(jsFault.contains(szKey_FI_ActivateFail) && jsFault[szKey_FI_ActivateFail].is_number())
+			fi.activateFailChance = jsFault[szKey_FI_ActivateFail];
+
+		if(jsFault.contains(szKey_FI_Seed) && jsFault[szKey_FI_Seed].is_number_unsigned())
+			fi.seed = jsFault[szKey_FI_Seed];
+
+		this->faultInjection = fi;
+	}
+
+	if(js.contains(szKey_ProcROI) && js[szKey_ProcROI].is_object())
+	{
+		const json& jsROI = js[szKey_ProcROI];
+		ProcessingROI roi;
+
+		if(jsROI.contains(szKey_ROI_X) && jsROI[szKey_ROI_X].is_number())
+			roi.x = jsROI[szKey_ROI_X];
+
+		if(jsROI.contains(szKey_ROI_Y) && jsROI[szKey_ROI_Y].is_number())
+			roi.y = jsROI[szKey_ROI_Y];
+
+		if(jsROI.contains(szKey_ROI_W) && jsROI[szKey_ROI_W].is_number())
+			roi.w = jsROI[szKey_ROI_W];
+
+		if(jsROI.contains(szKey_ROI_H) && jsROI[szKey_ROI_H].is_number())
+			roi.h = jsROI[szKey_ROI_H];
+
+		if(jsROI.contains(szKey_ROI_Passthrough) && jsROI[szKey_ROI_Passthrough].is_boolean())
+			roi.passthrough = jsROI[szKey_ROI_Passthrough];
+
+		this->processingROI = roi;
+	}
+
 	if (js.contains(szKey_Processing))
 	{
 		if(js[szKey_Processing].is_string())
@@ -195,4 +333,64 @@ VideoPollType cvgCamFeedSource::GetUsedPoll() const
 #endif
 
 	return ret;
+}
+
+bool cvgCamFeedSource::SameDeviceAs(const cvgCamFeedSource& other) const
+{
+	VideoPollType usedPoll = this->GetUsedPoll();
+	if(usedPoll != other.GetUsedPoll())
+		return false;
+
+	// The fault injection wrapper is created with the implementation.
+	if(this->faultInjection != other.faultInjection)
+		return false;
+
+	// The pixel format is negotiated when the device is opened.
+	if(this->captureFormat != other.captureFormat || this->negotiateCaptureMode != other.negotiateCaptureMode)
+		return false;
+
+	// The grabber thread is started with the stream.
+	if(this->lowLatencyGrab != other.lowLatencyGrab)
+		return false;
+
+	// Only the location members relevant to the poll type matter.
+	switch(usedPoll)
+	{
+	case VideoPollType::OpenCVUSB_Idx:
+		return this->camIndex == other.camIndex;
+
+	case VideoPollType::OpenCVUSB_Named:
+		return this->devicePath == other.devicePath;
+
+	case VideoPollType::Web:
+		return this->uriSource == other.uriSource;
+
+	case VideoPollType::Image:
+		return this->staticImagePath == other.staticImagePath;
+
+	case VideoPollType::MMAL:
+		return this->camMMALIdx == other.camMMALIdx;
+
+	case VideoPollType::Replay:
+		// The frames are loaded, and their timing set, when activated.
+		return 
+			this->replayPath		== other.replayPath			&&
+			this->replayFPS			== other.replayFPS			&&
+			this->replayLoop		== other.replayLoop			&&
+			this->replayTimestamps	== other.replayTimestamps	&&
+			this->channelCtFromPipe == other.channelCtFromPipe	&&
+			this->pipeWidth			== other.pipeWidth			&&
+			this->pipeHeight		== other.pipeHeight;
+
+	case VideoPollType::External:
+		// There's no handshaking with the external program, so the
+		// expected frame layout is part of its identity.
+		return 
+			this->externalPipeCmd	== other.externalPipeCmd	&&
+			this->channelCtFromPipe == other.channelCtFromPipe	&&
+			this->pipeWidth			== other.pipeWidth			&&
+			this->pipeHeight		== other.pipeHeight;
+	}
+
+	return true;
 }
\ No newline at end of file
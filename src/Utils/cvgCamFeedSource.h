@@ -1,10 +1,13 @@
 #pragma once
 #include "VideoPollType.h"
 #include "ProcessingType.h"
+#include "CaptureFormat.h"
 #include "nlohmann/json.hpp"
 #include <string>
 #include <optional>
 #include "GainStructs.h"
+#include "CamFaultProfile.h"
+#include "ProcessingROI.h"
 
 using json = nlohmann::json;
 
@@ -52,20 +55,48 @@ public:
 	/// </summary>
 	std::string staticImagePath = "testimage.png";
 
+	/// <summary>
+	/// If the poll type is Replay, the recorded raw frame file, or the 
+	/// directory of images, to replay.
+	/// </summary>
+	std::string replayPath = "replay.raw";
+
+	/// <summary>
+	/// The frame rate to replay at. A value of 0 replays frames as fast
+	/// as the camera's pipeline can take them.
+	/// </summary>
+	double replayFPS = 30.0;
+
+	/// <summary>
+	/// If true, replaying starts over at the end of the frames. Else, the
+	/// last frame is repeated.
+	/// </summary>
+	bool replayLoop = true;
+
+	/// <summary>
+	/// If true, and the replay has a timestamps file, frames are replayed
+	/// with their recorded timing instead of at replayFPS.
+	/// </summary>
+	bool replayTimestamps = false;
+
 	/// <summary>
 	/// The number of (1 byte channels) that externalPipeCmd
 	/// should pipe in. There's no handshaking involved with the program
 	/// so this needs to be explicitly known and defined by us.
+	/// 
+	/// This also defines the frames of a raw frame file being replayed.
 	/// </summary>
 	int channelCtFromPipe = 3;
 
 	/// <summary>
-	/// The width of the image if we're streaming it from externalPipeCmd;
+	/// The width of the image if we're streaming it from externalPipeCmd,
+	/// or replaying it from a raw frame file.
 	/// </summary>
 	int pipeWidth = 640;
 
 	/// <summary>
-	/// The height of the image if we're streaming it from externalPipeCmd;
+	/// The height of the image if we're streaming it from externalPipeCmd,
+	/// or replaying it from a raw frame file.
 	/// </summary>
 	int pipeHeight = 480;
 
@@ -83,6 +114,39 @@ public:
 	/// </summary>
 	int streamHeight = 480;
 
+	/// <summary>
+	/// The frame rate of the camera stream. This is requested from the device,
+	/// and paces the camera's polling and recording. The composite runs at 
+	/// the rate of the fastest feed.
+	/// </summary>
+	double streamFPS = 30.0;
+
+	/// <summary>
+	/// The pixel format to request from the camera (if using an OpenCV 
+	/// implementation). Monochrome feeds, such as the NIR camera, should use 
+	/// a single channel format so the frames stay single channel throughout
+	/// the pipeline, instead of being converted to BGR and back.
+	/// </summary>
+	CaptureFormat captureFormat = CaptureFormat::BGR;
+
+	/// <summary>
+	/// If true, USB and V4L2 devices (if using an OpenCV implementation) are
+	/// opened with the mode that best matches the stream dimensions and frame
+	/// rate out of what the device supports, using MJPEG if that's the only
+	/// way to reach the frame rate. If false, the stream dimensions are 
+	/// requested as-is.
+	/// </summary>
+	bool negotiateCaptureMode = true;
+
+	/// <summary>
+	/// If true (and using an OpenCV implementation), a dedicated thread
+	/// grabs frames as fast as the source delivers them, and only the newest
+	/// frame is retrieved when polled. Use this for sources that buffer frames,
+	/// such as RTSP/HTTP streams, where polling at our own rate would fall 
+	/// behind.
+	/// </summary>
+	bool lowLatencyGrab = false;
+
 	/// <summary>
 	/// For algorithms that specify an explict threshold value (from 0-255)
 	/// </summary>
@@ -136,6 +200,20 @@ public:
 	/// </summary>
 	bool spamGains = false;
 
+	/// <summary>
+	/// If set, the camera implementation is wrapped to randomly simulate
+	/// dropped frames, stalls and disconnects. This is for development
+	/// only, see CamImpl_FaultInject.
+	/// </summary>
+	std::optional<CamFaultProfile> faultInjection;
+
+	/// <summary>
+	/// If set, image processing is limited to this region of the frames.
+	/// Can also be adjusted at runtime with the StreamParams::ProcessingROI*
+	/// parameters.
+	/// </summary>
+	std::optional<ProcessingROI> processingROI;
+
 };
 
 
@@ -180,6 +258,16 @@ public:
 	/// <returns></returns>
 	VideoPollType GetUsedPoll() const;
 
+	/// <summary>
+	/// Check if another set of options refers to the same device, using the
+	/// same polling method. If not, switching between the two requires the
+	/// camera to be reconnected - else, the differences may be able to be
+	/// applied to the running camera.
+	/// </summary>
+	/// <param name="other">The options to compare against.</param>
+	/// <returns>True if both options would connect to the same device.</returns>
+	bool SameDeviceAs(const cvgCamFeedSource& other) const;
+
 	/// <summary>
 	/// Get a JSON representation of the object.
 	/// </summary>
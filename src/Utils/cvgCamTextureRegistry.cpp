@@ -97,6 +97,10 @@ GLuint cvgCamTextureRegistry::LoadTexture(int camIdx, cv::Ptr<cv::Mat> img, long
 
 	}
 
+	// Single channel rows aren't necessarily 4 byte aligned.
+	if(img->step % 4 != 0)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
 	glTexImage2D(
 		GL_TEXTURE_2D, 
 		0, 
@@ -108,6 +112,9 @@ GLuint cvgCamTextureRegistry::LoadTexture(int camIdx, cv::Ptr<cv::Mat> img, long
 		GL_UNSIGNED_BYTE,
 		img->ptr());
 
+	if(img->step % 4 != 0)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
 	return texAlloc;
 }
 
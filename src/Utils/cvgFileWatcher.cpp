@@ -0,0 +1,166 @@
+#include "cvgFileWatcher.h"
+#include "multiplatform.h"
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+cvgFileWatcher::~cvgFileWatcher()
+{
+	this->Stop();
+}
+
+bool cvgFileWatcher::Start(const std::string& filepath, Callback onChanged, int debounceMS)
+{
+	this->Stop();
+
+	if(filepath.empty() || !onChanged)
+		return false;
+
+	this->filepath		= filepath;
+	this->onChanged		= onChanged;
+	this->debounceMS	= debounceMS;
+
+	this->stopRequested = false;
+	this->watchThread = new std::thread(&cvgFileWatcher::ThreadFn, this);
+	return true;
+}
+
+void cvgFileWatcher::Stop()
+{
+	if(this->watchThread == nullptr)
+		return;
+
+	this->stopRequested = true;
+	this->watchThread->join();
+	delete this->watchThread;
+	this->watchThread = nullptr;
+}
+
+void cvgFileWatcher::IgnoreChangesFor(int ms)
+{
+	long long nowMS = 
+		std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+
+	this->ignoreUntilMS = nowMS + ms;
+}
+
+void cvgFileWatcher::ThreadFn()
+{
+	typedef std::chrono::steady_clock Clock;
+	namespace fs = std::filesystem;
+
+	// How often the thread wakes up to check stopRequested and the
+	// debounce timer.
+	const int tickMS = 100;
+
+	bool pendingChange = false;
+	Clock::time_point lastChange;
+
+	auto flagChange =
+		[&]()
+		{
+			long long nowMS = 
+				std::chrono::duration_cast<std::chrono::milliseconds>(
+					Clock::now().time_since_epoch()).count();
+
+			if(nowMS < this->ignoreUntilMS)
+				return;
+
+			pendingChange = true;
+			lastChange = Clock::now();
+		};
+
+	auto fireIfSettled =
+		[&]()
+		{
+			if(!pendingChange)
+				return;
+
+			auto quietMS = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - lastChange).count();
+			if(quietMS < this->debounceMS)
+				return;
+
+			pendingChange = false;
+			this->onChanged();
+		};
+
+	std::error_code ec;
+	fs::path watchPath = fs::absolute(this->filepath, ec);
+
+#ifdef __linux__
+	int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(fd < 0)
+	{
+		std::cerr << "Could not initialize inotify to watch " << this->filepath << std::endl;
+		return;
+	}
+
+	// Watch the directory instead of the file, because editors that
+	// save by renaming a temp file over the original would replace
+	// the inode we were watching.
+	std::string watchDir = watchPath.parent_path().string();
+	std::string watchName = watchPath.filename().string();
+	int wd = inotify_add_watch(fd, watchDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if(wd < 0)
+	{
+		std::cerr << "Could not add inotify watch for directory " << watchDir << std::endl;
+		close(fd);
+		return;
+	}
+
+	// inotify_events are variable length, so the buffer needs to be
+	// aligned for them.
+	alignas(struct inotify_event) char buf[4096];
+
+	while(!this->stopRequested)
+	{
+		pollfd pfd;
+		pfd.fd		= fd;
+		pfd.events	= POLLIN;
+		pfd.revents	= 0;
+
+		if(poll(&pfd, 1, tickMS) > 0 && (pfd.revents & POLLIN))
+		{
+			ssize_t len;
+			while((len = read(fd, buf, sizeof(buf))) > 0)
+			{
+				for(char* p = buf; p < buf + len; )
+				{
+					const struct inotify_event* ev = (const struct inotify_event*)p;
+					if(ev->len > 0 && watchName == ev->name)
+						flagChange();
+
+					p += sizeof(struct inotify_event) + ev->len;
+				}
+			}
+		}
+		fireIfSettled();
+	}
+
+	inotify_rm_watch(fd, wd);
+	close(fd);
+#else
+	// No inotify, fall back to polling the modification time.
+	fs::file_time_type lastWrite = fs::last_write_time(watchPath, ec);
+
+	while(!this->stopRequested)
+	{
+		MSSleep(tickMS);
+
+		fs::file_time_type curWrite = fs::last_write_time(watchPath, ec);
+		if(!ec && curWrite != lastWrite)
+		{
+			lastWrite = curWrite;
+			flagChange();
+		}
+		fireIfSettled();
+	}
+#endif
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <string>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+/// <summary>
+/// Watches a single file for modifications on a background thread.
+///
+/// On Linux this uses inotify on the file's parent directory, so that
+/// editors that save by writing a temp file and renaming it over the
+/// original are still detected. On other platforms, the file's last
+/// write time is polled.
+///
+/// Editors will often generate several events for a single save, so
+/// events are debounced - the callback is only invoked once the file
+/// has been quiet for a short amount of time.
+///
+/// NOTE: The callback is invoked from the watcher's thread. Anything
+/// that needs to happen on the main thread should be marshalled there
+/// by the callback.
+/// </summary>
+class cvgFileWatcher
+{
+public:
+	typedef std::function<void()> Callback;
+
+private:
+	/// <summary>
+	/// The file being watched.
+	/// </summary>
+	std::string filepath;
+
+	/// <summary>
+	/// The function to call when the file has changed.
+	/// </summary>
+	Callback onChanged;
+
+	/// <summary>
+	/// The number of milliseconds the file needs to stay unchanged
+	/// before onChanged is called.
+	/// </summary>
+	int debounceMS = 250;
+
+	std::thread* watchThread = nullptr;
+
+	/// <summary>
+	/// Signal for watchThread to exit.
+	/// </summary>
+	std::atomic_bool stopRequested = false;
+
+	/// <summary>
+	/// Changes before this time, in milliseconds on the steady clock, are
+	/// ignored. See IgnoreChangesFor().
+	/// </summary>
+	std::atomic<long long> ignoreUntilMS = 0;
+
+private:
+	void ThreadFn();
+
+public:
+	~cvgFileWatcher();
+
+	/// <summary>
+	/// Start watching a file. If a file is already being watched, it
+	/// will be stopped first.
+	/// </summary>
+	/// <param name="filepath">The file to watch.</param>
+	/// <param name="onChanged">The function to call when the file changes.</param>
+	/// <param name="debounceMS">
+	/// The milliseconds the file needs to stay unchanged before calling onChanged.
+	/// </param>
+	/// <returns>True if the watch was started.</returns>
+	bool Start(const std::string& filepath, Callback onChanged, int debounceMS = 250);
+
+	/// <summary>
+	/// Stop watching the file, and join the watch thread.
+	/// </summary>
+	void Stop();
+
+	/// <summary>
+	/// Ignore changes to the file for a while. For when the program is
+	/// about to write the file itself, and shouldn't react to its own 
+	/// write.
+	/// </summary>
+	/// <param name="ms">The milliseconds to ignore changes for.</param>
+	void IgnoreChangesFor(int ms);
+
+	inline bool IsWatching() const
+	{ return this->watchThread != nullptr; }
+};
@@ -7,7 +7,8 @@ cvgGrabTimer::cvgGrabTimer()
 
 void cvgGrabTimer::Reset(int startAccumMS)
 {
-	this->excessMicroseconds = startAccumMS;
+	this->accumMilli = startAccumMS;
+	this->excessMicroseconds = 0;
 	this->lastTime = std::chrono::high_resolution_clock::now();
 }
 
@@ -44,4 +45,18 @@ bool cvgGrabTimer::GrabMS(int ms)
 		return true;
 	}
 	return false;
+}
+
+bool cvgGrabTimer::GrabMicroseconds(long long us)
+{
+	this->FlushTime();
+
+	long long accumMicro = (long long)this->accumMilli * 1000 + this->excessMicroseconds;
+	if(accumMicro < us)
+		return false;
+
+	accumMicro -= us;
+	this->accumMilli = (long)(accumMicro / 1000);
+	this->excessMicroseconds = accumMicro % 1000;
+	return true;
 }
\ No newline at end of file
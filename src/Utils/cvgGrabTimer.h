@@ -64,4 +64,16 @@ public:
 	/// and the action tied to the chunk of time should be omitted.
 	/// </returns>
 	bool GrabMS(int ms);
+
+	/// <summary>
+	/// The same as GrabMS(), but in microseconds, for chunks of time that 
+	/// aren't a whole number of milliseconds (e.g., a 60FPS frame).
+	/// </summary>
+	/// <param name="us">
+	/// The specified number of allocated microseconds to attempt to remove.
+	/// </param>
+	/// <returns>
+	/// If true, the specified number of microseconds was removed.
+	/// </returns>
+	bool GrabMicroseconds(long long us);
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "cvgJitterMeter.h"
+#include <cmath>
+#include <algorithm>
+
+void cvgJitterMeter::Tick()
+{
+	std::lock_guard<std::mutex> guard(this->statsMutex);
+
+	double ms = (double)this->swInterval.Microseconds() / 1000.0;
+	if(!this->started)
+	{
+		this->started = true;
+		return;
+	}
+
+	++this->sampleCt;
+	if(this->sampleCt == 1)
+	{
+		this->minMS = ms;
+		this->maxMS = ms;
+	}
+	else
+	{
+		this->minMS = std::min(this->minMS, ms);
+		this->maxMS = std::max(this->maxMS, ms);
+	}
+
+	double delta = ms - this->meanMS;
+	this->meanMS += delta / (double)this->sampleCt;
+	this->m2 += delta * (ms - this->meanMS);
+}
+
+void cvgJitterMeter::Reset()
+{
+	std::lock_guard<std::mutex> guard(this->statsMutex);
+	this->started	= false;
+	this->sampleCt	= 0;
+	this->meanMS	= 0.0;
+	this->m2		= 0.0;
+	this->minMS		= 0.0;
+	this->maxMS		= 0.0;
+}
+
+cvgJitterMeter::Stats cvgJitterMeter::GetStats()
+{
+	std::lock_guard<std::mutex> guard(this->statsMutex);
+
+	Stats ret;
+	ret.sampleCt	= this->sampleCt;
+	ret.meanMS		= this->meanMS;
+	ret.minMS		= this->minMS;
+	ret.maxMS		= this->maxMS;
+
+	if(this->sampleCt > 1)
+		ret.jitterMS = std::sqrt(this->m2 / (double)(this->sampleCt - 1));
+
+	return ret;
+}
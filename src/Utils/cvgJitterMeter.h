@@ -0,0 +1,68 @@
+#pragma once
+
+#include "cvgStopwatch.h"
+#include <mutex>
+
+/// <summary>
+/// Measures how regularly something happens, such as frames arriving
+/// in a processing loop. Tick() is called on each occurrence, and the
+/// statistics of the intervals between ticks are tracked.
+///
+/// The jitter is the standard deviation of the intervals.
+///
+/// Tick() and GetStats() can be called from different threads.
+/// </summary>
+class cvgJitterMeter
+{
+public:
+	/// <summary>
+	/// The interval statistics, in milliseconds.
+	/// </summary>
+	struct Stats
+	{
+		/// <summary>
+		/// The number of intervals measured.
+		/// </summary>
+		long long sampleCt = 0;
+
+		double meanMS = 0.0;
+		double jitterMS = 0.0;
+		double minMS = 0.0;
+		double maxMS = 0.0;
+	};
+
+private:
+	std::mutex statsMutex;
+
+	cvgStopwatch swInterval;
+
+	/// <summary>
+	/// If false, the next Tick() only starts the first interval.
+	/// </summary>
+	bool started = false;
+
+	long long sampleCt = 0;
+	double meanMS = 0.0;
+
+	/// <summary>
+	/// The running sum of squared differences from the mean, for
+	/// Welford's online variance.
+	/// </summary>
+	double m2 = 0.0;
+
+	double minMS = 0.0;
+	double maxMS = 0.0;
+
+public:
+	/// <summary>
+	/// Record an occurrence, measuring the interval since the last one.
+	/// </summary>
+	void Tick();
+
+	/// <summary>
+	/// Clear the statistics. The next Tick() will start a new interval.
+	/// </summary>
+	void Reset();
+
+	Stats GetStats();
+};
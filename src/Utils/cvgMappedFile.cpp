@@ -0,0 +1,272 @@
+#include "cvgMappedFile.h"
+
+#if _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+cvgMappedFile::cvgMappedFile()
+{}
+
+cvgMappedFile::~cvgMappedFile()
+{
+	this->Close();
+}
+
+#if _WIN32
+
+/// <summary>
+/// Map all of an open file.
+/// </summary>
+static bool MapFileHandle(HANDLE file, bool writable, void*& outMapping, unsigned char*& outData)
+{
+	HANDLE mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+	if(mapping == NULL)
+		return false;
+
+	void* view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+	if(view == NULL)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	outMapping	= mapping;
+	outData		= (unsigned char*)view;
+	return true;
+}
+
+bool cvgMappedFile::Open(const std::string& path)
+{
+	this->Close();
+
+	HANDLE file =
+		CreateFileA(
+			path.c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			NULL,
+			OPEN_EXISTING,
+			FILE_FLAG_SEQUENTIAL_SCAN,
+			NULL);
+
+	if(file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	if(!MapFileHandle(file, false, this->mapHandle, this->data))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	this->fileHandle	= file;
+	this->size			= (size_t)fileSize.QuadPart;
+	this->writable		= false;
+	return true;
+}
+
+bool cvgMappedFile::Create(const std::string& path, size_t size)
+{
+	this->Close();
+
+	if(size == 0)
+		return false;
+
+	HANDLE file =
+		CreateFileA(
+			path.c_str(),
+			GENERIC_READ | GENERIC_WRITE,
+			FILE_SHARE_READ,
+			NULL,
+			CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL,
+			NULL);
+
+	if(file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = (LONGLONG)size;
+	if(!SetFilePointerEx(file, fileSize, NULL, FILE_BEGIN) || !SetEndOfFile(file))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	if(!MapFileHandle(file, true, this->mapHandle, this->data))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	this->fileHandle	= file;
+	this->size			= size;
+	this->writable		= true;
+	return true;
+}
+
+void cvgMappedFile::Flush()
+{
+	if(this->data != nullptr && this->writable)
+		FlushViewOfFile(this->data, 0);
+}
+
+void cvgMappedFile::Close()
+{
+	if(this->data != nullptr)
+		UnmapViewOfFile(this->data);
+
+	if(this->mapHandle != nullptr)
+		CloseHandle((HANDLE)this->mapHandle);
+
+	if(this->fileHandle != nullptr)
+		CloseHandle((HANDLE)this->fileHandle);
+
+	this->data			= nullptr;
+	this->size			= 0;
+	this->writable		= false;
+	this->mapHandle		= nullptr;
+	this->fileHandle	= nullptr;
+}
+
+void cvgMappedFile::CloseAndTruncate(size_t keepBytes)
+{
+	if(!this->writable || keepBytes >= this->size)
+	{
+		this->Close();
+		return;
+	}
+
+	// The file can't be resized while it's mapped.
+	UnmapViewOfFile(this->data);
+	CloseHandle((HANDLE)this->mapHandle);
+	this->data		= nullptr;
+	this->mapHandle	= nullptr;
+
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = (LONGLONG)keepBytes;
+	if(SetFilePointerEx((HANDLE)this->fileHandle, fileSize, NULL, FILE_BEGIN))
+		SetEndOfFile((HANDLE)this->fileHandle);
+
+	this->Close();
+}
+
+#else
+
+bool cvgMappedFile::Open(const std::string& path)
+{
+	this->Close();
+
+	int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(file == -1)
+		return false;
+
+	struct stat st;
+	if(fstat(file, &st) != 0 || st.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, file, 0);
+	if(view == MAP_FAILED)
+	{
+		close(file);
+		return false;
+	}
+
+	// Files are expected to be read front to back.
+	madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	this->fd		= file;
+	this->data		= (unsigned char*)view;
+	this->size		= (size_t)st.st_size;
+	this->writable	= false;
+	return true;
+}
+
+bool cvgMappedFile::Create(const std::string& path, size_t size)
+{
+	this->Close();
+
+	if(size == 0)
+		return false;
+
+	int file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if(file == -1)
+		return false;
+
+	// Allocating the blocks up front keeps writing pages from having to
+	// wait on the filesystem to find space. If the filesystem doesn't
+	// support it, the file is still sized, just sparsely.
+	if(posix_fallocate(file, 0, (off_t)size) != 0 && ftruncate(file, (off_t)size) != 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if(view == MAP_FAILED)
+	{
+		close(file);
+		return false;
+	}
+
+	this->fd		= file;
+	this->data		= (unsigned char*)view;
+	this->size		= size;
+	this->writable	= true;
+	return true;
+}
+
+void cvgMappedFile::Flush()
+{
+	if(this->data != nullptr && this->writable)
+		msync(this->data, this->size, MS_ASYNC);
+}
+
+void cvgMappedFile::Close()
+{
+	if(this->data != nullptr)
+		munmap(this->data, this->size);
+
+	if(this->fd != -1)
+		close(this->fd);
+
+	this->data		= nullptr;
+	this->size		= 0;
+	this->writable	= false;
+	this->fd		= -1;
+}
+
+void cvgMappedFile::CloseAndTruncate(size_t keepBytes)
+{
+	if(this->writable && keepBytes < this->size)
+	{
+		munmap(this->data, this->size);
+		this->data = nullptr;
+
+		if(ftruncate(this->fd, (off_t)keepBytes) != 0)
+		{
+			// Left at its full size, the unused part is just zeros.
+		}
+	}
+
+	this->Close();
+}
+
+#endif
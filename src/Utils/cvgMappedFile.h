@@ -0,0 +1,94 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+/// <summary>
+/// A memory mapping of an entire file.
+///
+/// Existing files are mapped read-only, with Open(). The file's contents are
+/// paged in by the OS as they're accessed, instead of being read into memory
+/// up front. New files can be created at a preallocated size and mapped for
+/// writing, with Create().
+/// </summary>
+class cvgMappedFile
+{
+private:
+	unsigned char* data = nullptr;
+	size_t size = 0;
+
+	/// <summary>
+	/// If true, the file was mapped with Create() and can be written to.
+	/// </summary>
+	bool writable = false;
+
+#if _WIN32
+	// The file and mapping, as Win32 HANDLEs.
+	void* fileHandle = nullptr;
+	void* mapHandle = nullptr;
+#else
+	int fd = -1;
+#endif
+
+public:
+	cvgMappedFile();
+	~cvgMappedFile();
+
+	cvgMappedFile(const cvgMappedFile&) = delete;
+	cvgMappedFile& operator=(const cvgMappedFile&) = delete;
+
+	/// <summary>
+	/// Map a file, closing any file that was already mapped.
+	/// </summary>
+	/// <param name="path">The file to map.</param>
+	/// <returns>
+	/// False if the file couldn't be opened or mapped. Empty files fail
+	/// to map.
+	/// </returns>
+	bool Open(const std::string& path);
+
+	/// <summary>
+	/// Create a file (replacing any existing file) with its space allocated
+	/// up front, and map it for writing. Closes any file already mapped.
+	/// </summary>
+	/// <param name="path">The file to create.</param>
+	/// <param name="size">The size of the file, in bytes.</param>
+	/// <returns>False if the file couldn't be created, allocated, or mapped.</returns>
+	bool Create(const std::string& path, size_t size);
+
+	/// <summary>
+	/// Start writing any modified pages of a writable mapping back to the
+	/// file, without waiting for them to finish.
+	/// </summary>
+	void Flush();
+
+	/// <summary>
+	/// Unmap and close the file, if one is mapped.
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Unmap and close a writable file, truncating it to the portion that 
+	/// was used. Read-only files are closed as-is.
+	/// </summary>
+	/// <param name="keepBytes">The size to truncate the file to.</param>
+	void CloseAndTruncate(size_t keepBytes);
+
+	inline bool IsOpen() const
+	{ return this->data != nullptr; }
+
+	/// <summary>
+	/// The mapped contents of the file, or nullptr if nothing is mapped.
+	/// </summary>
+	inline const unsigned char* Data() const
+	{ return this->data; }
+
+	/// <summary>
+	/// The mapped contents of the file for writing, or nullptr if nothing 
+	/// is mapped, or the file was mapped read-only.
+	/// </summary>
+	inline unsigned char* MutableData()
+	{ return this->writable ? this->data : nullptr; }
+
+	inline size_t Size() const
+	{ return this->size; }
+};
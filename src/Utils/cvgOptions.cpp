@@ -27,11 +27,35 @@ static const char* szKey_mousepad_scale		= "_mousepad_scale";
 static const char* szKey_debugUI			= "_debug_ui";
 static const char* szKey_compositeWidth		= "composite_width";
 static const char* szKey_compositeHeight	= "composite_height";
+static const char* szKey_startupTimeline	= "startup_timeline_json";
+static const char* szKey_camParallelOpen	= "cam_parallel_open";
+static const char* szKey_threadPlacement	= "thread_placement";
+static const char* szKey_opencvThreads		= "opencv_threads";
+static const char* szKey_taskPoolThreads	= "task_pool_threads";
+static const char* szKey_taskPoolOpenCV		= "task_pool_opencv";
+static const char* szKey_qualityGovernor	= "quality_governor";
+static const char* szKey_syncAcquisition	= "sync_acquisition";
+static const char* szKey_rawRecording		= "raw_recording";
+static const char* szKey_videoFramePadding	= "video_frame_padding";
+static const char* szKey_frameHistoryMB		= "frame_history_mb";
+static const char* szKey_frameHistorySecs	= "frame_history_seconds";
+static const char* szKey_frameHistoryStore	= "frame_history_storage";
+static const char* szKey_frameHistoryScale	= "frame_history_downscale";
+static const char* szKey_frameHistoryJPEG	= "frame_history_jpeg_quality";
+static const char* szKey_videoPreRollSecs	= "video_preroll_seconds";
+static const char* szKey_burstMultiFrame	= "burst_multiframe_dicom";
+static const char* szKey_dicomCompression	= "dicom_compression";
+static const char* szKey_storageBufferMB	= "storage_buffer_mb";
+static const char* szKey_storageSyncBatch	= "storage_sync_batch";
+static const char* szKey_storageWarnFreeMB	= "storage_warn_free_mb";
+static const char* szKey_storagePrealloc	= "storage_preallocate";
+static const char* szKey_storageIOUring		= "storage_io_uring";
 
 static const char* szkey_FeedOpts			= "feed_options";
 static const char* szKey_CarouselSeries		= "carousel_series";
 static const char* szKey_CarouselBody		= "carousel_body";
 static const char* szKey_CarouselOrient		= "carousel_orientation";
+static const char* szKey_CarouselIconCache	= "carousel_icon_cache_max";
 
 static const char* szKey_ExposureID			= "exposure_idx";
 static const char* szKey_ExposureEntry		= "exposure_entries";
@@ -227,6 +251,40 @@ void cvgOptions::Apply(json& data)
 	JSONGetMember(data, szKey_mousepad_scale,	this->mousepadScale);
 	JSONGetMember(data, szKey_debugUI,			this->drawUIDebug);
 	JSONGetMember(data, szKey_fullscreen,		this->fullscreen);
+	JSONGetMember(data, szKey_CarouselIconCache,this->caroIconCacheMax);
+	JSONGetMember(data, szKey_startupTimeline,	this->startupTimelinePath);
+	JSONGetMember(data, szKey_camParallelOpen,	this->camParallelOpen);
+	JSONGetMember(data, szKey_opencvThreads,	this->opencvThreads);
+	JSONGetMember(data, szKey_taskPoolThreads,	this->taskPoolThreads);
+	JSONGetMember(data, szKey_taskPoolOpenCV,	this->taskPoolOpenCV);
+	JSONGetMember(data, szKey_qualityGovernor,	this->qualityGovernor);
+	JSONGetMember(data, szKey_syncAcquisition,	this->syncAcquisition);
+	JSONGetMember(data, szKey_rawRecording,		this->rawRecording);
+	JSONGetMember(data, szKey_videoFramePadding,	this->videoFramePadding);
+	JSONGetMember(data, szKey_frameHistoryMB,	this->frameHistoryMB);
+	JSONGetMember(data, szKey_frameHistorySecs,	this->frameHistorySeconds);
+	JSONGetMember(data, szKey_frameHistoryStore,	this->frameHistoryStorage);
+	JSONGetMember(data, szKey_frameHistoryScale,	this->frameHistoryDownscale);
+	JSONGetMember(data, szKey_frameHistoryJPEG,	this->frameHistoryJPEGQuality);
+	JSONGetMember(data, szKey_videoPreRollSecs,	this->videoPreRollSeconds);
+	JSONGetMember(data, szKey_burstMultiFrame,	this->burstMultiFrameDicom);
+	JSONGetMember(data, szKey_dicomCompression,	this->dicomCompression);
+	JSONGetMember(data, szKey_storageBufferMB,	this->storageBufferMB);
+	JSONGetMember(data, szKey_storageSyncBatch,	this->storageSyncBatch);
+	JSONGetMember(data, szKey_storageWarnFreeMB,	this->storageWarnFreeMB);
+	JSONGetMember(data, szKey_storagePrealloc,	this->storagePreallocate);
+	JSONGetMember(data, szKey_storageIOUring,	this->storageIOUring);
+
+	if(data.contains(szKey_threadPlacement) && data[szKey_threadPlacement].is_object())
+	{
+		this->threadPlacements.clear();
+		for(auto it : data[szKey_threadPlacement].items())
+		{
+			ThreadPlacementOpts tpo;
+			if(tpo.ApplyJSON(it.value()))
+				this->threadPlacements[it.key()] = tpo;
+		}
+	}
 
 	if(data.contains(szkey_FeedOpts) && data[szkey_FeedOpts].is_array())
 	{
@@ -320,6 +378,37 @@ json cvgOptions::RepresentAsJSON() const
 
 	ret[szKey_fullscreen		]	= this->fullscreen;
 
+	ret[szKey_startupTimeline	]	= this->startupTimelinePath;
+	ret[szKey_camParallelOpen	]	= this->camParallelOpen;
+
+	//		THREAD PLACEMENT
+	//////////////////////////////////////////////////
+	json jsPlacements = json::object();
+	for(auto it : this->threadPlacements)
+		jsPlacements[it.first] = it.second.AsJSON();
+
+	ret[szKey_threadPlacement	]	= jsPlacements;
+	ret[szKey_opencvThreads		]	= this->opencvThreads;
+	ret[szKey_taskPoolThreads	]	= this->taskPoolThreads;
+	ret[szKey_taskPoolOpenCV	]	= this->taskPoolOpenCV;
+	ret[szKey_qualityGovernor	]	= this->qualityGovernor;
+	ret[szKey_syncAcquisition	]	= this->syncAcquisition;
+	ret[szKey_rawRecording		]	= this->rawRecording;
+	ret[szKey_videoFramePadding	]	= this->videoFramePadding;
+	ret[szKey_frameHistoryMB	]	= this->frameHistoryMB;
+	ret[szKey_frameHistorySecs	]	= this->frameHistorySeconds;
+	ret[szKey_frameHistoryStore	]	= this->frameHistoryStorage;
+	ret[szKey_frameHistoryScale	]	= this->frameHistoryDownscale;
+	ret[szKey_frameHistoryJPEG	]	= this->frameHistoryJPEGQuality;
+	ret[szKey_videoPreRollSecs	]	= this->videoPreRollSeconds;
+	ret[szKey_burstMultiFrame	]	= this->burstMultiFrameDicom;
+	ret[szKey_dicomCompression	]	= this->dicomCompression;
+	ret[szKey_storageBufferMB	]	= this->storageBufferMB;
+	ret[szKey_storageSyncBatch	]	= this->storageSyncBatch;
+	ret[szKey_storageWarnFreeMB	]	= this->storageWarnFreeMB;
+	ret[szKey_storagePrealloc	]	= this->storagePreallocate;
+	ret[szKey_storageIOUring	]	= this->storageIOUring;
+
 	//		VIDEO FEED ENTRIES
 	//////////////////////////////////////////////////
 	json feedOpts = json::array();
@@ -333,6 +422,7 @@ json cvgOptions::RepresentAsJSON() const
 	ret[szKey_CarouselBody]		= this->caroBody.AsJSON();
 	ret[szKey_CarouselSeries]	= this->caroSysSeries.AsJSON();
 	ret[szKey_CarouselOrient]	= this->caroSysOrient.AsJSON();
+	ret[szKey_CarouselIconCache]= this->caroIconCacheMax;
 
 	//		EXPOSURES
 	//////////////////////////////////////////////////
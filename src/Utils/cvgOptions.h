@@ -3,6 +3,7 @@
 #include "nlohmann/json.hpp"
 #include "cvgCamFeedSource.h"
 #include "CarouselData.h"
+#include "cvgThreadPlacement.h"
 #include <string>
 #include <vector>
 
@@ -120,6 +121,13 @@ public:
 	CarouselSystemData caroSysSeries;
 	CarouselSystemData caroSysOrient;
 
+	/// <summary>
+	/// The maximum number of carousel icon textures to keep loaded
+	/// at once, shared between all carousels. Icons past this are
+	/// evicted least-recently-used first.
+	/// </summary>
+	int caroIconCacheMax = 16;
+
 	// This should have 4 entries. Anything more will be ignored.
 	std::vector<ExposureSetting> exposures;
 
@@ -130,6 +138,154 @@ public:
 	/// </summary>
 	int defaultExposureID = 0;
 
+	/// <summary>
+	/// If not empty, the filepath to save the startup timeline to as
+	/// JSON. The timeline is always printed to the console.
+	/// </summary>
+	std::string startupTimelinePath = "";
+
+	/// <summary>
+	/// If true, hardware cameras are allowed to open their devices in 
+	/// parallel. Off by default because V4L2 device opens have caused
+	/// intermittent segfaults on the Pi when not serialized.
+	/// </summary>
+	bool camParallelOpen = false;
+
+	/// <summary>
+	/// CPU affinity and scheduling options for the app's threads, keyed
+	/// by thread role. See cvgThreadPlacement for the roles. Threads
+	/// without an entry are left as is.
+	/// </summary>
+	std::map<std::string, ThreadPlacementOpts> threadPlacements;
+
+	/// <summary>
+	/// The number of threads OpenCV is allowed to use for parallelizing
+	/// its own operations. OpenCV's thread pool is shared by all the 
+	/// processing stages. A negative value uses OpenCV's default.
+	/// </summary>
+	int opencvThreads = -1;
+
+	/// <summary>
+	/// The number of worker threads in the shared task pool (cvgTaskPool)
+	/// used for snapshot encoding, video encoding and compositing. If 0, 
+	/// one worker per hardware thread is used. If negative, the pool isn't 
+	/// started and that work is done on the camera and composite threads 
+	/// directly. Only read at startup.
+	/// </summary>
+	int taskPoolThreads = 0;
+
+	/// <summary>
+	/// If true, and the task pool is running, OpenCV's parallel_for_ is
+	/// routed into the task pool instead of OpenCV's own threads. Requires 
+	/// OpenCV 4.5.2 or later. Only read at startup.
+	/// </summary>
+	bool taskPoolOpenCV = true;
+
+	/// <summary>
+	/// If true, the quality governor (cvgQualityGovernor) reduces the 
+	/// processing quality when the cameras or composite fall behind the 
+	/// frame rate.
+	/// </summary>
+	bool qualityGovernor = true;
+
+	/// <summary>
+	/// If true, the cameras grab their frames at the same time, and frames
+	/// are tagged with a shared acquisition epoch so the composite and 
+	/// snapshots pair up matching frames. See CamSyncGroup.
+	/// </summary>
+	bool syncAcquisition = false;
+
+	/// <summary>
+	/// If true, videos are recorded losslessly as raw capture recordings
+	/// (see RawCaptureWriter), instead of compressed video files.
+	/// </summary>
+	bool rawRecording = false;
+
+	/// <summary>
+	/// If true, compressed videos are padded with duplicate frames to keep
+	/// a constant frame rate. Else, each frame is written once, and the
+	/// real capture times are in the video's timestamps file.
+	/// </summary>
+	bool videoFramePadding = false;
+
+	/// <summary>
+	/// The memory budget, in megabytes, of each stream's history of recent
+	/// frames (see FrameHistory). If 0, no history is kept, and snapshots
+	/// and videos can't start from before they were requested.
+	/// </summary>
+	int frameHistoryMB = 0;
+
+	/// <summary>
+	/// The longest span of time, in seconds, kept in each stream's history.
+	/// </summary>
+	float frameHistorySeconds = 5.0f;
+
+	/// <summary>
+	/// How frames are stored in the history: "full", "downscaled" or 
+	/// "compressed" (JPEG).
+	/// </summary>
+	std::string frameHistoryStorage = "full";
+
+	/// <summary>
+	/// The factor the width and height of frames are divided by, for 
+	/// "downscaled" history storage.
+	/// </summary>
+	int frameHistoryDownscale = 2;
+
+	/// <summary>
+	/// The JPEG quality, for "compressed" history storage.
+	/// </summary>
+	int frameHistoryJPEGQuality = 90;
+
+	/// <summary>
+	/// How many seconds before recording is started that compressed videos 
+	/// start at, using the stream's history. 
+	/// </summary>
+	float videoPreRollSeconds = 0.0f;
+
+	/// <summary>
+	/// If true, burst snapshots are saved into one multi-frame DICOM file
+	/// (see MultiFrameDicomWriter). Else, each frame is saved as its own
+	/// DICOM file.
+	/// </summary>
+	bool burstMultiFrameDicom = true;
+
+	/// <summary>
+	/// The lossless compression of saved DICOM pixel data, "none", "rle" or
+	/// "jpegls" (see DicomCompress). JPEG-LS needs a build with DCMTK's 
+	/// dcmjpls, else RLE is used.
+	/// </summary>
+	std::string dicomCompression = "none";
+
+	/// <summary>
+	/// The most memory used by snapshots waiting to be written to disk (see
+	/// CaptureStorage). Past it, snapshots are written as they're encoded.
+	/// If 0, they're always written as they're encoded.
+	/// </summary>
+	int storageBufferMB = 64;
+
+	/// <summary>
+	/// The most captures written to disk before they're synced together.
+	/// </summary>
+	int storageSyncBatch = 16;
+
+	/// <summary>
+	/// When the free space of the captures' disk falls below this, a
+	/// warning is shown in the HMD.
+	/// </summary>
+	int storageWarnFreeMB = 1024;
+
+	/// <summary>
+	/// If true, the space of captures is preallocated before they're written.
+	/// </summary>
+	bool storagePreallocate = true;
+
+	/// <summary>
+	/// If true, captures are written through io_uring. Needs a Linux build
+	/// with IOURING=1, else it's ignored.
+	/// </summary>
+	bool storageIOUring = true;
+
 public:
 	cvgOptions(int defSources, bool sampleCarousels = true);
 
@@ -0,0 +1,185 @@
+#include "cvgQualityGovernor.h"
+#include <iostream>
+#include <algorithm>
+
+// How often the load is evaluated.
+const int msEvaluateInterval = 500;
+
+// The weight of a new sample in a stage's moving average.
+const double stageAvgWeight = 0.1;
+
+// The load the slowest stage needs to be over to step down.
+const double stepDownLoad = 0.9;
+// The load the slowest stage needs to be under to step up.
+const double stepUpLoad = 0.6;
+
+// The number of evaluations in a row needed to step down.
+const int stepDownEvals = 2;
+// The number of evaluations in a row needed to step up, before any
+// backoff from bouncing.
+const int stepUpEvalsMin = 10;
+const int stepUpEvalsMax = 120;
+
+// If a step down happens within this long after a step up, the step
+// up is considered to have bounced.
+const int msBounceWindow = 10000;
+
+cvgQualityGovernor cvgQualityGovernor::_inst;
+
+cvgQualityGovernor::cvgQualityGovernor()
+{
+	this->stepUpEvals = stepUpEvalsMin;
+}
+
+cvgQualityGovernor& cvgQualityGovernor::GetInstance()
+{
+	return _inst;
+}
+
+void cvgQualityGovernor::SetEnabled(bool enable)
+{
+	if(this->enabled == enable)
+		return;
+
+	this->enabled = enable;
+	if(!enable)
+		this->Reset();
+}
+
+void cvgQualityGovernor::SetBudgetMS(double ms)
+{
+	std::lock_guard<std::mutex> guard(this->govMutex);
+	this->budgetMS = std::max(ms, 1.0);
+}
+
+void cvgQualityGovernor::ReportStage(const std::string& stage, double ms)
+{
+	if(!this->enabled)
+		return;
+
+	std::lock_guard<std::mutex> guard(this->govMutex);
+
+	auto itFind = this->stageAvgMS.find(stage);
+	if(itFind == this->stageAvgMS.end())
+		this->stageAvgMS[stage] = ms;
+	else
+		itFind->second += (ms - itFind->second) * stageAvgWeight;
+
+	if(this->swEvaluate.Milliseconds(false) >= msEvaluateInterval)
+	{
+		this->swEvaluate.Restart();
+		this->_Evaluate();
+	}
+}
+
+void cvgQualityGovernor::_Evaluate()
+{
+	double slowestMS = 0.0;
+	std::string slowestStage;
+	for(auto it : this->stageAvgMS)
+	{
+		if(it.second > slowestMS)
+		{
+			slowestMS = it.second;
+			slowestStage = it.first;
+		}
+	}
+
+	double load = slowestMS / this->budgetMS;
+	this->status.load = load;
+	this->status.slowestStage = slowestStage;
+
+	int curLevel = this->level;
+	if(load > stepDownLoad)
+	{
+		this->underEvalCt = 0;
+		++this->overEvalCt;
+		if(this->overEvalCt >= stepDownEvals && curLevel < (int)Level::Count - 1)
+		{
+			// If we just stepped up and it couldn't hold, wait longer
+			// before trying again.
+			if(this->lastChangeWasUp && this->swLastChange.Milliseconds(false) < msBounceWindow)
+				this->stepUpEvals = std::min(this->stepUpEvals * 2, stepUpEvalsMax);
+
+			this->lastChangeWasUp = false;
+			++this->status.stepDownCt;
+			this->_SetLevel(curLevel + 1);
+		}
+	}
+	else if(load < stepUpLoad)
+	{
+		this->overEvalCt = 0;
+		++this->underEvalCt;
+		if(this->underEvalCt >= this->stepUpEvals && curLevel > 0)
+		{
+			this->lastChangeWasUp = true;
+			++this->status.stepUpCt;
+			this->_SetLevel(curLevel - 1);
+		}
+	}
+	else
+	{
+		this->overEvalCt = 0;
+		this->underEvalCt = 0;
+	}
+
+	// After a long enough time without bouncing, stop penalizing
+	// stepping up.
+	if(this->stepUpEvals > stepUpEvalsMin && this->swLastChange.Milliseconds(false) >= msBounceWindow * 6)
+		this->stepUpEvals = stepUpEvalsMin;
+}
+
+void cvgQualityGovernor::_SetLevel(int newLevel)
+{
+	std::cout << "Quality governor changing from " << to_string((Level)this->level.load()) << " to " << to_string((Level)newLevel) << ", load " << this->status.load << " from " << this->status.slowestStage << "." << std::endl;
+
+	this->level = newLevel;
+	this->overEvalCt = 0;
+	this->underEvalCt = 0;
+	this->swLastChange.Restart();
+
+	// The averages were measured at the old level, start over.
+	this->stageAvgMS.clear();
+}
+
+cvgQualityGovernor::Status cvgQualityGovernor::GetStatus()
+{
+	std::lock_guard<std::mutex> guard(this->govMutex);
+	Status ret = this->status;
+	ret.level = this->GetLevel();
+	return ret;
+}
+
+void cvgQualityGovernor::Reset()
+{
+	std::lock_guard<std::mutex> guard(this->govMutex);
+	this->level = (int)Level::Full;
+	this->stageAvgMS.clear();
+	this->overEvalCt = 0;
+	this->underEvalCt = 0;
+	this->stepUpEvals = stepUpEvalsMin;
+	this->lastChangeWasUp = false;
+	this->status.load = 0.0;
+	this->status.slowestStage.clear();
+}
+
+std::string to_string(cvgQualityGovernor::Level lvl)
+{
+	switch(lvl)
+	{
+	case cvgQualityGovernor::Level::Full:
+		return "full";
+	case cvgQualityGovernor::Level::HalfResMask:
+		return "half_res_mask";
+	case cvgQualityGovernor::Level::HalfRateMask:
+		return "half_rate_mask";
+	case cvgQualityGovernor::Level::HalfResComposite:
+		return "half_res_composite";
+	case cvgQualityGovernor::Level::HalfRateComposite:
+		return "half_rate_composite";
+
+	case cvgQualityGovernor::Level::Count:
+		break;
+	}
+	return "unknown";
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "cvgStopwatch.h"
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+
+/// <summary>
+/// Holds the frame rate when the device falls behind, by reducing the
+/// quality of the processing stages.
+///
+/// The camera and composite threads report how long their stages took
+/// for each frame. When the slowest stage stays over the frame budget, the
+/// quality is stepped down one level. When there's been enough headroom for
+/// a while, it's stepped back up one level. The levels are in the order the
+/// reductions are applied, and each level includes the reductions of the
+/// levels before it.
+///
+/// Stepping up requires both less load, and holding it for longer than
+/// stepping down, so the level doesn't bounce between two levels. If a step
+/// up is quickly followed by a step down, the time required before trying
+/// to step up again is doubled.
+/// </summary>
+class cvgQualityGovernor
+{
+public:
+	enum class Level
+	{
+		/// <summary>
+		/// No reductions.
+		/// </summary>
+		Full = 0,
+
+		/// <summary>
+		/// Threshold masks are computed at half resolution.
+		/// </summary>
+		HalfResMask,
+
+		/// <summary>
+		/// Threshold masks are only recomputed every other frame.
+		/// </summary>
+		HalfRateMask,
+
+		/// <summary>
+		/// The composite is rendered at half resolution. It's still
+		/// output at its full resolution.
+		/// </summary>
+		HalfResComposite,
+
+		/// <summary>
+		/// The composite is only updated at half the frame rate.
+		/// </summary>
+		HalfRateComposite,
+
+		/// <summary>
+		/// The number of levels.
+		/// </summary>
+		Count
+	};
+
+	struct Status
+	{
+		Level level = Level::Full;
+
+		/// <summary>
+		/// The average time of the slowest stage, as a fraction of the
+		/// frame budget.
+		/// </summary>
+		double load = 0.0;
+
+		/// <summary>
+		/// The name of the slowest stage.
+		/// </summary>
+		std::string slowestStage;
+
+		int stepDownCt = 0;
+		int stepUpCt = 0;
+	};
+
+private:
+	static cvgQualityGovernor _inst;
+
+	/// <summary>
+	/// Guards everything but level and enabled.
+	/// </summary>
+	std::mutex govMutex;
+
+	std::atomic_bool enabled = true;
+
+	/// <summary>
+	/// The current level, stored as an int.
+	/// </summary>
+	std::atomic_int level = 0;
+
+	/// <summary>
+	/// The time each stage is allowed to take per frame.
+	/// </summary>
+	double budgetMS = 1000.0 / 30.0;
+
+	/// <summary>
+	/// The moving average of each stage's time, keyed by stage name.
+	/// </summary>
+	std::map<std::string, double> stageAvgMS;
+
+	/// <summary>
+	/// The time since the load was last evaluated.
+	/// </summary>
+	cvgStopwatch swEvaluate;
+
+	/// <summary>
+	/// The time since the level last changed.
+	/// </summary>
+	cvgStopwatch swLastChange;
+
+	/// <summary>
+	/// The number of evaluations in a row that were over, or under, the
+	/// thresholds to change the level.
+	/// </summary>
+	int overEvalCt = 0;
+	int underEvalCt = 0;
+
+	/// <summary>
+	/// The number of evaluations in a row that need to be under the step
+	/// up threshold before stepping up. Doubled when a step up bounces.
+	/// </summary>
+	int stepUpEvals;
+
+	/// <summary>
+	/// If true, the last change of level was a step up.
+	/// </summary>
+	bool lastChangeWasUp = false;
+
+	Status status;
+
+private:
+	cvgQualityGovernor();
+
+	void _Evaluate();
+
+	void _SetLevel(int newLevel);
+
+public:
+	static cvgQualityGovernor& GetInstance();
+
+	/// <summary>
+	/// Enable or disable the governor. Disabling it returns the
+	/// quality to Level::Full.
+	/// </summary>
+	void SetEnabled(bool enable);
+
+	inline bool IsEnabled() const
+	{ return this->enabled; }
+
+	/// <summary>
+	/// Set the time each stage is allowed to take per frame.
+	/// </summary>
+	void SetBudgetMS(double ms);
+
+	/// <summary>
+	/// Report how long a stage took to handle a frame. Can be called
+	/// from any thread.
+	/// </summary>
+	/// <param name="stage">The name of the stage, such as "camera_0".</param>
+	/// <param name="ms">The time the stage took, in milliseconds.</param>
+	void ReportStage(const std::string& stage, double ms);
+
+	inline Level GetLevel() const
+	{ return (Level)this->level.load(); }
+
+	/// <summary>
+	/// Check if the reductions of a level are being applied.
+	/// </summary>
+	inline bool IsAtLeast(Level lvl) const
+	{ return this->level >= (int)lvl; }
+
+	Status GetStatus();
+
+	/// <summary>
+	/// Forget the stage timings and return to Level::Full.
+	/// </summary>
+	void Reset();
+};
+
+std::string to_string(cvgQualityGovernor::Level lvl);
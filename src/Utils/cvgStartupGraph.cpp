@@ -0,0 +1,378 @@
+#include "cvgStartupGraph.h"
+#include "nlohmann/json.hpp"
+#include <thread>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+using json = nlohmann::json;
+
+std::string to_string(cvgStartupGraph::TaskState state)
+{
+	switch(state)
+	{
+	case cvgStartupGraph::TaskState::Waiting:
+		return "waiting";
+
+	case cvgStartupGraph::TaskState::Running:
+		return "running";
+
+	case cvgStartupGraph::TaskState::Succeeded:
+		return "succeeded";
+
+	case cvgStartupGraph::TaskState::Failed:
+		return "failed";
+
+	case cvgStartupGraph::TaskState::Skipped:
+		return "skipped";
+	}
+	return "unknown";
+}
+
+cvgStartupGraph::cvgStartupGraph()
+{
+	this->epoch = std::chrono::steady_clock::now();
+}
+
+double cvgStartupGraph::MSSinceEpoch() const
+{
+	std::chrono::duration<double, std::milli> ell = std::chrono::steady_clock::now() - this->epoch;
+	return ell.count();
+}
+
+bool cvgStartupGraph::AddTask(
+	const std::string& name,
+	const std::vector<std::string>& deps,
+	TaskFn fn,
+	Affinity affinity)
+{
+	std::lock_guard<std::mutex> guard(this->graphMutex);
+
+	if(this->taskLookup.find(name) != this->taskLookup.end())
+	{
+		std::cerr << "Startup task " << name << " was added multiple times." << std::endl;
+		return false;
+	}
+
+	Task t;
+	t.name		= name;
+	t.deps		= deps;
+	t.fn		= fn;
+	t.affinity	= affinity;
+
+	this->taskLookup[name] = (int)this->tasks.size();
+	this->tasks.push_back(t);
+	return true;
+}
+
+cvgStartupGraph::TaskState cvgStartupGraph::_CheckDependencies(const Task& t) const
+{
+	bool allDone = true;
+	for(const std::string& dep : t.deps)
+	{
+		auto itFind = this->taskLookup.find(dep);
+		if(itFind == this->taskLookup.end())
+		{
+			std::cerr << "Startup task " << t.name << " depends on unknown task " << dep << "." << std::endl;
+			return TaskState::Failed;
+		}
+
+		TaskState depState = this->tasks[itFind->second].state;
+		if(depState == TaskState::Failed || depState == TaskState::Skipped)
+			return TaskState::Failed;
+
+		if(depState != TaskState::Succeeded)
+			allDone = false;
+	}
+
+	return allDone ? TaskState::Succeeded : TaskState::Waiting;
+}
+
+void cvgStartupGraph::_RunWorkerTask(int idx)
+{
+	// The tasks vector isn't modified while Run() is active, so the
+	// function can be safely called outside the lock.
+	TaskFn fn;
+	{
+		std::lock_guard<std::mutex> guard(this->graphMutex);
+		fn = this->tasks[idx].fn;
+	}
+
+	bool success = fn();
+
+	{
+		std::lock_guard<std::mutex> guard(this->graphMutex);
+		this->_FinishTask(this->tasks[idx], success ? TaskState::Succeeded : TaskState::Failed);
+
+		// Start dependents from here, instead of waiting for the Run()
+		// thread, which may be busy with a main thread task.
+		this->_DispatchWorkers();
+	}
+	this->taskDone.notify_all();
+}
+
+void cvgStartupGraph::_FinishTask(Task& t, TaskState state)
+{
+	t.state = state;
+	t.endMS = this->MSSinceEpoch();
+
+	TimelineEntry te;
+	te.name		= t.name;
+	te.thread	= (t.affinity == Affinity::MainThread) ? "main" : "worker";
+	te.startMS	= t.startMS;
+	te.endMS	= t.endMS;
+	te.state	= t.state;
+	this->timeline.push_back(te);
+
+	if(state == TaskState::Failed)
+		std::cerr << "Startup task " << t.name << " failed." << std::endl;
+}
+
+void cvgStartupGraph::_DispatchWorkers()
+{
+	// Skipping a task can make its dependents skippable, so keep
+	// scanning until nothing changes.
+	bool changed = true;
+	while(changed)
+	{
+		changed = false;
+		for(int i = 0; i < (int)this->tasks.size(); ++i)
+		{
+			Task& t = this->tasks[i];
+			if(t.state != TaskState::Waiting)
+				continue;
+
+			TaskState depState = this->_CheckDependencies(t);
+			if(depState == TaskState::Waiting)
+				continue;
+
+			if(depState == TaskState::Failed)
+			{
+				t.startMS = this->MSSinceEpoch();
+				this->_FinishTask(t, TaskState::Skipped);
+				changed = true;
+				continue;
+			}
+
+			if(t.affinity != Affinity::Worker)
+				continue;
+
+			t.startMS = this->MSSinceEpoch();
+			t.state = TaskState::Running;
+			this->workerThreads.emplace_back(&cvgStartupGraph::_RunWorkerTask, this, i);
+		}
+	}
+}
+
+bool cvgStartupGraph::Run()
+{
+	std::unique_lock<std::mutex> lock(this->graphMutex);
+	while(true)
+	{
+		this->_DispatchWorkers();
+
+		int mainIdx = -1;
+		int runningCt = 0;
+		for(int i = 0; i < (int)this->tasks.size(); ++i)
+		{
+			const Task& t = this->tasks[i];
+			if(t.state == TaskState::Running)
+				++runningCt;
+
+			if(t.state != TaskState::Waiting)
+				continue;
+
+			// After dispatching, anything waiting that's ready
+			// to run is a main thread task.
+			if(mainIdx == -1 && this->_CheckDependencies(t) == TaskState::Succeeded)
+				mainIdx = i;
+		}
+
+		if(mainIdx != -1)
+		{
+			// Main thread tasks are run right here, while the worker
+			// tasks continue in the background.
+			Task& t = this->tasks[mainIdx];
+			t.startMS = this->MSSinceEpoch();
+			t.state = TaskState::Running;
+
+			TaskFn fn = t.fn;
+			lock.unlock();
+			bool success = fn();
+			lock.lock();
+			this->_FinishTask(this->tasks[mainIdx], success ? TaskState::Succeeded : TaskState::Failed);
+			continue;
+		}
+
+		if(runningCt == 0)
+		{
+			// If nothing is running and nothing can be started, anything
+			// still waiting is part of a dependency cycle.
+			for(Task& t : this->tasks)
+			{
+				if(t.state != TaskState::Waiting)
+					continue;
+
+				std::cerr << "Startup task " << t.name << " is part of a dependency cycle." << std::endl;
+				t.startMS = this->MSSinceEpoch();
+				this->_FinishTask(t, TaskState::Skipped);
+			}
+			break;
+		}
+
+		this->taskDone.wait(lock);
+	}
+
+	bool allSucceeded = true;
+	for(const Task& t : this->tasks)
+	{
+		if(t.state != TaskState::Succeeded)
+			allSucceeded = false;
+	}
+
+	this->tasks.clear();
+	this->taskLookup.clear();
+
+	std::vector<std::thread> workers;
+	workers.swap(this->workerThreads);
+	lock.unlock();
+
+	// Every worker has already reported back, so these should all be
+	// finished or just about to exit.
+	for(std::thread& w : workers)
+		w.join();
+
+	this->_SaveIfRequested();
+	return allSucceeded;
+}
+
+void cvgStartupGraph::RecordEvent(const std::string& name, double startMS, double endMS, bool success)
+{
+	{
+		std::lock_guard<std::mutex> guard(this->graphMutex);
+
+		TimelineEntry te;
+		te.name		= name;
+		te.thread	= "event";
+		te.startMS	= startMS;
+		te.endMS	= endMS;
+		te.state	= success ? TaskState::Succeeded : TaskState::Failed;
+		this->timeline.push_back(te);
+	}
+	this->_SaveIfRequested();
+}
+
+void cvgStartupGraph::SetTimelineJSONPath(const std::string& path)
+{
+	std::lock_guard<std::mutex> guard(this->graphMutex);
+	this->timelineJSONPath = path;
+}
+
+void cvgStartupGraph::_SaveIfRequested() const
+{
+	std::string path;
+	{
+		std::lock_guard<std::mutex> guard(this->graphMutex);
+		path = this->timelineJSONPath;
+	}
+
+	if(!path.empty())
+		this->SaveTimelineJSON(path);
+}
+
+std::vector<cvgStartupGraph::TimelineEntry> cvgStartupGraph::GetTimeline() const
+{
+	std::vector<TimelineEntry> ret;
+	{
+		std::lock_guard<std::mutex> guard(this->graphMutex);
+		ret = this->timeline;
+	}
+
+	std::stable_sort(
+		ret.begin(),
+		ret.end(),
+		[](const TimelineEntry& a, const TimelineEntry& b){ return a.startMS < b.startMS; });
+
+	return ret;
+}
+
+void cvgStartupGraph::PrintTimeline(std::ostream& os) const
+{
+	std::vector<TimelineEntry> entries = this->GetTimeline();
+	if(entries.empty())
+		return;
+
+	double spanMS = 0.0;
+	size_t nameWidth = 0;
+	for(const TimelineEntry& te : entries)
+	{
+		spanMS = std::max(spanMS, te.endMS);
+		nameWidth = std::max(nameWidth, te.name.size());
+	}
+
+	// Draw each entry as a bar, scaled to the entire timeline,
+	// to make overlapping tasks easy to see.
+	const int barWidth = 40;
+	auto toCol =
+		[spanMS, barWidth](double ms)
+		{
+			if(spanMS <= 0.0)
+				return 0;
+			return std::min(barWidth, (int)(ms / spanMS * barWidth));
+		};
+
+	os << "Startup timeline (ms):" << std::endl;
+	for(const TimelineEntry& te : entries)
+	{
+		int barStart	= toCol(te.startMS);
+		int barEnd		= std::max(barStart + 1, toCol(te.endMS));
+		std::string bar =
+			std::string(barStart, ' ') +
+			std::string(std::min(barEnd, barWidth) - barStart, '#') +
+			std::string(std::max(0, barWidth - barEnd), ' ');
+
+		os << "\t" << std::left << std::setw(nameWidth) << te.name << std::right <<
+			" " << std::setw(6) << te.thread <<
+			std::fixed << std::setprecision(1) <<
+			" " << std::setw(8) << te.startMS <<
+			" " << std::setw(8) << te.endMS <<
+			" " << std::setw(8) << te.DurationMS() <<
+			" |" << bar << "| " << to_string(te.state) << std::endl;
+	}
+}
+
+bool cvgStartupGraph::SaveTimelineJSON(const std::string& path) const
+{
+	std::vector<TimelineEntry> entries = this->GetTimeline();
+
+	json jsTasks = json::array();
+	double spanMS = 0.0;
+	for(const TimelineEntry& te : entries)
+	{
+		json jsEntry = json::object();
+		jsEntry["name"]			= te.name;
+		jsEntry["thread"]		= te.thread;
+		jsEntry["start_ms"]		= te.startMS;
+		jsEntry["end_ms"]		= te.endMS;
+		jsEntry["duration_ms"]	= te.DurationMS();
+		jsEntry["state"]		= to_string(te.state);
+		jsTasks.push_back(jsEntry);
+
+		spanMS = std::max(spanMS, te.endMS);
+	}
+
+	json ret = json::object();
+	ret["total_ms"] = spanMS;
+	ret["tasks"] = jsTasks;
+
+	std::ofstream ofs(path);
+	if(!ofs.is_open())
+	{
+		std::cerr << "Could not save startup timeline to " << path << std::endl;
+		return false;
+	}
+
+	ofs << std::setw(4) << ret << std::endl;
+	return true;
+}
@@ -0,0 +1,221 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <ostream>
+
+/// <summary>
+/// A dependency-aware set of startup tasks that are run concurrently
+/// where possible, with a timeline of when each task ran.
+///
+/// Tasks are either run on worker threads, or on the thread that called
+/// Run() - which is needed for anything that touches OpenGL. A task is
+/// started as soon as all the tasks it depends on have succeeded. If a
+/// dependency fails, the task is skipped.
+///
+/// All times are in milliseconds since the graph was constructed.
+/// </summary>
+class cvgStartupGraph
+{
+public:
+	/// <summary>
+	/// Where a task is allowed to run.
+	/// </summary>
+	enum class Affinity
+	{
+		/// <summary>
+		/// Run on its own worker thread.
+		/// </summary>
+		Worker,
+
+		/// <summary>
+		/// Run on the thread that called Run(). Use this for
+		/// OpenGL work.
+		/// </summary>
+		MainThread
+	};
+
+	enum class TaskState
+	{
+		Waiting,
+		Running,
+		Succeeded,
+		Failed,
+
+		/// <summary>
+		/// Not run, because a dependency failed or doesn't exist.
+		/// </summary>
+		Skipped
+	};
+
+	/// <summary>
+	/// A task function. Return false on failure.
+	/// </summary>
+	typedef std::function<bool()> TaskFn;
+
+	/// <summary>
+	/// A recorded span of time in the startup timeline.
+	/// </summary>
+	struct TimelineEntry
+	{
+		std::string name;
+
+		/// <summary>
+		/// "main", "worker", or "event" for spans recorded with RecordEvent().
+		/// </summary>
+		std::string thread;
+
+		double startMS = 0.0;
+		double endMS = 0.0;
+		TaskState state = TaskState::Waiting;
+
+		inline double DurationMS() const
+		{ return this->endMS - this->startMS; }
+	};
+
+private:
+	struct Task
+	{
+		std::string name;
+		std::vector<std::string> deps;
+		TaskFn fn;
+		Affinity affinity = Affinity::Worker;
+		TaskState state = TaskState::Waiting;
+		double startMS = 0.0;
+		double endMS = 0.0;
+	};
+
+	std::chrono::steady_clock::time_point epoch;
+
+	/// <summary>
+	/// The tasks, in the order they were added.
+	/// </summary>
+	std::vector<Task> tasks;
+
+	/// <summary>
+	/// Task name to index in tasks.
+	/// </summary>
+	std::map<std::string, int> taskLookup;
+
+	/// <summary>
+	/// Finished tasks and recorded events.
+	/// </summary>
+	std::vector<TimelineEntry> timeline;
+
+	/// <summary>
+	/// Guards the task states, and the timeline.
+	/// </summary>
+	mutable std::mutex graphMutex;
+
+	/// <summary>
+	/// Signaled when a worker task finishes.
+	/// </summary>
+	std::condition_variable taskDone;
+
+	/// <summary>
+	/// The threads started for worker tasks during Run().
+	/// </summary>
+	std::vector<std::thread> workerThreads;
+
+	/// <summary>
+	/// If not empty, where to save the timeline JSON.
+	/// </summary>
+	std::string timelineJSONPath;
+
+private:
+	/// <summary>
+	/// Check the dependencies of a task. Assumes graphMutex is locked.
+	/// </summary>
+	/// <returns>
+	/// Succeeded if the task is ready to run, Failed if it can never run,
+	/// or Waiting if it's still waiting on other tasks.
+	/// </returns>
+	TaskState _CheckDependencies(const Task& t) const;
+
+	void _RunWorkerTask(int idx);
+
+	/// <summary>
+	/// Start every worker task whose dependencies have succeeded, and skip
+	/// any task whose dependencies have failed. Assumes graphMutex is locked.
+	/// </summary>
+	void _DispatchWorkers();
+
+	/// <summary>
+	/// Record a task as finished. Assumes graphMutex is locked.
+	/// </summary>
+	void _FinishTask(Task& t, TaskState state);
+
+	void _SaveIfRequested() const;
+
+public:
+	cvgStartupGraph();
+
+	/// <summary>
+	/// The milliseconds since the graph was constructed.
+	/// </summary>
+	double MSSinceEpoch() const;
+
+	/// <summary>
+	/// Add a task to be run by Run().
+	/// </summary>
+	/// <param name="name">The unique name of the task.</param>
+	/// <param name="deps">The names of tasks that need to succeed first.</param>
+	/// <param name="fn">The task.</param>
+	/// <param name="affinity">The thread to run the task on.</param>
+	/// <returns>False if a task with the name already exists.</returns>
+	bool AddTask(
+		const std::string& name,
+		const std::vector<std::string>& deps,
+		TaskFn fn,
+		Affinity affinity = Affinity::Worker);
+
+	/// <summary>
+	/// Run all added tasks, and wait for them to finish. The tasks are
+	/// cleared afterwards, but stay in the timeline.
+	/// </summary>
+	/// <returns>True if every task succeeded.</returns>
+	bool Run();
+
+	/// <summary>
+	/// Add a span of time to the timeline that wasn't run as a task. For
+	/// startup work that can't be run from the graph, or that finishes
+	/// asynchronously.
+	///
+	/// This is threadsafe.
+	/// </summary>
+	/// <param name="name">The name of the event.</param>
+	/// <param name="startMS">When the event started, from MSSinceEpoch().</param>
+	/// <param name="endMS">When the event ended, from MSSinceEpoch().</param>
+	/// <param name="success">If the event was successful.</param>
+	void RecordEvent(const std::string& name, double startMS, double endMS, bool success = true);
+
+	/// <summary>
+	/// Set a filepath to save the timeline JSON to, whenever it's updated
+	/// by Run() or RecordEvent(). An empty string disables saving.
+	/// </summary>
+	void SetTimelineJSONPath(const std::string& path);
+
+	/// <summary>
+	/// Get a copy of the timeline, sorted by start time.
+	/// </summary>
+	std::vector<TimelineEntry> GetTimeline() const;
+
+	/// <summary>
+	/// Print a human readable timeline.
+	/// </summary>
+	void PrintTimeline(std::ostream& os) const;
+
+	/// <summary>
+	/// Save the timeline as a JSON file.
+	/// </summary>
+	/// <param name="path">The filepath to save to.</param>
+	/// <returns>True if the file was written.</returns>
+	bool SaveTimelineJSON(const std::string& path) const;
+};
+
+std::string to_string(cvgStartupGraph::TaskState state);
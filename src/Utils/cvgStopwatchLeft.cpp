@@ -39,4 +39,25 @@ int cvgStopwatchLeft::MSLeft(int msToPass)
 int cvgStopwatchLeft::MSLeft33()
 {
 	return this->MSLeft(33);
+}
+
+int cvgStopwatchLeft::MSLeftForFPS(double fps)
+{
+	if(fps <= 0.0)
+		fps = 30.0;
+
+	std::chrono::microseconds period((long long)(1000000.0 / fps));
+	std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+	std::chrono::high_resolution_clock::time_point scheduled = this->lastTime + period;
+
+	if(now >= scheduled)
+	{
+		this->lastTime = now;
+		return 0;
+	}
+
+	// Rounded down, any fraction of a millisecond not slept is made up for
+	// by the next frame still being scheduled from this one.
+	this->lastTime = scheduled;
+	return (int)std::chrono::duration_cast<std::chrono::milliseconds>(scheduled - now).count();
 }
\ No newline at end of file
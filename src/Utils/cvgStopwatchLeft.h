@@ -61,4 +61,19 @@ public:
 	/// The equivalent of what MSLeft(33) would return.
 	/// </returns>
 	int MSLeft33();
+
+	/// <summary>
+	/// Check how many milliseconds to sleep to loop at a frame rate.
+	/// 
+	/// Unlike MSLeft(), each frame is scheduled one frame period after the 
+	/// previous frame's scheduled time, instead of after the previous call. 
+	/// This keeps frame rates that aren't a whole number of milliseconds 
+	/// (e.g., 60FPS at 16.67ms) accurate on average. If the loop falls behind,
+	/// it's rescheduled from now instead of trying to catch up.
+	/// </summary>
+	/// <param name="fps">
+	/// The frame rate to loop at. If 0 or less, 30FPS is used.
+	/// </param>
+	/// <returns>The number of milliseconds to sleep.</returns>
+	int MSLeftForFPS(double fps);
 };
\ No newline at end of file
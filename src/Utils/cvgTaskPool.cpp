@@ -0,0 +1,505 @@
+#include "cvgTaskPool.h"
+#include "cvgThreadPlacement.h"
+#include <opencv2/core.hpp>
+#include <opencv2/core/version.hpp>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+// The parallel_for_ backend API was added in OpenCV 4.5.2.
+#if (CV_VERSION_MAJOR > 4) || (CV_VERSION_MAJOR == 4 && (CV_VERSION_MINOR > 5 || (CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 2)))
+	#define CVG_TASKPOOL_CVBACKEND 1
+	#include <opencv2/core/parallel/parallel_backend.hpp>
+#else
+	#define CVG_TASKPOOL_CVBACKEND 0
+#endif
+
+cvgTaskPool cvgTaskPool::_inst;
+
+/// <summary>
+/// The worker index of the current thread, or -1 if not a worker.
+/// </summary>
+static thread_local int tlsWorkerIdx = -1;
+
+#if CVG_TASKPOOL_CVBACKEND
+/// <summary>
+/// Routes OpenCV's parallel_for_ into the cvgTaskPool.
+/// </summary>
+class TaskPoolCVBackend : public cv::parallel::ParallelForAPI
+{
+public:
+	void parallel_for(int tasks, FN_parallel_for_body_cb_t body_callback, void* callback_data) override
+	{
+		cvgTaskPool& pool = cvgTaskPool::GetInstance();
+		pool._CountCVParallelFor();
+		pool.ParallelFor(
+			0,
+			tasks,
+			[body_callback, callback_data](int start, int end)
+			{
+				body_callback(start, end, callback_data);
+			});
+	}
+
+	int getThreadNum() const override
+	{
+		// OpenCV expects [0, getNumThreads()). Threads outside the pool
+		// that call into OpenCV are given 0, and the workers follow.
+		return cvgTaskPool::CurrentWorker() + 1;
+	}
+
+	int getNumThreads() const override
+	{
+		return cvgTaskPool::GetInstance().WorkerCount() + 1;
+	}
+
+	int setNumThreads(int nThreads) override
+	{
+		// The pool size is set by the AppOptions when the pool starts.
+		return this->getNumThreads();
+	}
+
+	const char* getName() const override
+	{
+		return "cvgTaskPool";
+	}
+};
+#endif
+
+cvgTaskPool::cvgTaskPool()
+{}
+
+cvgTaskPool& cvgTaskPool::GetInstance()
+{
+	return _inst;
+}
+
+int cvgTaskPool::CurrentWorker()
+{
+	return tlsWorkerIdx;
+}
+
+int cvgTaskPool::WorkerCount() const
+{
+	if(!this->running)
+		return 0;
+
+	return (int)this->workers.size();
+}
+
+bool cvgTaskPool::Start(int workerCt, bool routeOpenCV)
+{
+	if(this->running)
+		return false;
+
+	if(workerCt <= 0)
+		workerCt = std::max(1, (int)std::thread::hardware_concurrency());
+
+	std::cout << "Starting task pool with " << workerCt << " workers." << std::endl;
+
+	this->stopping = false;
+	for(int i = 0; i < workerCt; ++i)
+		this->queues.push_back(std::make_unique<WorkerQueue>());
+
+	this->running = true;
+	for(int i = 0; i < workerCt; ++i)
+		this->workers.emplace_back(&cvgTaskPool::_WorkerFn, this, i);
+
+	if(routeOpenCV)
+	{
+#if CVG_TASKPOOL_CVBACKEND
+		cv::parallel::setParallelForBackend(std::make_shared<TaskPoolCVBackend>(), false);
+		this->routingOpenCV = true;
+#else
+		std::cout << "OpenCV " << CV_VERSION << " doesn't support custom parallel_for_ backends, OpenCV will use its own threads." << std::endl;
+#endif
+	}
+	return true;
+}
+
+void cvgTaskPool::Shutdown()
+{
+	if(!this->running)
+		return;
+
+#if CVG_TASKPOOL_CVBACKEND
+	// Hand OpenCV back its own backend before the workers go away.
+	if(this->routingOpenCV)
+	{
+		cv::parallel::setParallelForBackend(std::shared_ptr<cv::parallel::ParallelForAPI>(), false);
+		this->routingOpenCV = false;
+	}
+#endif
+
+	{
+		std::lock_guard<std::mutex> guard(this->sleepMutex);
+		this->stopping = true;
+	}
+	this->sleepCV.notify_all();
+
+	for(std::thread& t : this->workers)
+		t.join();
+
+	this->workers.clear();
+	this->queues.clear();
+	this->running = false;
+}
+
+void cvgTaskPool::_WorkerFn(int workerIdx)
+{
+	tlsWorkerIdx = workerIdx;
+	cvgThreadPlacement::GetInstance().ApplyToCurrentThread("taskpool");
+
+	while(true)
+	{
+		if(this->_TryRunOne(workerIdx))
+			continue;
+
+		std::unique_lock<std::mutex> lock(this->sleepMutex);
+		if(this->stopping && this->queueDepth == 0)
+			break;
+
+		// The timeout is a safety net, the CV is notified on submits.
+		if(this->queueDepth == 0)
+			this->sleepCV.wait_for(lock, std::chrono::milliseconds(10));
+	}
+
+	cvgThreadPlacement::GetInstance().UnregisterCurrentThread();
+	tlsWorkerIdx = -1;
+}
+
+bool cvgTaskPool::_TakeFrom(int queueIdx, bool asOwner, Task& outTask)
+{
+	WorkerQueue& wq = *this->queues[queueIdx];
+	std::lock_guard<std::mutex> guard(wq.queueMutex);
+	if(wq.tasks.empty())
+		return false;
+
+	if(asOwner)
+	{
+		outTask = std::move(wq.tasks.back());
+		wq.tasks.pop_back();
+	}
+	else
+	{
+		outTask = std::move(wq.tasks.front());
+		wq.tasks.pop_front();
+	}
+	--this->queueDepth;
+	return true;
+}
+
+bool cvgTaskPool::_TryRunOneOf(Group& group)
+{
+	if(this->queueDepth == 0)
+		return false;
+
+	Task task;
+	bool found = false;
+	for(size_t i = 0; i < this->queues.size() && !found; ++i)
+	{
+		WorkerQueue& wq = *this->queues[i];
+		std::lock_guard<std::mutex> guard(wq.queueMutex);
+		for(auto it = wq.tasks.begin(); it != wq.tasks.end(); ++it)
+		{
+			if(it->group != &group)
+				continue;
+
+			task = std::move(*it);
+			wq.tasks.erase(it);
+			--this->queueDepth;
+			found = true;
+			break;
+		}
+	}
+
+	if(!found)
+		return false;
+
+	this->_RunTask(task, true);
+	return true;
+}
+
+bool cvgTaskPool::_TryRunOne(int workerIdx)
+{
+	if(this->queueDepth == 0)
+		return false;
+
+	Task task;
+	if(workerIdx >= 0 && this->_TakeFrom(workerIdx, true, task))
+	{
+		this->_RunTask(task, false);
+		return true;
+	}
+
+	// Start at a different queue for each worker, so thieves
+	// don't all pile onto the same victim.
+	int queueCt = (int)this->queues.size();
+	int start = (workerIdx >= 0) ? workerIdx + 1 : 0;
+	for(int i = 0; i < queueCt; ++i)
+	{
+		int victim = (start + i) % queueCt;
+		if(victim == workerIdx)
+			continue;
+
+		if(this->_TakeFrom(victim, false, task))
+		{
+			this->_RunTask(task, true);
+			return true;
+		}
+	}
+	return false;
+}
+
+void cvgTaskPool::_RunTask(Task& task, bool stolen)
+{
+	if(stolen)
+		++this->stealCt;
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	task.fn();
+	std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+
+	long long queueUS = std::chrono::duration_cast<std::chrono::microseconds>(startTime - task.submitTime).count();
+	long long runUS = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+	{
+		std::lock_guard<std::mutex> guard(this->timingMutex);
+		++this->executedCt;
+		this->totalQueueUS	+= queueUS;
+		this->totalRunUS	+= runUS;
+		this->maxQueueUS	= std::max(this->maxQueueUS, queueUS);
+		this->maxRunUS		= std::max(this->maxRunUS, runUS);
+	}
+
+	if(task.group != nullptr)
+		this->_GroupDone(*task.group);
+}
+
+void cvgTaskPool::_GroupDone(Group& group)
+{
+	// The group may be destroyed as soon as its count reaches 0,
+	// so it can't be touched afterwards.
+	if(--group.pending == 0)
+	{
+		// Lock to make sure a waiter isn't between checking the
+		// count and going to sleep.
+		std::lock_guard<std::mutex> guard(this->sleepMutex);
+	}
+	this->sleepCV.notify_all();
+	this->groupDoneCV.notify_all();
+}
+
+void cvgTaskPool::Submit(std::function<void()> fn, Group* group)
+{
+	if(group != nullptr)
+		++group->pending;
+
+	Task task;
+	task.fn			= std::move(fn);
+	task.group		= group;
+	task.submitTime	= std::chrono::steady_clock::now();
+
+	if(!this->running || this->stopping)
+	{
+		// Without a pool, it's the same as calling it directly.
+		task.fn();
+		if(group != nullptr)
+			this->_GroupDone(*group);
+		return;
+	}
+
+	int queueIdx = tlsWorkerIdx;
+	if(queueIdx < 0)
+		queueIdx = (int)(this->nextQueue++ % this->queues.size());
+
+	{
+		WorkerQueue& wq = *this->queues[queueIdx];
+		std::lock_guard<std::mutex> guard(wq.queueMutex);
+		wq.tasks.push_back(std::move(task));
+
+		int depth = ++this->queueDepth;
+		int prevMax = this->maxQueueDepth;
+		while(depth > prevMax && !this->maxQueueDepth.compare_exchange_weak(prevMax, depth))
+		{}
+	}
+	++this->submittedCt;
+
+	// Lock to make sure a worker isn't between checking the queue
+	// depth and going to sleep.
+	{
+		std::lock_guard<std::mutex> guard(this->sleepMutex);
+	}
+	this->sleepCV.notify_one();
+}
+
+void cvgTaskPool::Wait(Group& group)
+{
+	int workerIdx = tlsWorkerIdx;
+	if(workerIdx < 0)
+	{
+		// Not a worker, so this is a camera, UI or other thread that
+		// shouldn't pick up unrelated tasks. It could be held up by them,
+		// or deadlock if it holds a lock one of them needs.
+		while(group.pending > 0)
+		{
+			if(this->_TryRunOneOf(group))
+				continue;
+
+			std::unique_lock<std::mutex> lock(this->sleepMutex);
+			if(group.pending > 0)
+				this->groupDoneCV.wait_for(lock, std::chrono::milliseconds(10));
+		}
+		return;
+	}
+
+	while(group.pending > 0)
+	{
+		if(this->_TryRunOne(workerIdx))
+			continue;
+
+		// Nothing to help with, the rest of the group's tasks are
+		// already running on other threads.
+		std::unique_lock<std::mutex> lock(this->sleepMutex);
+		if(group.pending > 0 && this->queueDepth == 0)
+			this->sleepCV.wait_for(lock, std::chrono::milliseconds(1));
+	}
+}
+
+void cvgTaskPool::ParallelFor(int begin, int end, const std::function<void(int, int)>& fn, int chunkCt)
+{
+	int range = end - begin;
+	if(range <= 0)
+		return;
+
+	if(chunkCt <= 0)
+		chunkCt = this->WorkerCount() + 1;
+
+	chunkCt = std::min(chunkCt, range);
+	if(chunkCt <= 1 || !this->running)
+	{
+		fn(begin, end);
+		return;
+	}
+
+	Group group;
+	for(int i = 1; i < chunkCt; ++i)
+	{
+		int chunkBeg = begin + (int)((long long)range * i / chunkCt);
+		int chunkEnd = begin + (int)((long long)range * (i + 1) / chunkCt);
+		this->Submit([&fn, chunkBeg, chunkEnd]{ fn(chunkBeg, chunkEnd); }, &group);
+	}
+
+	// The calling thread does the first chunk itself.
+	fn(begin, begin + (int)((long long)range / chunkCt));
+	this->Wait(group);
+}
+
+cvgTaskPool::Metrics cvgTaskPool::GetMetrics()
+{
+	Metrics ret;
+	ret.workerCt		= this->WorkerCount();
+	ret.queueDepth		= this->queueDepth;
+	ret.maxQueueDepth	= this->maxQueueDepth;
+	ret.submittedCt		= this->submittedCt;
+	ret.stealCt			= this->stealCt;
+	ret.cvParallelForCt	= this->cvParallelForCt;
+
+	std::lock_guard<std::mutex> guard(this->timingMutex);
+	ret.executedCt	= this->executedCt;
+	ret.maxQueueUS	= this->maxQueueUS;
+	ret.maxRunUS	= this->maxRunUS;
+	if(this->executedCt > 0)
+	{
+		ret.avgQueueUS	= (double)this->totalQueueUS / (double)this->executedCt;
+		ret.avgRunUS	= (double)this->totalRunUS / (double)this->executedCt;
+	}
+	return ret;
+}
+
+void cvgTaskPool::ResetMetrics()
+{
+	this->maxQueueDepth		= (int)this->queueDepth;
+	this->submittedCt		= 0;
+	this->stealCt			= 0;
+	this->cvParallelForCt	= 0;
+
+	std::lock_guard<std::mutex> guard(this->timingMutex);
+	this->executedCt	= 0;
+	this->totalQueueUS	= 0;
+	this->maxQueueUS	= 0;
+	this->totalRunUS	= 0;
+	this->maxRunUS		= 0;
+}
+
+void cvgTaskPool::DumpMetrics(std::ostream& os)
+{
+	Metrics m = this->GetMetrics();
+	os << std::fixed << std::setprecision(1) <<
+		"Task pool - Workers: " << m.workerCt <<
+		" - Queue: " << m.queueDepth << " (max " << m.maxQueueDepth << ")" <<
+		" - Submitted: " << m.submittedCt <<
+		" - Executed: " << m.executedCt <<
+		" - Steals: " << m.stealCt <<
+		" - OpenCV parallel_for: " << m.cvParallelForCt << std::endl <<
+		"\tQueue US - Avg: " << m.avgQueueUS << " - Max: " << m.maxQueueUS <<
+		" - Run US - Avg: " << m.avgRunUS << " - Max: " << m.maxRunUS << std::endl;
+}
+
+cvgTaskPool::Strand::~Strand()
+{
+	this->Drain();
+}
+
+void cvgTaskPool::Strand::Post(std::function<void()> fn)
+{
+	++this->group.pending;
+
+	bool schedule = false;
+	{
+		std::lock_guard<std::mutex> guard(this->strandMutex);
+		this->posted.push_back(std::move(fn));
+		if(!this->scheduled)
+		{
+			this->scheduled = true;
+			schedule = true;
+		}
+	}
+
+	if(schedule)
+		cvgTaskPool::GetInstance().Submit([this]{ this->_RunPosted(); });
+}
+
+void cvgTaskPool::Strand::_RunPosted()
+{
+	while(true)
+	{
+		std::function<void()> fn;
+		{
+			std::lock_guard<std::mutex> guard(this->strandMutex);
+			fn = std::move(this->posted.front());
+			this->posted.pop_front();
+		}
+
+		fn();
+
+		bool more = false;
+		{
+			std::lock_guard<std::mutex> guard(this->strandMutex);
+			more = !this->posted.empty();
+			if(!more)
+				this->scheduled = false;
+		}
+
+		// Once the last posted task is marked done, a Drain() can return
+		// and the Strand can be destroyed, so nothing of it can be touched
+		// after that.
+		cvgTaskPool::GetInstance()._GroupDone(this->group);
+		if(!more)
+			return;
+	}
+}
+
+void cvgTaskPool::Strand::Drain()
+{
+	cvgTaskPool::GetInstance().Wait(this->group);
+}
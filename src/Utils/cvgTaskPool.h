@@ -0,0 +1,310 @@
+#pragma once
+
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <ostream>
+
+/// <summary>
+/// A process-wide work-stealing task pool.
+///
+/// Each worker thread has its own queue. Tasks submitted from a worker go
+/// into that worker's queue, and tasks submitted from anywhere else are
+/// spread between the workers' queues. Workers run their own newest task
+/// first, and when their queue is empty, steal the oldest task from another
+/// worker.
+///
+/// A worker waiting on tasks (see Wait()) helps run queued tasks instead of
+/// blocking, so tasks can safely wait on other tasks. Other threads only help
+/// with the tasks of the group they're waiting on.
+///
+/// OpenCV's parallel_for_ can be routed into the pool (see Start()), so that
+/// OpenCV's internal parallelism shares the same threads instead of
+/// oversubscribing the cores with its own pool.
+///
+/// If the pool isn't running, submitted tasks are run immediately on the
+/// submitting thread.
+/// </summary>
+class cvgTaskPool
+{
+public:
+	/// <summary>
+	/// A set of tasks that can be waited on together.
+	/// </summary>
+	class Group
+	{
+		friend class cvgTaskPool;
+	private:
+		std::atomic_int pending = 0;
+
+	public:
+		/// <summary>
+		/// The number of tasks in the group that haven't finished.
+		/// </summary>
+		inline int Pending() const
+		{ return this->pending; }
+	};
+
+	/// <summary>
+	/// Runs posted tasks on the pool one at a time, in the order they
+	/// were posted. For work that must stay ordered, such as writing
+	/// frames to a video file.
+	///
+	/// The Strand must outlive its posted tasks, which is handled by the
+	/// destructor draining them.
+	/// </summary>
+	class Strand
+	{
+		friend class cvgTaskPool;
+	private:
+		std::mutex strandMutex;
+		std::deque<std::function<void()>> posted;
+
+		/// <summary>
+		/// If true, a pool task is running (or queued to run) the
+		/// posted tasks.
+		/// </summary>
+		bool scheduled = false;
+
+		Group group;
+
+		void _RunPosted();
+
+	public:
+		~Strand();
+
+		/// <summary>
+		/// Queue a task to run after everything posted before it.
+		/// </summary>
+		void Post(std::function<void()> fn);
+
+		/// <summary>
+		/// Wait for all posted tasks to finish. Must not be called from
+		/// one of the strand's own tasks.
+		/// </summary>
+		void Drain();
+
+		inline int Pending() const
+		{ return this->group.Pending(); }
+	};
+
+	/// <summary>
+	/// Statistics of the pool. Times are in microseconds.
+	/// </summary>
+	struct Metrics
+	{
+		int workerCt = 0;
+
+		/// <summary>
+		/// The number of tasks currently queued and not yet started.
+		/// </summary>
+		int queueDepth = 0;
+
+		/// <summary>
+		/// The most tasks queued at once.
+		/// </summary>
+		int maxQueueDepth = 0;
+
+		long long submittedCt = 0;
+		long long executedCt = 0;
+
+		/// <summary>
+		/// The number of tasks taken from another worker's queue, or
+		/// run by a thread waiting on a group.
+		/// </summary>
+		long long stealCt = 0;
+
+		/// <summary>
+		/// The time between a task being submitted and started.
+		/// </summary>
+		double avgQueueUS = 0.0;
+		long long maxQueueUS = 0;
+
+		/// <summary>
+		/// The time it took to run a task.
+		/// </summary>
+		double avgRunUS = 0.0;
+		long long maxRunUS = 0;
+
+		/// <summary>
+		/// The number of OpenCV parallel_for_ calls routed into the pool.
+		/// </summary>
+		long long cvParallelForCt = 0;
+	};
+
+private:
+	struct Task
+	{
+		std::function<void()> fn;
+		Group* group = nullptr;
+		std::chrono::steady_clock::time_point submitTime;
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex queueMutex;
+		std::deque<Task> tasks;
+	};
+
+	static cvgTaskPool _inst;
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> workers;
+
+	std::atomic_bool running = false;
+	std::atomic_bool stopping = false;
+
+	/// <summary>
+	/// Used to put idle workers (and waiting threads) to sleep.
+	/// </summary>
+	std::mutex sleepMutex;
+	std::condition_variable sleepCV;
+
+	/// <summary>
+	/// Notified when a group's task finishes, for threads that aren't
+	/// workers waiting on a group. Uses sleepMutex.
+	/// </summary>
+	std::condition_variable groupDoneCV;
+
+	/// <summary>
+	/// Round-robin counter for distributing tasks submitted from
+	/// outside the pool.
+	/// </summary>
+	std::atomic_uint nextQueue = 0;
+
+	/// <summary>
+	/// If true, OpenCV's parallel_for_ is routed into the pool.
+	/// </summary>
+	bool routingOpenCV = false;
+
+	// Metrics
+	std::atomic_int queueDepth = 0;
+	std::atomic_int maxQueueDepth = 0;
+	std::atomic_llong submittedCt = 0;
+	std::atomic_llong stealCt = 0;
+	std::atomic_llong cvParallelForCt = 0;
+	//
+	std::mutex timingMutex;
+	long long executedCt = 0;
+	long long totalQueueUS = 0;
+	long long maxQueueUS = 0;
+	long long totalRunUS = 0;
+	long long maxRunUS = 0;
+
+private:
+	cvgTaskPool();
+
+	void _WorkerFn(int workerIdx);
+
+	/// <summary>
+	/// Try to take a task and run it.
+	/// </summary>
+	/// <param name="workerIdx">The calling worker's index, or -1 if not a worker.</param>
+	/// <returns>True if a task was run.</returns>
+	bool _TryRunOne(int workerIdx);
+
+	/// <summary>
+	/// Take a task from a queue. The owner takes from the back, everyone
+	/// else takes from the front.
+	/// </summary>
+	bool _TakeFrom(int queueIdx, bool asOwner, Task& outTask);
+
+	/// <summary>
+	/// Try to take a task of a group and run it. Used by threads that
+	/// aren't workers, so they don't pick up unrelated work (a DICOM encode,
+	/// or a strand's queued video frames) while they wait.
+	/// </summary>
+	/// <returns>True if a task was run.</returns>
+	bool _TryRunOneOf(Group& group);
+
+	void _RunTask(Task& task, bool stolen);
+
+	/// <summary>
+	/// Mark a task of a group as finished.
+	/// </summary>
+	void _GroupDone(Group& group);
+
+public:
+	static cvgTaskPool& GetInstance();
+
+	/// <summary>
+	/// Start the worker threads.
+	/// </summary>
+	/// <param name="workerCt">
+	/// The number of worker threads. If 0 or less, one per hardware
+	/// thread is used.
+	/// </param>
+	/// <param name="routeOpenCV">
+	/// If true, OpenCV's parallel_for_ is routed into the pool. This is
+	/// only supported with OpenCV 4.5.2 and later, and ignored otherwise.
+	/// </param>
+	/// <returns>False if the pool was already running.</returns>
+	bool Start(int workerCt, bool routeOpenCV);
+
+	/// <summary>
+	/// Finish all queued tasks, and stop the worker threads.
+	/// </summary>
+	void Shutdown();
+
+	inline bool IsRunning() const
+	{ return this->running; }
+
+	/// <summary>
+	/// The number of worker threads, or 0 if not running.
+	/// </summary>
+	int WorkerCount() const;
+
+	/// <summary>
+	/// The index of the calling thread's worker, or -1 if the calling
+	/// thread isn't one of the pool's workers.
+	/// </summary>
+	static int CurrentWorker();
+
+	/// <summary>
+	/// Queue a task to run on the pool.
+	/// </summary>
+	/// <param name="fn">The task.</param>
+	/// <param name="group">An optional group the task belongs to, for waiting on.</param>
+	void Submit(std::function<void()> fn, Group* group = nullptr);
+
+	/// <summary>
+	/// Wait for all the tasks in a group to finish. If called from a worker,
+	/// it helps run any queued tasks while it waits. Else, it only runs the
+	/// group's own queued tasks, and otherwise blocks.
+	/// </summary>
+	void Wait(Group& group);
+
+	/// <summary>
+	/// Run a function over the range [begin, end) in parallel, split into
+	/// contiguous chunks, and wait for it to finish.
+	/// </summary>
+	/// <param name="begin">The start of the range.</param>
+	/// <param name="end">The end of the range, exclusive.</param>
+	/// <param name="fn">The function, called with the [start, end) of each chunk.</param>
+	/// <param name="chunkCt">
+	/// The number of chunks to split the range into. If 0 or less, it's
+	/// split once per worker (plus the calling thread).
+	/// </param>
+	void ParallelFor(int begin, int end, const std::function<void(int, int)>& fn, int chunkCt = 0);
+
+	Metrics GetMetrics();
+
+	void ResetMetrics();
+
+	/// <summary>
+	/// Print the metrics in a human readable form.
+	/// </summary>
+	void DumpMetrics(std::ostream& os);
+
+	/// <summary>
+	/// Used by the OpenCV backend.
+	/// </summary>
+	inline void _CountCVParallelFor()
+	{ ++this->cvParallelForCt; }
+};
@@ -0,0 +1,293 @@
+#include "cvgTaskPoolBenchmark.h"
+#include "cvgTaskPool.h"
+#include "cvgStopwatchLeft.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iomanip>
+
+namespace
+{
+	typedef std::chrono::steady_clock BenchClock;
+
+	const int camCt			= 2;
+	const int frameWidth	= 1280;
+	const int frameHeight	= 720;
+
+	double MSSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+	}
+
+	/// <summary>
+	/// The timings of a stage of the benchmark, which may be added to
+	/// from multiple threads.
+	/// </summary>
+	struct StageTiming
+	{
+		std::mutex timingMutex;
+		long long ct = 0;
+		double totalMS = 0.0;
+		double maxMS = 0.0;
+
+		/// <summary>
+		/// The time a frame is allowed to take.
+		/// </summary>
+		double msPerFrame = 0.0;
+
+		/// <summary>
+		/// The number of times the stage took longer than a frame.
+		/// </summary>
+		long long missedCt = 0;
+
+		/// <summary>
+		/// When the first and last frames were added, to measure the
+		/// sustained frame rate.
+		/// </summary>
+		BenchClock::time_point firstTime;
+		BenchClock::time_point lastTime;
+
+		void Add(double ms)
+		{
+			std::lock_guard<std::mutex> guard(this->timingMutex);
+			BenchClock::time_point now = BenchClock::now();
+			if(this->ct == 0)
+				this->firstTime = now;
+
+			this->lastTime = now;
+			++this->ct;
+			this->totalMS += ms;
+			this->maxMS = std::max(this->maxMS, ms);
+			if(ms > this->msPerFrame)
+				++this->missedCt;
+		}
+
+		void Print(std::ostream& os, const std::string& name)
+		{
+			std::lock_guard<std::mutex> guard(this->timingMutex);
+			double avgMS = (this->ct > 0) ? (this->totalMS / (double)this->ct) : 0.0;
+
+			double spanSec = std::chrono::duration<double>(this->lastTime - this->firstTime).count();
+			double sustainedFPS = (this->ct > 1 && spanSec > 0.0) ? ((double)(this->ct - 1) / spanSec) : 0.0;
+
+			os << std::fixed << std::setprecision(2) <<
+				"\t" << name <<
+				" - Frames: " << this->ct <<
+				" - FPS: " << sustainedFPS <<
+				" - Avg MS: " << avgMS <<
+				" - Max MS: " << this->maxMS <<
+				" - Missed " << this->msPerFrame << "ms: " << this->missedCt << std::endl;
+		}
+	};
+
+	/// <summary>
+	/// The latest processed frame of each camera, for the composite.
+	/// </summary>
+	struct LatestFrames
+	{
+		std::mutex framesMutex;
+		std::vector<cv::Mat> frames;
+	};
+
+	/// <summary>
+	/// The same kind of work as a thresholding ManagedCam::ProcessImage().
+	/// </summary>
+	cv::Mat ProcessFrame(const cv::Mat& src)
+	{
+		cv::Mat blurred;
+		cv::Mat grey;
+		cv::Mat thresholded;
+		cv::GaussianBlur(src, blurred, cv::Size(5, 5), 0.0);
+		cv::cvtColor(blurred, grey, cv::COLOR_BGR2GRAY);
+		cv::threshold(grey, thresholded, 0.0, 255.0, cv::THRESH_BINARY | cv::THRESH_OTSU);
+		return thresholded;
+	}
+
+	/// <summary>
+	/// Stand-in for writing a frame to a video file, as the available
+	/// video codecs differ between machines.
+	/// </summary>
+	void EncodeFrame(const cv::Mat& img)
+	{
+		std::vector<uchar> encoded;
+		cv::imencode(".jpg", img, encoded);
+	}
+
+	/// <summary>
+	/// Call a function at a frame rate for the set number of seconds. It's
+	/// paced the same way as the camera and composite threads, so the 
+	/// sustained frame rate includes the pacing's accuracy.
+	/// </summary>
+	template<typename Fn>
+	void PacedLoop(int seconds, double fps, Fn fn)
+	{
+		cvgStopwatchLeft swLoopSleep;
+		BenchClock::time_point end = BenchClock::now() + std::chrono::seconds(seconds);
+		while(BenchClock::now() < end)
+		{
+			fn();
+			std::this_thread::sleep_for(std::chrono::milliseconds(swLoopSleep.MSLeftForFPS(fps)));
+		}
+	}
+
+	/// <summary>
+	/// Run the two cameras and the composite for the set number of seconds,
+	/// with whatever state the task pool is in.
+	/// </summary>
+	void RunScenario(std::ostream& os, int seconds, double fps)
+	{
+		cvgTaskPool& pool = cvgTaskPool::GetInstance();
+
+		LatestFrames latest;
+		latest.frames.resize(camCt);
+
+		StageTiming camTimings[camCt];
+		StageTiming compTiming;
+		StageTiming encodeTiming;
+
+		for(StageTiming& timing : camTimings)
+			timing.msPerFrame = 1000.0 / fps;
+
+		compTiming.msPerFrame	= 1000.0 / fps;
+		encodeTiming.msPerFrame = 1000.0 / fps;
+
+		std::vector<std::thread> threads;
+		for(int camIdx = 0; camIdx < camCt; ++camIdx)
+		{
+			threads.emplace_back(
+				[&, camIdx]
+				{
+					cv::Mat src(frameHeight, frameWidth, CV_8UC3);
+					cv::randu(src, cv::Scalar::all(0), cv::Scalar::all(255));
+
+					cvgTaskPool::Strand recordStrand;
+					PacedLoop(
+						seconds,
+						fps,
+						[&]
+						{
+							BenchClock::time_point frameStart = BenchClock::now();
+
+							// The copy stands in for the frame being polled.
+							cv::Mat processed = ProcessFrame(src.clone());
+							{
+								std::lock_guard<std::mutex> guard(latest.framesMutex);
+								latest.frames[camIdx] = processed;
+							}
+
+							BenchClock::time_point submitTime = BenchClock::now();
+							recordStrand.Post(
+								[processed, submitTime, &encodeTiming]
+								{
+									EncodeFrame(processed);
+									encodeTiming.Add(MSSince(submitTime));
+								});
+
+							camTimings[camIdx].Add(MSSince(frameStart));
+						});
+				});
+		}
+
+		threads.emplace_back(
+			[&]
+			{
+				cvgTaskPool::Strand recordStrand;
+				PacedLoop(
+					seconds,
+					fps,
+					[&]
+					{
+						BenchClock::time_point frameStart = BenchClock::now();
+
+						std::vector<cv::Mat> tiles;
+						{
+							std::lock_guard<std::mutex> guard(latest.framesMutex);
+							for(const cv::Mat& m : latest.frames)
+							{
+								if(!m.empty())
+									tiles.push_back(m);
+							}
+						}
+
+						// Same steps as ManagedComposite::ThreadFn().
+						std::vector<cv::Mat> tileMats(tiles.size());
+						pool.ParallelFor(
+							0,
+							(int)tiles.size(),
+							[&tiles, &tileMats](int start, int end)
+							{
+								for(int i = start; i < end; ++i)
+								{
+									cv::Mat cpy;
+									cv::resize(tiles[i], cpy, cv::Size(frameWidth, frameHeight));
+									std::vector<cv::Mat> chans =
+									{
+										cv::Mat(cpy.rows, cpy.cols, CV_8UC1, cv::Scalar(0)),
+										cv::Mat(cpy.rows, cpy.cols, CV_8UC1, cv::Scalar(0)),
+										cpy
+									};
+									cv::merge(chans, tileMats[i]);
+								}
+							},
+							(int)tiles.size());
+
+						cv::Mat accum(frameHeight, frameWidth, CV_8UC3, cv::Scalar(0, 0, 0));
+						for(const cv::Mat& tile : tileMats)
+							cv::add(accum, tile, accum);
+
+						BenchClock::time_point submitTime = BenchClock::now();
+						recordStrand.Post(
+							[accum, submitTime, &encodeTiming]
+							{
+								EncodeFrame(accum);
+								encodeTiming.Add(MSSince(submitTime));
+							});
+
+						compTiming.Add(MSSince(frameStart));
+					});
+			});
+
+		for(std::thread& t : threads)
+			t.join();
+
+		for(int i = 0; i < camCt; ++i)
+			camTimings[i].Print(os, "camera_" + std::to_string(i));
+
+		compTiming.Print(os, "composite");
+		encodeTiming.Print(os, "encode latency");
+	}
+}
+
+bool cvgTaskPoolBenchmark::Run(std::ostream& os, int seconds, double fps)
+{
+	cvgTaskPool& pool = cvgTaskPool::GetInstance();
+	if(pool.IsRunning())
+	{
+		os << "The task pool benchmark can't run while the task pool is already running." << std::endl;
+		return false;
+	}
+
+	if(fps <= 0.0)
+		fps = 30.0;
+
+	os << "Benchmarking " << camCt << " cameras at " << frameWidth << "x" << frameHeight <<
+		", " << fps << " FPS, with compositing and recording, for " << seconds << " seconds per model." << std::endl;
+
+	os << "Dedicated threads (OpenCV threads: " << cv::getNumThreads() << "):" << std::endl;
+	RunScenario(os, seconds, fps);
+
+	pool.Start(0, true);
+	pool.ResetMetrics();
+	os << "Task pool:" << std::endl;
+	RunScenario(os, seconds, fps);
+	pool.DumpMetrics(os);
+	pool.Shutdown();
+
+	return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <ostream>
+
+/// <summary>
+/// A synthetic benchmark comparing the app's threading models for
+/// processing, compositing and recording camera frames.
+///
+/// Two simulated 1280x720 cameras are polled at a frame rate (30 FPS by 
+/// default) on their own threads, and a composite thread combines their
+/// processed frames at the same rate. Every processed and composited frame 
+/// is also encoded, standing in for video recording. Each stage reports the
+/// frame rate it sustained, and how often it took longer than a frame.
+///
+/// The scenario is run twice:
+/// - Dedicated threads: The task pool isn't running, so each thread does
+///   its own encoding, and OpenCV uses its own thread pool. This is the
+///   threading model used when the task pool is disabled.
+/// - Task pool: Encoding and composite tiles are run on the cvgTaskPool,
+///   and OpenCV's parallel_for_ is routed into the pool if supported.
+///
+/// Run with the --benchmark-taskpool command line option, and optionally
+/// --benchmark-fps to test a higher frame rate.
+/// </summary>
+class cvgTaskPoolBenchmark
+{
+public:
+	/// <summary>
+	/// Run the benchmark and print the results.
+	/// </summary>
+	/// <param name="os">The stream to print the results to.</param>
+	/// <param name="seconds">How long to run each threading model for.</param>
+	/// <param name="fps">The frame rate to run the cameras and composite at.</param>
+	/// <returns>
+	/// False if the task pool was already running, in which case the
+	/// benchmark isn't run.
+	/// </returns>
+	static bool Run(std::ostream& os, int seconds, double fps = 30.0);
+};
@@ -0,0 +1,347 @@
+#include "cvgThreadPlacement.h"
+#include <opencv2/core.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#if !_WIN32
+	#include <pthread.h>
+	#include <sched.h>
+	#include <unistd.h>
+	#include <sys/resource.h>
+	#include <sys/syscall.h>
+	#include <cstring>
+	#include <cerrno>
+#endif
+
+static const char* szKey_CPUs		= "cpus";
+static const char* szKey_FIFO		= "fifo_priority";
+static const char* szKey_Nice		= "nice";
+
+cvgThreadPlacement cvgThreadPlacement::_inst;
+
+/// <summary>
+/// Get the OS thread id of the calling thread.
+/// </summary>
+static long long CurrentTID()
+{
+#if !_WIN32
+	return (long long)syscall(SYS_gettid);
+#else
+	return 0;
+#endif
+}
+
+bool ThreadPlacementOpts::IsDefault() const
+{
+	return
+		this->cpus.empty() &&
+		this->fifoPriority == 0 &&
+		this->nice == 0;
+}
+
+bool ThreadPlacementOpts::HasScheduling() const
+{
+	return this->fifoPriority > 0 || this->nice != 0;
+}
+
+#if !_WIN32
+/// <summary>
+/// Get the scheduling of the calling thread, in the form of 
+/// cvgThreadPlacement::placedScheds.
+/// </summary>
+static std::pair<int, int> CurrentSched()
+{
+	int policy = sched_getscheduler(0);
+	if(policy == SCHED_FIFO || policy == SCHED_RR)
+	{
+		sched_param param;
+		if(sched_getparam(0, &param) == 0)
+			return std::make_pair(policy, param.sched_priority);
+	}
+
+	// getpriority() can legitimately return -1, so errors are checked
+	// through errno.
+	errno = 0;
+	int nice = getpriority(PRIO_PROCESS, (id_t)CurrentTID());
+	return std::make_pair((int)SCHED_OTHER, errno == 0 ? nice : 0);
+}
+
+/// <summary>
+/// Get the scheduling placement options put a thread on, in the form of
+/// cvgThreadPlacement::placedScheds.
+/// </summary>
+static std::pair<int, int> PlacedSched(const ThreadPlacementOpts& opts)
+{
+	if(opts.fifoPriority > 0)
+		return std::make_pair((int)SCHED_FIFO, opts.fifoPriority);
+
+	return std::make_pair((int)SCHED_OTHER, opts.nice);
+}
+#endif
+
+json ThreadPlacementOpts::AsJSON() const
+{
+	json ret = json::object();
+	ret[szKey_CPUs]	= this->cpus;
+	ret[szKey_FIFO]	= this->fifoPriority;
+	ret[szKey_Nice]	= this->nice;
+	return ret;
+}
+
+bool ThreadPlacementOpts::ApplyJSON(const json& js)
+{
+	if(!js.is_object())
+		return false;
+
+	if(js.contains(szKey_CPUs) && js[szKey_CPUs].is_array())
+	{
+		this->cpus.clear();
+		for(const json& jsCPU : js[szKey_CPUs])
+		{
+			if(jsCPU.is_number_integer())
+				this->cpus.push_back(jsCPU.get<int>());
+		}
+	}
+
+	if(js.contains(szKey_FIFO) && js[szKey_FIFO].is_number_integer())
+		this->fifoPriority = std::clamp(js[szKey_FIFO].get<int>(), 0, 99);
+
+	if(js.contains(szKey_Nice) && js[szKey_Nice].is_number_integer())
+		this->nice = std::clamp(js[szKey_Nice].get<int>(), -20, 19);
+
+	return true;
+}
+
+bool ThreadPlacementOpts::operator==(const ThreadPlacementOpts& other) const
+{
+	return
+		this->cpus			== other.cpus			&&
+		this->fifoPriority	== other.fifoPriority	&&
+		this->nice			== other.nice;
+}
+
+cvgThreadPlacement::cvgThreadPlacement()
+{}
+
+cvgThreadPlacement& cvgThreadPlacement::GetInstance()
+{
+	return _inst;
+}
+
+void cvgThreadPlacement::SetPlacements(const std::map<std::string, ThreadPlacementOpts>& placements, int cvThreads)
+{
+	std::lock_guard<std::mutex> guard(this->placementMutex);
+	this->placements = placements;
+
+	if(cvThreads != this->cvThreads && cvThreads >= 0)
+	{
+		std::cout << "Setting OpenCV to use " << cvThreads << " threads." << std::endl;
+		cv::setNumThreads(cvThreads);
+	}
+	this->cvThreads = cvThreads;
+}
+
+bool cvgThreadPlacement::ApplyToCurrentThread(const std::string& role)
+{
+	ThreadPlacementOpts opts;
+	bool resetSched = false;
+	{
+		std::lock_guard<std::mutex> guard(this->placementMutex);
+
+		RegisteredThread rt;
+		rt.role = role;
+		rt.tid = CurrentTID();
+		this->registered.push_back(rt);
+
+		auto itFind = this->placements.find(role);
+		if(itFind != this->placements.end())
+			opts = itFind->second;
+
+#if !_WIN32
+		// Threads inherit the scheduling of the thread that created them,
+		// which may be a SCHED_FIFO main thread. That, or a role that's no
+		// longer placed, is put back to the default. Anything else was set
+		// from outside, and is left alone.
+		if(opts.HasScheduling())
+		{
+			this->schedPlacedRoles.insert(role);
+			this->placedScheds.insert(PlacedSched(opts));
+		}
+		else
+		{
+			resetSched = 
+				this->schedPlacedRoles.count(role) != 0 ||
+				this->placedScheds.count(CurrentSched()) != 0;
+		}
+#endif
+	}
+
+	if(opts.IsDefault() && !resetSched)
+		return true;
+
+	return _ApplyOpts(role, opts, resetSched);
+}
+
+bool cvgThreadPlacement::_ApplyOpts(const std::string& role, const ThreadPlacementOpts& opts, bool resetSched)
+{
+#if !_WIN32
+	bool allApplied = true;
+
+	if(!opts.cpus.empty())
+	{
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		for(int cpu : opts.cpus)
+		{
+			if(cpu >= 0 && cpu < CPU_SETSIZE)
+				CPU_SET(cpu, &cpuSet);
+		}
+
+		int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+		if(err != 0)
+		{
+			std::cerr << "Could not set CPU affinity for thread " << role << ": " << strerror(err) << std::endl;
+			allApplied = false;
+		}
+	}
+
+	if(opts.fifoPriority > 0)
+	{
+		sched_param param;
+		param.sched_priority = opts.fifoPriority;
+
+		int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if(err != 0)
+		{
+			std::cerr << "Could not set SCHED_FIFO priority " << opts.fifoPriority << " for thread " << role << ": " << strerror(err) << std::endl;
+			allApplied = false;
+		}
+	}
+	else if(opts.nice != 0 || resetSched)
+	{
+		// Threads inherit the scheduling of the thread that created them, 
+		// so a thread created by a SCHED_FIFO thread needs to be explicitly
+		// put back on the normal policy.
+		if(sched_getscheduler(0) != SCHED_OTHER)
+		{
+			sched_param param;
+			param.sched_priority = 0;
+			pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+		}
+
+		// On Linux, the nice value is per-thread when given a thread id.
+		// Going back to 0 from an inherited positive nice value can need
+		// privileges, so that's only a best effort.
+		if(setpriority(PRIO_PROCESS, (id_t)CurrentTID(), opts.nice) != 0 && opts.nice != 0)
+		{
+			std::cerr << "Could not set nice " << opts.nice << " for thread " << role << ": " << strerror(errno) << std::endl;
+			allApplied = false;
+		}
+	}
+
+	return allApplied;
+#else
+	std::cout << "Ignoring thread placement for " << role << ", not supported on platform." << std::endl;
+	return false;
+#endif
+}
+
+void cvgThreadPlacement::UnregisterCurrentThread()
+{
+	long long tid = CurrentTID();
+
+	std::lock_guard<std::mutex> guard(this->placementMutex);
+	for(auto it = this->registered.begin(); it != this->registered.end(); ++it)
+	{
+		if(it->tid == tid)
+		{
+			this->registered.erase(it);
+			return;
+		}
+	}
+}
+
+void cvgThreadPlacement::DumpPlacement(std::ostream& os)
+{
+	std::vector<RegisteredThread> threads;
+	{
+		std::lock_guard<std::mutex> guard(this->placementMutex);
+		threads = this->registered;
+	}
+
+	os << "Thread placement (OpenCV threads: " << cv::getNumThreads() << "):" << std::endl;
+
+	for(const RegisteredThread& rt : threads)
+	{
+		os << "\t" << rt.role << " (tid " << rt.tid << ")";
+
+#if !_WIN32
+		pid_t tid = (pid_t)rt.tid;
+
+		// Allowed CPUs
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		if(sched_getaffinity(tid, sizeof(cpu_set_t), &cpuSet) == 0)
+		{
+			os << " - CPUs:";
+			for(int i = 0; i < CPU_SETSIZE; ++i)
+			{
+				if(CPU_ISSET(i, &cpuSet))
+					os << " " << i;
+			}
+		}
+
+		// The CPU the thread last ran on is field 39 of its stat file. The
+		// fields are counted after the executable name, which is in
+		// parenthesis and may have spaces.
+		std::ifstream ifsStat("/proc/self/task/" + std::to_string(rt.tid) + "/stat");
+		std::string stat;
+		if(std::getline(ifsStat, stat))
+		{
+			size_t commEnd = stat.rfind(')');
+			if(commEnd != std::string::npos)
+			{
+				std::stringstream sstrmFields(stat.substr(commEnd + 1));
+				std::string field;
+				int fieldIdx = 2;
+				while(sstrmFields >> field)
+				{
+					if(++fieldIdx == 39)
+					{
+						os << " - Last CPU: " << field;
+						break;
+					}
+				}
+			}
+		}
+
+		int policy = sched_getscheduler(tid);
+		sched_param param;
+		if(policy >= 0 && sched_getparam(tid, &param) == 0)
+		{
+			switch(policy)
+			{
+			case SCHED_FIFO:
+				os << " - SCHED_FIFO " << param.sched_priority;
+				break;
+			case SCHED_RR:
+				os << " - SCHED_RR " << param.sched_priority;
+				break;
+			default:
+				{
+					// getpriority() can legitimately return -1, so errors
+					// are checked through errno.
+					errno = 0;
+					int nice = getpriority(PRIO_PROCESS, (id_t)tid);
+					if(errno == 0)
+						os << " - Nice: " << nice;
+				}
+				break;
+			}
+		}
+#endif
+		os << std::endl;
+	}
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <utility>
+#include <mutex>
+#include <ostream>
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+/// <summary>
+/// Where a thread is allowed to run, and at what priority.
+///
+/// These are set per thread role in the AppOptions (see
+/// cvgOptions::threadPlacements), and are applied by each thread
+/// when it boots with cvgThreadPlacement::ApplyToCurrentThread().
+/// </summary>
+class ThreadPlacementOpts
+{
+public:
+	/// <summary>
+	/// The CPU cores the thread is allowed to run on. If empty,
+	/// the thread can run on any core.
+	/// </summary>
+	std::vector<int> cpus;
+
+	/// <summary>
+	/// If in the range [1, 99], the thread is run with the SCHED_FIFO
+	/// real-time policy at this priority. If 0, the normal scheduling
+	/// policy is used.
+	///
+	/// Using SCHED_FIFO requires the app to have the permission to
+	/// (e.g., running as root, or having CAP_SYS_NICE).
+	/// </summary>
+	int fifoPriority = 0;
+
+	/// <summary>
+	/// The nice value of the thread, from -20 (highest priority) to 19
+	/// (lowest priority). Only used if fifoPriority is 0. Negative values
+	/// require the same permissions as SCHED_FIFO.
+	/// </summary>
+	int nice = 0;
+
+public:
+	/// <summary>
+	/// Check if the options would leave the thread untouched.
+	/// </summary>
+	bool IsDefault() const;
+
+	/// <summary>
+	/// Check if the options change the scheduling policy or nice value.
+	/// </summary>
+	bool HasScheduling() const;
+
+	/// <summary>
+	/// Get a JSON representation of the object.
+	/// </summary>
+	json AsJSON() const;
+
+	/// <summary>
+	/// Load a JSON representation of the object. Missing
+	/// elements are left at their current values.
+	/// </summary>
+	/// <param name="js">The JSON object to load.</param>
+	/// <returns>False if js was not a JSON object.</returns>
+	bool ApplyJSON(const json& js);
+
+	bool operator==(const ThreadPlacementOpts& other) const;
+};
+
+/// <summary>
+/// Applies the CPU affinity and scheduling options to the app's threads
+/// by their role, and keeps track of the threads that have registered
+/// themselves, so their actual placement can be dumped for diagnostics.
+///
+/// The known thread roles are:
+/// - "main"			: The wx/OpenGL UI thread.
+/// - "camera_<n>"		: The ManagedCam threads, where n is the camera index.
+/// - "composite"		: The ManagedComposite thread.
+/// - "fauxmouse"		: The FauxMouse GPIO polling thread (RPi only).
+/// - "taskpool"		: The cvgTaskPool worker threads.
+///
+/// Affinity and scheduling are only supported on Linux. On other platforms
+/// the options are ignored, but threads are still registered.
+/// </summary>
+class cvgThreadPlacement
+{
+private:
+	/// <summary>
+	/// A thread that has registered itself.
+	/// </summary>
+	struct RegisteredThread
+	{
+		std::string role;
+
+		/// <summary>
+		/// The OS thread id. On Linux, this is the id from gettid().
+		/// </summary>
+		long long tid = 0;
+	};
+
+	static cvgThreadPlacement _inst;
+
+	/// <summary>
+	/// Guards all member variables.
+	/// </summary>
+	std::mutex placementMutex;
+
+	/// <summary>
+	/// The options for each thread role.
+	/// </summary>
+	std::map<std::string, ThreadPlacementOpts> placements;
+
+	/// <summary>
+	/// The number of threads OpenCV is allowed to use for its own
+	/// parallelization. A negative value leaves OpenCV's default.
+	/// </summary>
+	int cvThreads = -1;
+
+	/// <summary>
+	/// The threads that have registered themselves.
+	/// </summary>
+	std::vector<RegisteredThread> registered;
+
+	/// <summary>
+	/// The roles whose scheduling has been changed by their placement.
+	/// </summary>
+	std::set<std::string> schedPlacedRoles;
+
+	/// <summary>
+	/// The scheduling threads have been put on by their placement, as
+	/// (policy, priority) for real-time policies, or (SCHED_OTHER, nice).
+	/// Threads created by those threads inherit it.
+	/// </summary>
+	std::set<std::pair<int, int>> placedScheds;
+
+private:
+	cvgThreadPlacement();
+
+	/// <summary>
+	/// Apply placement options to the calling thread.
+	/// </summary>
+	/// <param name="resetSched">
+	/// If true, and the options don't change the scheduling, the thread is
+	/// put back on SCHED_OTHER at the default nice value. Else the scheduling
+	/// is left as is.
+	/// </param>
+	/// <returns>True if all the options were applied successfully.</returns>
+	static bool _ApplyOpts(const std::string& role, const ThreadPlacementOpts& opts, bool resetSched);
+
+public:
+	static cvgThreadPlacement& GetInstance();
+
+	/// <summary>
+	/// Set the placement options for each thread role. This should be
+	/// set before the threads are booted, as they're only applied when
+	/// a thread calls ApplyToCurrentThread().
+	/// </summary>
+	/// <param name="placements">The options, keyed by thread role.</param>
+	/// <param name="cvThreads">
+	/// The number of threads OpenCV should use, or a negative value to
+	/// leave it as is. OpenCV's thread pool is shared by the entire process,
+	/// so this is applied immediately for all stages.
+	/// </param>
+	void SetPlacements(const std::map<std::string, ThreadPlacementOpts>& placements, int cvThreads);
+
+	/// <summary>
+	/// Register the calling thread by its role, and apply the placement
+	/// options set for that role, if any.
+	///
+	/// If the options don't set the scheduling, the thread is put back on
+	/// SCHED_OTHER at the default nice value only if its scheduling came from
+	/// a placement: it was applied to the role before, or the thread inherited
+	/// it from a placed thread. Scheduling set from outside the app, like
+	/// chrt or nice on the whole process, is left alone.
+	/// </summary>
+	/// <param name="role">The role of the thread.</param>
+	/// <returns>
+	/// True if there were no options for the role, or they were successfully
+	/// applied.
+	/// </returns>
+	bool ApplyToCurrentThread(const std::string& role);
+
+	/// <summary>
+	/// Remove the calling thread from the registered threads. This should
+	/// be called before a registered thread exits.
+	/// </summary>
+	void UnregisterCurrentThread();
+
+	/// <summary>
+	/// Print where every registered thread is actually allowed to run,
+	/// the CPU it last ran on, and its scheduling policy and priority,
+	/// as reported by the OS.
+	/// </summary>
+	void DumpPlacement(std::ostream& os);
+};